@@ -41,6 +41,9 @@ extern "C" {
 #include "esp_nn_ansi_c.h"
 #endif
 
+/* row-band split of convolutions across cores */
+#include "esp_nn_parallel.h"
+
 #ifdef __cplusplus
 }
 #endif
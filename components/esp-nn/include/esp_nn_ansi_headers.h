@@ -120,6 +120,27 @@ int esp_nn_get_depthwise_conv_scratch_size_ansi(const data_dims_t *input_dims,
                                                 const dw_conv_params_t *conv_params);
 void esp_nn_set_depthwise_conv_scratch_buf_ansi(const void *buf);
 
+/**
+ * @brief       2d transpose convolution channelwise
+ *
+ * @note        operation: each output pixel gathers
+ *              result += (input + offset) * filter
+ *              over the input pixels that scatter into it, no scratch buffer
+ *
+ *              filter layout: out_channels x height x width x in_channels
+ *              inputs type: int8_t, output: int8_t
+ *              input offsets: although int32_t, they are contained in 8 bits [-128, 127]
+ */
+void esp_nn_transpose_conv_s8_ansi(const data_dims_t *input_dims,
+                                   const int8_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int32_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int8_t *out_data,
+                                   const conv_params_t *conv_params,
+                                   const quant_data_t *quant_data);
+
 /************************** Activation functions *****************************/
 
 /**
@@ -199,6 +220,23 @@ void esp_nn_fully_connected_s8_ansi(const int8_t *input_data,
                                     const int32_t activation_min,
                                     const int32_t activation_max);
 
+/**
+ * @brief       fully connected, accumulating into an int16 output
+ *
+ * @note        inputs type: int8_t, output: int16_t
+ *              operation: out = sat16(out + requant(bias + input * filter))
+ *              The input and filter offsets are to be folded into the bias,
+ *              which can't be NULL.
+ */
+void esp_nn_fully_connected_s8_acc_s16_ansi(const int8_t *input_data,
+                                            const uint16_t row_len,
+                                            const int8_t *filter_data,
+                                            const int32_t *bias,
+                                            int16_t *out_data,
+                                            const uint16_t out_channels,
+                                            const int32_t out_shift,
+                                            const int32_t out_mult);
+
 /**
  * @brief   Get scratch buffer size needed by softmax function
  *
@@ -291,6 +329,22 @@ int esp_nn_get_depthwise_conv_scratch_size_opt(const data_dims_t *input_dims,
                                                const dw_conv_params_t *conv_params);
 void esp_nn_set_depthwise_conv_scratch_buf_opt(const void *buf);
 
+/**
+ * @brief       2d transpose convolution channelwise optimized version
+ *
+ * @note        same operation as esp_nn_transpose_conv_s8_ansi, four output
+ *              channels at a time, with a path for stride 2 2x2 and 3x3 filters
+ */
+void esp_nn_transpose_conv_s8_opt(const data_dims_t *input_dims,
+                                  const int8_t *input_data,
+                                  const data_dims_t *filter_dims,
+                                  const int8_t *filter_data,
+                                  const int32_t *bias,
+                                  const data_dims_t *output_dims,
+                                  int8_t *out_data,
+                                  const conv_params_t *conv_params,
+                                  const quant_data_t *quant_data);
+
 /* ANSI C function to be hooked up when optimised version needed */
 void esp_nn_set_softmax_scratch_buf_opt(void *buffer);
 
@@ -0,0 +1,100 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file        Multi-core execution of convolution kernels.
+ *
+ *              The output is split into horizontal bands of rows, one per worker.
+ *              Each band is an ordinary, smaller convolution over a window of the
+ *              input, so every output element is computed by exactly the same code
+ *              as in the single core call and results are bit-exact.
+ *
+ *              Workers are FreeRTOS tasks when `CONFIG_NN_MULTICORE` is enabled,
+ *              pthreads when built with `ESP_NN_USE_PTHREADS` (host tests) and
+ *              the calling thread only otherwise.
+ */
+
+#pragma once
+
+#include "esp_nn_defs.h"
+
+#define ESP_NN_MAX_WORKERS 2
+
+/**
+ * @brief       worker entry, `worker` is in [0, num_workers)
+ */
+typedef void (*esp_nn_worker_fn_t)(void *arg, int worker);
+
+/**
+ * @brief       number of workers kernels are split across, 1 without threading support
+ */
+int esp_nn_parallel_num_workers(void);
+
+/**
+ * @brief       run `fn` once per worker and wait for all of them
+ *
+ * @note        worker 0 runs on the calling thread. Not reentrant, only one
+ *              task may be running parallel kernels at a time.
+ */
+void esp_nn_parallel_run(esp_nn_worker_fn_t fn, void *arg, int num_workers);
+
+/**
+ * @brief       scratch size needed by each worker of `esp_nn_conv_s8_parallel`
+ */
+int esp_nn_get_conv_scratch_size_parallel(const data_dims_t *input_dims,
+                                          const data_dims_t *filter_dims,
+                                          const data_dims_t *output_dims,
+                                          const conv_params_t *conv_params);
+
+/**
+ * @brief       2d-convolution split across `esp_nn_parallel_num_workers()` workers
+ *
+ * @note        `scratch_bufs` holds one buffer per worker, each of
+ *              `esp_nn_get_conv_scratch_size_parallel` bytes
+ */
+void esp_nn_conv_s8_parallel(const data_dims_t *input_dims,
+                             const int8_t *input_data,
+                             const data_dims_t *filter_dims,
+                             const int8_t *filter_data,
+                             const int32_t *bias,
+                             const data_dims_t *output_dims,
+                             int8_t *out_data,
+                             const conv_params_t *conv_params,
+                             const quant_data_t *quant_data,
+                             void *const *scratch_bufs);
+
+/**
+ * @brief       scratch size needed by each worker of `esp_nn_depthwise_conv_s8_parallel`
+ */
+int esp_nn_get_depthwise_conv_scratch_size_parallel(const data_dims_t *input_dims,
+                                                    const data_dims_t *filter_dims,
+                                                    const data_dims_t *output_dims,
+                                                    const dw_conv_params_t *conv_params);
+
+/**
+ * @brief       depthwise convolution split across `esp_nn_parallel_num_workers()` workers
+ *
+ * @note        `scratch_bufs` holds one buffer per worker, each of
+ *              `esp_nn_get_depthwise_conv_scratch_size_parallel` bytes
+ */
+void esp_nn_depthwise_conv_s8_parallel(const data_dims_t *input_dims,
+                                       const int8_t *input_data,
+                                       const data_dims_t *filter_dims,
+                                       const int8_t *filter_data,
+                                       const int32_t *bias,
+                                       const data_dims_t *output_dims,
+                                       int8_t *out_data,
+                                       const dw_conv_params_t *conv_params,
+                                       const quant_data_t *quant_data,
+                                       void *const *scratch_bufs);
@@ -24,6 +24,12 @@
  */
 #define __NN_FORCE_INLINE__ __attribute((always_inline)) static inline
 
+/**
+ * Scratch buffer pointers are kept per thread, so that the workers of
+ * `esp_nn_*_parallel` can run the same kernel with their own scratch.
+ */
+#define ESP_NN_THREAD_LOCAL __thread
+
 /* min/max macros */
 #ifndef max
 #define max(a, b) ({            \
@@ -226,7 +232,7 @@ __NN_FORCE_INLINE__ void esp_nn_s8_to_s16_with_offset(const int8_t *src, int16_t
                                                       const int size, const int32_t offset)
 {
     int i = 0;
-    for (; i < size; i += 2) {
+    for (; i < size - 1; i += 2) {
         dst[i + 0] = src[i + 0] + offset;
         dst[i + 1] = src[i + 1] + offset;
     }
@@ -245,7 +251,7 @@ __NN_FORCE_INLINE__ void esp_nn_s8_to_s16_with_offset(const int8_t *src, int16_t
 __NN_FORCE_INLINE__ void esp_nn_s8_to_s16(const int8_t *src, int16_t *dst, const int size)
 {
     int i = 0;
-    for (; i < size; i += 2) {
+    for (; i < size - 1; i += 2) {
         dst[i + 0] = src[i + 0];
         dst[i + 1] = src[i + 1];
     }
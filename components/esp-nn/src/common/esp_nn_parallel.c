@@ -0,0 +1,153 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <esp_nn_parallel.h>
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+#if defined(CONFIG_NN_MULTICORE) && !defined(CONFIG_FREERTOS_UNICORE)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define WORKER_STACK_SIZE   4096
+
+/* workers 1..n-1 are long lived tasks, worker 0 is the caller */
+static TaskHandle_t s_worker_task[ESP_NN_MAX_WORKERS];
+static SemaphoreHandle_t s_start[ESP_NN_MAX_WORKERS];
+static SemaphoreHandle_t s_done;
+static esp_nn_worker_fn_t s_fn;
+static void *s_arg;
+
+static void esp_nn_worker_task(void *param)
+{
+    const int worker = (int) (intptr_t) param;
+    while (1) {
+        xSemaphoreTake(s_start[worker], portMAX_DELAY);
+        s_fn(s_arg, worker);
+        xSemaphoreGive(s_done);
+    }
+}
+
+static bool esp_nn_workers_init(void)
+{
+    if (s_done != NULL) {
+        return true;
+    }
+    s_done = xSemaphoreCreateCounting(ESP_NN_MAX_WORKERS, 0);
+    if (s_done == NULL) {
+        return false;
+    }
+    for (int w = 1; w < ESP_NN_MAX_WORKERS; w++) {
+        s_start[w] = xSemaphoreCreateBinary();
+        /* not pinned, the scheduler places it on whichever core is free */
+        if (s_start[w] == NULL ||
+                xTaskCreate(esp_nn_worker_task, "esp_nn_worker", WORKER_STACK_SIZE,
+                            (void *) (intptr_t) w, uxTaskPriorityGet(NULL),
+                            &s_worker_task[w]) != pdPASS) {
+            printf("esp_nn_parallel: failed to start worker %d\n", w);
+            return false;
+        }
+    }
+    return true;
+}
+
+int esp_nn_parallel_num_workers(void)
+{
+    return ESP_NN_MAX_WORKERS;
+}
+
+void esp_nn_parallel_run(esp_nn_worker_fn_t fn, void *arg, int num_workers)
+{
+    if (num_workers <= 1 || !esp_nn_workers_init()) {
+        for (int w = 0; w < num_workers; w++) {
+            fn(arg, w);
+        }
+        return;
+    }
+    s_fn = fn;
+    s_arg = arg;
+    for (int w = 1; w < num_workers; w++) {
+        xSemaphoreGive(s_start[w]);
+    }
+    fn(arg, 0);
+    for (int w = 1; w < num_workers; w++) {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+    }
+}
+
+#elif defined(ESP_NN_USE_PTHREADS)
+
+#include <pthread.h>
+
+typedef struct {
+    esp_nn_worker_fn_t fn;
+    void *arg;
+    int worker;
+} worker_job_t;
+
+static void *esp_nn_worker_thread(void *param)
+{
+    worker_job_t *job = (worker_job_t *) param;
+    job->fn(job->arg, job->worker);
+    return NULL;
+}
+
+int esp_nn_parallel_num_workers(void)
+{
+    return ESP_NN_MAX_WORKERS;
+}
+
+void esp_nn_parallel_run(esp_nn_worker_fn_t fn, void *arg, int num_workers)
+{
+    pthread_t threads[ESP_NN_MAX_WORKERS];
+    worker_job_t jobs[ESP_NN_MAX_WORKERS];
+    bool started[ESP_NN_MAX_WORKERS] = {false};
+
+    for (int w = 1; w < num_workers; w++) {
+        jobs[w] = (worker_job_t) {.fn = fn, .arg = arg, .worker = w};
+        started[w] = pthread_create(&threads[w], NULL, esp_nn_worker_thread, &jobs[w]) == 0;
+    }
+    fn(arg, 0);
+    for (int w = 1; w < num_workers; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+        } else {
+            fn(arg, w);
+        }
+    }
+}
+
+#else
+
+int esp_nn_parallel_num_workers(void)
+{
+    return 1;
+}
+
+void esp_nn_parallel_run(esp_nn_worker_fn_t fn, void *arg, int num_workers)
+{
+    for (int w = 0; w < num_workers; w++) {
+        fn(arg, w);
+    }
+}
+
+#endif
@@ -16,17 +16,275 @@
 
 #include <common_functions.h>
 
+static ESP_NN_THREAD_LOCAL void *scratch_buffer = NULL;
+
+/**
+ * With a scratch buffer, convolutions run as a GEMM of input patches, one row per
+ * output pixel in (filter_y, filter_x, in_channel) order, by the filter, whose
+ * rows are in the same order.
+ *
+ * Inputs enter the GEMM as s8 without the input offset. It is added back through
+ * `input_offset * sum(filter row)`, precomputed with the bias per output channel
+ * at the start of the scratch buffer. Padding is filled with `-input_offset`,
+ * which contributes nothing once offset. 1x1 stride 1 convolutions use the input
+ * directly as patches, others copy the patches of a tile of output pixels (one
+ * output row, rounded up to the block size) to the scratch buffer.
+ */
+#define CONV_GEMM_BLOCK 4
+
+static bool esp_nn_conv_uses_input_as_patches(const data_dims_t *input_dims,
+                                              const data_dims_t *filter_dims,
+                                              const data_dims_t *output_dims,
+                                              const conv_params_t *conv_params)
+{
+    return filter_dims->width == 1 && filter_dims->height == 1 &&
+           input_dims->width == output_dims->width && input_dims->height >= output_dims->height &&
+           conv_params->stride.width == 1 && conv_params->stride.height == 1 &&
+           conv_params->padding.width == 0 && conv_params->padding.height == 0;
+}
+
+static int32_t esp_nn_conv_tile_pixels(const data_dims_t *output_dims)
+{
+    const int32_t tile = (output_dims->width + CONV_GEMM_BLOCK - 1) & ~(CONV_GEMM_BLOCK - 1);
+    return min(tile, output_dims->width * output_dims->height);
+}
+
 int esp_nn_get_conv_scratch_size_opt(const data_dims_t *input_dims,
                                      const data_dims_t *filter_dims,
                                      const data_dims_t *output_dims,
                                      const conv_params_t *conv_params)
 {
-    return 0;
+    const int offsets_size = output_dims->channels * sizeof(int32_t);
+    if (esp_nn_conv_uses_input_as_patches(input_dims, filter_dims, output_dims, conv_params)) {
+        return offsets_size;
+    }
+    const int patch_size = filter_dims->width * filter_dims->height * input_dims->channels;
+    return offsets_size + esp_nn_conv_tile_pixels(output_dims) * patch_size;
 }
 
 void esp_nn_set_conv_scratch_buf_opt(const void *buf)
 {
+    scratch_buffer = (void *) buf;
+}
+
+/* patches of output pixels [first, first + count), see above */
+static void esp_nn_conv_im2col(const int8_t *input_data,
+                               const uint16_t input_wd,
+                               const uint16_t input_ht,
+                               const uint16_t in_channels,
+                               const int8_t pad_val,
+                               const uint16_t filter_wd,
+                               const uint16_t filter_ht,
+                               const uint16_t pad_wd,
+                               const uint16_t pad_ht,
+                               const uint16_t stride_wd,
+                               const uint16_t stride_ht,
+                               const uint16_t out_wd,
+                               const int32_t first,
+                               const int32_t count,
+                               int8_t *patches)
+{
+    const int32_t row_size = filter_wd * in_channels;
+    int32_t out_y = first / out_wd;
+    int32_t out_x = first % out_wd;
+
+    for (int32_t i = 0; i < count; i++) {
+        const int32_t base_y = out_y * stride_ht - pad_ht;
+        const int32_t base_x = out_x * stride_wd - pad_wd;
+        const int32_t filter_x_start = max(0, -base_x);
+        const int32_t filter_x_end = min((int32_t) filter_wd, input_wd - base_x);
+
+        for (int32_t filter_y_idx = 0; filter_y_idx < filter_ht; filter_y_idx++) {
+            const int32_t in_row = base_y + filter_y_idx;
+            if (in_row < 0 || in_row >= input_ht || filter_x_start >= filter_x_end) {
+                memset(patches, pad_val, row_size);
+            } else {
+                const int8_t *src = input_data + (in_row * input_wd + base_x + filter_x_start) * in_channels;
+                int8_t *dst = patches;
+                memset(dst, pad_val, filter_x_start * in_channels);
+                dst += filter_x_start * in_channels;
+                memcpy(dst, src, (filter_x_end - filter_x_start) * in_channels);
+                dst += (filter_x_end - filter_x_start) * in_channels;
+                memset(dst, pad_val, (filter_wd - filter_x_end) * in_channels);
+            }
+            patches += row_size;
+        }
+        if (++out_x == out_wd) {
+            out_x = 0;
+            out_y++;
+        }
+    }
+}
+
+__NN_FORCE_INLINE__ int8_t esp_nn_conv_requant(int32_t acc, int32_t mult, int32_t shift,
+                                               int32_t out_offset,
+                                               int32_t activation_min, int32_t activation_max)
+{
+    acc = esp_nn_multiply_by_quantized_mult_fast(acc, mult, shift);
+    acc += out_offset;
+    acc = max(acc, activation_min);
+    acc = min(acc, activation_max);
+    return (int8_t) acc;
+}
+
+/**
+ * out[p][o] = requant(ch_offsets[o] + patches[p] . filter[o]) for `num_patches`
+ * patches of `patch_size`, with `out_data` pointing at the output of the first one.
+ * The main loop computes 4 pixels x 4 output channels at a time, each input and
+ * filter value loaded being used 4 times.
+ */
+__attribute__ ((noinline))
+static void esp_nn_conv_s8_gemm(const int8_t *patches,
+                                const int32_t num_patches,
+                                const int32_t patch_size,
+                                const int8_t *filter_data,
+                                const int32_t *ch_offsets,
+                                int8_t *out_data,
+                                const uint16_t out_channels,
+                                const int32_t out_offset,
+                                const quant_data_t *quant_data,
+                                const int32_t activation_min,
+                                const int32_t activation_max)
+{
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    int32_t p = 0;
+
+    for (; p < num_patches - (CONV_GEMM_BLOCK - 1); p += CONV_GEMM_BLOCK) {
+        const int8_t *in0 = patches + p * patch_size;
+        const int8_t *in1 = in0 + patch_size;
+        const int8_t *in2 = in1 + patch_size;
+        const int8_t *in3 = in2 + patch_size;
+        int8_t *out0 = out_data + p * out_channels;
+        int8_t *out1 = out0 + out_channels;
+        int8_t *out2 = out1 + out_channels;
+        int8_t *out3 = out2 + out_channels;
+        int32_t oc = 0;
+
+        for (; oc < out_channels - (CONV_GEMM_BLOCK - 1); oc += CONV_GEMM_BLOCK) {
+            const int8_t *f0 = filter_data + oc * patch_size;
+            const int8_t *f1 = f0 + patch_size;
+            const int8_t *f2 = f1 + patch_size;
+            const int8_t *f3 = f2 + patch_size;
+            int32_t acc00 = ch_offsets[oc + 0], acc01 = ch_offsets[oc + 1];
+            int32_t acc02 = ch_offsets[oc + 2], acc03 = ch_offsets[oc + 3];
+            int32_t acc10 = acc00, acc11 = acc01, acc12 = acc02, acc13 = acc03;
+            int32_t acc20 = acc00, acc21 = acc01, acc22 = acc02, acc23 = acc03;
+            int32_t acc30 = acc00, acc31 = acc01, acc32 = acc02, acc33 = acc03;
+
+            for (int32_t k = 0; k < patch_size; k++) {
+                const int32_t w0 = f0[k], w1 = f1[k], w2 = f2[k], w3 = f3[k];
+                const int32_t x0 = in0[k], x1 = in1[k], x2 = in2[k], x3 = in3[k];
+                acc00 += x0 * w0; acc01 += x0 * w1; acc02 += x0 * w2; acc03 += x0 * w3;
+                acc10 += x1 * w0; acc11 += x1 * w1; acc12 += x1 * w2; acc13 += x1 * w3;
+                acc20 += x2 * w0; acc21 += x2 * w1; acc22 += x2 * w2; acc23 += x2 * w3;
+                acc30 += x3 * w0; acc31 += x3 * w1; acc32 += x3 * w2; acc33 += x3 * w3;
+            }
+
+            const int32_t m0 = out_mult[oc + 0], m1 = out_mult[oc + 1];
+            const int32_t m2 = out_mult[oc + 2], m3 = out_mult[oc + 3];
+            const int32_t s0 = out_shift[oc + 0], s1 = out_shift[oc + 1];
+            const int32_t s2 = out_shift[oc + 2], s3 = out_shift[oc + 3];
+            out0[oc + 0] = esp_nn_conv_requant(acc00, m0, s0, out_offset, activation_min, activation_max);
+            out0[oc + 1] = esp_nn_conv_requant(acc01, m1, s1, out_offset, activation_min, activation_max);
+            out0[oc + 2] = esp_nn_conv_requant(acc02, m2, s2, out_offset, activation_min, activation_max);
+            out0[oc + 3] = esp_nn_conv_requant(acc03, m3, s3, out_offset, activation_min, activation_max);
+            out1[oc + 0] = esp_nn_conv_requant(acc10, m0, s0, out_offset, activation_min, activation_max);
+            out1[oc + 1] = esp_nn_conv_requant(acc11, m1, s1, out_offset, activation_min, activation_max);
+            out1[oc + 2] = esp_nn_conv_requant(acc12, m2, s2, out_offset, activation_min, activation_max);
+            out1[oc + 3] = esp_nn_conv_requant(acc13, m3, s3, out_offset, activation_min, activation_max);
+            out2[oc + 0] = esp_nn_conv_requant(acc20, m0, s0, out_offset, activation_min, activation_max);
+            out2[oc + 1] = esp_nn_conv_requant(acc21, m1, s1, out_offset, activation_min, activation_max);
+            out2[oc + 2] = esp_nn_conv_requant(acc22, m2, s2, out_offset, activation_min, activation_max);
+            out2[oc + 3] = esp_nn_conv_requant(acc23, m3, s3, out_offset, activation_min, activation_max);
+            out3[oc + 0] = esp_nn_conv_requant(acc30, m0, s0, out_offset, activation_min, activation_max);
+            out3[oc + 1] = esp_nn_conv_requant(acc31, m1, s1, out_offset, activation_min, activation_max);
+            out3[oc + 2] = esp_nn_conv_requant(acc32, m2, s2, out_offset, activation_min, activation_max);
+            out3[oc + 3] = esp_nn_conv_requant(acc33, m3, s3, out_offset, activation_min, activation_max);
+        }
+        for (; oc < out_channels; oc++) {
+            const int8_t *f0 = filter_data + oc * patch_size;
+            int32_t acc0 = ch_offsets[oc], acc1 = acc0, acc2 = acc0, acc3 = acc0;
+
+            for (int32_t k = 0; k < patch_size; k++) {
+                const int32_t w0 = f0[k];
+                acc0 += in0[k] * w0;
+                acc1 += in1[k] * w0;
+                acc2 += in2[k] * w0;
+                acc3 += in3[k] * w0;
+            }
+            out0[oc] = esp_nn_conv_requant(acc0, out_mult[oc], out_shift[oc], out_offset, activation_min, activation_max);
+            out1[oc] = esp_nn_conv_requant(acc1, out_mult[oc], out_shift[oc], out_offset, activation_min, activation_max);
+            out2[oc] = esp_nn_conv_requant(acc2, out_mult[oc], out_shift[oc], out_offset, activation_min, activation_max);
+            out3[oc] = esp_nn_conv_requant(acc3, out_mult[oc], out_shift[oc], out_offset, activation_min, activation_max);
+        }
+    }
+    for (; p < num_patches; p++) {
+        const int8_t *in0 = patches + p * patch_size;
+        int8_t *out0 = out_data + p * out_channels;
+
+        for (int32_t oc = 0; oc < out_channels; oc++) {
+            const int8_t *f0 = filter_data + oc * patch_size;
+            int32_t acc = ch_offsets[oc];
+
+            for (int32_t k = 0; k < patch_size; k++) {
+                acc += in0[k] * f0[k];
+            }
+            out0[oc] = esp_nn_conv_requant(acc, out_mult[oc], out_shift[oc], out_offset, activation_min, activation_max);
+        }
+    }
+}
+
+static void esp_nn_conv_s8_im2col_gemm(const data_dims_t *input_dims,
+                                       const int8_t *input_data,
+                                       const data_dims_t *filter_dims,
+                                       const int8_t *filter_data,
+                                       const int32_t *bias,
+                                       const data_dims_t *output_dims,
+                                       int8_t *out_data,
+                                       const conv_params_t *conv_params,
+                                       const quant_data_t *quant_data)
+{
+    const uint16_t in_channels = input_dims->channels;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t patch_size = filter_wd * filter_ht * in_channels;
+    const int32_t num_pixels = output_dims->width * output_dims->height;
+
+    int32_t *ch_offsets = (int32_t *) scratch_buffer;
+    int8_t *patches = (int8_t *) (ch_offsets + out_channels);
 
+    for (int32_t oc = 0; oc < out_channels; oc++) {
+        const int8_t *filter_ptr = filter_data + oc * patch_size;
+        int32_t filter_sum = 0;
+        for (int32_t k = 0; k < patch_size; k++) {
+            filter_sum += filter_ptr[k];
+        }
+        ch_offsets[oc] = input_offset * filter_sum + (bias ? bias[oc] : 0);
+    }
+
+    if (esp_nn_conv_uses_input_as_patches(input_dims, filter_dims, output_dims, conv_params)) {
+        esp_nn_conv_s8_gemm(input_data, num_pixels, patch_size, filter_data, ch_offsets,
+                            out_data, out_channels, conv_params->out_offset, quant_data,
+                            conv_params->activation.min, conv_params->activation.max);
+        return;
+    }
+
+    const int32_t tile_pixels = esp_nn_conv_tile_pixels(output_dims);
+    for (int32_t first = 0; first < num_pixels; first += tile_pixels) {
+        const int32_t count = min(tile_pixels, num_pixels - first);
+        esp_nn_conv_im2col(input_data, input_dims->width, input_dims->height, in_channels,
+                           (int8_t) -input_offset, filter_wd, filter_ht,
+                           conv_params->padding.width, conv_params->padding.height,
+                           conv_params->stride.width, conv_params->stride.height,
+                           output_dims->width, first, count, patches);
+        esp_nn_conv_s8_gemm(patches, count, patch_size, filter_data, ch_offsets,
+                            out_data + first * out_channels, out_channels,
+                            conv_params->out_offset, quant_data,
+                            conv_params->activation.min, conv_params->activation.max);
+    }
 }
 
 __attribute__ ((noinline))
@@ -104,6 +362,11 @@ void esp_nn_conv_s8_opt(const data_dims_t *input_dims,
     const uint16_t filter_wd = filter_dims->width;
     const uint16_t filter_ht = filter_dims->height;
 
+    if (scratch_buffer != NULL) {
+        esp_nn_conv_s8_im2col_gemm(input_dims, input_data, filter_dims, filter_data, bias,
+                                   output_dims, out_data, conv_params, quant_data);
+        return;
+    }
     if (filter_wd == 1 && filter_ht == 1) {
         esp_nn_conv_s8_1x1(input_dims, input_data, filter_data, bias,
                            output_dims, out_data, conv_params, quant_data);
@@ -0,0 +1,263 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn.h>
+#include <esp_nn_parallel.h>
+
+#include <common_functions.h>
+
+/* below this, waking the other core costs more than it saves */
+#define PARALLEL_MIN_MACS   (32 * 1024)
+
+/**
+ * rows of the output computed by one worker, and the window of the input they read
+ */
+typedef struct {
+    int32_t out_start;
+    int32_t out_rows;
+    int32_t in_start;
+    int32_t in_rows;
+    int32_t pad_ht;
+} row_band_t;
+
+/**
+ * Split output rows evenly into `num_workers` bands.
+ * Returns the number of bands, 1 (the whole problem) when splitting isn't worth
+ * it or could change which kernel variant handles a band.
+ */
+static int esp_nn_split_rows(const data_dims_t *input_dims,
+                             const data_dims_t *filter_dims,
+                             const data_dims_t *output_dims,
+                             const data_2d_t *stride,
+                             const data_2d_t *padding,
+                             int32_t macs_per_out,
+                             row_band_t *bands)
+{
+    const int32_t num_workers = esp_nn_parallel_num_workers();
+    const int32_t out_ht = output_dims->height;
+    const int32_t in_ht = input_dims->height;
+    const int32_t in_row_size = input_dims->width * input_dims->channels;
+    const int32_t out_row_size = output_dims->width * output_dims->channels;
+
+    bands[0] = (row_band_t) {.out_start = 0, .out_rows = out_ht,
+                             .in_start = 0, .in_rows = in_ht, .pad_ht = padding->height};
+
+    if (num_workers < 2 || out_ht < num_workers ||
+            out_ht * out_row_size * macs_per_out < PARALLEL_MIN_MACS) {
+        return 1;
+    }
+
+    row_band_t split[ESP_NN_MAX_WORKERS];
+    for (int w = 0; w < num_workers; w++) {
+        const int32_t out_start = out_ht * w / num_workers;
+        const int32_t out_end = out_ht * (w + 1) / num_workers;
+        const int32_t first = out_start * stride->height - padding->height;
+        const int32_t last = (out_end - 1) * stride->height - padding->height + filter_dims->height;
+        const int32_t in_start = max(first, 0);
+        const int32_t in_end = min(last, in_ht);
+
+        if (in_end <= in_start) {
+            return 1;
+        }
+        /* kernels may rely on the alignment of the tensors they are given */
+        if ((in_start * in_row_size) % 16 || (out_start * out_row_size) % 16) {
+            return 1;
+        }
+        /**
+         * A band without any padding is treated as `valid` and may not check
+         * the bottom edge, whereas the full problem would have.
+         */
+        if (padding->width == 0 && padding->height != 0 &&
+                in_start == first && last > in_ht) {
+            return 1;
+        }
+        split[w] = (row_band_t) {.out_start = out_start, .out_rows = out_end - out_start,
+                                 .in_start = in_start, .in_rows = in_end - in_start,
+                                 .pad_ht = in_start - first};
+    }
+    for (int w = 0; w < num_workers; w++) {
+        bands[w] = split[w];
+    }
+    return num_workers;
+}
+
+/************************** 2d-convolution *****************************/
+
+typedef struct {
+    const data_dims_t *input_dims;
+    const int8_t *input_data;
+    const data_dims_t *filter_dims;
+    const int8_t *filter_data;
+    const int32_t *bias;
+    const data_dims_t *output_dims;
+    int8_t *out_data;
+    const conv_params_t *conv_params;
+    const quant_data_t *quant_data;
+    void *const *scratch_bufs;
+    row_band_t bands[ESP_NN_MAX_WORKERS];
+} conv_job_t;
+
+static void esp_nn_conv_s8_band(void *arg, int worker)
+{
+    const conv_job_t *job = (const conv_job_t *) arg;
+    const row_band_t *band = &job->bands[worker];
+    const int32_t in_row_size = job->input_dims->width * job->input_dims->channels;
+    const int32_t out_row_size = job->output_dims->width * job->output_dims->channels;
+
+    data_dims_t input_dims = *job->input_dims;
+    data_dims_t output_dims = *job->output_dims;
+    conv_params_t conv_params = *job->conv_params;
+    input_dims.height = band->in_rows;
+    output_dims.height = band->out_rows;
+    conv_params.padding.height = band->pad_ht;
+
+    /* scratch buffer pointers are per thread */
+    esp_nn_set_conv_scratch_buf(job->scratch_bufs[worker]);
+    esp_nn_conv_s8(&input_dims, job->input_data + band->in_start * in_row_size,
+                   job->filter_dims, job->filter_data, job->bias,
+                   &output_dims, job->out_data + band->out_start * out_row_size,
+                   &conv_params, job->quant_data);
+}
+
+int esp_nn_get_conv_scratch_size_parallel(const data_dims_t *input_dims,
+                                          const data_dims_t *filter_dims,
+                                          const data_dims_t *output_dims,
+                                          const conv_params_t *conv_params)
+{
+    row_band_t bands[ESP_NN_MAX_WORKERS];
+    const int32_t macs_per_out = filter_dims->width * filter_dims->height * input_dims->channels;
+    int num_bands = esp_nn_split_rows(input_dims, filter_dims, output_dims, &conv_params->stride,
+                                      &conv_params->padding, macs_per_out, bands);
+    int size = 0;
+    for (int w = 0; w < num_bands; w++) {
+        data_dims_t band_input_dims = *input_dims;
+        data_dims_t band_output_dims = *output_dims;
+        conv_params_t band_params = *conv_params;
+        band_input_dims.height = bands[w].in_rows;
+        band_output_dims.height = bands[w].out_rows;
+        band_params.padding.height = bands[w].pad_ht;
+        size = max(size, esp_nn_get_conv_scratch_size(&band_input_dims, filter_dims,
+                                                      &band_output_dims, &band_params));
+    }
+    return size;
+}
+
+void esp_nn_conv_s8_parallel(const data_dims_t *input_dims,
+                             const int8_t *input_data,
+                             const data_dims_t *filter_dims,
+                             const int8_t *filter_data,
+                             const int32_t *bias,
+                             const data_dims_t *output_dims,
+                             int8_t *out_data,
+                             const conv_params_t *conv_params,
+                             const quant_data_t *quant_data,
+                             void *const *scratch_bufs)
+{
+    conv_job_t job = {
+        .input_dims = input_dims, .input_data = input_data,
+        .filter_dims = filter_dims, .filter_data = filter_data, .bias = bias,
+        .output_dims = output_dims, .out_data = out_data,
+        .conv_params = conv_params, .quant_data = quant_data,
+        .scratch_bufs = scratch_bufs
+    };
+    const int32_t macs_per_out = filter_dims->width * filter_dims->height * input_dims->channels;
+    int num_bands = esp_nn_split_rows(input_dims, filter_dims, output_dims, &conv_params->stride,
+                                      &conv_params->padding, macs_per_out, job.bands);
+    esp_nn_parallel_run(esp_nn_conv_s8_band, &job, num_bands);
+}
+
+/************************** depthwise convolution *****************************/
+
+typedef struct {
+    const data_dims_t *input_dims;
+    const int8_t *input_data;
+    const data_dims_t *filter_dims;
+    const int8_t *filter_data;
+    const int32_t *bias;
+    const data_dims_t *output_dims;
+    int8_t *out_data;
+    const dw_conv_params_t *conv_params;
+    const quant_data_t *quant_data;
+    void *const *scratch_bufs;
+    row_band_t bands[ESP_NN_MAX_WORKERS];
+} dw_conv_job_t;
+
+static void esp_nn_depthwise_conv_s8_band(void *arg, int worker)
+{
+    const dw_conv_job_t *job = (const dw_conv_job_t *) arg;
+    const row_band_t *band = &job->bands[worker];
+    const int32_t in_row_size = job->input_dims->width * job->input_dims->channels;
+    const int32_t out_row_size = job->output_dims->width * job->output_dims->channels;
+
+    data_dims_t input_dims = *job->input_dims;
+    data_dims_t output_dims = *job->output_dims;
+    dw_conv_params_t conv_params = *job->conv_params;
+    input_dims.height = band->in_rows;
+    output_dims.height = band->out_rows;
+    conv_params.padding.height = band->pad_ht;
+
+    /* scratch buffer pointers are per thread */
+    esp_nn_set_depthwise_conv_scratch_buf(job->scratch_bufs[worker]);
+    esp_nn_depthwise_conv_s8(&input_dims, job->input_data + band->in_start * in_row_size,
+                             job->filter_dims, job->filter_data, job->bias,
+                             &output_dims, job->out_data + band->out_start * out_row_size,
+                             &conv_params, job->quant_data);
+}
+
+int esp_nn_get_depthwise_conv_scratch_size_parallel(const data_dims_t *input_dims,
+                                                    const data_dims_t *filter_dims,
+                                                    const data_dims_t *output_dims,
+                                                    const dw_conv_params_t *conv_params)
+{
+    row_band_t bands[ESP_NN_MAX_WORKERS];
+    const int32_t macs_per_out = filter_dims->width * filter_dims->height;
+    int num_bands = esp_nn_split_rows(input_dims, filter_dims, output_dims, &conv_params->stride,
+                                      &conv_params->padding, macs_per_out, bands);
+    int size = 0;
+    for (int w = 0; w < num_bands; w++) {
+        data_dims_t band_input_dims = *input_dims;
+        data_dims_t band_output_dims = *output_dims;
+        dw_conv_params_t band_params = *conv_params;
+        band_input_dims.height = bands[w].in_rows;
+        band_output_dims.height = bands[w].out_rows;
+        band_params.padding.height = bands[w].pad_ht;
+        size = max(size, esp_nn_get_depthwise_conv_scratch_size(&band_input_dims, filter_dims,
+                                                                &band_output_dims, &band_params));
+    }
+    return size;
+}
+
+void esp_nn_depthwise_conv_s8_parallel(const data_dims_t *input_dims,
+                                       const int8_t *input_data,
+                                       const data_dims_t *filter_dims,
+                                       const int8_t *filter_data,
+                                       const int32_t *bias,
+                                       const data_dims_t *output_dims,
+                                       int8_t *out_data,
+                                       const dw_conv_params_t *conv_params,
+                                       const quant_data_t *quant_data,
+                                       void *const *scratch_bufs)
+{
+    dw_conv_job_t job = {
+        .input_dims = input_dims, .input_data = input_data,
+        .filter_dims = filter_dims, .filter_data = filter_data, .bias = bias,
+        .output_dims = output_dims, .out_data = out_data,
+        .conv_params = conv_params, .quant_data = quant_data,
+        .scratch_bufs = scratch_bufs
+    };
+    const int32_t macs_per_out = filter_dims->width * filter_dims->height;
+    int num_bands = esp_nn_split_rows(input_dims, filter_dims, output_dims, &conv_params->stride,
+                                      &conv_params->padding, macs_per_out, job.bands);
+    esp_nn_parallel_run(esp_nn_depthwise_conv_s8_band, &job, num_bands);
+}
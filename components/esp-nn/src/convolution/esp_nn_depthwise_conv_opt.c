@@ -15,17 +15,219 @@
 #include <esp_nn_defs.h>
 #include <common_functions.h>
 
+static ESP_NN_THREAD_LOCAL int16_t *scratch_buffer = NULL;
+
+/**
+ * 3x3, ch_mult 1 layers with stride 1 or 2 take the s16 path below, which works
+ * on three input rows at a time, widened to s16 in the scratch buffer.
+ */
+static bool esp_nn_depthwise_conv_use_3x3_s16(const data_dims_t *filter_dims,
+                                              const dw_conv_params_t *conv_params)
+{
+    return (conv_params->ch_mult == 1) &&
+           (filter_dims->width == 3) && (filter_dims->height == 3) &&
+           (conv_params->stride.width == 1 || conv_params->stride.width == 2) &&
+           (conv_params->stride.height == 1 || conv_params->stride.height == 2);
+}
+
+/* input columns read by the 3x3 path, from `-pad_wd` onwards */
+static int esp_nn_depthwise_conv_3x3_row_wd(const data_dims_t *output_dims,
+                                            const dw_conv_params_t *conv_params)
+{
+    return (output_dims->width - 1) * conv_params->stride.width + 3;
+}
+
 int esp_nn_get_depthwise_conv_scratch_size_opt(const data_dims_t *input_dims,
                                                const data_dims_t *filter_dims,
                                                const data_dims_t *output_dims,
                                                const dw_conv_params_t *conv_params)
 {
+    if (esp_nn_depthwise_conv_use_3x3_s16(filter_dims, conv_params)) {
+        const int row_size = esp_nn_depthwise_conv_3x3_row_wd(output_dims, conv_params) *
+                             input_dims->channels;
+        return 3 * row_size * sizeof(int16_t);
+    }
     return 0;
 }
 
 void esp_nn_set_depthwise_conv_scratch_buf_opt(const void *buf)
 {
+    scratch_buffer = (int16_t *) buf;
+}
+
+/**
+ * Fill `dst` with input row `in_y` plus `input_offset`, for columns
+ * [-pad_wd, row_wd - pad_wd). Columns and rows outside the input are 0, which is
+ * what the padding value `-input_offset` becomes once offset.
+ */
+static void esp_nn_depthwise_conv_3x3_fill_row(const int8_t *input_data,
+                                               const uint16_t input_wd,
+                                               const uint16_t input_ht,
+                                               const uint16_t channels,
+                                               const int32_t input_offset,
+                                               const uint16_t pad_wd,
+                                               const int32_t in_y,
+                                               const int32_t row_wd,
+                                               int16_t *dst)
+{
+    if (in_y < 0 || in_y >= input_ht) {
+        memset(dst, 0, row_wd * channels * sizeof(int16_t));
+        return;
+    }
+    const int32_t left = min((int32_t) pad_wd, row_wd);
+    const int32_t copy = min((int32_t) input_wd, row_wd - left);
+    const int32_t right = row_wd - left - copy;
+
+    memset(dst, 0, left * channels * sizeof(int16_t));
+    dst += left * channels;
+    esp_nn_s8_to_s16_with_offset(input_data + in_y * input_wd * channels, dst,
+                                 copy * channels, input_offset);
+    dst += copy * channels;
+    memset(dst, 0, right * channels * sizeof(int16_t));
+}
+
+/**
+ * One output row of a single channel. Two output columns are computed per pass
+ * so that they share the filter taps kept in registers and, for stride 1, two
+ * thirds of the inputs. `stride_wd` is a constant at each call site.
+ */
+__NN_FORCE_INLINE__ void esp_nn_depthwise_conv_3x3_s16_row(const int16_t *row0,
+                                                           const int16_t *row1,
+                                                           const int16_t *row2,
+                                                           const uint16_t channels,
+                                                           const int stride_wd,
+                                                           const int8_t *filter,
+                                                           const int32_t bias,
+                                                           int8_t *out,
+                                                           const uint16_t out_wd,
+                                                           const int32_t out_offset,
+                                                           const int32_t mult,
+                                                           const int32_t shift,
+                                                           const int32_t activation_min,
+                                                           const int32_t activation_max)
+{
+    const int32_t f0 = filter[0 * channels], f1 = filter[1 * channels], f2 = filter[2 * channels];
+    const int32_t f3 = filter[3 * channels], f4 = filter[4 * channels], f5 = filter[5 * channels];
+    const int32_t f6 = filter[6 * channels], f7 = filter[7 * channels], f8 = filter[8 * channels];
+    const int32_t step = stride_wd * channels;
+    const int32_t c1 = channels, c2 = 2 * channels;
+
+    int out_x = 0;
+    for (; out_x < out_wd - 1; out_x += 2) {
+        const int16_t *p0 = row0 + out_x * step;
+        const int16_t *p1 = row1 + out_x * step;
+        const int16_t *p2 = row2 + out_x * step;
+        int32_t result0 = bias;
+        int32_t result1 = bias;
+
+        result0 += p0[0] * f0 + p0[c1] * f1 + p0[c2] * f2;
+        result0 += p1[0] * f3 + p1[c1] * f4 + p1[c2] * f5;
+        result0 += p2[0] * f6 + p2[c1] * f7 + p2[c2] * f8;
+        p0 += step;
+        p1 += step;
+        p2 += step;
+        result1 += p0[0] * f0 + p0[c1] * f1 + p0[c2] * f2;
+        result1 += p1[0] * f3 + p1[c1] * f4 + p1[c2] * f5;
+        result1 += p2[0] * f6 + p2[c1] * f7 + p2[c2] * f8;
+
+        result0 = esp_nn_multiply_by_quantized_mult_fast(result0, mult, shift);
+        result1 = esp_nn_multiply_by_quantized_mult_fast(result1, mult, shift);
+        result0 += out_offset;
+        result1 += out_offset;
+        result0 = max(result0, activation_min);
+        result1 = max(result1, activation_min);
+        result0 = min(result0, activation_max);
+        result1 = min(result1, activation_max);
+
+        out[0] = result0;
+        out[channels] = result1;
+        out += 2 * channels;
+    }
+    if (out_x < out_wd) {
+        const int16_t *p0 = row0 + out_x * step;
+        const int16_t *p1 = row1 + out_x * step;
+        const int16_t *p2 = row2 + out_x * step;
+        int32_t result = bias;
+
+        result += p0[0] * f0 + p0[c1] * f1 + p0[c2] * f2;
+        result += p1[0] * f3 + p1[c1] * f4 + p1[c2] * f5;
+        result += p2[0] * f6 + p2[c1] * f7 + p2[c2] * f8;
+        result = esp_nn_multiply_by_quantized_mult_fast(result, mult, shift);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out[0] = result;
+    }
+}
+
+/**
+ * 3x3, ch_mult 1, stride 1 or 2.
+ * Input rows are converted to s16 with the input offset applied and padded with
+ * zeros, once each, into a window of three rows in the scratch buffer. The
+ * kernel then has neither bounds checks nor offset additions left.
+ */
+__attribute__ ((noinline))
+static void esp_nn_depthwise_conv_s8_3x3_s16(const data_dims_t *input_dims,
+                                             const int8_t *input_data,
+                                             const int8_t *filter_data,
+                                             const int32_t *bias,
+                                             const data_dims_t *output_dims,
+                                             int8_t *out_data,
+                                             const dw_conv_params_t *conv_params,
+                                             const quant_data_t *quant_data)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const uint16_t stride_wd = conv_params->stride.width;
+    const uint16_t stride_ht = conv_params->stride.height;
+    const uint16_t out_wd = output_dims->width;
+    const uint16_t out_ht = output_dims->height;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    const int32_t row_wd = esp_nn_depthwise_conv_3x3_row_wd(output_dims, conv_params);
+    const int32_t row_size = row_wd * channels;
+    /* window slot `i` holds padded input row `slot_row[i]`, i.e. input row `slot_row[i] - pad_ht` */
+    int32_t slot_row[3] = {-1, -1, -1};
+
+    for (int out_y = 0; out_y < out_ht; out_y++) {
+        const int16_t *rows[3];
+        for (int k = 0; k < 3; k++) {
+            const int32_t padded_y = out_y * stride_ht + k;
+            const int slot = padded_y % 3;
+            int16_t *row = scratch_buffer + slot * row_size;
+            if (slot_row[slot] != padded_y) {
+                esp_nn_depthwise_conv_3x3_fill_row(input_data, input_wd, input_ht, channels,
+                                                   input_offset, pad_wd, padded_y - pad_ht,
+                                                   row_wd, row);
+                slot_row[slot] = padded_y;
+            }
+            rows[k] = row;
+        }
 
+        int8_t *out_row = out_data + out_y * out_wd * channels;
+        for (int ch_idx = 0; ch_idx < channels; ch_idx++) {
+            const int32_t ch_bias = bias ? bias[ch_idx] : 0;
+            if (stride_wd == 1) {
+                esp_nn_depthwise_conv_3x3_s16_row(rows[0] + ch_idx, rows[1] + ch_idx, rows[2] + ch_idx,
+                                                  channels, 1, filter_data + ch_idx, ch_bias,
+                                                  out_row + ch_idx, out_wd, out_offset,
+                                                  quant_data->mult[ch_idx], quant_data->shift[ch_idx],
+                                                  activation_min, activation_max);
+            } else {
+                esp_nn_depthwise_conv_3x3_s16_row(rows[0] + ch_idx, rows[1] + ch_idx, rows[2] + ch_idx,
+                                                  channels, 2, filter_data + ch_idx, ch_bias,
+                                                  out_row + ch_idx, out_wd, out_offset,
+                                                  quant_data->mult[ch_idx], quant_data->shift[ch_idx],
+                                                  activation_min, activation_max);
+            }
+        }
+    }
 }
 
 /* common channel multiplier == 1 case */
@@ -168,6 +370,11 @@ void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
                                   const quant_data_t *quant_data)
 {
     const uint16_t ch_mult = conv_params->ch_mult;
+    if (scratch_buffer != NULL && esp_nn_depthwise_conv_use_3x3_s16(filter_dims, conv_params)) {
+        esp_nn_depthwise_conv_s8_3x3_s16(input_dims, input_data, filter_data, bias,
+                                         output_dims, out_data, conv_params, quant_data);
+        return;
+    }
     if (ch_mult == 1) {
         esp_nn_depthwise_conv_s8_ch_mult_1(input_dims, input_data, filter_dims, filter_data,
                                            bias, output_dims, out_data, conv_params, quant_data);
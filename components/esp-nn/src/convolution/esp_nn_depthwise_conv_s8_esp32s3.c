@@ -17,7 +17,7 @@
 
 #include <common_functions.h>
 
-static int16_t *scratch_buffer = NULL;
+static ESP_NN_THREAD_LOCAL int16_t *scratch_buffer = NULL;
 
 extern void esp_nn_depthwise_conv_s16_mult8_3x3_esp32s3(const int16_t *input_data,
                                                         const uint16_t input_wd,
@@ -375,7 +375,8 @@ int esp_nn_get_depthwise_conv_scratch_size_esp32s3(const data_dims_t *input_dims
     int pad_width = 0, pad_height = 0;
 
     if ((ch_mult == 1) && (channels % 8 == 0) && (filter_wd == 3) && (filter_ht == 3)) {
-        if (channels % 16 == 0) {
+        /* 8 bit paths are only taken for pad (1, 1) and (0, 0), see below */
+        if ((channels % 16 == 0) && (pad_wd == pad_ht) && (pad_wd <= 1)) {
             if (pad_wd || pad_ht) {
                 pad_width = pad_wd * 2;
                 pad_height = pad_ht * 2;
@@ -0,0 +1,280 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn_defs.h>
+
+#include <common_functions.h>
+
+/**
+ * Same gather as the ansi version, see esp_nn_transpose_conv_ansi.c. Four output
+ * channels are accumulated at a time, so each offset input value is loaded once
+ * for four filter rows. The sums are exact, the result is the one of the ansi
+ * version.
+ */
+
+/* Filter taps of one output coordinate for stride 2 and a filter of 2 or 3 */
+#define TCONV_S2_MAX_TAPS 2
+
+__NN_FORCE_INLINE__ void esp_nn_tconv_tap_x4(const int8_t *input,
+                                             const int8_t *filter,
+                                             const int32_t filter_size,
+                                             const uint16_t in_channels,
+                                             const int32_t input_offset,
+                                             int32_t *acc)
+{
+    const int8_t *filter0 = filter;
+    const int8_t *filter1 = filter0 + filter_size;
+    const int8_t *filter2 = filter1 + filter_size;
+    const int8_t *filter3 = filter2 + filter_size;
+    int32_t acc0 = acc[0], acc1 = acc[1], acc2 = acc[2], acc3 = acc[3];
+    for (int32_t in_ch_idx = 0; in_ch_idx < in_channels; in_ch_idx++) {
+        const int32_t in_val = input[in_ch_idx] + input_offset;
+        acc0 += in_val * filter0[in_ch_idx];
+        acc1 += in_val * filter1[in_ch_idx];
+        acc2 += in_val * filter2[in_ch_idx];
+        acc3 += in_val * filter3[in_ch_idx];
+    }
+    acc[0] = acc0;
+    acc[1] = acc1;
+    acc[2] = acc2;
+    acc[3] = acc3;
+}
+
+__NN_FORCE_INLINE__ int32_t esp_nn_tconv_tap(const int8_t *input,
+                                             const int8_t *filter,
+                                             const uint16_t in_channels,
+                                             const int32_t input_offset)
+{
+    int32_t acc = 0;
+    for (int32_t in_ch_idx = 0; in_ch_idx < in_channels; in_ch_idx++) {
+        acc += (input[in_ch_idx] + input_offset) * filter[in_ch_idx];
+    }
+    return acc;
+}
+
+__NN_FORCE_INLINE__ int8_t esp_nn_tconv_requant(int32_t acc,
+                                                const int32_t mult,
+                                                const int32_t shift,
+                                                const int32_t out_offset,
+                                                const int32_t activation_min,
+                                                const int32_t activation_max)
+{
+    acc = esp_nn_multiply_by_quantized_mult(acc, mult, shift);
+    acc += out_offset;
+    acc = max(acc, activation_min);
+    acc = min(acc, activation_max);
+    return (int8_t) acc;
+}
+
+/* Taps of one output coordinate, from its parity: filter and input indices */
+__NN_FORCE_INLINE__ int32_t esp_nn_tconv_s2_taps(const int32_t base,
+                                                 const uint16_t filter_len,
+                                                 const uint16_t input_len,
+                                                 int32_t *filter_idx,
+                                                 int32_t *input_idx)
+{
+    int32_t n_taps = 0;
+    for (int32_t filter = base & 1; filter < filter_len; filter += 2) {
+        const int32_t in = (base - filter) >> 1;
+        if (in >= 0 && in < input_len) {
+            filter_idx[n_taps] = filter;
+            input_idx[n_taps] = in;
+            n_taps++;
+        }
+    }
+    return n_taps;
+}
+
+/**
+ * Stride 2 with a 2x2 or 3x3 filter, the decoder upsampling layers: every output
+ * pixel has at most two taps per dimension, picked from the parity of its
+ * coordinates without divisions. The taps of a pixel are listed once and
+ * shared by all output channels.
+ */
+static void esp_nn_transpose_conv_s8_s2_opt(const data_dims_t *input_dims,
+                                            const int8_t *input_data,
+                                            const data_dims_t *filter_dims,
+                                            const int8_t *filter_data,
+                                            const int32_t *bias,
+                                            const data_dims_t *output_dims,
+                                            int8_t *out_data,
+                                            const conv_params_t *conv_params,
+                                            const quant_data_t *quant_data)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t in_channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t out_wd = output_dims->width;
+    const uint16_t out_ht = output_dims->height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+    const int32_t filter_size = filter_wd * filter_ht * in_channels;
+
+    int32_t filter_y[TCONV_S2_MAX_TAPS], in_row[TCONV_S2_MAX_TAPS];
+    int32_t filter_x[TCONV_S2_MAX_TAPS], in_col[TCONV_S2_MAX_TAPS];
+    const int8_t *tap_input[TCONV_S2_MAX_TAPS * TCONV_S2_MAX_TAPS];
+    int32_t tap_filter[TCONV_S2_MAX_TAPS * TCONV_S2_MAX_TAPS];
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t taps_y = esp_nn_tconv_s2_taps(out_y + pad_ht, filter_ht, input_ht, filter_y, in_row);
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t taps_x = esp_nn_tconv_s2_taps(out_x + pad_wd, filter_wd, input_wd, filter_x, in_col);
+            int32_t n_taps = 0;
+            for (int32_t i = 0; i < taps_y; i++) {
+                for (int32_t j = 0; j < taps_x; j++) {
+                    tap_input[n_taps] = input_data + (in_row[i] * input_wd + in_col[j]) * in_channels;
+                    tap_filter[n_taps] = (filter_y[i] * filter_wd + filter_x[j]) * in_channels;
+                    n_taps++;
+                }
+            }
+
+            int32_t out_ch_idx = 0;
+            for (; out_ch_idx + 3 < out_channels; out_ch_idx += 4) {
+                int32_t acc[4] = {0, 0, 0, 0};
+                if (bias) {
+                    acc[0] = bias[out_ch_idx];
+                    acc[1] = bias[out_ch_idx + 1];
+                    acc[2] = bias[out_ch_idx + 2];
+                    acc[3] = bias[out_ch_idx + 3];
+                }
+                const int8_t *filter = filter_data + out_ch_idx * filter_size;
+                for (int32_t tap = 0; tap < n_taps; tap++) {
+                    esp_nn_tconv_tap_x4(tap_input[tap], filter + tap_filter[tap], filter_size,
+                                        in_channels, input_offset, acc);
+                }
+                for (int32_t i = 0; i < 4; i++) {
+                    *out_data++ = esp_nn_tconv_requant(acc[i], out_mult[out_ch_idx + i],
+                                                       out_shift[out_ch_idx + i], out_offset,
+                                                       activation_min, activation_max);
+                }
+            }
+            for (; out_ch_idx < out_channels; out_ch_idx++) {
+                int32_t acc = bias ? bias[out_ch_idx] : 0;
+                const int8_t *filter = filter_data + out_ch_idx * filter_size;
+                for (int32_t tap = 0; tap < n_taps; tap++) {
+                    acc += esp_nn_tconv_tap(tap_input[tap], filter + tap_filter[tap],
+                                            in_channels, input_offset);
+                }
+                *out_data++ = esp_nn_tconv_requant(acc, out_mult[out_ch_idx], out_shift[out_ch_idx],
+                                                   out_offset, activation_min, activation_max);
+            }
+        }
+    }
+}
+
+void esp_nn_transpose_conv_s8_opt(const data_dims_t *input_dims,
+                                  const int8_t *input_data,
+                                  const data_dims_t *filter_dims,
+                                  const int8_t *filter_data,
+                                  const int32_t *bias,
+                                  const data_dims_t *output_dims,
+                                  int8_t *out_data,
+                                  const conv_params_t *conv_params,
+                                  const quant_data_t *quant_data)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t in_channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const uint16_t stride_wd = conv_params->stride.width;
+    const uint16_t stride_ht = conv_params->stride.height;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t out_wd = output_dims->width;
+    const uint16_t out_ht = output_dims->height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+    const int32_t filter_size = filter_wd * filter_ht * in_channels;
+
+    if (stride_wd == 2 && stride_ht == 2 &&
+            filter_wd >= 2 && filter_wd <= 3 && filter_ht >= 2 && filter_ht <= 3) {
+        esp_nn_transpose_conv_s8_s2_opt(input_dims, input_data, filter_dims, filter_data, bias,
+                                        output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t base_y = out_y + pad_ht;
+        /* Filter rows of this output row whose input row is inside the input */
+        const int32_t filter_y_start = base_y % stride_ht +
+                max(0, (base_y / stride_ht - input_ht + 1) * stride_ht);
+        const int32_t filter_y_end = min(filter_ht, base_y + 1);
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t base_x = out_x + pad_wd;
+            const int32_t filter_x_start = base_x % stride_wd +
+                    max(0, (base_x / stride_wd - input_wd + 1) * stride_wd);
+            const int32_t filter_x_end = min(filter_wd, base_x + 1);
+
+            int32_t out_ch_idx = 0;
+            for (; out_ch_idx + 3 < out_channels; out_ch_idx += 4) {
+                int32_t acc[4] = {0, 0, 0, 0};
+                if (bias) {
+                    acc[0] = bias[out_ch_idx];
+                    acc[1] = bias[out_ch_idx + 1];
+                    acc[2] = bias[out_ch_idx + 2];
+                    acc[3] = bias[out_ch_idx + 3];
+                }
+                const int8_t *filter = filter_data + out_ch_idx * filter_size;
+                for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end;
+                        filter_y_idx += stride_ht) {
+                    const int32_t in_row = (base_y - filter_y_idx) / stride_ht;
+                    for (int32_t filter_x_idx = filter_x_start; filter_x_idx < filter_x_end;
+                            filter_x_idx += stride_wd) {
+                        const int32_t in_col = (base_x - filter_x_idx) / stride_wd;
+                        esp_nn_tconv_tap_x4(input_data + (in_row * input_wd + in_col) * in_channels,
+                                            filter + (filter_y_idx * filter_wd + filter_x_idx) * in_channels,
+                                            filter_size, in_channels, input_offset, acc);
+                    }
+                }
+                for (int32_t i = 0; i < 4; i++) {
+                    *out_data++ = esp_nn_tconv_requant(acc[i], out_mult[out_ch_idx + i],
+                                                       out_shift[out_ch_idx + i], out_offset,
+                                                       activation_min, activation_max);
+                }
+            }
+            for (; out_ch_idx < out_channels; out_ch_idx++) {
+                int32_t acc = bias ? bias[out_ch_idx] : 0;
+                const int8_t *filter = filter_data + out_ch_idx * filter_size;
+                for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end;
+                        filter_y_idx += stride_ht) {
+                    const int32_t in_row = (base_y - filter_y_idx) / stride_ht;
+                    for (int32_t filter_x_idx = filter_x_start; filter_x_idx < filter_x_end;
+                            filter_x_idx += stride_wd) {
+                        const int32_t in_col = (base_x - filter_x_idx) / stride_wd;
+                        acc += esp_nn_tconv_tap(input_data + (in_row * input_wd + in_col) * in_channels,
+                                                filter + (filter_y_idx * filter_wd + filter_x_idx) * in_channels,
+                                                in_channels, input_offset);
+                    }
+                }
+                *out_data++ = esp_nn_tconv_requant(acc, out_mult[out_ch_idx], out_shift[out_ch_idx],
+                                                   out_offset, activation_min, activation_max);
+            }
+        }
+    }
+}
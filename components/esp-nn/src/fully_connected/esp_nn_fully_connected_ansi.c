@@ -48,3 +48,26 @@ void esp_nn_fully_connected_s8_ansi(const int8_t *input_data,
         out_data[out_c] = (int8_t) result;
     }
 }
+
+void esp_nn_fully_connected_s8_acc_s16_ansi(const int8_t *input_data,
+                                            const uint16_t row_len,
+                                            const int8_t *filter_data,
+                                            const int32_t *bias,
+                                            int16_t *out_data,
+                                            const uint16_t out_channels,
+                                            const int32_t out_shift,
+                                            const int32_t out_mult)
+{
+    for (int32_t out_c = 0; out_c < out_channels; ++out_c) {
+        int32_t result = bias[out_c];
+        for (int32_t data_idx = 0; data_idx < row_len; data_idx++) {
+            int32_t filter_index = row_len * out_c + data_idx;
+            result += filter_data[filter_index] * input_data[data_idx];
+        }
+        result = esp_nn_multiply_by_quantized_mult(result, out_mult, out_shift);
+        result += out_data[out_c];
+        result = max(result, INT16_MIN);
+        result = min(result, INT16_MAX);
+        out_data[out_c] = (int16_t) result;
+    }
+}
@@ -62,6 +62,10 @@ void app_main()
     printf("depthwise, c %u opt %u\n", total_c, total_opt);
     esp_nn_conv_s8_test();
     printf("conv2d, c %u opt %u\n", total_c, total_opt);
+    esp_nn_transpose_conv_s8_test();
+    printf("transpose_conv2d, c %u opt %u\n", total_c, total_opt);
+    esp_nn_depthwise_conv_s8_parallel_test();
+    esp_nn_conv_s8_parallel_test();
 
     esp_nn_relu6_s8_test();
     printf("relu, c %u opt %u\n", total_c, total_opt);
@@ -71,6 +75,8 @@ void app_main()
     printf("max_pool, c %u opt %u\n", total_c, total_opt);
     esp_nn_fully_connected_s8_test();
     printf("fully_connected, c %u opt %u\n", total_c, total_opt);
+    esp_nn_fully_connected_s8_acc_s16_test();
+    printf("fully_connected_acc_s16, c %u opt %u\n", total_c, total_opt);
     esp_nn_softmax_s8_test();
     printf("softmax, c %u opt %u\n", total_c, total_opt);
     ESP_LOGI(TAG, "s8 tests done!\n");
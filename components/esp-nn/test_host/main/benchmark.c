@@ -0,0 +1,431 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file        Host benchmark for esp-nn kernels
+ *
+ *              Runs every kernel variant (ANSI C and generic optimised) over a
+ *              matrix of shapes, checks the variants agree with the ANSI C
+ *              output and reports cycles per call and MACs per second.
+ *
+ *              usage: esp_nn_host_bench [-n iterations] [-k conv|dwconv|fc] [-c]
+ *                  -n  timed calls per shape (default 20)
+ *                  -k  run a single kernel family
+ *                  -c  CSV output
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_nn.h>
+#include "host_cycles.h"
+
+typedef void (*conv_fn_t)(const data_dims_t *, const int8_t *, const data_dims_t *, const int8_t *,
+                          const int32_t *, const data_dims_t *, int8_t *,
+                          const conv_params_t *, const quant_data_t *);
+typedef int (*conv_scratch_size_fn_t)(const data_dims_t *, const data_dims_t *,
+                                      const data_dims_t *, const conv_params_t *);
+typedef void (*conv_set_scratch_fn_t)(const void *);
+
+typedef void (*dw_conv_fn_t)(const data_dims_t *, const int8_t *, const data_dims_t *, const int8_t *,
+                             const int32_t *, const data_dims_t *, int8_t *,
+                             const dw_conv_params_t *, const quant_data_t *);
+typedef int (*dw_conv_scratch_size_fn_t)(const data_dims_t *, const data_dims_t *,
+                                         const data_dims_t *, const dw_conv_params_t *);
+
+typedef void (*fc_fn_t)(const int8_t *, const int32_t, const uint16_t, const int8_t *, const int32_t,
+                        const int32_t *, int8_t *, const uint16_t, const int32_t,
+                        const int32_t, const int32_t, const int32_t, const int32_t);
+
+typedef struct {
+    const char *name;
+    conv_fn_t run;
+    conv_scratch_size_fn_t scratch_size;
+    conv_set_scratch_fn_t set_scratch;
+} conv_variant_t;
+
+typedef struct {
+    const char *name;
+    dw_conv_fn_t run;
+    dw_conv_scratch_size_fn_t scratch_size;
+    conv_set_scratch_fn_t set_scratch;
+} dw_conv_variant_t;
+
+typedef struct {
+    const char *name;
+    fc_fn_t run;
+} fc_variant_t;
+
+/* first entry of every table is the reference the others are checked against */
+static const conv_variant_t conv_variants[] = {
+    {"ansi", esp_nn_conv_s8_ansi, esp_nn_get_conv_scratch_size_ansi, esp_nn_set_conv_scratch_buf_ansi},
+    {"opt", esp_nn_conv_s8_opt, esp_nn_get_conv_scratch_size_opt, esp_nn_set_conv_scratch_buf_opt},
+};
+
+static const dw_conv_variant_t dw_conv_variants[] = {
+    {"ansi", esp_nn_depthwise_conv_s8_ansi, esp_nn_get_depthwise_conv_scratch_size_ansi,
+     esp_nn_set_depthwise_conv_scratch_buf_ansi},
+    {"opt", esp_nn_depthwise_conv_s8_opt, esp_nn_get_depthwise_conv_scratch_size_opt,
+     esp_nn_set_depthwise_conv_scratch_buf_opt},
+};
+
+static const fc_variant_t fc_variants[] = {
+    {"ansi", esp_nn_fully_connected_s8_ansi},
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define MAX_VARIANTS 4
+
+static int iterations = 20;
+static bool csv;
+static int mismatches;
+
+static void *alloc_aligned(size_t size)
+{
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, 16, size ? size : 16) != 0) {
+        return NULL;
+    }
+    return ptr;
+}
+
+static void fill_s8(int8_t *buf, int size)
+{
+    for (int i = 0; i < size; i++) {
+        buf[i] = rand() % 256 - 128;
+    }
+}
+
+static void fill_quant(int32_t *bias, int32_t *shift, int32_t *mult, int channels)
+{
+    for (int i = 0; i < channels; i++) {
+        bias[i] = rand() % UINT16_MAX - INT16_MAX;
+        shift[i] = -9 + rand() % 3;
+        mult[i] = 0x7f67f4f8 + rand() % 50;
+    }
+}
+
+static void print_header(void)
+{
+    if (csv) {
+        printf("kernel,variant,shape,macs,cycles,ns,mmacs_per_s,speedup\n");
+    } else {
+        printf("%-7s %-6s %-44s %12s %12s %10s %8s\n",
+               "kernel", "variant", "shape", "MACs", "cycles", "MMAC/s", "speedup");
+    }
+}
+
+static void report(const char *kernel, const char *variant, const char *shape,
+                   uint64_t macs, uint64_t cycles, uint64_t ns, double speedup)
+{
+    double mmacs = ns ? (double) macs * 1000.0 / (double) ns : 0.0;
+    if (csv) {
+        printf("%s,%s,\"%s\",%llu,%llu,%llu,%.1f,%.2f\n", kernel, variant, shape,
+               (unsigned long long) macs, (unsigned long long) cycles,
+               (unsigned long long) ns, mmacs, speedup);
+    } else {
+        printf("%-7s %-6s %-44s %12llu %12llu %10.1f %7.2fx\n", kernel, variant, shape,
+               (unsigned long long) macs, (unsigned long long) cycles, mmacs, speedup);
+    }
+}
+
+static void check_equal(const char *kernel, const char *variant, const char *shape,
+                        const int8_t *ref, const int8_t *out, int size)
+{
+    if (memcmp(ref, out, size) != 0) {
+        printf("MISMATCH %s/%s %s\n", kernel, variant, shape);
+        mismatches++;
+    }
+}
+
+static void bench_conv(int in_wd, int in_ht, int in_ch, int out_ch, int filter_wd, int filter_ht,
+                       int stride, int pad)
+{
+    int out_wd = (in_wd + 2 * pad - filter_wd) / stride + 1;
+    int out_ht = (in_ht + 2 * pad - filter_ht) / stride + 1;
+    int in_size = in_wd * in_ht * in_ch;
+    int out_size = out_wd * out_ht * out_ch;
+    int filter_size = filter_wd * filter_ht * in_ch * out_ch;
+    uint64_t macs = (uint64_t) out_size * filter_wd * filter_ht * in_ch;
+
+    int8_t *input = alloc_aligned(in_size);
+    int8_t *filter = alloc_aligned(filter_size);
+    int32_t *bias = alloc_aligned(out_ch * sizeof(int32_t));
+    int32_t *shift = alloc_aligned(out_ch * sizeof(int32_t));
+    int32_t *mult = alloc_aligned(out_ch * sizeof(int32_t));
+    int8_t *out[MAX_VARIANTS] = {NULL};
+    for (size_t v = 0; v < ARRAY_SIZE(conv_variants); v++) {
+        out[v] = alloc_aligned(out_size);
+    }
+    fill_s8(input, in_size);
+    fill_s8(filter, filter_size);
+    fill_quant(bias, shift, mult, out_ch);
+
+    data_dims_t input_dims = {.width = in_wd, .height = in_ht, .channels = in_ch, 1};
+    data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_ch, 1};
+    data_dims_t filter_dims = {.width = filter_wd, .height = filter_ht, 0, 0};
+    conv_params_t params = {.in_offset = 5, .out_offset = 3,
+                            .stride = {stride, stride}, .padding = {pad, pad},
+                            .dilation = {0, 0}, .activation = {-128, 127}};
+    quant_data_t quant = {.shift = shift, .mult = mult};
+
+    char shape[64];
+    snprintf(shape, sizeof(shape), "in %dx%dx%d out_ch %d f %dx%d s %d p %d",
+             in_wd, in_ht, in_ch, out_ch, filter_wd, filter_ht, stride, pad);
+
+    uint64_t ref_ns = 0;
+    for (size_t v = 0; v < ARRAY_SIZE(conv_variants); v++) {
+        const conv_variant_t *var = &conv_variants[v];
+        int scratch_size = var->scratch_size(&input_dims, &filter_dims, &output_dims, &params);
+        void *scratch = scratch_size > 0 ? alloc_aligned(scratch_size) : NULL;
+        var->set_scratch(scratch);
+
+        /* warm up caches, then time */
+        var->run(&input_dims, input, &filter_dims, filter, bias, &output_dims, out[v], &params, &quant);
+        uint64_t ns = host_time_ns();
+        uint64_t cycles = host_cycles();
+        for (int i = 0; i < iterations; i++) {
+            var->run(&input_dims, input, &filter_dims, filter, bias, &output_dims, out[v], &params, &quant);
+        }
+        cycles = (host_cycles() - cycles) / iterations;
+        ns = (host_time_ns() - ns) / iterations;
+        if (v == 0) {
+            ref_ns = ns;
+        } else {
+            check_equal("conv", var->name, shape, out[0], out[v], out_size);
+        }
+        report("conv", var->name, shape, macs, cycles, ns, ns ? (double) ref_ns / ns : 0.0);
+        var->set_scratch(NULL);
+        free(scratch);
+    }
+
+    for (size_t v = 0; v < ARRAY_SIZE(conv_variants); v++) {
+        free(out[v]);
+    }
+    free(input);
+    free(filter);
+    free(bias);
+    free(shift);
+    free(mult);
+}
+
+static void bench_dw_conv(int in_wd, int in_ht, int channels, int ch_mult, int filter_wd, int filter_ht,
+                          int stride, int pad)
+{
+    int out_ch = channels * ch_mult;
+    int out_wd = (in_wd + 2 * pad - filter_wd) / stride + 1;
+    int out_ht = (in_ht + 2 * pad - filter_ht) / stride + 1;
+    int in_size = in_wd * in_ht * channels;
+    int out_size = out_wd * out_ht * out_ch;
+    int filter_size = filter_wd * filter_ht * out_ch;
+    uint64_t macs = (uint64_t) out_size * filter_wd * filter_ht;
+
+    int8_t *input = alloc_aligned(in_size);
+    int8_t *filter = alloc_aligned(filter_size);
+    int32_t *bias = alloc_aligned(out_ch * sizeof(int32_t));
+    int32_t *shift = alloc_aligned(out_ch * sizeof(int32_t));
+    int32_t *mult = alloc_aligned(out_ch * sizeof(int32_t));
+    int8_t *out[MAX_VARIANTS] = {NULL};
+    for (size_t v = 0; v < ARRAY_SIZE(dw_conv_variants); v++) {
+        out[v] = alloc_aligned(out_size);
+    }
+    fill_s8(input, in_size);
+    fill_s8(filter, filter_size);
+    fill_quant(bias, shift, mult, out_ch);
+
+    data_dims_t input_dims = {.width = in_wd, .height = in_ht, .channels = channels, 1};
+    data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_ch, 1};
+    data_dims_t filter_dims = {.width = filter_wd, .height = filter_ht, 0, 0};
+    dw_conv_params_t params = {.in_offset = 5, .out_offset = 7, .ch_mult = ch_mult,
+                               .stride = {stride, stride}, .padding = {pad, pad},
+                               .dilation = {0, 0}, .activation = {-128, 127}};
+    quant_data_t quant = {.shift = shift, .mult = mult};
+
+    char shape[64];
+    snprintf(shape, sizeof(shape), "in %dx%dx%d mult %d f %dx%d s %d p %d",
+             in_wd, in_ht, channels, ch_mult, filter_wd, filter_ht, stride, pad);
+
+    uint64_t ref_ns = 0;
+    for (size_t v = 0; v < ARRAY_SIZE(dw_conv_variants); v++) {
+        const dw_conv_variant_t *var = &dw_conv_variants[v];
+        int scratch_size = var->scratch_size(&input_dims, &filter_dims, &output_dims, &params);
+        void *scratch = scratch_size > 0 ? alloc_aligned(scratch_size) : NULL;
+        var->set_scratch(scratch);
+
+        var->run(&input_dims, input, &filter_dims, filter, bias, &output_dims, out[v], &params, &quant);
+        uint64_t ns = host_time_ns();
+        uint64_t cycles = host_cycles();
+        for (int i = 0; i < iterations; i++) {
+            var->run(&input_dims, input, &filter_dims, filter, bias, &output_dims, out[v], &params, &quant);
+        }
+        cycles = (host_cycles() - cycles) / iterations;
+        ns = (host_time_ns() - ns) / iterations;
+        if (v == 0) {
+            ref_ns = ns;
+        } else {
+            check_equal("dwconv", var->name, shape, out[0], out[v], out_size);
+        }
+        report("dwconv", var->name, shape, macs, cycles, ns, ns ? (double) ref_ns / ns : 0.0);
+        var->set_scratch(NULL);
+        free(scratch);
+    }
+
+    for (size_t v = 0; v < ARRAY_SIZE(dw_conv_variants); v++) {
+        free(out[v]);
+    }
+    free(input);
+    free(filter);
+    free(bias);
+    free(shift);
+    free(mult);
+}
+
+static void bench_fc(int row_len, int out_ch)
+{
+    int8_t *input = alloc_aligned(row_len);
+    int8_t *filter = alloc_aligned(row_len * out_ch);
+    int32_t *bias = alloc_aligned(out_ch * sizeof(int32_t));
+    int8_t *out[MAX_VARIANTS] = {NULL};
+    for (size_t v = 0; v < ARRAY_SIZE(fc_variants); v++) {
+        out[v] = alloc_aligned(out_ch);
+    }
+    fill_s8(input, row_len);
+    fill_s8(filter, row_len * out_ch);
+    for (int i = 0; i < out_ch; i++) {
+        bias[i] = rand() % UINT16_MAX - INT16_MAX;
+    }
+
+    char shape[64];
+    snprintf(shape, sizeof(shape), "len %d out_ch %d", row_len, out_ch);
+    uint64_t macs = (uint64_t) row_len * out_ch;
+
+    uint64_t ref_ns = 0;
+    for (size_t v = 0; v < ARRAY_SIZE(fc_variants); v++) {
+        const fc_variant_t *var = &fc_variants[v];
+        var->run(input, 5, row_len, filter, 0, bias, out[v], out_ch, 3, -9, 0x7f67f4f8, -128, 127);
+        uint64_t ns = host_time_ns();
+        uint64_t cycles = host_cycles();
+        for (int i = 0; i < iterations; i++) {
+            var->run(input, 5, row_len, filter, 0, bias, out[v], out_ch, 3, -9, 0x7f67f4f8, -128, 127);
+        }
+        cycles = (host_cycles() - cycles) / iterations;
+        ns = (host_time_ns() - ns) / iterations;
+        if (v == 0) {
+            ref_ns = ns;
+        } else {
+            check_equal("fc", var->name, shape, out[0], out[v], out_ch);
+        }
+        report("fc", var->name, shape, macs, cycles, ns, ns ? (double) ref_ns / ns : 0.0);
+    }
+
+    for (size_t v = 0; v < ARRAY_SIZE(fc_variants); v++) {
+        free(out[v]);
+    }
+    free(input);
+    free(filter);
+    free(bias);
+}
+
+static void run_conv_matrix(void)
+{
+    static const int in_chs[] = {3, 16, 32};
+    static const int out_chs[] = {16, 64};
+    static const int filters[] = {1, 3};
+    static const int strides[] = {1, 2};
+
+    for (size_t i = 0; i < ARRAY_SIZE(in_chs); i++) {
+        for (size_t o = 0; o < ARRAY_SIZE(out_chs); o++) {
+            for (size_t f = 0; f < ARRAY_SIZE(filters); f++) {
+                for (size_t s = 0; s < ARRAY_SIZE(strides); s++) {
+                    for (int pad = 0; pad <= filters[f] / 2; pad++) {
+                        bench_conv(24, 24, in_chs[i], out_chs[o], filters[f], filters[f], strides[s], pad);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void run_dw_conv_matrix(void)
+{
+    static const int channels[] = {8, 16, 32, 64};
+    static const int ch_mults[] = {1, 4};
+    static const int filters[] = {3, 5};
+    static const int strides[] = {1, 2};
+
+    for (size_t c = 0; c < ARRAY_SIZE(channels); c++) {
+        for (size_t m = 0; m < ARRAY_SIZE(ch_mults); m++) {
+            for (size_t f = 0; f < ARRAY_SIZE(filters); f++) {
+                for (size_t s = 0; s < ARRAY_SIZE(strides); s++) {
+                    for (int pad = 0; pad <= 1; pad++) {
+                        bench_dw_conv(24, 24, channels[c], ch_mults[m], filters[f], filters[f],
+                                      strides[s], pad);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void run_fc_matrix(void)
+{
+    static const int row_lens[] = {64, 256, 1024};
+    static const int out_chs[] = {2, 16, 64};
+
+    for (size_t r = 0; r < ARRAY_SIZE(row_lens); r++) {
+        for (size_t o = 0; o < ARRAY_SIZE(out_chs); o++) {
+            bench_fc(row_lens[r], out_chs[o]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *kernel = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            kernel = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0) {
+            csv = true;
+        } else {
+            printf("usage: %s [-n iterations] [-k conv|dwconv|fc] [-c]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    srand(1);
+
+    print_header();
+    if (kernel == NULL || strcmp(kernel, "conv") == 0) {
+        run_conv_matrix();
+    }
+    if (kernel == NULL || strcmp(kernel, "dwconv") == 0) {
+        run_dw_conv_matrix();
+    }
+    if (kernel == NULL || strcmp(kernel, "fc") == 0) {
+        run_fc_matrix();
+    }
+
+    if (mismatches) {
+        printf("%d variant(s) differ from the ANSI C reference\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
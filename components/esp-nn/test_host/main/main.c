@@ -0,0 +1,82 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <test_functions.h>
+#include "host_cycles.h"
+
+static uint64_t start_c, start_opt, total_c, total_opt;
+
+void profile_c_start()
+{
+    /* initiate profiling */
+    start_c = host_cycles();
+}
+
+void profile_c_end()
+{
+    /* record profile number */
+    total_c = host_cycles() - start_c;
+}
+
+void profile_opt_start()
+{
+    /* initiate profiling */
+    start_opt = host_cycles();
+}
+
+void profile_opt_end()
+{
+    /* record profile number */
+    total_opt = host_cycles() - start_opt;
+}
+
+int main(int argc, char *argv[])
+{
+    /* fixed seed keeps the random test vectors reproducible between runs */
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+
+    /* s8 tests */
+    printf("Running s8 tests...\n");
+    esp_nn_add_elementwise_s8_test();
+    printf("add, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_mul_elementwise_s8_test();
+    printf("mul, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_depthwise_conv_s8_test();
+    printf("depthwise, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_conv_s8_test();
+    printf("conv2d, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_transpose_conv_s8_test();
+    printf("transpose_conv2d, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_depthwise_conv_s8_parallel_test();
+    esp_nn_conv_s8_parallel_test();
+
+    esp_nn_relu6_s8_test();
+    printf("relu, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_avg_pool_s8_test();
+    printf("avg_pool, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_max_pool_s8_test();
+    printf("max_pool, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_fully_connected_s8_test();
+    printf("fully_connected, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_fully_connected_s8_acc_s16_test();
+    printf("fully_connected_acc_s16, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    esp_nn_softmax_s8_test();
+    printf("softmax, c %llu opt %llu\n", (unsigned long long) total_c, (unsigned long long) total_opt);
+    printf("s8 tests done!\n");
+    return 0;
+}
@@ -19,11 +19,16 @@ void esp_nn_mul_elementwise_s8_test();
 
 void esp_nn_depthwise_conv_s8_test();
 void esp_nn_conv_s8_test();
+void esp_nn_transpose_conv_s8_test();
+
+void esp_nn_depthwise_conv_s8_parallel_test();
+void esp_nn_conv_s8_parallel_test();
 
 void esp_nn_avg_pool_s8_test();
 void esp_nn_max_pool_s8_test();
 
 void esp_nn_fully_connected_s8_test();
+void esp_nn_fully_connected_s8_acc_s16_test();
 
 void esp_nn_relu6_s8_test();
 
@@ -45,8 +45,8 @@ void esp_nn_depthwise_conv_s8_test()
     uint16_t filter_ht, filter_wd, ch_mult;
     uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
 
-    // run for 15 iterations
-    for (int itr = 0; itr < 15; itr++) {
+    // run for 17 iterations
+    for (int itr = 0; itr < 17; itr++) {
         /* prepare data */
         switch (itr) {
         case 0: // (ch_mult 1, (channels % 16) = 0), filter (3,3), pad (0,0)
@@ -169,6 +169,30 @@ void esp_nn_depthwise_conv_s8_test()
             stride_wd = 2;
             stride_ht = 2;
             break;
+        case 10: // (ch_mult 1, odd channels), filter (3,3), pad (1,1), stride (2,2)
+            input_wd = 11;
+            input_ht = 9;
+            filter_ht = 3;
+            filter_wd = 3;
+            ch_mult = 1;
+            channels = 3;
+            pad_wd = 1;
+            pad_ht = 1;
+            stride_wd = 2;
+            stride_ht = 2;
+            break;
+        case 11: // (ch_mult 1, (channels % 8) = 0), filter (3,3), pad (1,1), large
+            input_wd = 48;
+            input_ht = 48;
+            filter_ht = 3;
+            filter_wd = 3;
+            ch_mult = 1;
+            channels = 8;
+            pad_wd = 1;
+            pad_ht = 1;
+            stride_wd = 1;
+            stride_ht = 1;
+            break;
         default:
             input_wd = 6;
             input_ht = 6;
@@ -324,6 +348,7 @@ void esp_nn_depthwise_conv_s8_test()
         }
         if (scratch_buf) {
             free(scratch_buf);
+            scratch_buf = NULL;
         }
     }
 }
@@ -347,8 +372,8 @@ void esp_nn_conv_s8_test()
     uint16_t filter_ht, filter_wd;
     uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
 
-    // run for 10 iterations
-    for (int itr = 0; itr < 10; itr++) {
+    // run for 12 iterations
+    for (int itr = 0; itr < 12; itr++) {
         switch (itr) {
         case 0: // ch % 8 == 0 && filter (1,1), padding (0,0)
             in_wd = 10;
@@ -434,6 +459,30 @@ void esp_nn_conv_s8_test()
             stride_wd = 1;
             stride_ht = 1;
             break;
+        case 7: // single channel, filter (3,3), pad (1,1), stride (2,2)
+            in_wd = 19;
+            in_ht = 19;
+            in_channels = 1;
+            out_channels = 8;
+            filter_ht = 3;
+            filter_wd = 3;
+            pad_wd = 1;
+            pad_ht = 1;
+            stride_wd = 2;
+            stride_ht = 2;
+            break;
+        case 8: // odd channels, filter (3,3), pad (1,1)
+            in_wd = 7;
+            in_ht = 5;
+            in_channels = 7;
+            out_channels = 11;
+            filter_ht = 3;
+            filter_wd = 3;
+            pad_wd = 1;
+            pad_ht = 1;
+            stride_wd = 1;
+            stride_ht = 1;
+            break;
         default: // ch % 8 == 0
             in_wd = 8;
             in_ht = 8;
@@ -523,10 +572,10 @@ void esp_nn_conv_s8_test()
                                                             &output_dims, &conv_params);
         if (scratch_buf_size > 0) {
 #if IDF_HEAP_CAPS
-            void *scratch_buf = heap_caps_malloc(scratch_buf_size + 32, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            scratch_buf = heap_caps_malloc(scratch_buf_size + 32, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
             int align_sz = 16 - (((int32_t) scratch_buf) & 0xf);
 #else
-            void *scratch_buf = memalign(16, scratch_buf_size);
+            scratch_buf = memalign(16, scratch_buf_size);
             int align_sz = 0;
 #endif
             if (scratch_buf == NULL) {
@@ -600,6 +649,122 @@ void esp_nn_conv_s8_test()
         }
         if (scratch_buf) {
             free(scratch_buf);
+            scratch_buf = NULL;
         }
     }
 }
+
+void esp_nn_transpose_conv_s8_test()
+{
+    const int32_t input_offset = 5; /* some number in [-128, 127] */
+    const int32_t activation_min = -128;
+    const int32_t activation_max = 127;
+    const int32_t out_offset = 3;
+
+    /* in_wd, in_ht, in_channels, out_channels, filter_wd, filter_ht, stride, pad */
+    static const uint16_t cases[][8] = {
+        {12, 12, 16, 16, 2, 2, 2, 0}, /* stride 2, 2x2 filter */
+        {12, 12, 16, 16, 3, 3, 2, 1}, /* stride 2, 3x3 filter, same padding */
+        {7, 5, 7, 11, 3, 3, 2, 0},    /* stride 2, odd channels */
+        {10, 10, 8, 13, 3, 3, 1, 1},  /* stride 1 */
+        {6, 6, 3, 8, 4, 4, 2, 1},     /* stride 2, 4x4 filter */
+        {5, 7, 5, 6, 5, 3, 3, 2},     /* stride 3, 5x3 filter */
+    };
+
+    for (int itr = 0; itr < (int) (sizeof(cases) / sizeof(cases[0])); itr++) {
+        const uint16_t in_wd = cases[itr][0];
+        const uint16_t in_ht = cases[itr][1];
+        const uint16_t in_channels = cases[itr][2];
+        const uint16_t out_channels = cases[itr][3];
+        const uint16_t filter_wd = cases[itr][4];
+        const uint16_t filter_ht = cases[itr][5];
+        const uint16_t stride = cases[itr][6];
+        const uint16_t pad = cases[itr][7];
+
+        /* prepare data */
+        uint16_t out_wd = (in_wd - 1) * stride + filter_wd - 2 * pad;
+        uint16_t out_ht = (in_ht - 1) * stride + filter_ht - 2 * pad;
+
+        int in_size = in_wd * in_ht * in_channels;
+        int filter_size = filter_wd * filter_ht * in_channels * out_channels;
+        int out_size = out_wd * out_ht * out_channels;
+
+        int8_t *input = malloc(in_size);
+        int8_t *filter_data = malloc(filter_size);
+        int8_t *out_data_c = malloc(out_size);
+        int8_t *out_data_opt = malloc(out_size);
+        int32_t *bias = malloc(sizeof (int32_t) * out_channels);
+        int32_t *out_shift = malloc(sizeof (int32_t) * out_channels);
+        int32_t *out_mult = malloc(sizeof (int32_t) * out_channels);
+
+        if (input == NULL || filter_data == NULL || out_data_c == NULL || out_data_opt == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"%s allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__);
+            goto transpose_conv_s8_cleanup;
+        }
+
+        /* Generate input, filter, bias, shift and multiplier */
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = (int32_t)rand() % UINT16_MAX - INT16_MAX;
+            out_shift[i] = -10 + rand() % 2;
+            out_mult[i] = 0x7f67f4f8 + rand() % 50;
+        }
+
+        data_dims_t input_dims = {.width = in_wd, .height = in_ht, .channels = in_channels, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_channels, 1};
+        data_dims_t filter_dims = {.width = filter_wd, .height = filter_ht, 0, 0};
+        conv_params_t conv_params = {.in_offset = input_offset, .out_offset = out_offset,
+                                    .stride = {stride, stride}, .padding = {pad, pad},
+                                    .dilation = {1, 1}, .activation = {activation_min, activation_max}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        if (itr == 0) {
+            /* enable profiler */
+            profile_c_start();
+        }
+
+        /* C function */
+        esp_nn_transpose_conv_s8_ansi(&input_dims, input, &filter_dims, filter_data,
+                                      bias, &output_dims, out_data_c, &conv_params, &quant_data);
+
+        if (itr == 0) {
+            profile_c_end();
+            profile_opt_start();
+        }
+
+        /* Optimized function */
+        esp_nn_transpose_conv_s8(&input_dims, input, &filter_dims, filter_data,
+                                 bias, &output_dims, out_data_opt, &conv_params, &quant_data);
+
+        if (itr == 0) {
+            /* disable profiler */
+            profile_opt_end();
+        }
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(out_data_opt, out_size / out_ht, out_ht);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(out_data_c, out_size / out_ht, out_ht);
+            goto transpose_conv_s8_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+
+    transpose_conv_s8_cleanup:
+        free(input);
+        free(filter_data);
+        free(out_data_c);
+        free(out_data_opt);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+    }
+}
@@ -109,3 +109,100 @@ void esp_nn_fully_connected_s8_test()
         printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
     }
 }
+
+/* gemmlowp's SaturatingRoundingDoublingHighMul and RoundingDivideByPOT, as
+ * TFLite's MultiplyByQuantizedMultiplier() applies them, written out
+ * independently of common_functions.h. */
+static int32_t expected_requantize(int32_t x, int32_t mult, int32_t shift)
+{
+    const int32_t left_shift = shift > 0 ? shift : 0;
+    const int32_t right_shift = shift > 0 ? 0 : -shift;
+    int32_t high;
+    if (x * (1 << left_shift) == INT32_MIN && mult == INT32_MIN) {
+        high = INT32_MAX;
+    } else {
+        const int64_t ab = (int64_t) (x * (1 << left_shift)) * mult;
+        const int64_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+        high = (int32_t) ((ab + nudge) / ((int64_t) 1 << 31));
+    }
+    const int32_t mask = (int32_t) (((int64_t) 1 << right_shift) - 1);
+    const int32_t remainder = high & mask;
+    const int32_t threshold = (mask >> 1) + (high < 0 ? 1 : 0);
+    return (high >> right_shift) + (remainder > threshold ? 1 : 0);
+}
+
+/* There is no optimised acc_s16 kernel yet, the ANSI one is checked against
+ * out = sat16(out + MultiplyByQuantizedMultiplier(bias + filter . input)). */
+void esp_nn_fully_connected_s8_acc_s16_test()
+{
+    /* prepare data */
+    static uint16_t row_len = 64 + 7;
+    static uint16_t out_channels = 4 * 8 + 3;
+    int8_t input[row_len];
+    int8_t filter_data[row_len * out_channels];
+    int32_t bias[out_channels];
+    int16_t output_c[out_channels], expected[out_channels];
+    int32_t out_shift, out_mult;
+
+    for (int itr = 0; itr < 5; itr++) {
+        /* Generate input, filter, quantization and the values accumulated into */
+        for (int i = 0; i < row_len; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < row_len * out_channels; ++i) {
+            filter_data[i] = rand() % 256 - 128;
+        }
+        out_mult = INT32_MAX / 2 + rand() % INT16_MAX;
+        switch (itr) {
+        case 1:
+            out_shift = -20;
+            break;
+        case 2: /* saturates most outputs */
+            out_shift = 8;
+            break;
+        default:
+            out_shift = -8 + rand() % 9;
+            break;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = rand() % INT16_MAX - INT16_MAX / 2;
+            output_c[i] = rand() % 4096 - 2048;
+        }
+
+        for (int out_c = 0; out_c < out_channels; ++out_c) {
+            int32_t acc = bias[out_c];
+            for (int i = 0; i < row_len; ++i) {
+                acc += filter_data[out_c * row_len + i] * input[i];
+            }
+            int32_t result = output_c[out_c] +
+                             expected_requantize(acc, out_mult, out_shift);
+            result = result < INT16_MIN ? INT16_MIN : result;
+            result = result > INT16_MAX ? INT16_MAX : result;
+            expected[out_c] = (int16_t) result;
+        }
+
+        if (itr == 0) {
+            /* enable profiler */
+            profile_c_start();
+        }
+
+        /* C function */
+        esp_nn_fully_connected_s8_acc_s16_ansi(input, row_len, filter_data, bias, output_c,
+                                               out_channels, out_shift, out_mult);
+
+        if (itr == 0) {
+            profile_c_end();
+        }
+
+        bool ret = CHECK_EQUAL(output_c, expected, out_channels);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(output_c, out_channels * 2, 1);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(expected, out_channels * 2, 1);
+            return;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+    }
+}
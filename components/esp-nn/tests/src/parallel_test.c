@@ -0,0 +1,240 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include <esp_nn.h>
+#include <esp_nn_parallel.h>
+#include "test_utils.h"
+
+/**
+ * Parallel versions are checked against ANSI C, on shapes large enough to be
+ * split. Row bands should give bit-exact results whatever the padding.
+ */
+
+typedef struct {
+    uint16_t in_wd, in_ht, in_ch;
+    uint16_t out_ch; /* ch_mult for depthwise */
+    uint16_t filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht;
+    uint16_t stride_wd, stride_ht;
+    uint16_t out_wd, out_ht; /* 0: no padding past the input on the right/bottom */
+} parallel_test_case_t;
+
+static const parallel_test_case_t conv_cases[] = {
+    {24, 24, 8, 16, 3, 3, 1, 1, 1, 1},   // 3x3 same
+    {25, 25, 16, 16, 3, 3, 0, 0, 2, 2},  // 3x3 valid, stride 2
+    {24, 24, 3, 8, 3, 3, 0, 0, 2, 2, 12, 12}, // same, padding only at the bottom
+    {16, 16, 32, 32, 1, 1, 0, 0, 1, 1},  // 1x1
+    {13, 13, 12, 24, 5, 5, 2, 2, 1, 1},  // odd number of rows
+    {20, 24, 8, 16, 3, 3, 0, 1, 1, 1},   // padding only along height
+};
+
+static const parallel_test_case_t dw_conv_cases[] = {
+    {24, 24, 16, 1, 3, 3, 1, 1, 1, 1},
+    {25, 25, 16, 1, 3, 3, 0, 0, 2, 2},
+    {24, 24, 32, 1, 3, 3, 1, 1, 2, 2},
+    {21, 21, 8, 2, 5, 5, 2, 2, 1, 1},
+    {16, 16, 8, 4, 3, 3, 1, 1, 1, 1},
+    {24, 20, 24, 1, 3, 3, 0, 1, 1, 1},
+    {24, 24, 16, 1, 3, 3, 0, 0, 2, 2, 12, 12},
+};
+
+static void **alloc_scratch_bufs(int size)
+{
+    static void *bufs[ESP_NN_MAX_WORKERS];
+    for (int w = 0; w < ESP_NN_MAX_WORKERS; w++) {
+        bufs[w] = size > 0 ? memalign(16, size) : NULL;
+    }
+    return bufs;
+}
+
+static void free_scratch_bufs(void **bufs)
+{
+    for (int w = 0; w < ESP_NN_MAX_WORKERS; w++) {
+        free(bufs[w]);
+        bufs[w] = NULL;
+    }
+}
+
+void esp_nn_conv_s8_parallel_test()
+{
+    const int32_t input_offset = 5;
+    const int32_t out_offset = 3;
+    const int num_cases = sizeof(conv_cases) / sizeof(conv_cases[0]);
+
+    printf("%s: %d workers\n", __FUNCTION__, esp_nn_parallel_num_workers());
+    for (int itr = 0; itr < num_cases; itr++) {
+        const parallel_test_case_t *tc = &conv_cases[itr];
+        uint16_t out_wd = tc->out_wd ? tc->out_wd :
+                          (tc->in_wd + 2 * tc->pad_wd - tc->filter_wd) / tc->stride_wd + 1;
+        uint16_t out_ht = tc->out_ht ? tc->out_ht :
+                          (tc->in_ht + 2 * tc->pad_ht - tc->filter_ht) / tc->stride_ht + 1;
+        int in_size = tc->in_wd * tc->in_ht * tc->in_ch;
+        int filter_size = tc->filter_wd * tc->filter_ht * tc->in_ch * tc->out_ch;
+        int out_size = out_wd * out_ht * tc->out_ch;
+
+        int8_t *input = memalign(16, in_size);
+        int8_t *filter_data = memalign(16, filter_size);
+        int8_t *out_data_c = memalign(16, out_size);
+        int8_t *out_data_opt = memalign(16, out_size);
+        int32_t *bias = malloc(tc->out_ch * sizeof(int32_t));
+        int32_t *out_shift = malloc(tc->out_ch * sizeof(int32_t));
+        int32_t *out_mult = malloc(tc->out_ch * sizeof(int32_t));
+        void **scratch_bufs = NULL;
+
+        if (input == NULL || filter_data == NULL || out_data_c == NULL || out_data_opt == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"%s[%d] allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            goto conv_parallel_cleanup;
+        }
+
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = rand() % 255 - 128;
+        }
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < tc->out_ch; ++i) {
+            bias[i] = (int32_t)rand() % UINT16_MAX + UINT8_MAX;
+            out_shift[i] = -10 + rand() % 2;
+            out_mult[i] = 0x7f67f4f8 + rand() % 50;
+        }
+
+        data_dims_t input_dims = {.width = tc->in_wd, .height = tc->in_ht, .channels = tc->in_ch, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = tc->out_ch, 1};
+        data_dims_t filter_dims = {.width = tc->filter_wd, .height = tc->filter_ht, 0, 0};
+        conv_params_t conv_params = {.in_offset = input_offset, .out_offset = out_offset,
+                                     .stride = {tc->stride_wd, tc->stride_ht},
+                                     .padding = {tc->pad_wd, tc->pad_ht},
+                                     .dilation = {0, 0}, .activation = {-125, 122}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        scratch_bufs = alloc_scratch_bufs(esp_nn_get_conv_scratch_size_parallel(
+                                              &input_dims, &filter_dims, &output_dims, &conv_params));
+
+        esp_nn_conv_s8_ansi(&input_dims, input, &filter_dims, filter_data,
+                            bias, &output_dims, out_data_c, &conv_params, &quant_data);
+        esp_nn_conv_s8_parallel(&input_dims, input, &filter_dims, filter_data,
+                                bias, &output_dims, out_data_opt, &conv_params, &quant_data,
+                                scratch_bufs);
+
+        if (!CHECK_EQUAL(out_data_c, out_data_opt, out_size)) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            goto conv_parallel_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+
+    conv_parallel_cleanup:
+        free(input);
+        free(filter_data);
+        free(out_data_c);
+        free(out_data_opt);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+        if (scratch_bufs) {
+            free_scratch_bufs(scratch_bufs);
+        }
+    }
+}
+
+void esp_nn_depthwise_conv_s8_parallel_test()
+{
+    const int32_t input_offset = 5;
+    const int32_t out_offset = 7;
+    const int num_cases = sizeof(dw_conv_cases) / sizeof(dw_conv_cases[0]);
+
+    printf("%s: %d workers\n", __FUNCTION__, esp_nn_parallel_num_workers());
+    for (int itr = 0; itr < num_cases; itr++) {
+        const parallel_test_case_t *tc = &dw_conv_cases[itr];
+        const uint16_t ch_mult = tc->out_ch;
+        const uint16_t out_ch = tc->in_ch * ch_mult;
+        uint16_t out_wd = tc->out_wd ? tc->out_wd :
+                          (tc->in_wd + 2 * tc->pad_wd - tc->filter_wd) / tc->stride_wd + 1;
+        uint16_t out_ht = tc->out_ht ? tc->out_ht :
+                          (tc->in_ht + 2 * tc->pad_ht - tc->filter_ht) / tc->stride_ht + 1;
+        int in_size = tc->in_wd * tc->in_ht * tc->in_ch;
+        int filter_size = tc->filter_wd * tc->filter_ht * out_ch;
+        int out_size = out_wd * out_ht * out_ch;
+
+        int8_t *input = memalign(16, in_size);
+        int8_t *filter_data = memalign(16, filter_size);
+        int8_t *out_data_c = memalign(16, out_size);
+        int8_t *out_data_opt = memalign(16, out_size);
+        int32_t *bias = malloc(out_ch * sizeof(int32_t));
+        int32_t *out_shift = malloc(out_ch * sizeof(int32_t));
+        int32_t *out_mult = malloc(out_ch * sizeof(int32_t));
+        void **scratch_bufs = NULL;
+
+        if (input == NULL || filter_data == NULL || out_data_c == NULL || out_data_opt == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"%s[%d] allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            goto dw_conv_parallel_cleanup;
+        }
+
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = rand() % 128;
+        }
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_ch; ++i) {
+            bias[i] = rand() % INT16_MAX;
+            out_shift[i] = -8 + rand() % 3;
+            out_mult[i] = 0x7eb0e200 + rand() % 50;
+        }
+
+        data_dims_t input_dims = {.width = tc->in_wd, .height = tc->in_ht, .channels = tc->in_ch, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_ch, 1};
+        data_dims_t filter_dims = {.width = tc->filter_wd, .height = tc->filter_ht, 0, 0};
+        dw_conv_params_t conv_params = {.in_offset = input_offset, .out_offset = out_offset,
+                                        .ch_mult = ch_mult,
+                                        .stride = {tc->stride_wd, tc->stride_ht},
+                                        .padding = {tc->pad_wd, tc->pad_ht},
+                                        .dilation = {0, 0}, .activation = {-125, 120}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        scratch_bufs = alloc_scratch_bufs(esp_nn_get_depthwise_conv_scratch_size_parallel(
+                                              &input_dims, &filter_dims, &output_dims, &conv_params));
+
+        esp_nn_depthwise_conv_s8_ansi(&input_dims, input, &filter_dims, filter_data,
+                                      bias, &output_dims, out_data_c, &conv_params, &quant_data);
+        esp_nn_depthwise_conv_s8_parallel(&input_dims, input, &filter_dims, filter_data,
+                                          bias, &output_dims, out_data_opt, &conv_params, &quant_data,
+                                          scratch_bufs);
+
+        if (!CHECK_EQUAL(out_data_c, out_data_opt, out_size)) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            goto dw_conv_parallel_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+
+    dw_conv_parallel_cleanup:
+        free(input);
+        free(filter_data);
+        free(out_data_c);
+        free(out_data_opt);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+        if (scratch_bufs) {
+            free_scratch_bufs(scratch_bufs);
+        }
+    }
+}
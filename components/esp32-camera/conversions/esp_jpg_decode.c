@@ -47,6 +47,7 @@ typedef struct {
         void * arg;
         size_t len;
         size_t index;
+        bool luma;
 } esp_jpg_decoder_t;
 
 static const char * jd_errors[] = {
@@ -71,6 +72,16 @@ static unsigned int _jpg_write(JDEC *decoder, void *bitmap, JRECT *rect)
 
     esp_jpg_decoder_t * jpeg = (esp_jpg_decoder_t *)decoder->device;
 
+#ifndef JD_LUMA
+    // The ROM decoder only outputs RGB888, reduce it to luma in place
+    if (jpeg->luma) {
+        const uint8_t *rgb = data;
+        for (size_t i = 0; i < (size_t)w * h; i++, rgb += 3) {
+            data[i] = (rgb[0] * 77 + rgb[1] * 150 + rgb[2] * 29) >> 8;
+        }
+    }
+#endif
+
     if (jpeg->writer) {
         return jpeg->writer(jpeg->arg, x, y, w, h, data);
     }
@@ -93,7 +104,7 @@ static unsigned int _jpg_read(JDEC *decoder, uint8_t *buf, unsigned int len)
     return len;
 }
 
-esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void * arg)
+static esp_err_t _jpg_decode(size_t len, jpg_scale_t scale, bool luma, jpg_reader_cb reader, jpg_writer_cb writer, void * arg)
 {
     static uint8_t work[3100];
     JDEC decoder;
@@ -105,6 +116,7 @@ esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jp
     jpeg.arg = arg;
     jpeg.scale = scale;
     jpeg.index = 0;
+    jpeg.luma = luma;
 
     JRESULT jres = jd_prepare(&decoder, _jpg_read, work, 3100, &jpeg);
     if(jres != JDR_OK){
@@ -118,7 +130,12 @@ esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jp
     //output start
     writer(arg, 0, 0, output_width, output_height, NULL);
     //output write
+#ifdef JD_LUMA
+    jres = luma ? jd_decomp_luma(&decoder, _jpg_write, (uint8_t)jpeg.scale)
+                : jd_decomp(&decoder, _jpg_write, (uint8_t)jpeg.scale);
+#else
     jres = jd_decomp(&decoder, _jpg_write, (uint8_t)jpeg.scale);
+#endif
     //output end
     writer(arg, output_width, output_height, output_width, output_height, NULL);
 
@@ -134,3 +151,12 @@ esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jp
     return ESP_OK;
 }
 
+esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void * arg)
+{
+    return _jpg_decode(len, scale, false, reader, writer, arg);
+}
+
+esp_err_t esp_jpg_decode_gray(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void * arg)
+{
+    return _jpg_decode(len, scale, true, reader, writer, arg);
+}
@@ -36,6 +36,17 @@ typedef bool (* jpg_writer_cb)(void * arg, uint16_t x, uint16_t y, uint16_t w, u
 
 esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void * arg);
 
+/**
+ * @brief Decode only the luma of a JPEG image
+ *
+ * Same as esp_jpg_decode(), but the writer receives 8-bit grayscale blocks.
+ * Where the decoder is not in ROM (ESP32-S2 and the host build) the chroma
+ * blocks are parsed but never transformed or color converted; the ROM decoder
+ * outputs RGB888, which is reduced to luma before every write. Either way the
+ * decoder only uses its fixed work area and does not allocate.
+ */
+esp_err_t esp_jpg_decode_gray(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void * arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -83,6 +83,62 @@ bool fmt2jpg(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
  */
 bool frame2jpg(camera_fb_t * fb, uint8_t quality, uint8_t ** out, size_t * out_len);
 
+typedef struct jpg_encoder jpg_encoder_t;
+
+/**
+ * @brief Create an incremental JPEG encoder
+ *
+ * All the memory the encoder needs is allocated here, compressing images with
+ * it afterwards does not touch the heap.
+ *
+ * @param max_width Width in pixels of the widest image to be compressed
+ * @param color     Whether RGB565, RGB888 and YUYV images will be compressed, or only GRAYSCALE ones
+ *
+ * @return the encoder, NULL if out of memory
+ */
+jpg_encoder_t * jpg_encoder_create(uint16_t max_width, bool color);
+
+/**
+ * @brief Delete an encoder created with jpg_encoder_create()
+ */
+void jpg_encoder_delete(jpg_encoder_t * enc);
+
+/**
+ * @brief Start compressing an image, the headers are written to the callback right away
+ *
+ * @param enc       Encoder
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format, read until the image is done
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param cb        Callback to be called to write the bytes of the output JPEG.
+ *                  Returning less than the given length fails the encoder.
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool jpg_encoder_start(jpg_encoder_t * enc, uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Compress the next MCU rows of the started image
+ *
+ * An MCU row is 8 lines of a GRAYSCALE image and 16 of a color one. Callers
+ * run a few rows at a time and yield in between, so a long image does not hold
+ * the CPU. The end of image is written with the last row.
+ *
+ * @param enc       Encoder
+ * @param mcu_rows  Number of MCU rows to compress
+ *
+ * @return true on success, false if no image is being compressed or the callback failed
+ */
+bool jpg_encoder_run(jpg_encoder_t * enc, size_t mcu_rows);
+
+/**
+ * @brief Whether the whole image has been compressed and written
+ */
+bool jpg_encoder_done(const jpg_encoder_t * enc);
+
 /**
  * @brief Convert image buffer to BMP buffer
  *
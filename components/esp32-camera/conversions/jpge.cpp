@@ -566,7 +566,7 @@ namespace jpge {
     }
 
     // Higher-level methods.
-    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels)
+    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels, uint8 *pMcu_buf)
     {
         m_num_components = 3;
         switch (m_params.m_subsampling)
@@ -612,7 +612,8 @@ namespace jpge {
         m_image_bpl_mcu  = m_image_x_mcu * m_num_components;
         m_mcus_per_row   = m_image_x_mcu / m_mcu_x;
 
-        if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
+        m_owns_mcu_lines = !pMcu_buf;
+        if ((m_mcu_lines[0] = pMcu_buf ? pMcu_buf : static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
             return false;
         }
         for (int i = 1; i < m_mcu_y; i++)
@@ -679,6 +680,7 @@ namespace jpge {
     void jpeg_encoder::clear()
     {
         m_mcu_lines[0] = NULL;
+        m_owns_mcu_lines = false;
         m_pass_num = 0;
         m_all_stream_writes_succeeded = true;
     }
@@ -699,12 +701,33 @@ namespace jpge {
         if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels != 1) && (src_channels != 3) && (src_channels != 4)) || (!comp_params.check())) return false;
         m_pStream = pStream;
         m_params = comp_params;
-        return jpg_open(width, height, src_channels);
+        return jpg_open(width, height, src_channels, NULL);
+    }
+
+    bool jpeg_encoder::init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params, void *pMcu_buf, uint mcu_buf_size)
+    {
+        deinit();
+        if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels != 1) && (src_channels != 3) && (src_channels != 4)) || (!comp_params.check())) return false;
+        if (!pMcu_buf || mcu_buf_size < mcu_buffer_size(width, comp_params)) return false;
+        m_pStream = pStream;
+        m_params = comp_params;
+        return jpg_open(width, height, src_channels, static_cast<uint8*>(pMcu_buf));
+    }
+
+    uint jpeg_encoder::mcu_buffer_size(int width, const params &comp_params)
+    {
+        // Same geometry as jpg_open(): Y_ONLY and H1V1 MCUs are 8x8, H2V1 16x8 and H2V2 16x16
+        const int components = comp_params.m_subsampling == Y_ONLY ? 1 : 3;
+        const int mcu_x = comp_params.m_subsampling >= H2V1 ? 16 : 8;
+        const int mcu_y = comp_params.m_subsampling == H2V2 ? 16 : 8;
+        return ((width + mcu_x - 1) & ~(mcu_x - 1)) * components * mcu_y;
     }
 
     void jpeg_encoder::deinit()
     {
-        jpge_free(m_mcu_lines[0]);
+        if (m_owns_mcu_lines) {
+            jpge_free(m_mcu_lines[0]);
+        }
         clear();
     }
 
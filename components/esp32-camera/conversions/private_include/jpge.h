@@ -64,6 +64,16 @@ namespace jpge
             // Returns false on out of memory or if a stream write fails.
             bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params = params());
 
+            // Same as above, but the MCU lines are kept in pMcu_buf (mcu_buf_size bytes, see mcu_buffer_size())
+            // instead of being allocated, so an encoder can be reused frame after frame without touching the heap.
+            bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params, void *pMcu_buf, uint mcu_buf_size);
+
+            // Bytes of MCU lines needed to compress images up to width pixels wide with comp_params.
+            static uint mcu_buffer_size(int width, const params &comp_params);
+
+            // Number of scanlines in an MCU row, process_scanline() compresses a row once it has them all.
+            int mcu_height() const { return m_mcu_y; }
+
             // Call this method with each source scanline.
             // width * src_channels bytes per scanline is expected (RGB or Y format).
             // You must call with NULL after all scanlines are processed to finish compression.
@@ -90,6 +100,7 @@ namespace jpge
             int m_mcus_per_row;
             int m_mcu_x, m_mcu_y;
             uint8 *m_mcu_lines[16];
+            bool m_owns_mcu_lines;
             uint8 m_mcu_y_ofs;
             sample_array_t m_sample_array[64];
             int16 m_coefficient_array[64];
@@ -103,7 +114,7 @@ namespace jpge
             uint8 m_pass_num;
             bool m_all_stream_writes_succeeded;
 
-            bool jpg_open(int p_x_res, int p_y_res, int src_channels);
+            bool jpg_open(int p_x_res, int p_y_res, int src_channels, uint8 *pMcu_buf);
 
             void flush_output_buffer();
             void put_bits(uint bits, uint len);
@@ -13,6 +13,7 @@
 // limitations under the License.
 #include <stddef.h>
 #include <string.h>
+#include <new>
 #include "esp_attr.h"
 #include "soc/efuse_reg.h"
 #include "esp_heap_caps.h"
@@ -153,7 +154,7 @@ public:
         index += ocb(oarg, index, data, len);
         return true;
     }
-    virtual size_t get_size() const
+    virtual jpge::uint get_size() const
     {
         return index;
     }
@@ -172,6 +173,136 @@ bool frame2jpg_cb(camera_fb_t * fb, uint8_t quality, jpg_out_cb cb, void * arg)
 
 
 
+// Fails the encoder when the callback takes fewer bytes than it was given
+class checked_callback_stream : public callback_stream {
+public:
+    checked_callback_stream() : callback_stream(NULL, NULL) { }
+    void reset(jpg_out_cb cb, void * arg)
+    {
+        ocb = cb;
+        oarg = arg;
+        index = 0;
+    }
+    virtual bool put_buf(const void* data, int len)
+    {
+        size_t written = ocb(oarg, index, data, len);
+        index += written;
+        return written == (size_t)len;
+    }
+};
+
+struct jpg_encoder {
+    jpge::jpeg_encoder jpeg;
+    checked_callback_stream stream;
+    jpge::params params;
+    uint8_t *mcu_buf;
+    size_t mcu_buf_size;
+    uint8_t *line;
+    size_t line_size;
+    uint8_t *src;
+    uint16_t width;
+    uint16_t height;
+    pixformat_t format;
+    uint16_t next_line;
+    bool running;
+    bool finished;
+};
+
+jpg_encoder_t * jpg_encoder_create(uint16_t max_width, bool color)
+{
+    jpge::params params;
+    params.m_subsampling = color ? jpge::H2V2 : jpge::Y_ONLY;
+    size_t mcu_buf_size = jpge::jpeg_encoder::mcu_buffer_size(max_width, params);
+    size_t line_size = max_width * (color ? 3 : 1);
+
+    void * mem = _malloc(sizeof(jpg_encoder_t) + mcu_buf_size + line_size);
+    if (!mem) {
+        ESP_LOGE(TAG, "JPG encoder malloc failed");
+        return NULL;
+    }
+    jpg_encoder_t * enc = new (mem) jpg_encoder_t();
+    enc->params = params;
+    enc->mcu_buf = (uint8_t *)mem + sizeof(jpg_encoder_t);
+    enc->mcu_buf_size = mcu_buf_size;
+    enc->line = enc->mcu_buf + mcu_buf_size;
+    enc->line_size = line_size;
+    enc->running = false;
+    enc->finished = false;
+    return enc;
+}
+
+void jpg_encoder_delete(jpg_encoder_t * enc)
+{
+    if (enc) {
+        enc->~jpg_encoder_t();
+        free(enc);
+    }
+}
+
+bool jpg_encoder_start(jpg_encoder_t * enc, uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpg_out_cb cb, void * arg)
+{
+    int num_channels = format == PIXFORMAT_GRAYSCALE ? 1 : 3;
+    enc->running = false;
+    enc->finished = false;
+    if (num_channels == 3 && enc->params.m_subsampling == jpge::Y_ONLY) {
+        ESP_LOGE(TAG, "JPG encoder was created for grayscale");
+        return false;
+    }
+    if ((size_t)width * num_channels > enc->line_size) {
+        ESP_LOGE(TAG, "JPG encoder was created for narrower images than %u", width);
+        return false;
+    }
+
+    jpge::params params = enc->params;
+    params.m_subsampling = num_channels == 1 ? jpge::Y_ONLY : jpge::H2V2;
+    params.m_quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+    enc->stream.reset(cb, arg);
+    if (!enc->jpeg.init(&enc->stream, width, height, num_channels, params, enc->mcu_buf, enc->mcu_buf_size)) {
+        ESP_LOGE(TAG, "JPG encoder init failed");
+        return false;
+    }
+    enc->src = src;
+    enc->width = width;
+    enc->height = height;
+    enc->format = format;
+    enc->next_line = 0;
+    enc->running = true;
+    return true;
+}
+
+bool jpg_encoder_run(jpg_encoder_t * enc, size_t mcu_rows)
+{
+    if (!enc->running) {
+        return false;
+    }
+    for (size_t lines = mcu_rows * enc->jpeg.mcu_height(); lines && enc->next_line < enc->height; lines--) {
+        convert_line_format(enc->src, enc->format, enc->line, enc->width, enc->format == PIXFORMAT_GRAYSCALE ? 1 : 3, enc->next_line);
+        if (!enc->jpeg.process_scanline(enc->line)) {
+            ESP_LOGE(TAG, "JPG process line %u failed", enc->next_line);
+            enc->jpeg.deinit();
+            enc->running = false;
+            return false;
+        }
+        enc->next_line++;
+    }
+    if (enc->next_line == enc->height) {
+        enc->running = false;
+        if (!enc->jpeg.process_scanline(NULL)) {
+            ESP_LOGE(TAG, "JPG image finish failed");
+            enc->jpeg.deinit();
+            return false;
+        }
+        enc->jpeg.deinit();
+        enc->finished = true;
+    }
+    return true;
+}
+
+bool jpg_encoder_done(const jpg_encoder_t * enc)
+{
+    return enc->finished;
+}
+
 class memory_stream : public jpge::output_stream {
 protected:
     uint8_t *out_buf;
@@ -199,7 +330,7 @@ public:
         return true;
     }
 
-    virtual size_t get_size() const
+    virtual jpge::uint get_size() const
     {
         return index;
     }
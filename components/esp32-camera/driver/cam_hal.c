@@ -146,6 +146,12 @@ static void cam_task(void *arg)
             case CAM_STATE_READ_BUF: {
                 camera_fb_t * frame_buffer_event = &cam_obj->frames[frame_pos].fb;
                 size_t pixels_per_dma = (cam_obj->dma_half_buffer_size * cam_obj->fb_bytes_per_pixel) / (cam_obj->dma_bytes_per_item * cam_obj->in_bytes_per_pixel);
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+                if (cam_obj->decimate_x > 1 || cam_obj->decimate_y > 1) {
+                    // the decimating filter stops writing after the last output row
+                    pixels_per_dma = 0;
+                }
+#endif
 
                 if (cam_event == CAM_IN_SUC_EOF_EVENT) {
                     if(!cam_obj->psram_mode){
@@ -367,6 +373,7 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     esp_err_t ret = ESP_OK;
 
     ret = ll_cam_set_sample_mode(cam_obj, (pixformat_t)config->pixel_format, config->xclk_freq_hz, sensor_pid);
+    CAM_CHECK_GOTO(ret == ESP_OK, "ll_cam_set_sample_mode failed", err);
 
     cam_obj->jpeg_mode = config->pixel_format == PIXFORMAT_JPEG;
 #if CONFIG_IDF_TARGET_ESP32
@@ -383,7 +390,11 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
         cam_obj->fb_size = cam_obj->recv_size;
     } else {
         cam_obj->recv_size = cam_obj->width * cam_obj->height * cam_obj->in_bytes_per_pixel;
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+        cam_obj->fb_size = (cam_obj->width / cam_obj->decimate_x) * (cam_obj->height / cam_obj->decimate_y) * cam_obj->fb_bytes_per_pixel;
+#else
         cam_obj->fb_size = cam_obj->width * cam_obj->height * cam_obj->fb_bytes_per_pixel;
+#endif
     }
 
     ret = cam_dma_config(config);
@@ -78,6 +78,10 @@ static const char *TAG = "camera";
 typedef struct {
     sensor_t sensor;
     camera_fb_t fb;
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    uint8_t decimate_x;
+    uint8_t decimate_y;
+#endif
 } camera_state_t;
 
 static const char *CAMERA_SENSOR_NVS_KEY = "sensor";
@@ -314,6 +318,13 @@ esp_err_t esp_camera_init(const camera_config_t *config)
         s_state->sensor.pixformat = get_output_data_format(config->conv_mode); // If conversion enabled, change the out data format by conversion mode
     }
 #endif
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    s_state->decimate_x = config->decimate_x > 1 ? config->decimate_x : 1;
+    s_state->decimate_y = config->decimate_y > 1 ? config->decimate_y : 1;
+    if (s_state->decimate_x > 1 || s_state->decimate_y > 1) {
+        s_state->sensor.pixformat = PIXFORMAT_GRAYSCALE; // the DMA filter only keeps the decimated luma
+    }
+#endif
 
     if (s_state->sensor.id.PID == OV2640_PID) {
         s_state->sensor.set_gainceiling(&s_state->sensor, GAINCEILING_2X);
@@ -363,6 +374,10 @@ camera_fb_t *esp_camera_fb_get()
         fb->width = resolution[s_state->sensor.status.framesize].width;
         fb->height = resolution[s_state->sensor.status.framesize].height;
         fb->format = s_state->sensor.pixformat;
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+        fb->width /= s_state->decimate_x;
+        fb->height /= s_state->decimate_y;
+#endif
     }
     return fb;
 }
@@ -76,6 +76,16 @@
 extern "C" {
 #endif
 
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+/**
+ * @brief How a decimated Y8 pixel is computed from its box of input pixels
+ */
+typedef enum {
+    CAMERA_DECIMATE_POINT,      /*!< Keep the top left pixel of every box */
+    CAMERA_DECIMATE_BOX,        /*!< Average every pixel of the box */
+} camera_decimate_mode_t;
+#endif
+
 /**
  * @brief Configuration structure for camera initialization
  */
@@ -147,6 +157,11 @@ typedef struct {
 #if CONFIG_CAMERA_CONVERTER_ENABLED
     camera_conv_mode_t conv_mode;   /*!< RGB<->YUV Conversion mode */
 #endif
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    uint8_t decimate_x;             /*!< Horizontal decimation factor, 0 or 1 disables. Needs GRAYSCALE or YUV422 input, the frame buffer then holds Y8 */
+    uint8_t decimate_y;             /*!< Vertical decimation factor, 0 or 1 disables */
+    camera_decimate_mode_t decimate_mode; /*!< Point sampling or box averaging */
+#endif
 
     int sccb_i2c_port;              /*!< If pin_sccb_sda is -1, use the already configured I2C bus by number */
 } camera_config_t;
@@ -13,8 +13,10 @@
 // limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "soc/i2s_struct.h"
+#include "esp_heap_caps.h"
 #include "esp_idf_version.h"
 #if (ESP_IDF_VERSION_MAJOR >= 4) && (ESP_IDF_VERSION_MINOR > 1)
 #include "hal/gpio_ll.h"
@@ -31,6 +33,7 @@ static inline int gpio_ll_get_level(gpio_dev_t *hw, int gpio_num)
 }
 #endif
 #include "ll_cam.h"
+#include "ll_cam_dma_filter.h"
 #include "xclk.h"
 #include "cam_hal.h"
 
@@ -49,16 +52,6 @@ static const char *TAG = "esp32 ll_cam";
 #define I2S_ISR_ENABLE(i) {I2S0.int_clr.i = 1;I2S0.int_ena.i = 1;}
 #define I2S_ISR_DISABLE(i) {I2S0.int_ena.i = 0;I2S0.int_clr.i = 1;}
 
-typedef union {
-    struct {
-        uint32_t sample2:8;
-        uint32_t unused2:8;
-        uint32_t sample1:8;
-        uint32_t unused1:8;
-    };
-    uint32_t val;
-} dma_elem_t;
-
 typedef enum {
     /* camera sends byte sequence: s1, s2, s3, s4, ...
      * fifo receives: 00 s1 00 s2, 00 s2 00 s3, 00 s3 00 s4, ...
@@ -74,8 +67,6 @@ typedef enum {
     SM_0A00_0B00 = 3,
 } i2s_sampling_mode_t;
 
-typedef size_t (*dma_filter_t)(uint8_t* dst, const uint8_t* src, size_t len);
-
 static i2s_sampling_mode_t sampling_mode = SM_0A00_0B00;
 
 static size_t ll_cam_bytes_per_sample(i2s_sampling_mode_t mode)
@@ -93,111 +84,36 @@ static size_t ll_cam_bytes_per_sample(i2s_sampling_mode_t mode)
     }
 }
 
-static size_t IRAM_ATTR ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    // manually unrolling 4 iterations of the loop here
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[1].sample1;
-        dst[2] = dma_el[2].sample1;
-        dst[3] = dma_el[3].sample1;
-        dma_el += 4;
-        dst += 4;
-    }
-    return elements;
-}
-
-static size_t IRAM_ATTR ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    for (size_t i = 0; i < end; ++i) {
-        // manually unrolling 4 iterations of the loop here
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[1].sample1;
-        dst[2] = dma_el[2].sample1;
-        dst[3] = dma_el[3].sample1;
-        dma_el += 4;
-        dst += 4;
-    }
-    return elements;
-}
+static dma_filter_t dma_filter = ll_cam_dma_filter_jpeg;
 
-static size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 8;
-    for (size_t i = 0; i < end; ++i) {
-        // manually unrolling 4 iterations of the loop here
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[2].sample1;
-        dst[2] = dma_el[4].sample1;
-        dst[3] = dma_el[6].sample1;
-        dma_el += 8;
-        dst += 4;
-    }
-    // the final sample of a line in SM_0A0B_0B0C sampling mode needs special handling
-    if ((elements & 0x7) != 0) {
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[2].sample1;
-        elements += 1;
-    }
-    return elements / 2;
-}
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+static ll_cam_decimator_t decimator;
+static uint16_t *decimator_acc = NULL;
 
-static size_t IRAM_ATTR ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len)
+static size_t IRAM_ATTR ll_cam_dma_filter_decimate(uint8_t* dst, const uint8_t* src, size_t len)
 {
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[0].sample2;//u
-        dst[2] = dma_el[1].sample1;//y1
-        dst[3] = dma_el[1].sample2;//v
-
-        dst[4] = dma_el[2].sample1;//y0
-        dst[5] = dma_el[2].sample2;//u
-        dst[6] = dma_el[3].sample1;//y1
-        dst[7] = dma_el[3].sample2;//v
-        dma_el += 4;
-        dst += 8;
-    }
-    return elements * 2;
+    return ll_cam_decimator_run(&decimator, dst, src, len);
 }
 
-static size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+static bool ll_cam_init_decimator(cam_obj_t *cam)
 {
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 8;
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[1].sample1;//u
-        dst[2] = dma_el[2].sample1;//y1
-        dst[3] = dma_el[3].sample1;//v
-
-        dst[4] = dma_el[4].sample1;//y0
-        dst[5] = dma_el[5].sample1;//u
-        dst[6] = dma_el[6].sample1;//y1
-        dst[7] = dma_el[7].sample1;//v
-        dma_el += 8;
-        dst += 8;
+    free(decimator_acc);
+    decimator_acc = NULL;
+    if (cam->decimate_box) {
+        decimator_acc = (uint16_t *)heap_caps_malloc((cam->width / cam->decimate_x) * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+        if (decimator_acc == NULL) {
+            ESP_LOGE(TAG, "Decimator accumulator malloc failed");
+            return 0;
+        }
     }
-    if ((elements & 0x7) != 0) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[1].sample1;//u
-        dst[2] = dma_el[2].sample1;//y1
-        dst[3] = dma_el[2].sample2;//v
-        elements += 4;
+    if (!ll_cam_decimator_init(&decimator, cam->width, cam->height, cam->in_bytes_per_pixel, cam->dma_bytes_per_item,
+                               cam->decimate_x, cam->decimate_y, cam->decimate_box, decimator_acc)) {
+        ESP_LOGE(TAG, "Unsupported decimation %ux%u of %ux%u", cam->decimate_x, cam->decimate_y, cam->width, cam->height);
+        return 0;
     }
-    return elements;
+    return 1;
 }
+#endif
 
 static void IRAM_ATTR ll_cam_vsync_isr(void *arg)
 {
@@ -253,6 +169,10 @@ esp_err_t ll_cam_deinit(cam_obj_t *cam)
         esp_intr_free(cam->cam_intr_handle);
         cam->cam_intr_handle = NULL;
     }
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    free(decimator_acc);
+    decimator_acc = NULL;
+#endif
 
     return ESP_OK;
 }
@@ -322,6 +242,11 @@ esp_err_t ll_cam_config(cam_obj_t *cam, const camera_config_t *config)
     I2S0.timing.val = 0;
     I2S0.timing.rx_dsync_sw = 1;
 
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    cam->decimate_x = config->decimate_x > 1 ? config->decimate_x : 1;
+    cam->decimate_y = config->decimate_y > 1 ? config->decimate_y : 1;
+    cam->decimate_box = config->decimate_mode == CAMERA_DECIMATE_BOX;
+#endif
     return ESP_OK;
 }
 
@@ -383,6 +308,11 @@ esp_err_t ll_cam_init_isr(cam_obj_t *cam)
 
 void ll_cam_do_vsync(cam_obj_t *cam)
 {
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    if (dma_filter == ll_cam_dma_filter_decimate) {
+        ll_cam_decimator_reset(&decimator);
+    }
+#endif
 }
 
 uint8_t ll_cam_get_dma_align(cam_obj_t *cam)
@@ -469,13 +399,18 @@ bool ll_cam_dma_sizes(cam_obj_t *cam)
         cam->dma_half_buffer_size = cam->dma_node_buffer_size * 2;
         cam->dma_buffer_size = cam->dma_half_buffer_cnt * cam->dma_half_buffer_size;
     } else {
-        return ll_cam_calc_rgb_dma(cam);
+        if (!ll_cam_calc_rgb_dma(cam)) {
+            return 0;
+        }
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+        if (dma_filter == ll_cam_dma_filter_decimate) {
+            return ll_cam_init_decimator(cam);
+        }
+#endif
     }
     return 1;
 }
 
-static dma_filter_t dma_filter = ll_cam_dma_filter_jpeg;
-
 size_t IRAM_ATTR ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in, size_t len)
 {
     //DBG_PIN_SET(1);
@@ -530,6 +465,16 @@ esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_
         ESP_LOGE(TAG, "Requested format is not supported");
         return ESP_ERR_NOT_SUPPORTED;
     }
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    if (cam->decimate_x > 1 || cam->decimate_y > 1) {
+        if (pix_format != PIXFORMAT_GRAYSCALE && pix_format != PIXFORMAT_YUV422) {
+            ESP_LOGE(TAG, "Decimation needs GRAYSCALE or YUV422 input");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        dma_filter = ll_cam_dma_filter_decimate;
+        cam->fb_bytes_per_pixel = 1;       // frame buffer stores decimated Y8
+    }
+#endif
     I2S0.fifo_conf.rx_fifo_mod = sampling_mode;
     return ESP_OK;
 }
@@ -0,0 +1,230 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "ll_cam_dma_filter.h"
+
+size_t IRAM_ATTR ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    // manually unrolling 4 iterations of the loop here
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        dst[2] = dma_el[4].sample1;
+        dst[3] = dma_el[6].sample1;
+        dma_el += 8;
+        dst += 4;
+    }
+    // the final sample of a line in SM_0A0B_0B0C sampling mode needs special handling
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        elements += 1;
+    }
+    return elements / 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[0].sample2;//u
+        dst[2] = dma_el[1].sample1;//y1
+        dst[3] = dma_el[1].sample2;//v
+
+        dst[4] = dma_el[2].sample1;//y0
+        dst[5] = dma_el[2].sample2;//u
+        dst[6] = dma_el[3].sample1;//y1
+        dst[7] = dma_el[3].sample2;//v
+        dma_el += 4;
+        dst += 8;
+    }
+    return elements * 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[3].sample1;//v
+
+        dst[4] = dma_el[4].sample1;//y0
+        dst[5] = dma_el[5].sample1;//u
+        dst[6] = dma_el[6].sample1;//y1
+        dst[7] = dma_el[7].sample1;//v
+        dma_el += 8;
+        dst += 8;
+    }
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[2].sample2;//v
+        elements += 4;
+    }
+    return elements;
+}
+
+/* (sum * ceil(2^24 / area)) >> 24 == sum / area for every sum < 2^24 / area,
+ * which 255 * area satisfies for areas up to 256 */
+#define DECIMATE_RECIP_SHIFT 24
+
+static inline uint8_t IRAM_ATTR ll_cam_decimate_pixel(const ll_cam_decimator_t *dec, const dma_elem_t *dma_el, size_t pixel)
+{
+    const dma_elem_t *el = &dma_el[(pixel * dec->step) >> dec->pack];
+    return (pixel & dec->pack) ? el->sample2 : el->sample1;
+}
+
+bool ll_cam_decimator_init(ll_cam_decimator_t *dec, uint16_t in_width, uint16_t in_height,
+                           uint8_t in_bytes_per_pixel, uint8_t dma_bytes_per_item,
+                           uint8_t factor_x, uint8_t factor_y, bool box, uint16_t *acc)
+{
+    if (factor_x == 0 || factor_x > LL_CAM_DECIMATE_MAX_FACTOR ||
+        factor_y == 0 || factor_y > LL_CAM_DECIMATE_MAX_FACTOR ||
+        in_width < factor_x || in_height < factor_y) {
+        return false;
+    }
+    if ((in_bytes_per_pixel != 1 && in_bytes_per_pixel != 2) ||
+        (dma_bytes_per_item != 2 && dma_bytes_per_item != 4)) {
+        return false;
+    }
+    if (box && acc == NULL) {
+        return false;
+    }
+    // DMA elements hold 4 / dma_bytes_per_item sensor bytes, the Y byte comes first
+    size_t half_elements_per_pixel = in_bytes_per_pixel * dma_bytes_per_item / 2;
+    dec->pack = half_elements_per_pixel == 1;
+    dec->step = dec->pack ? 1 : half_elements_per_pixel / 2;
+
+    dec->in_width = in_width;
+    dec->out_width = in_width / factor_x;
+    dec->out_height = in_height / factor_y;
+    dec->factor_x = factor_x;
+    dec->factor_y = factor_y;
+    dec->box = box;
+    dec->recip = ((1u << DECIMATE_RECIP_SHIFT) + factor_x * factor_y - 1) / (factor_x * factor_y);
+    dec->acc = acc;
+    ll_cam_decimator_reset(dec);
+    return true;
+}
+
+void IRAM_ATTR ll_cam_decimator_reset(ll_cam_decimator_t *dec)
+{
+    dec->x = 0;
+    dec->row = 0;
+    dec->out_row = 0;
+    if (dec->box) {
+        memset(dec->acc, 0, dec->out_width * sizeof(dec->acc[0]));
+    }
+}
+
+size_t IRAM_ATTR ll_cam_decimator_run(ll_cam_decimator_t *dec, uint8_t *dst, const uint8_t *src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    const size_t factor_x = dec->factor_x;
+    const size_t used_width = dec->out_width * factor_x;
+    size_t pixels = ((len / sizeof(dma_elem_t)) << dec->pack) / dec->step;
+    size_t pixel = 0;
+    uint8_t *out = dst;
+
+    while (pixel < pixels && dec->out_row < dec->out_height) {
+        size_t x = dec->x;
+        size_t run = dec->in_width - x;
+        if (run > pixels - pixel) {
+            run = pixels - pixel;
+        }
+        size_t end = x + run < used_width ? x + run : used_width;
+
+        if (dec->box) {
+            // add this part of the line to the column sums of its output pixels
+            uint16_t *acc = &dec->acc[x / factor_x];
+            size_t phase = x % factor_x;
+            for (size_t i = pixel; x < end; x++, i++) {
+                *acc += ll_cam_decimate_pixel(dec, dma_el, i);
+                if (++phase == factor_x) {
+                    phase = 0;
+                    acc++;
+                }
+            }
+        } else if (dec->row == 0) {
+            // keep the top left pixel of every box
+            for (x = ((x + factor_x - 1) / factor_x) * factor_x; x < end; x += factor_x) {
+                *out++ = ll_cam_decimate_pixel(dec, dma_el, pixel + x - dec->x);
+            }
+        }
+
+        pixel += run;
+        dec->x += run;
+        if (dec->x == dec->in_width) {
+            dec->x = 0;
+            if (++dec->row == dec->factor_y) {
+                dec->row = 0;
+                dec->out_row++;
+                if (dec->box) {
+                    for (size_t i = 0; i < dec->out_width; i++) {
+                        out[i] = (dec->acc[i] * dec->recip) >> DECIMATE_RECIP_SHIFT;
+                        dec->acc[i] = 0;
+                    }
+                    out += dec->out_width;
+                }
+            }
+        }
+    }
+    return out - dst;
+}
@@ -0,0 +1,107 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+ * Filters that unpack the ESP32 I2S camera DMA stream into the frame buffer.
+ * They only touch memory, so they also build on a Linux host where the unit
+ * tests feed them synthetic DMA buffers.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef union {
+    struct {
+        uint32_t sample2:8;
+        uint32_t unused2:8;
+        uint32_t sample1:8;
+        uint32_t unused1:8;
+    };
+    uint32_t val;
+} dma_elem_t;
+
+typedef size_t (*dma_filter_t)(uint8_t* dst, const uint8_t* src, size_t len);
+
+size_t ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+
+#define LL_CAM_DECIMATE_MAX_FACTOR 16
+
+/**
+ * @brief State of the decimating Y8 filter
+ *
+ * The filter keeps the position inside the frame between DMA half-buffers, so
+ * a frame can be split at any pixel boundary. Input rows past
+ * `out_height * factor_y` and columns past `out_width * factor_x` are dropped.
+ */
+typedef struct {
+    uint16_t in_width;          /*!< Input pixels per line */
+    uint16_t out_width;         /*!< in_width / factor_x */
+    uint16_t out_height;        /*!< in_height / factor_y */
+    uint8_t factor_x;
+    uint8_t factor_y;
+    uint8_t step;               /*!< DMA elements per pixel, before packing */
+    uint8_t pack;               /*!< 1 when a DMA element carries two pixels */
+    bool box;                   /*!< Average the factor_x * factor_y box instead of point sampling */
+    uint32_t recip;             /*!< ceil(2^24 / box area) */
+    uint16_t *acc;              /*!< out_width row accumulators, box mode only */
+    uint16_t x;                 /*!< Input column of the next pixel */
+    uint16_t row;               /*!< Input row inside the current output row */
+    uint16_t out_row;           /*!< Output row being produced */
+} ll_cam_decimator_t;
+
+/**
+ * @brief Configure a decimator for one frame geometry
+ *
+ * @param in_bytes_per_pixel   Bytes the sensor sends per pixel, 2 for YU/YV and 1 for Y8
+ * @param dma_bytes_per_item   DMA bytes per sensor byte of the I2S sampling mode, 2 or 4
+ * @param acc                  out_width accumulators, may be NULL in point-sampling mode
+ *
+ * @return false when the geometry or the factors are not supported
+ */
+bool ll_cam_decimator_init(ll_cam_decimator_t *dec, uint16_t in_width, uint16_t in_height,
+                           uint8_t in_bytes_per_pixel, uint8_t dma_bytes_per_item,
+                           uint8_t factor_x, uint8_t factor_y, bool box, uint16_t *acc);
+
+/**
+ * @brief Rewind to the first pixel of a frame, call on every VSYNC
+ */
+void ll_cam_decimator_reset(ll_cam_decimator_t *dec);
+
+/**
+ * @brief Decimate one DMA buffer into the Y8 output frame
+ *
+ * @return number of bytes written to dst
+ */
+size_t ll_cam_decimator_run(ll_cam_decimator_t *dec, uint8_t *dst, const uint8_t *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,9 +10,12 @@
 #define JD_FORMAT		0	/* Output pixel format 0:RGB888 (3 BYTE/pix), 1:RGB565 (1 WORD/pix) */
 #define	JD_USE_SCALE	1	/* Use descaling feature for output */
 #define JD_TBLCLIP		1	/* Use table for saturation (might be a bit faster but increases 1K bytes of code size) */
+#define JD_LUMA			1	/* Provide jd_decomp_luma(), which outputs the Y component only (1 BYTE/pix) */
 
 /*---------------------------------------------------------------------------*/
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,10 +35,10 @@ typedef unsigned short	USHORT;
 typedef unsigned short	WORD;
 typedef unsigned short	WCHAR;
 
-/* These types must be 32-bit integer */
-typedef long			LONG;
-typedef unsigned long	ULONG;
-typedef unsigned long	DWORD;
+/* These types must be 32-bit integer, long is 64-bit on LP64 hosts */
+typedef int32_t			LONG;
+typedef uint32_t		ULONG;
+typedef uint32_t		DWORD;
 
 
 /* Error code */
@@ -68,7 +71,9 @@ struct JDEC {
 	BYTE* inbuf;			/* Bit stream input buffer */
 	BYTE dmsk;				/* Current bit in the current read byte */
 	BYTE scale;				/* Output scaling ratio */
+	BYTE luma;				/* Output the Y component only, the chroma blocks are not transformed */
 	BYTE msx, msy;			/* MCU size in unit of block (width, height) */
+	BYTE ncomp;				/* Number of image components (3: Y/Cb/Cr, 1: grayscale) */
 	BYTE qtid[3];			/* Quantization table ID of each component */
 	SHORT dcv[3];			/* Previous DC element of each component */
 	WORD nrst;				/* Restart inverval */
@@ -90,6 +95,7 @@ struct JDEC {
 /* TJpgDec API functions */
 JRESULT jd_prepare (JDEC*, UINT(*)(JDEC*,BYTE*,UINT), void*, UINT, void*);
 JRESULT jd_decomp (JDEC*, UINT(*)(JDEC*,void*,JRECT*), BYTE);
+JRESULT jd_decomp_luma (JDEC*, UINT(*)(JDEC*,void*,JRECT*), BYTE);
 
 
 #ifdef __cplusplus
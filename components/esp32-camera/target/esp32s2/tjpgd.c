@@ -492,7 +492,7 @@ JRESULT mcu_load (
 
 
 	nby = jd->msx * jd->msy;	/* Number of Y blocks (1, 2 or 4) */
-	nbc = 2;					/* Number of C blocks (2) */
+	nbc = jd->ncomp == 3 ? 2 : 0;	/* Number of C blocks (2, none in grayscale) */
 	bp = jd->mcubuf;			/* Pointer to the first block */
 
 	for (blk = 0; blk < nby + nbc; blk++) {
@@ -542,6 +542,8 @@ JRESULT mcu_load (
 			}
 		} while (++i < 64);		/* Next AC element */
 
+		if (cmp && jd->luma) continue;	/* Chroma blocks are only parsed to keep the stream in sync */
+
 		if (JD_USE_SCALE && jd->scale == 3)
 			*bp = (*tmp / 256) + 128;	/* If scale ratio is 1/8, IDCT can be ommited and only DC element is used */
 		else
@@ -707,6 +709,82 @@ JRESULT mcu_output (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Output an MCU: Copy the Y blocks and output them in grayscale form    */
+/*-----------------------------------------------------------------------*/
+
+static
+JRESULT mcu_output_luma (
+	JDEC* jd,	/* Pointer to the decompressor object */
+	UINT (*outfunc)(JDEC*, void*, JRECT*),	/* Grayscale output function */
+	UINT x,		/* MCU position in the image (left of the MCU) */
+	UINT y		/* MCU position in the image (top of the MCU) */
+)
+{
+	UINT ix, iy, mx, my, rx, ry;
+	BYTE *py, *op;
+	JRECT rect;
+
+
+	mx = jd->msx * 8; my = jd->msy * 8;					/* MCU size (pixel) */
+	rx = (x + mx <= jd->width) ? mx : jd->width - x;	/* Output rectangular size (it may be clipped at right/bottom end) */
+	ry = (y + my <= jd->height) ? my : jd->height - y;
+	if (JD_USE_SCALE) {
+		rx >>= jd->scale; ry >>= jd->scale;
+		if (!rx || !ry) return JDR_OK;					/* Skip this MCU if all pixel is to be rounded off */
+		x >>= jd->scale; y >>= jd->scale;
+	}
+	rect.left = x; rect.right = x + rx - 1;				/* Rectangular area in the frame buffer */
+	rect.top = y; rect.bottom = y + ry - 1;
+
+	op = (BYTE*)jd->workbuf;
+	if (!JD_USE_SCALE || jd->scale != 3) {	/* Not for 1/8 scaling */
+		UINT w = 1 << jd->scale;	/* Width of the square averaged into a pixel */
+		UINT s = jd->scale * 2;		/* Number of shifts for averaging */
+		UINT sx, sy, v;
+
+		for (iy = 0; iy < my; iy += w) {
+			for (ix = 0; ix < mx; ix += w) {
+				v = 0;
+				for (sy = iy; sy < iy + w; sy++) {
+					py = jd->mcubuf + (sy & 8) * 16 + (sy & 7) * 8;	/* Blocks are ordered left to right, then top to bottom */
+					for (sx = ix; sx < ix + w; sx++) {
+						v += py[(sx & 8) * 8 + (sx & 7)];
+					}
+				}
+				*op++ = (BYTE)(v >> s);
+			}
+		}
+	} else {	/* For only 1/8 scaling (the DC value of each block) */
+		py = jd->mcubuf;
+		for (iy = 0; iy < my; iy += 8) {
+			for (ix = 0; ix < mx; ix += 8) {
+				*op++ = *py;
+				py += 64;
+			}
+		}
+	}
+
+	/* Squeeze up pixel table if a part of MCU is to be truncated */
+	mx >>= jd->scale;
+	if (rx < mx) {
+		BYTE *s, *d;
+		UINT x, y;
+
+		s = d = (BYTE*)jd->workbuf;
+		for (y = 0; y < ry; y++) {
+			for (x = 0; x < rx; x++) *d++ = *s++;	/* Copy effective pixels */
+			s += mx - rx;	/* Skip truncated pixels */
+		}
+	}
+
+	/* Output the grayscale rectangular */
+	return outfunc(jd, jd->workbuf, &rect) ? JDR_OK : JDR_INTR;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Process restart interval                                              */
 /*-----------------------------------------------------------------------*/
@@ -780,6 +858,7 @@ JRESULT jd_prepare (
 	jd->infunc = infunc;	/* Stream input function */
 	jd->device = dev;		/* I/O device identifier */
 	jd->nrst = 0;			/* No restart interval (default) */
+	jd->luma = 0;			/* Full color output (default) */
 
 	for (i = 0; i < 2; i++) {	/* Nulls pointers */
 		for (j = 0; j < 2; j++) {
@@ -814,12 +893,15 @@ JRESULT jd_prepare (
 
 			jd->width = LDB_WORD(seg+3);		/* Image width in unit of pixel */
 			jd->height = LDB_WORD(seg+1);		/* Image height in unit of pixel */
-			if (seg[5] != 3) return JDR_FMT3;	/* Err: Supports only Y/Cb/Cr format */
+			jd->ncomp = seg[5];					/* Number of image components */
+			if (jd->ncomp != 3 && jd->ncomp != 1) return JDR_FMT3;	/* Err: Supports only Y/Cb/Cr and grayscale format */
 
-			/* Check three image components */
-			for (i = 0; i < 3; i++) {	
+			/* Check image components */
+			for (i = 0; i < jd->ncomp; i++) {
 				b = seg[7 + 3 * i];							/* Get sampling factor */
-				if (!i) {	/* Y component */
+				if (jd->ncomp == 1) {	/* Grayscale, MCUs are single blocks whatever the sampling factor */
+					jd->msx = jd->msy = 1;
+				} else if (!i) {	/* Y component */
 					if (b != 0x11 && b != 0x22 && b != 0x21)/* Check sampling factor */
 						return JDR_FMT3;					/* Err: Supports only 4:4:4, 4:2:0 or 4:2:2 */
 					jd->msx = b >> 4; jd->msy = b & 15;		/* Size of MCU [blocks] */
@@ -868,10 +950,10 @@ JRESULT jd_prepare (
 
 			if (!jd->width || !jd->height) return JDR_FMT1;	/* Err: Invalid image size */
 
-			if (seg[0] != 3) return JDR_FMT3;				/* Err: Supports only three color components format */
+			if (seg[0] != jd->ncomp) return JDR_FMT3;		/* Err: Supports only scans of all components */
 
 			/* Check if all tables corresponding to each components have been loaded */
-			for (i = 0; i < 3; i++) {
+			for (i = 0; i < jd->ncomp; i++) {
 				b = seg[2 + 2 * i];	/* Get huffman table ID */
 				if (b != 0x00 && b != 0x11)	return JDR_FMT3;	/* Err: Different table number for DC/AC element */
 				b = i ? 1 : 0;
@@ -889,6 +971,9 @@ JRESULT jd_prepare (
 			if (!jd->workbuf) return JDR_MEM1;			/* Err: not enough memory */
 			jd->mcubuf = alloc_pool(jd, (n + 2) * 64);	/* Allocate MCU working buffer */
 			if (!jd->mcubuf) return JDR_MEM1;			/* Err: not enough memory */
+			if (jd->ncomp == 1) {						/* Grayscale has neutral chroma */
+				for (i = 0; i < 2 * 64; i++) jd->mcubuf[n * 64 + i] = 128;
+			}
 
 			/* Pre-load the JPEG data to extract it from the bit stream */
 			jd->dptr = seg; jd->dctr = 0; jd->dmsk = 0;	/* Prepare to read bit stream */
@@ -958,13 +1043,39 @@ JRESULT jd_decomp (
 			}
 			rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream and apply IDCT) */
 			if (rc != JDR_OK) return rc;
-			rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (color space conversion, scaling and output) */
+			if (jd->luma)
+				rc = mcu_output_luma(jd, outfunc, x, y);	/* Output the Y component of the MCU (scaling and output) */
+			else
+				rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (color space conversion, scaling and output) */
 			if (rc != JDR_OK) return rc;
 		}
 	}
 
 	return rc;
 }
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Start to decompress the Y component of the JPEG picture               */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_decomp_luma (
+	JDEC* jd,								/* Initialized decompression object */
+	UINT (*outfunc)(JDEC*, void*, JRECT*),	/* Grayscale output function */
+	BYTE scale								/* Output de-scaling factor (0 to 3) */
+)
+{
+	JRESULT rc;
+
+
+	jd->luma = 1;
+	rc = jd_decomp(jd, outfunc, scale);
+	jd->luma = 0;
+
+	return rc;
+}
 #endif//SUPPORT_JPEG
 
 
@@ -123,6 +123,11 @@ typedef struct {
 #else
     uint8_t in_bytes_per_pixel;
     uint8_t fb_bytes_per_pixel;
+#endif
+#if CONFIG_CAMERA_DECIMATION_ENABLED
+    uint8_t decimate_x;
+    uint8_t decimate_y;
+    bool decimate_box;
 #endif
     uint32_t fb_size;
 
@@ -0,0 +1,189 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ll_cam_dma_filter.h"
+
+#define MAX_WIDTH  160
+#define MAX_HEIGHT 120
+
+static int failures;
+
+#define CHECK(cond, ...) do {                           \
+        if (!(cond)) {                                  \
+            printf("FAILED %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                        \
+            printf("\n");                               \
+            failures++;                                 \
+        }                                               \
+    } while (0)
+
+static uint8_t luma[MAX_HEIGHT][MAX_WIDTH];
+static dma_elem_t dma[MAX_HEIGHT * MAX_WIDTH * 2];
+static uint8_t out[MAX_HEIGHT * MAX_WIDTH];
+static uint8_t expected[MAX_HEIGHT * MAX_WIDTH];
+static uint16_t acc[MAX_WIDTH];
+
+static void fill_luma(int width, int height)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            luma[y][x] = rand() & 0xff;
+        }
+    }
+}
+
+/* Lay the frame out the way the I2S FIFO stores it: YU/YV sensors interleave
+ * chroma after every luma byte, and every DMA element carries one sensor byte
+ * in sample1 (4 DMA bytes per item) or two in sample1, sample2 (2 per item). */
+static size_t encode_dma(int width, int height, int in_bytes_per_pixel, int dma_bytes_per_item)
+{
+    size_t k = 0;
+    memset(dma, 0, sizeof(dma));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int b = 0; b < in_bytes_per_pixel; b++, k++) {
+                uint8_t byte = b ? (uint8_t) (0x80 ^ x) : luma[y][x];
+                if (dma_bytes_per_item == 4) {
+                    dma[k].sample1 = byte;
+                } else if (k & 1) {
+                    dma[k / 2].sample2 = byte;
+                } else {
+                    dma[k / 2].sample1 = byte;
+                }
+            }
+        }
+    }
+    return k * dma_bytes_per_item;
+}
+
+static size_t reference(int width, int height, int fx, int fy, bool box)
+{
+    int out_width = width / fx;
+    int out_height = height / fy;
+    for (int oy = 0; oy < out_height; oy++) {
+        for (int ox = 0; ox < out_width; ox++) {
+            uint32_t sum = 0;
+            for (int y = 0; y < (box ? fy : 1); y++) {
+                for (int x = 0; x < (box ? fx : 1); x++) {
+                    sum += luma[oy * fy + y][ox * fx + x];
+                }
+            }
+            expected[oy * out_width + ox] = box ? sum / (fx * fy) : sum;
+        }
+    }
+    return out_width * out_height;
+}
+
+static void test_grayscale_filter(void)
+{
+    const int width = MAX_WIDTH, height = 4;
+    fill_luma(width, height);
+
+    size_t len = encode_dma(width, height, 2, 2);
+    size_t n = ll_cam_dma_filter_grayscale(out, (const uint8_t *) dma, len);
+    CHECK(n == width * height, "grayscale wrote %zu", n);
+    CHECK(memcmp(out, luma, n) == 0, "grayscale luma mismatch");
+
+    len = encode_dma(width, height, 2, 4);
+    n = ll_cam_dma_filter_grayscale_highspeed(out, (const uint8_t *) dma, len);
+    CHECK(n == width * height, "grayscale highspeed wrote %zu", n);
+    CHECK(memcmp(out, luma, n) == 0, "grayscale highspeed luma mismatch");
+}
+
+/* Feed the frame in `chunk` byte DMA buffers, the last one may be shorter */
+static void run_decimator(int width, int height, int in_bpp, int dma_bpi,
+                          int fx, int fy, bool box, size_t chunk)
+{
+    ll_cam_decimator_t dec;
+    bool ok = ll_cam_decimator_init(&dec, width, height, in_bpp, dma_bpi, fx, fy, box, acc);
+    CHECK(ok, "init %dx%d /%dx%d", width, height, fx, fy);
+    if (!ok) {
+        return;
+    }
+
+    fill_luma(width, height);
+    size_t len = encode_dma(width, height, in_bpp, dma_bpi);
+    size_t want = reference(width, height, fx, fy, box);
+
+    // run two frames to check that reset rewinds the state
+    for (int frame = 0; frame < 2; frame++) {
+        ll_cam_decimator_reset(&dec);
+        memset(out, 0xaa, sizeof(out));
+        size_t got = 0;
+        for (size_t pos = 0; pos < len; pos += chunk) {
+            size_t n = len - pos < chunk ? len - pos : chunk;
+            got += ll_cam_decimator_run(&dec, &out[got], (const uint8_t *) dma + pos, n);
+        }
+        CHECK(got == want, "%dx%d bpp %d bpi %d /%dx%d %s chunk %zu: wrote %zu, want %zu",
+              width, height, in_bpp, dma_bpi, fx, fy, box ? "box" : "point", chunk, got, want);
+        CHECK(memcmp(out, expected, want) == 0, "%dx%d bpp %d bpi %d /%dx%d %s chunk %zu: pixel mismatch",
+              width, height, in_bpp, dma_bpi, fx, fy, box ? "box" : "point", chunk);
+        CHECK(out[want] == 0xaa, "wrote past the decimated frame");
+    }
+}
+
+static void test_decimator(void)
+{
+    static const struct {
+        int width, height, fx, fy;
+    } shapes[] = {
+        {160, 120, 2, 2},
+        {160, 120, 5, 5},       // 32x24
+        {150, 100, 4, 3},       // drops the right 2 columns and the bottom row
+        {96, 96, 1, 1},
+        {64, 32, 16, 16},
+        {48, 40, 3, 1},
+    };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        for (int in_bpp = 1; in_bpp <= 2; in_bpp++) {
+            for (int dma_bpi = 2; dma_bpi <= 4; dma_bpi += 2) {
+                size_t line = shapes[s].width * in_bpp * dma_bpi;
+                for (int box = 0; box <= 1; box++) {
+                    // whole lines per buffer, as ll_cam_calc_rgb_dma sizes them, and splits inside
+                    // lines after an even pixel count, so packed Y8 elements stay whole
+                    run_decimator(shapes[s].width, shapes[s].height, in_bpp, dma_bpi,
+                                  shapes[s].fx, shapes[s].fy, box, 4 * line);
+                    run_decimator(shapes[s].width, shapes[s].height, in_bpp, dma_bpi,
+                                  shapes[s].fx, shapes[s].fy, box, 38 * in_bpp * dma_bpi);
+                }
+            }
+        }
+    }
+}
+
+static void test_decimator_rejects(void)
+{
+    ll_cam_decimator_t dec;
+    CHECK(!ll_cam_decimator_init(&dec, 160, 120, 2, 4, 0, 2, false, NULL), "accepted factor 0");
+    CHECK(!ll_cam_decimator_init(&dec, 160, 120, 2, 4, 17, 2, false, NULL), "accepted factor 17");
+    CHECK(!ll_cam_decimator_init(&dec, 160, 120, 3, 4, 2, 2, false, NULL), "accepted 3 bytes per pixel");
+    CHECK(!ll_cam_decimator_init(&dec, 160, 120, 2, 4, 2, 2, true, NULL), "accepted box mode without accumulators");
+    CHECK(!ll_cam_decimator_init(&dec, 8, 8, 2, 4, 16, 2, false, NULL), "accepted factor wider than the frame");
+}
+
+int main(int argc, char *argv[])
+{
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+
+    test_grayscale_filter();
+    test_decimator();
+    test_decimator_rejects();
+
+    printf("%s\n", failures ? "DMA filter tests failed" : "DMA filter tests passed");
+    return failures != 0;
+}
@@ -18,6 +18,148 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/microfrontend/lib/kiss_fft_int16.h"
 
+namespace {
+
+// The fixed point operations of kissfft_fixed16 (see _kiss_fft_guts.h), which
+// the radix-4 FFT repeats in the same order so that its output is the same to
+// the bit. Every intermediate value is an int16_t, as it is in kissfft.
+
+inline int16_t Round15(int32_t value) {
+  return static_cast<int16_t>((value + (1 << 14)) >> 15);
+}
+
+// C_FIXDIV()
+template <int kDivisor>
+inline complex_int16_t Div(complex_int16_t c) {
+  const int32_t scale = 32767 / kDivisor;
+  return {Round15(c.real * scale), Round15(c.imag * scale)};
+}
+
+// C_MUL()
+inline complex_int16_t Mul(complex_int16_t a, complex_int16_t b) {
+  return {Round15(a.real * b.real - a.imag * b.imag),
+          Round15(a.real * b.imag + a.imag * b.real)};
+}
+
+inline complex_int16_t Add(complex_int16_t a, complex_int16_t b) {
+  return {static_cast<int16_t>(a.real + b.real),
+          static_cast<int16_t>(a.imag + b.imag)};
+}
+
+inline complex_int16_t Sub(complex_int16_t a, complex_int16_t b) {
+  return {static_cast<int16_t>(a.real - b.real),
+          static_cast<int16_t>(a.imag - b.imag)};
+}
+
+// kf_bfly4() of a forward FFT on the four points a0 to a3, scaled down and
+// multiplied by their twiddle factors already.
+inline void Butterfly4(complex_int16_t a0, complex_int16_t a1,
+                       complex_int16_t a2, complex_int16_t a3,
+                       complex_int16_t* out, size_t m) {
+  const complex_int16_t t5 = Sub(a0, a2);
+  a0 = Add(a0, a2);
+  const complex_int16_t t3 = Add(a1, a3);
+  const complex_int16_t t4 = Sub(a1, a3);
+  out[2 * m] = Sub(a0, t3);
+  out[0] = Add(a0, t3);
+  out[m].real = t5.real + t4.imag;
+  out[m].imag = t5.imag - t4.real;
+  out[3 * m].real = t5.real - t4.imag;
+  out[3 * m].imag = t5.imag + t4.real;
+}
+
+// A radix-4 stage over blocks of 4 * m points. The first twiddle factor of
+// each block is 1, by which multiplying a scaled down value leaves it as is,
+// so that butterfly skips the multiplications.
+void Radix4Stage(complex_int16_t* data, size_t size, size_t m,
+                 const complex_int16_t* twiddles) {
+  for (complex_int16_t* block = data; block < data + size; block += 4 * m) {
+    complex_int16_t* out = block;
+    Butterfly4(Div<4>(out[0]), Div<4>(out[m]), Div<4>(out[2 * m]),
+               Div<4>(out[3 * m]), out, m);
+    const complex_int16_t* tw = twiddles + 3;
+    for (size_t k = 1; k < m; ++k, tw += 3) {
+      ++out;
+      Butterfly4(Div<4>(out[0]), Mul(Div<4>(out[m]), tw[0]),
+                 Mul(Div<4>(out[2 * m]), tw[1]),
+                 Mul(Div<4>(out[3 * m]), tw[2]), out, m);
+    }
+  }
+}
+
+// The first stage, reading its points from the input in the order of
+// input_index rather than from a copy of them.
+void FirstRadix4Stage(const complex_int16_t* input,
+                      const uint16_t* input_index, complex_int16_t* data,
+                      size_t size) {
+  for (complex_int16_t* out = data; out < data + size; out += 4) {
+    Butterfly4(Div<4>(input[input_index[0]]), Div<4>(input[input_index[1]]),
+               Div<4>(input[input_index[2]]), Div<4>(input[input_index[3]]),
+               out, 1);
+    input_index += 4;
+  }
+}
+
+// kf_bfly2() as the first stage, where its twiddle factor is 1.
+void FirstRadix2Stage(const complex_int16_t* input,
+                      const uint16_t* input_index, complex_int16_t* data,
+                      size_t size) {
+  for (complex_int16_t* out = data; out < data + size; out += 2) {
+    const complex_int16_t a0 = Div<2>(input[input_index[0]]);
+    const complex_int16_t a1 = Div<2>(input[input_index[1]]);
+    out[1] = Sub(a0, a1);
+    out[0] = Add(a0, a1);
+    input_index += 2;
+  }
+}
+
+// kiss_fftr() with kiss_fft() run as radix-4 stages, in place in the output.
+void Radix4Fftr(const FftRadix4Tables* tables, const int16_t* input,
+                complex_int16_t* output, size_t fft_size) {
+  const size_t ncfft = fft_size / 2;
+  const complex_int16_t* packed =
+      reinterpret_cast<const complex_int16_t*>(input);
+
+  // kissfft factors out 4 as long as it can, leaving a radix-2 stage to run
+  // first for the odd powers of two. Each stage then spans 4 times more points.
+  size_t m;
+  if (ncfft & 0xAAAAAAAA) {
+    FirstRadix2Stage(packed, tables->input_index, output, ncfft);
+    m = 2;
+  } else {
+    FirstRadix4Stage(packed, tables->input_index, output, ncfft);
+    m = 4;
+  }
+  const complex_int16_t* twiddles = tables->stage_twiddles;
+  for (; m < ncfft; m *= 4) {
+    Radix4Stage(output, ncfft, m, twiddles);
+    twiddles += 3 * m;
+  }
+
+  // Separate the FFTs of the even and odd samples packed in the real and
+  // imaginary parts. Both points k and ncfft - k are read before either is
+  // written, which lets this run in place.
+  const complex_int16_t dc = Div<2>(output[0]);
+  output[0].real = dc.real + dc.imag;
+  output[ncfft].real = dc.real - dc.imag;
+  output[0].imag = output[ncfft].imag = 0;
+  const complex_int16_t* super_twiddles = tables->super_twiddles;
+  for (size_t k = 1; k <= ncfft / 2; ++k) {
+    const complex_int16_t fpk = Div<2>(output[k]);
+    complex_int16_t fpnk = output[ncfft - k];
+    fpnk.imag = -fpnk.imag;
+    fpnk = Div<2>(fpnk);
+    const complex_int16_t f1k = Add(fpk, fpnk);
+    const complex_int16_t tw = Mul(Sub(fpk, fpnk), super_twiddles[k - 1]);
+    output[k].real = (f1k.real + tw.real) >> 1;
+    output[k].imag = (f1k.imag + tw.imag) >> 1;
+    output[ncfft - k].real = (f1k.real - tw.real) >> 1;
+    output[ncfft - k].imag = (tw.imag - f1k.imag) >> 1;
+  }
+}
+
+}  // namespace
+
 void FftCompute(struct FftState* state, const int16_t* input,
                 int input_scale_shift) {
   const size_t input_size = state->input_size;
@@ -36,6 +178,11 @@ void FftCompute(struct FftState* state, const int16_t* input,
   }
 
   // Apply the FFT.
+  if (fft_size >= 4) {
+    Radix4Fftr(reinterpret_cast<const FftRadix4Tables*>(state->scratch),
+               state->input, state->output, fft_size);
+    return;
+  }
   kissfft_fixed16::kiss_fftr(
       reinterpret_cast<kissfft_fixed16::kiss_fftr_cfg>(state->scratch),
       state->input,
@@ -27,11 +27,26 @@ struct complex_int16_t {
   int16_t imag;
 };
 
+// Tables of the FFT for an fft_size of 4 and more, which FftPopulateState()
+// builds in the scratch buffer. The complex FFT of fft_size / 2 points that
+// the real FFT packs the input into runs as radix-4 stages, and a radix-2 one
+// first for odd powers of two, with the arithmetic of kissfft.
+struct FftRadix4Tables {
+  // Twiddle factors of the stages after the first, in the order FftCompute()
+  // reads them: three for each butterfly of a block of the stage.
+  struct complex_int16_t* stage_twiddles;
+  // Twiddle factors splitting the complex FFT into the real one.
+  struct complex_int16_t* super_twiddles;
+  // The complex input point the first stage reads at each output point.
+  uint16_t* input_index;
+};
+
 struct FftState {
   int16_t* input;
   struct complex_int16_t* output;
   size_t fft_size;
   size_t input_size;
+  // kissfft's configuration below an fft_size of 4, FftRadix4Tables from 4 on.
   void* scratch;
   size_t scratch_size;
 };
@@ -14,10 +14,86 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/microfrontend/lib/fft_util.h"
 
+#include <math.h>
 #include <stdio.h>
 
 #include "tensorflow/lite/experimental/microfrontend/lib/kiss_fft_int16.h"
 
+namespace {
+
+// kf_cexp() of kissfft_fixed16.
+complex_int16_t Exp(double phase) {
+  return {static_cast<int16_t>(floor(.5 + 32767 * cos(phase))),
+          static_cast<int16_t>(floor(.5 + 32767 * sin(phase)))};
+}
+
+// The complex input point kf_work() copies to each output point of the first
+// stage, for a sub-FFT of size points taking every stride-th one from first.
+void FillInputIndex(uint16_t* input_index, size_t first, size_t stride,
+                    size_t size) {
+  const size_t radix = size % 4 == 0 ? 4 : 2;
+  const size_t m = size / radix;
+  for (size_t q = 0; q < radix; ++q) {
+    if (m == 1) {
+      input_index[q] = first + q * stride;
+    } else {
+      FillInputIndex(input_index + q * m, first + q * stride, stride * radix,
+                     m);
+    }
+  }
+}
+
+// Builds the FftRadix4Tables of a forward FFT of fft_size points in memory,
+// or only returns their size when memory is null.
+size_t PopulateRadix4Tables(size_t fft_size, void* memory) {
+  const size_t ncfft = fft_size / 2;
+  size_t num_stage_twiddles = 0;
+  for (size_t m = ncfft / 4; m > 1; m /= 4) {
+    num_stage_twiddles += 3 * m;
+  }
+  const size_t size = sizeof(FftRadix4Tables) +
+                      (num_stage_twiddles + ncfft / 2 + ncfft) *
+                          sizeof(complex_int16_t) +
+                      ncfft * sizeof(uint16_t);
+  if (memory == nullptr) {
+    return size;
+  }
+
+  FftRadix4Tables* tables = reinterpret_cast<FftRadix4Tables*>(memory);
+  tables->stage_twiddles = reinterpret_cast<complex_int16_t*>(tables + 1);
+  tables->super_twiddles = tables->stage_twiddles + num_stage_twiddles;
+  // The twiddles of kiss_fft_alloc(), which the stages read with a stride.
+  complex_int16_t* twiddles = tables->super_twiddles + ncfft / 2;
+  tables->input_index = reinterpret_cast<uint16_t*>(twiddles + ncfft);
+
+  const double pi =
+      3.141592653589793238462643383279502884197169399375105820974944;
+  for (size_t i = 0; i < ncfft; ++i) {
+    twiddles[i] = Exp(-2 * pi * i / ncfft);
+  }
+  // A stage of m butterflies per block has ncfft / (4 * m) blocks, and reads
+  // every ncfft / (4 * m)-th twiddle. Listed from the first to run.
+  complex_int16_t* stage_twiddles = tables->stage_twiddles;
+  for (size_t m = (ncfft & 0xAAAAAAAA) ? 2 : 4; m < ncfft; m *= 4) {
+    const size_t stride = ncfft / (4 * m);
+    for (size_t k = 0; k < m; ++k) {
+      *stage_twiddles++ = twiddles[k * stride];
+      *stage_twiddles++ = twiddles[2 * k * stride];
+      *stage_twiddles++ = twiddles[3 * k * stride];
+    }
+  }
+  // As in kiss_fftr_alloc().
+  for (size_t i = 0; i < ncfft / 2; ++i) {
+    const double phase =
+        -3.14159265358979323846264338327 * ((double)(i + 1) / ncfft + .5);
+    tables->super_twiddles[i] = Exp(phase);
+  }
+  FillInputIndex(tables->input_index, 0, 1, ncfft);
+  return size;
+}
+
+}  // namespace
+
 int FftPopulateState(struct FftState* state, size_t input_size) {
   state->input_size = input_size;
   state->fft_size = 1;
@@ -39,6 +115,17 @@ int FftPopulateState(struct FftState* state, size_t input_size) {
     return 0;
   }
 
+  if (state->fft_size >= 4) {
+    state->scratch_size = PopulateRadix4Tables(state->fft_size, nullptr);
+    state->scratch = malloc(state->scratch_size);
+    if (state->scratch == nullptr) {
+      fprintf(stderr, "Failed to alloc fft tables\n");
+      return 0;
+    }
+    PopulateRadix4Tables(state->fft_size, state->scratch);
+    return 1;
+  }
+
   // Ask kissfft how much memory it wants.
   size_t scratch_size = 0;
   kissfft_fixed16::kiss_fftr_cfg kfft_cfg = kissfft_fixed16::kiss_fftr_alloc(
@@ -43,6 +43,7 @@ void FilterbankAccumulateChannels(struct FilterbankState* state,
   const int16_t* channel_frequency_starts = state->channel_frequency_starts;
   const int16_t* channel_weight_starts = state->channel_weight_starts;
   const int16_t* channel_widths = state->channel_widths;
+  const uint32_t* channel_energy_limits = state->channel_energy_limits;
 
   int num_channels_plus_1 = state->num_channels + 1;
   int i;
@@ -51,11 +52,31 @@ void FilterbankAccumulateChannels(struct FilterbankState* state,
     const int16_t* weights = state->weights + *channel_weight_starts;
     const int16_t* unweights = state->unweights + *channel_weight_starts++;
     const int width = *channel_widths++;
+    const uint32_t energy_limit = *channel_energy_limits++;
     int j;
     for (j = 0; j < width; ++j) {
-      weight_accumulator += *weights++ * ((uint64_t)*magnitudes);
-      unweight_accumulator += *unweights++ * ((uint64_t)*magnitudes);
-      ++magnitudes;
+      if ((uint32_t)magnitudes[j] > energy_limit) {
+        break;
+      }
+    }
+    if (j == width) {
+      // No product or sum passes 32 bits, so 32 bit multiply-accumulates,
+      // which are much cheaper on 32 bit cores, give the same sums.
+      uint32_t weight_sum = 0;
+      uint32_t unweight_sum = 0;
+      for (j = 0; j < width; ++j) {
+        weight_sum += *weights++ * (uint32_t)*magnitudes;
+        unweight_sum += *unweights++ * (uint32_t)*magnitudes;
+        ++magnitudes;
+      }
+      weight_accumulator += weight_sum;
+      unweight_accumulator = unweight_sum;
+    } else {
+      for (j = 0; j < width; ++j) {
+        weight_accumulator += *weights++ * ((uint64_t)*magnitudes);
+        unweight_accumulator += *unweights++ * ((uint64_t)*magnitudes);
+        ++magnitudes;
+      }
     }
     *work++ = weight_accumulator;
     weight_accumulator = unweight_accumulator;
@@ -35,6 +35,9 @@ struct FilterbankState {
   int16_t* channel_widths;
   int16_t* weights;
   int16_t* unweights;
+  // The largest energy for which a channel's sums of weighted and unweighted
+  // energies fit in 32 bits.
+  uint32_t* channel_energy_limits;
   uint64_t* work;
 };
 
@@ -45,7 +48,8 @@ void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
                                          int32_t* energy);
 
 // Computes the mel-scale filterbank on the given energy array. Output is cached
-// internally - to fetch it, you need to call FilterbankSqrt.
+// internally - to fetch it, you need to call FilterbankSqrt. Channels whose
+// energy is within their channel_energy_limits accumulate in 32 bits.
 void FilterbankAccumulateChannels(struct FilterbankState* state,
                                   const int32_t* energy);
 
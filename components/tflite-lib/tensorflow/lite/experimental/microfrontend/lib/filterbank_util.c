@@ -71,6 +71,8 @@ int FilterbankPopulateState(const struct FilterbankConfig* config,
       malloc(num_channels_plus_1 * sizeof(*state->channel_weight_starts));
   state->channel_widths =
       malloc(num_channels_plus_1 * sizeof(*state->channel_widths));
+  state->channel_energy_limits =
+      malloc(num_channels_plus_1 * sizeof(*state->channel_energy_limits));
   state->work = malloc(num_channels_plus_1 * sizeof(*state->work));
 
   float* center_mel_freqs =
@@ -82,7 +84,7 @@ int FilterbankPopulateState(const struct FilterbankConfig* config,
 
   if (state->channel_frequency_starts == NULL ||
       state->channel_weight_starts == NULL || state->channel_widths == NULL ||
-      center_mel_freqs == NULL || actual_channel_starts == NULL ||
+      state->channel_energy_limits == NULL || center_mel_freqs == NULL || actual_channel_starts == NULL ||
       actual_channel_widths == NULL) {
     free(center_mel_freqs);
     free(actual_channel_starts);
@@ -200,6 +202,28 @@ int FilterbankPopulateState(const struct FilterbankConfig* config,
     }
   }
 
+  // Each sum is at most the largest energy times the sum of the weights. A
+  // negative weight would wrap the 32 bit sums differently from the 64 bit
+  // ones, so such a channel only takes zero energy.
+  for (chan = 0; chan < num_channels_plus_1; ++chan) {
+    const int16_t* weights = state->weights + state->channel_weight_starts[chan];
+    const int16_t* unweights =
+        state->unweights + state->channel_weight_starts[chan];
+    uint32_t weight_sum = 0;
+    uint32_t unweight_sum = 0;
+    int negative = 0;
+    int j;
+    for (j = 0; j < state->channel_widths[chan]; ++j) {
+      negative |= weights[j] < 0 || unweights[j] < 0;
+      weight_sum += weights[j];
+      unweight_sum += unweights[j];
+    }
+    const uint32_t max_sum =
+        weight_sum > unweight_sum ? weight_sum : unweight_sum;
+    state->channel_energy_limits[chan] =
+        negative ? 0 : (max_sum == 0 ? UINT32_MAX : UINT32_MAX / max_sum);
+  }
+
   free(center_mel_freqs);
   free(actual_channel_starts);
   free(actual_channel_widths);
@@ -214,6 +238,7 @@ void FilterbankFreeStateContents(struct FilterbankState* state) {
   free(state->channel_frequency_starts);
   free(state->channel_weight_starts);
   free(state->channel_widths);
+  free(state->channel_energy_limits);
   free(state->weights);
   free(state->unweights);
   free(state->work);
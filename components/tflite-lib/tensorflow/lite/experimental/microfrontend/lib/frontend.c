@@ -14,22 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/microfrontend/lib/frontend.h"
 
-#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
-
-struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
-                                             const int16_t* samples,
-                                             size_t num_samples,
-                                             size_t* num_samples_read) {
-  struct FrontendOutput output;
-  output.values = NULL;
-  output.size = 0;
+#include <string.h>
 
-  // Try to apply the window - if it fails, return and wait for more data.
-  if (!WindowProcessSamples(&state->window, samples, num_samples,
-                            num_samples_read)) {
-    return output;
-  }
+#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
 
+// Computes the features of the window's output.
+static uint16_t* ProcessWindow(struct FrontendState* state) {
   // Apply the FFT to the window's output (and scale it so that the fixed point
   // FFT can have as much resolution as possible).
   int input_shift =
@@ -55,15 +45,77 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
   // Apply the log and scale.
   int correction_bits =
       MostSignificantBit32(state->fft.fft_size) - 1 - (kFilterbankBits / 2);
-  uint16_t* logged_filterbank =
-      LogScaleApply(&state->log_scale, scaled_filterbank,
-                    state->filterbank.num_channels, correction_bits);
+  return LogScaleApply(&state->log_scale, scaled_filterbank,
+                       state->filterbank.num_channels, correction_bits);
+}
+
+struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
+                                             const int16_t* samples,
+                                             size_t num_samples,
+                                             size_t* num_samples_read) {
+  struct FrontendOutput output;
+  output.values = NULL;
+  output.size = 0;
+
+  // Try to apply the window - if it fails, return and wait for more data.
+  if (!WindowProcessSamples(&state->window, samples, num_samples,
+                            num_samples_read)) {
+    return output;
+  }
 
   output.size = state->filterbank.num_channels;
-  output.values = logged_filterbank;
+  output.values = ProcessWindow(state);
   return output;
 }
 
+size_t FrontendProcessSamplesBatch(struct FrontendState* state,
+                                   const int16_t* samples, size_t num_samples,
+                                   uint16_t* features, size_t max_frames,
+                                   size_t* num_samples_read) {
+  struct WindowState* window = &state->window;
+  const size_t num_channels = state->filterbank.num_channels;
+  size_t read = 0;
+  size_t frames = 0;
+  // Whether the window's input buffer is behind, its input_used samples being
+  // the ones before samples + read rather than in the buffer.
+  int input_in_place = 0;
+
+  while (frames < max_frames) {
+    // The samples the window holds are the last input_used ones of the stream,
+    // so once as many have been read from this block, they are also in it.
+    if (window->input_used <= read &&
+        window->size - window->input_used <= num_samples - read) {
+      WindowApply(window, samples + read - window->input_used);
+      read += window->size - window->input_used;
+      window->input_used = window->size - window->step;
+      input_in_place = 1;
+    } else {
+      if (input_in_place) {
+        memcpy(window->input, samples + read - window->input_used,
+               window->input_used * sizeof(*samples));
+        input_in_place = 0;
+      }
+      size_t window_read;
+      const int have_window = WindowProcessSamples(
+          window, samples + read, num_samples - read, &window_read);
+      read += window_read;
+      if (!have_window) {
+        break;
+      }
+    }
+    memcpy(features + frames * num_channels, ProcessWindow(state),
+           num_channels * sizeof(*features));
+    ++frames;
+  }
+  if (input_in_place) {
+    memcpy(window->input, samples + read - window->input_used,
+           window->input_used * sizeof(*samples));
+  }
+
+  *num_samples_read = read;
+  return frames;
+}
+
 void FrontendReset(struct FrontendState* state) {
   WindowReset(&state->window);
   FftReset(&state->fft);
@@ -55,6 +55,19 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
                                              size_t num_samples,
                                              size_t* num_samples_read);
 
+// Processes a block of samples of any length into as many feature vectors as
+// it completes, up to max_frames, writing the i-th one to features +
+// i * filterbank.num_channels. Updates num_samples_read to contain the number
+// of samples that have been consumed, which is all of them unless max_frames
+// vectors were generated first, and returns the number of vectors. The output
+// is that of FrontendProcessSamples() called until it has consumed as much,
+// but windows that lie within samples are read in place rather than copied
+// through the window's input buffer.
+size_t FrontendProcessSamplesBatch(struct FrontendState* state,
+                                   const int16_t* samples, size_t num_samples,
+                                   uint16_t* features, size_t max_frames,
+                                   size_t* num_samples_read);
+
 void FrontendReset(struct FrontendState* state);
 
 #ifdef __cplusplus
@@ -18,8 +18,6 @@ limitations under the License.
 
 int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
                          size_t num_samples, size_t* num_samples_read) {
-  const int size = state->size;
-
   // Copy samples from the samples buffer over to our local input.
   size_t max_samples_to_copy = state->size - state->input_used;
   if (max_samples_to_copy > num_samples) {
@@ -36,8 +34,20 @@ int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
   }
 
   // Apply the window to the input.
+  WindowApply(state, state->input);
+
+  // Shuffle the input down by the step size, and update how much we have used.
+  memmove(state->input, state->input + state->step,
+          sizeof(*state->input) * (state->size - state->step));
+  state->input_used -= state->step;
+
+  // Indicate that the output buffer is valid for the next stage.
+  return 1;
+}
+
+void WindowApply(struct WindowState* state, const int16_t* input) {
+  const int size = state->size;
   const int16_t* coefficients = state->coefficients;
-  const int16_t* input = state->input;
   int16_t* output = state->output;
   int i;
   int16_t max_abs_output_value = 0;
@@ -52,14 +62,7 @@ int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
       max_abs_output_value = new_value;
     }
   }
-  // Shuffle the input down by the step size, and update how much we have used.
-  memmove(state->input, state->input + state->step,
-          sizeof(*state->input) * (state->size - state->step));
-  state->input_used -= state->step;
   state->max_abs_output_value = max_abs_output_value;
-
-  // Indicate that the output buffer is valid for the next stage.
-  return 1;
 }
 
 void WindowReset(struct WindowState* state) {
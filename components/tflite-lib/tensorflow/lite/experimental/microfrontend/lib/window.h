@@ -40,6 +40,10 @@ struct WindowState {
 int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
                          size_t num_samples, size_t* num_samples_read);
 
+// Applies the window to the size samples at input, which need not be in the
+// state's input buffer, filling output and max_abs_output_value.
+void WindowApply(struct WindowState* state, const int16_t* input);
+
 void WindowReset(struct WindowState* state);
 
 #ifdef __cplusplus
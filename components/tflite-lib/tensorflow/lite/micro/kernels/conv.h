@@ -88,25 +88,44 @@ inline TfLiteRegistration Register_CONV_2D_INT8REF() {
 }
 #endif
 
-#if defined(CMSIS_NN)
+#if defined(CMSIS_NN) || defined(ESP_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int8 activations and int8 weights and uses the latency optimized
 // implementations.
 TfLiteRegistration Register_CONV_2D_INT8();
+#else
+inline TfLiteRegistration Register_CONV_2D_INT8() { return Register_CONV_2D(); }
+#endif
 
+#if defined(CMSIS_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int16 activations and int8 weights and uses the latency optimized
 // implementations.
 TfLiteRegistration Register_CONV_2D_INT16();
 
 #else
-inline TfLiteRegistration Register_CONV_2D_INT8() { return Register_CONV_2D(); }
-
 inline TfLiteRegistration Register_CONV_2D_INT16() {
   return Register_CONV_2D();
 }
 #endif
 
+#if ESP_NN
+// Entry points for row streaming (see micro_row_streaming.h), which runs an
+// int8 convolution on bands of rows. A band's input already holds the rows of
+// vertical padding, so the kernel only pads horizontally.
+
+// Makes sure the node's scratch buffers also fit bands of up to `output_rows`
+// rows. Called once the node is prepared, before the model allocation ends.
+TfLiteStatus ConvPrepareInt8Rows(TfLiteContext* context, TfLiteNode* node,
+                                 int output_rows);
+
+// Computes `output_rows` rows of the output into `output` from the
+// `input_rows` rows at `input`.
+TfLiteStatus ConvEvalInt8Rows(TfLiteContext* context, TfLiteNode* node,
+                              const int8_t* input, int input_rows,
+                              int8_t* output, int output_rows);
+#endif
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_MICRO_KERNELS_CONV_H_
@@ -54,27 +54,40 @@ TfLiteStatus DepthwiseConvPrepare(TfLiteContext* context, TfLiteNode* node);
 // (reference or optimized) must define this function.
 TfLiteRegistration Register_DEPTHWISE_CONV_2D();
 
-#if defined(CMSIS_NN)
+#if defined(CMSIS_NN) || defined(ESP_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int8 activations and int8 weights and uses the latency optimized
 // implementations.
 TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT8();
+#else
+inline TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT8() {
+  return Register_DEPTHWISE_CONV_2D();
+}
+#endif
 
+#if defined(CMSIS_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int16 activations and int8 weights and uses the latency optimized
 // implementations.
 TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT16();
 
 #else
-inline TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT8() {
-  return Register_DEPTHWISE_CONV_2D();
-}
-
 inline TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT16() {
   return Register_DEPTHWISE_CONV_2D();
 }
 #endif
 
+#if ESP_NN
+// Row streaming entry points, the depthwise counterparts of
+// ConvPrepareInt8Rows() and ConvEvalInt8Rows() in conv.h.
+TfLiteStatus DepthwiseConvPrepareInt8Rows(TfLiteContext* context,
+                                          TfLiteNode* node, int output_rows);
+TfLiteStatus DepthwiseConvEvalInt8Rows(TfLiteContext* context,
+                                       TfLiteNode* node, const int8_t* input,
+                                       int input_rows, int8_t* output,
+                                       int output_rows);
+#endif
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_MICRO_KERNELS_DEPTHWISE_CONV_H_
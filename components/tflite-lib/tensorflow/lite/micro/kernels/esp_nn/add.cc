@@ -28,14 +28,10 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long add_total_time = 0;
-
 namespace tflite {
 
 void EvalAdd(TfLiteContext* context, TfLiteNode* node, TfLiteAddParams* params,
@@ -178,8 +174,6 @@ TfLiteStatus AddEval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kAddOutputTensor);
 
-  long long start_time = esp_timer_get_time();
-
   if (output->type == kTfLiteFloat32) {
     EvalAdd(context, node, params, data, input1, input2, output);
   } else if (output->type == kTfLiteInt8 || output->type == kTfLiteInt16) {
@@ -190,7 +184,6 @@ TfLiteStatus AddEval(TfLiteContext* context, TfLiteNode* node) {
                 output->type);
     return kTfLiteError;
   }
-  add_total_time += esp_timer_get_time() - start_time;
 
   return kTfLiteOk;
 }
@@ -27,21 +27,30 @@ limitations under the License.
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long dc_total_time = 0;
-
 namespace tflite {
 namespace {
 
 struct NodeData {
   OpDataConv op_data;
 #if ESP_NN
-  int buffer_idx;
+  // One scratch buffer per worker of esp_nn_*_parallel.
+  int buffer_idx[ESP_NN_MAX_WORKERS];
+  // Bytes of each of the buffers above.
+  int scratch_size;
+  // Arguments of the esp_nn call for int8 data, set by Prepare. Eval runs
+  // one call per batch, `input_size` and `output_size` elements apart.
+  data_dims_t input_dims;
+  data_dims_t filter_dims;
+  data_dims_t output_dims;
+  dw_conv_params_t conv_params;
+  quant_data_t quant_data;
+  int input_size;
+  int output_size;
+  int batch_size;
 #endif
 };
 
@@ -62,85 +71,27 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
   const int dilation_height_factor = params.dilation_height_factor;
 
   if (dilation_width_factor == 1 && dilation_height_factor == 1) {
-    // Get parameters.
-    RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
-    RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
-    RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
-    RuntimeShape bias_shape = tflite::micro::GetTensorShape(bias);
-
-    TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-    TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
-    TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+    void *scratch_bufs[ESP_NN_MAX_WORKERS];
+    for (int i = 0; i < ESP_NN_MAX_WORKERS; i++) {
+      scratch_bufs[i] = NULL;
+      if (data.buffer_idx[i] > -1) {
+        scratch_bufs[i] = context->GetScratchBuffer(context, data.buffer_idx[i]);
+      }
+    }
 
     const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
+    const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+    const int32_t *bias_data = tflite::micro::GetTensorData<int32_t>(bias);
     int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
 
-    const int depth_multiplier = params.depth_multiplier;
-    const int32_t input_offset = -data.op_data.input_zero_point;
-    const int32_t output_offset = data.op_data.output_zero_point;
-    const int stride_width = params.stride_width;
-    const int stride_height = params.stride_height;
-    const int pad_width = data.op_data.padding.width;
-    const int pad_height = data.op_data.padding.height;
-
-    const int input_height = input_shape.Dims(1);
-    const int input_width = input_shape.Dims(2);
-    const int input_depth = input_shape.Dims(3);
-    const int filter_height = filter_shape.Dims(1);
-    const int filter_width = filter_shape.Dims(2);
-    const int output_height = output_shape.Dims(1);
-    const int output_width = output_shape.Dims(2);
-
-    // Set min and max value of the output.
-    const int32_t activation_min = data.op_data.output_activation_min;
-    const int32_t activation_max = data.op_data.output_activation_max;
-
-    // Consistency check.
-    TFLITE_DCHECK_LE(activation_min, activation_max);
-    const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
-    const int output_depth = MatchingDim(filter_shape, 3, output_shape, 3);
-
-    TFLITE_DCHECK_EQ(output_depth, input_depth * depth_multiplier);
-    if (tflite::micro::GetTensorData<int8_t>(bias)) {
-      TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
-    }
-
-    const int input_size = input_width * input_height * input_depth;
-    const int output_size = output_width * output_height * output_depth;
-    void *scratch_buf = NULL;
-    if (data.buffer_idx > -1) {
-      scratch_buf = context->GetScratchBuffer(context, data.buffer_idx);
-    }
-
-    esp_nn_set_depthwise_conv_scratch_buf(scratch_buf);
-
-    data_dims_t input_dims =  {
-                                .width = input_width, .height = input_height,
-                                .channels = input_depth, 1
-                              };
-    data_dims_t output_dims = {
-                                .width = output_width, .height = output_height,
-                                .channels = output_depth, 1
-                              };
-    data_dims_t filter_dims = {.width = filter_width, .height = filter_height, 0, 0};
-    dw_conv_params_t conv_params =  {
-                                      .in_offset = input_offset, .out_offset = output_offset,
-                                      .ch_mult = depth_multiplier,
-                                      .stride = {stride_width, stride_height},
-                                      .padding = {pad_width, pad_height}, .dilation = {0, 0},
-                                      .activation = {activation_min, activation_max}
-                                    };
-    quant_data_t quant_data = {
-                                .shift = data.op_data.per_channel_output_shift,
-                                .mult = data.op_data.per_channel_output_multiplier
-                              };
-
-    for (int i_batch = 0; i_batch < batch_size; i_batch++) {
-      esp_nn_depthwise_conv_s8(&input_dims, input_data + i_batch * input_size,
-                               &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
-                               tflite::micro::GetTensorData<int32_t>(bias),
-                               &output_dims, output_data + i_batch * output_size,
-                               &conv_params, &quant_data);
+    // Shapes, offsets and quantization were set up by Prepare. Output rows
+    // are split across cores when CONFIG_NN_MULTICORE is set, otherwise this
+    // is a plain esp_nn_depthwise_conv_s8 call.
+    for (int i_batch = 0; i_batch < data.batch_size; i_batch++) {
+      esp_nn_depthwise_conv_s8_parallel(&data.input_dims, input_data + i_batch * data.input_size,
+                                        &data.filter_dims, filter_data, bias_data,
+                                        &data.output_dims, output_data + i_batch * data.output_size,
+                                        &data.conv_params, &data.quant_data, scratch_bufs);
     }
   } else {
     reference_integer_ops::DepthwiseConvPerChannel(
@@ -223,30 +174,47 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
 #if ESP_NN
   if (input->type == kTfLiteInt8) {
-    data_dims_t input_dims =  {
-                                .width = input_width, .height = input_height,
-                                .channels = input->dims->data[3], 1
-                              };
-    data_dims_t output_dims = {
-                                .width = output_width, .height = output_height,
-                                .channels = output->dims->data[3], 1
-                              };
-    data_dims_t filter_dims = {.width = filter_width, .height = filter_height, 0, 0};
-    dw_conv_params_t conv_params =  {
-                                      .in_offset = 0, .out_offset = 0,
-                                      .ch_mult = params.depth_multiplier,
-                                      .stride = {params.stride_width, params.stride_height},
-                                      .padding = {data->op_data.padding.width, data->op_data.padding.height},
-                                      .dilation = {0, 0}, .activation = {-128, 127}
-                                    };
-
-    int scratch_buf_size = esp_nn_get_depthwise_conv_scratch_size(
-        &input_dims, &filter_dims, &output_dims, &conv_params);
+    const int input_depth = input->dims->data[3];
+    const int output_depth = output->dims->data[3];
+    data->input_dims =  {
+                          .width = input_width, .height = input_height,
+                          .channels = input_depth, 1
+                        };
+    data->output_dims = {
+                          .width = output_width, .height = output_height,
+                          .channels = output_depth, 1
+                        };
+    data->filter_dims = {.width = filter_width, .height = filter_height, 0, 0};
+    data->conv_params = {
+                          .in_offset = -data->op_data.input_zero_point,
+                          .out_offset = data->op_data.output_zero_point,
+                          .ch_mult = params.depth_multiplier,
+                          .stride = {params.stride_width, params.stride_height},
+                          .padding = {data->op_data.padding.width, data->op_data.padding.height},
+                          .dilation = {0, 0},
+                          .activation = {data->op_data.output_activation_min,
+                                         data->op_data.output_activation_max}
+                        };
+    data->quant_data = {
+                         .shift = data->op_data.per_channel_output_shift,
+                         .mult = data->op_data.per_channel_output_multiplier
+                       };
+    data->input_size = input_width * input_height * input_depth;
+    data->output_size = output_width * output_height * output_depth;
+    data->batch_size = input->dims->data[0];
+
+    int scratch_buf_size = esp_nn_get_depthwise_conv_scratch_size_parallel(
+        &data->input_dims, &data->filter_dims, &data->output_dims,
+        &data->conv_params);
+    for (int i = 0; i < ESP_NN_MAX_WORKERS; i++) {
+      data->buffer_idx[i] = -1;
+    }
+    data->scratch_size = scratch_buf_size;
     if (scratch_buf_size > 0) {
-      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
-        context, scratch_buf_size, &data->buffer_idx));
-    } else {
-      data->buffer_idx = -1;
+      for (int i = 0; i < esp_nn_parallel_num_workers(); i++) {
+        TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, scratch_buf_size, &data->buffer_idx[i]));
+      }
     }
   }
 #endif
@@ -278,7 +246,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           ? tflite::micro::GetEvalInput(context, node, kDepthwiseConvBiasTensor)
           : nullptr;
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32:
       tflite::reference_ops::DepthwiseConv(
@@ -329,12 +296,36 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  long long time_this_instance = esp_timer_get_time() - start_time;
-  dc_total_time += time_this_instance;
-  // printf("time this instance: %llu\n", time_this_instance / 1000);
+  return kTfLiteOk;
+}
 
+#if ESP_NN
+// Eval of Register_DEPTHWISE_CONV_2D_INT8(), which leaves the float and uint8
+// kernels out of the link.
+TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  auto& params =
+      *(reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data));
+  const NodeData& data = *(static_cast<const NodeData*>(node->user_data));
+
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kDepthwiseConvOutputTensor);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kDepthwiseConvBiasTensor)
+          : nullptr;
+
+  EvalQuantizedPerChannel(context, node, params, data, input, filter, bias,
+                          output);
   return kTfLiteOk;
 }
+#endif
 
 }  // namespace
 
@@ -342,4 +333,125 @@ TfLiteRegistration Register_DEPTHWISE_CONV_2D() {
   return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
+#if ESP_NN
+TfLiteRegistration Register_DEPTHWISE_CONV_2D_INT8() {
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+}
+#endif
+
+#if ESP_NN
+TfLiteStatus DepthwiseConvPrepareInt8Rows(TfLiteContext* context,
+                                          TfLiteNode* node, int output_rows) {
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+  const auto& params =
+      *(static_cast<const TfLiteDepthwiseConvParams*>(node->builtin_data));
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvWeightsTensor);
+  const TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kDepthwiseConvOutputTensor);
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, params.dilation_width_factor, 1);
+  TF_LITE_ENSURE_EQ(context, params.dilation_height_factor, 1);
+
+  const int filter_height = filter->dims->data[1];
+  data_dims_t input_dims =  {
+                              .width = input->dims->data[2],
+                              .height = (output_rows - 1) * params.stride_height + filter_height,
+                              .channels = input->dims->data[3], 1
+                            };
+  data_dims_t output_dims = {
+                              .width = output->dims->data[2], .height = output_rows,
+                              .channels = output->dims->data[3], 1
+                            };
+  data_dims_t filter_dims = {.width = filter->dims->data[2], .height = filter_height, 0, 0};
+  dw_conv_params_t conv_params =  {
+                                    .in_offset = 0, .out_offset = 0,
+                                    .ch_mult = params.depth_multiplier,
+                                    .stride = {params.stride_width, params.stride_height},
+                                    .padding = {data->op_data.padding.width, 0},
+                                    .dilation = {0, 0}, .activation = {-128, 127}
+                                  };
+
+  // Without vertical padding a band may take another kernel variant, with
+  // its own scratch needs. The buffers requested by Prepare grow to fit it.
+  int scratch_buf_size = esp_nn_get_depthwise_conv_scratch_size_parallel(
+      &input_dims, &filter_dims, &output_dims, &conv_params);
+  if (scratch_buf_size > data->scratch_size) {
+    MicroContext* micro_context = GetMicroContext(context);
+    for (int i = 0; i < esp_nn_parallel_num_workers(); i++) {
+      if (data->buffer_idx[i] > -1) {
+        TF_LITE_ENSURE_STATUS(micro_context->ResizeScratchBufferInArena(
+          scratch_buf_size, data->buffer_idx[i]));
+      } else {
+        TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, scratch_buf_size, &data->buffer_idx[i]));
+      }
+    }
+    data->scratch_size = scratch_buf_size;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus DepthwiseConvEvalInt8Rows(TfLiteContext* context,
+                                       TfLiteNode* node,
+                                       const int8_t* input_data,
+                                       int input_rows, int8_t* output_data,
+                                       int output_rows) {
+  const auto& params =
+      *(static_cast<const TfLiteDepthwiseConvParams*>(node->builtin_data));
+  const NodeData& data = *(static_cast<const NodeData*>(node->user_data));
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kDepthwiseConvBiasTensor)
+          : nullptr;
+  const TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kDepthwiseConvOutputTensor);
+
+  void *scratch_bufs[ESP_NN_MAX_WORKERS];
+  for (int i = 0; i < ESP_NN_MAX_WORKERS; i++) {
+    scratch_bufs[i] = NULL;
+    if (data.buffer_idx[i] > -1) {
+      scratch_bufs[i] = context->GetScratchBuffer(context, data.buffer_idx[i]);
+    }
+  }
+
+  data_dims_t input_dims =  {
+                              .width = input->dims->data[2], .height = input_rows,
+                              .channels = input->dims->data[3], 1
+                            };
+  data_dims_t output_dims = {
+                              .width = output->dims->data[2], .height = output_rows,
+                              .channels = output->dims->data[3], 1
+                            };
+  data_dims_t filter_dims = {.width = filter->dims->data[2], .height = filter->dims->data[1], 0, 0};
+  dw_conv_params_t conv_params =  {
+                                    .in_offset = -data.op_data.input_zero_point,
+                                    .out_offset = data.op_data.output_zero_point,
+                                    .ch_mult = params.depth_multiplier,
+                                    .stride = {params.stride_width, params.stride_height},
+                                    .padding = {data.op_data.padding.width, 0},
+                                    .dilation = {0, 0},
+                                    .activation = {data.op_data.output_activation_min,
+                                                   data.op_data.output_activation_max}
+                                  };
+  quant_data_t quant_data = {
+                              .shift = data.op_data.per_channel_output_shift,
+                              .mult = data.op_data.per_channel_output_multiplier
+                            };
+
+  esp_nn_depthwise_conv_s8_parallel(&input_dims, input_data, &filter_dims,
+                                    tflite::micro::GetTensorData<int8_t>(filter),
+                                    tflite::micro::GetTensorData<int32_t>(bias),
+                                    &output_dims, output_data, &conv_params,
+                                    &quant_data, scratch_bufs);
+  return kTfLiteOk;
+}
+#endif
+
 }  // namespace tflite
@@ -29,17 +29,23 @@ limitations under the License.
 #include <esp_nn.h>
 #endif
 
-#include <esp_timer.h>
-
-long long fc_total_time = 0;
-
 namespace tflite {
 namespace {
 
+struct NodeData {
+  OpDataFullyConnected op_data;
+#if ESP_NN
+  // Arguments of the esp_nn call for int8 data, set by Prepare. Eval runs
+  // one call per batch.
+  int batches;
+  int accum_depth;
+  int output_depth;
+#endif
+};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context,
-                                           sizeof(OpDataFullyConnected));
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -48,7 +54,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
 
-  auto* data = static_cast<OpDataFullyConnected*>(node->user_data);
+  auto* data = static_cast<NodeData*>(node->user_data);
   const auto params =
       static_cast<const TfLiteFullyConnectedParams*>(node->builtin_data);
 
@@ -70,7 +76,18 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   TF_LITE_ENSURE_OK(context, CalculateOpDataFullyConnected(
                                  context, params->activation, input->type,
-                                 input, filter, bias, output, data));
+                                 input, filter, bias, output, &data->op_data));
+
+#if ESP_NN
+  if (input->type == kTfLiteInt8) {
+    const int filter_dim_count = NumDimensions(filter);
+    data->output_depth = output->dims->data[NumDimensions(output) - 1];
+    data->batches = NumElements(output) / data->output_depth;
+    TF_LITE_ENSURE(context, data->output_depth <=
+                                filter->dims->data[filter_dim_count - 2]);
+    data->accum_depth = filter->dims->data[filter_dim_count - 1];
+  }
+#endif
 
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
@@ -81,6 +98,57 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+#if ESP_NN
+void EvalQuantizedInt8(const NodeData& node_data,
+                       const TfLiteEvalTensor* input,
+                       const TfLiteEvalTensor* filter,
+                       const int32_t* bias_data, TfLiteEvalTensor* output) {
+  const OpDataFullyConnected& data = node_data.op_data;
+  const int batches = node_data.batches;
+  const int output_depth = node_data.output_depth;
+  const int accum_depth = node_data.accum_depth;
+
+  const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
+  const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+
+  for (int b = 0; b < batches; ++b) {
+    esp_nn_fully_connected_s8(input_data, -data.input_zero_point,
+                              accum_depth,
+                              filter_data, -data.filter_zero_point,
+                              bias_data, output_data, output_depth,
+                              data.output_zero_point,
+                              data.output_shift, data.output_multiplier,
+                              data.output_activation_min,
+                              data.output_activation_max);
+    input_data += accum_depth;
+    output_data += output_depth;
+  }
+}
+
+// Eval of Register_FULLY_CONNECTED_INT8(), int8 input and output only, which
+// leaves the float and uint8 kernels out of the link.
+TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kFullyConnectedInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kFullyConnectedWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kFullyConnectedBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kFullyConnectedOutputTensor);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const auto& data = *(static_cast<const NodeData*>(node->user_data));
+
+  EvalQuantizedInt8(data, input, filter,
+                    nullptr != bias ? tflite::micro::GetTensorData<int32_t>(bias)
+                                    : nullptr,
+                    output);
+  return kTfLiteOk;
+}
+#endif
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->builtin_data != nullptr);
   const auto* params =
@@ -96,10 +164,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       tflite::micro::GetEvalOutput(context, node, kFullyConnectedOutputTensor);
 
   TFLITE_DCHECK(node->user_data != nullptr);
-  const auto& data =
-      *(static_cast<const OpDataFullyConnected*>(node->user_data));
+  const auto& data = *(static_cast<const NodeData*>(node->user_data));
 
-  long long start_time = esp_timer_get_time();
   // Checks in Prepare ensure input, output and filter types are all the same.
   switch (input->type) {
     case kTfLiteFloat32: {
@@ -121,33 +187,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           nullptr != bias ? tflite::micro::GetTensorData<int32_t>(bias)
                           : nullptr;
 #if ESP_NN
-      const RuntimeShape& filter_shape = tflite::micro::GetTensorShape(filter);
-      const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
-      const int filter_dim_count = filter_shape.DimensionsCount();
-      const int batches = output_shape.Dims(0);
-      const int output_depth = output_shape.Dims(1);
-      TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
-      const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
-
-      const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
-      int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
-      const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
-
-      for (int b = 0; b < batches; ++b) {
-        esp_nn_fully_connected_s8(input_data, -data.input_zero_point,
-                                  accum_depth,
-                                  filter_data, -data.filter_zero_point,
-                                  bias_data, output_data, output_depth,
-                                  data.output_zero_point,
-                                  data.output_shift, data.output_multiplier,
-                                  data.output_activation_min,
-                                  data.output_activation_max);
-        input_data += accum_depth;
-        output_data += output_depth;
-      }
+      EvalQuantizedInt8(data, input, filter, bias_data, output);
 #else
       tflite::reference_integer_ops::FullyConnected(
-          FullyConnectedParamsQuantized(data),
+          FullyConnectedParamsQuantized(data.op_data),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<int8_t>(input),
           tflite::micro::GetTensorShape(filter),
@@ -161,7 +204,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
     case kTfLiteUInt8: {
       tflite::reference_ops::FullyConnected(
-          FullyConnectedParamsQuantized(data),
+          FullyConnectedParamsQuantized(data.op_data),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<uint8_t>(input),
           tflite::micro::GetTensorShape(filter),
@@ -178,7 +221,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
     }
   }
-  fc_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -188,4 +230,10 @@ TfLiteRegistration Register_FULLY_CONNECTED() {
   return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
+#if ESP_NN
+TfLiteRegistration Register_FULLY_CONNECTED_INT8() {
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+}
+#endif
+
 }  // namespace tflite
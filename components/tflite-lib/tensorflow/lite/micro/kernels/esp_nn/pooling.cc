@@ -23,122 +23,88 @@ limitations under the License.
 #include <esp_nn.h>
 #endif
 
-#include <esp_timer.h>
-
-long long pooling_total_time = 0;
-
 namespace tflite {
 
 namespace {
+
+struct NodeData {
+  OpDataPooling op_data;
 #if ESP_NN
-void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
-                          const TfLitePoolParams* params, const OpDataPooling* data,
+  // Arguments of the esp_nn calls for int8 data, set by Prepare. Eval runs
+  // one call per batch, `input_size` and `output_size` elements apart.
+  int input_width;
+  int input_height;
+  int output_width;
+  int output_height;
+  int depth;
+  int batches;
+  int input_size;
+  int output_size;
+#endif
+};
+
+#if ESP_NN
+void AverageEvalQuantized(const TfLitePoolParams* params, const NodeData* data,
                           const TfLiteEvalTensor* input,
                           TfLiteEvalTensor* output) {
-
-  const int stride_height = params->stride_height;
-  const int stride_width = params->stride_width;
-  const int filter_height = params->filter_height;
-  const int filter_width = params->filter_width;
-  const int activation_min = data->activation_min;
-  const int activation_max = data->activation_max;
-  const int pad_height = data->padding.height;
-  const int pad_width = data->padding.width;
-
-  const RuntimeShape& input_shape = tflite::micro::GetTensorShape(input);
-  const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
-  TFLITE_DCHECK_LE(activation_min, activation_max);
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
-  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
-  const int input_height = input_shape.Dims(1);
-  const int input_width = input_shape.Dims(2);
-  const int output_height = output_shape.Dims(1);
-  const int output_width = output_shape.Dims(2);
-
   const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
   int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
 
-  const int input_size = input_width * input_height * depth;
-  const int output_size = output_width * output_height * depth;
-
-  if (depth % 4 == 0) { // S3 version only supports channels multiple of 4
-    for (int batch = 0; batch < batches; ++batch) {
-      esp_nn_avg_pool_s8(input_data, input_width, input_height,
-                         output_data, output_width, output_height,
-                         stride_width, stride_height,
-                         filter_width, filter_height,
-                         pad_width, pad_height,
-                         activation_min, activation_max, depth);
-      input_data += input_size;
-      output_data += output_size;
+  if (data->depth % 4 == 0) { // S3 version only supports channels multiple of 4
+    for (int batch = 0; batch < data->batches; ++batch) {
+      esp_nn_avg_pool_s8(input_data, data->input_width, data->input_height,
+                         output_data, data->output_width, data->output_height,
+                         params->stride_width, params->stride_height,
+                         params->filter_width, params->filter_height,
+                         data->op_data.padding.width, data->op_data.padding.height,
+                         data->op_data.activation_min,
+                         data->op_data.activation_max, data->depth);
+      input_data += data->input_size;
+      output_data += data->output_size;
     }
   } else {
-    for (int batch = 0; batch < batches; ++batch) {
-      esp_nn_avg_pool_s8_ansi(input_data, input_width, input_height,
-                              output_data, output_width, output_height,
-                              stride_width, stride_height,
-                              filter_width, filter_height,
-                              pad_width, pad_height,
-                              activation_min, activation_max, depth);
-      input_data += input_size;
-      output_data += output_size;
+    for (int batch = 0; batch < data->batches; ++batch) {
+      esp_nn_avg_pool_s8_ansi(input_data, data->input_width, data->input_height,
+                              output_data, data->output_width, data->output_height,
+                              params->stride_width, params->stride_height,
+                              params->filter_width, params->filter_height,
+                              data->op_data.padding.width, data->op_data.padding.height,
+                              data->op_data.activation_min,
+                              data->op_data.activation_max, data->depth);
+      input_data += data->input_size;
+      output_data += data->output_size;
     }
   }
 }
 
-void MaxEvalQuantized(TfLiteContext* context, TfLiteNode* node,
-                      TfLitePoolParams* params, const OpDataPooling* data,
+void MaxEvalQuantized(const TfLitePoolParams* params, const NodeData* data,
                       const TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
-
-  const int stride_height = params->stride_height;
-  const int stride_width = params->stride_width;
-  const int filter_height = params->filter_height;
-  const int filter_width = params->filter_width;
-  const int activation_min = data->activation_min;
-  const int activation_max = data->activation_max;
-  const int pad_height = data->padding.height;
-  const int pad_width = data->padding.width;
-
-  const RuntimeShape& input_shape = tflite::micro::GetTensorShape(input);
-  const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
-  TFLITE_DCHECK_LE(activation_min, activation_max);
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
-  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
-  const int input_height = input_shape.Dims(1);
-  const int input_width = input_shape.Dims(2);
-  const int output_height = output_shape.Dims(1);
-  const int output_width = output_shape.Dims(2);
-
   const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
   int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
 
-  const int input_size = input_width * input_height * depth;
-  const int output_size = output_width * output_height * depth;
-  if (depth % 4 == 0) { // S3 version only supports channels multiple of 4
-    for (int batch = 0; batch < batches; ++batch) {
-      esp_nn_max_pool_s8(input_data, input_width, input_height,
-                         output_data, output_width, output_height,
-                         stride_width, stride_height,
-                         filter_width, filter_height,
-                         pad_width, pad_height,
-                         activation_min, activation_max, depth);
-      input_data += input_size;
-      output_data += output_size;
+  if (data->depth % 4 == 0) { // S3 version only supports channels multiple of 4
+    for (int batch = 0; batch < data->batches; ++batch) {
+      esp_nn_max_pool_s8(input_data, data->input_width, data->input_height,
+                         output_data, data->output_width, data->output_height,
+                         params->stride_width, params->stride_height,
+                         params->filter_width, params->filter_height,
+                         data->op_data.padding.width, data->op_data.padding.height,
+                         data->op_data.activation_min,
+                         data->op_data.activation_max, data->depth);
+      input_data += data->input_size;
+      output_data += data->output_size;
     }
   } else {
-    for (int batch = 0; batch < batches; ++batch) {
-      esp_nn_max_pool_s8_ansi(input_data, input_width, input_height,
-                              output_data, output_width, output_height,
-                              stride_width, stride_height,
-                              filter_width, filter_height,
-                              pad_width, pad_height,
-                              activation_min, activation_max, depth);
-      input_data += input_size;
-      output_data += output_size;
+    for (int batch = 0; batch < data->batches; ++batch) {
+      esp_nn_max_pool_s8_ansi(input_data, data->input_width, data->input_height,
+                              output_data, data->output_width, data->output_height,
+                              params->stride_width, params->stride_height,
+                              params->filter_width, params->filter_height,
+                              data->op_data.padding.width, data->op_data.padding.height,
+                              data->op_data.activation_min,
+                              data->op_data.activation_max, data->depth);
+      input_data += data->input_size;
+      output_data += data->output_size;
     }
   }
 }
@@ -149,25 +115,25 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
 
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataPooling* data =
-      static_cast<const OpDataPooling*>(node->user_data);
+  const NodeData* data = static_cast<const NodeData*>(node->user_data);
 
   const TfLiteEvalTensor* input =
       micro::GetEvalInput(context, node, kPoolingInputTensor);
   TfLiteEvalTensor* output =
       micro::GetEvalOutput(context, node, kPoolingOutputTensor);
 
-  long long start_time = esp_timer_get_time();
   // Inputs and outputs share the same type, guaranteed by the converter.
   switch (input->type) {
     case kTfLiteFloat32:
-      AveragePoolingEvalFloat(context, node, params, data, input, output);
+      AveragePoolingEvalFloat(context, node, params, &data->op_data, input,
+                              output);
       break;
     case kTfLiteInt8:
 #if ESP_NN
-      AverageEvalQuantized(context, node, params, data, input, output);
+      AverageEvalQuantized(params, data, input, output);
 #else
-      AveragePoolingEvalQuantized(context, node, params, data, input, output);
+      AveragePoolingEvalQuantized(context, node, params, &data->op_data, input,
+                                  output);
 #endif
       break;
     default:
@@ -175,7 +141,6 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type));
       return kTfLiteError;
   }
-  pooling_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -184,24 +149,24 @@ TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
 
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataPooling* data =
-      static_cast<const OpDataPooling*>(node->user_data);
+  const NodeData* data = static_cast<const NodeData*>(node->user_data);
 
   const TfLiteEvalTensor* input =
       micro::GetEvalInput(context, node, kPoolingInputTensor);
   TfLiteEvalTensor* output =
       micro::GetEvalOutput(context, node, kPoolingOutputTensor);
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {
     case kTfLiteFloat32:
-      MaxPoolingEvalFloat(context, node, params, data, input, output);
+      MaxPoolingEvalFloat(context, node, params, &data->op_data, input,
+                          output);
       break;
     case kTfLiteInt8:
 #if ESP_NN
-      MaxEvalQuantized(context, node, params, data, input, output);
+      MaxEvalQuantized(params, data, input, output);
 #else
-      MaxPoolingEvalQuantized(context, node, params, data, input, output);
+      MaxPoolingEvalQuantized(context, node, params, &data->op_data, input,
+                              output);
 #endif
       break;
     default:
@@ -209,23 +174,104 @@ TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type));
       return kTfLiteError;
   }
-  pooling_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
+#if ESP_NN
+// Evals of the _INT8 registrations, which leave the float kernels out of the
+// link. Everything but the tensor data comes from Prepare.
+TfLiteStatus AverageEvalInt8(TfLiteContext* context, TfLiteNode* node) {
+  AverageEvalQuantized(
+      static_cast<const TfLitePoolParams*>(node->builtin_data),
+      static_cast<const NodeData*>(node->user_data),
+      micro::GetEvalInput(context, node, kPoolingInputTensor),
+      micro::GetEvalOutput(context, node, kPoolingOutputTensor));
+  return kTfLiteOk;
+}
+
+TfLiteStatus MaxEvalInt8(TfLiteContext* context, TfLiteNode* node) {
+  MaxEvalQuantized(
+      static_cast<const TfLitePoolParams*>(node->builtin_data),
+      static_cast<const NodeData*>(node->user_data),
+      micro::GetEvalInput(context, node, kPoolingInputTensor),
+      micro::GetEvalOutput(context, node, kPoolingOutputTensor));
+  return kTfLiteOk;
+}
+#endif
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(OpDataPooling));
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+}
+
+// PoolingPrepare() for NodeData, which also sets up the esp_nn arguments.
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kPoolingInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kPoolingOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_STATUS(
+      CalculateOpDataPooling(context, params, input, output, &data->op_data));
+
+  if (input->type == kTfLiteFloat32) {
+    CalculateActivationRange(params->activation,
+                             &data->op_data.activation_min_f32,
+                             &data->op_data.activation_max_f32);
+  } else if (input->type == kTfLiteInt8) {
+    CalculateActivationRangeQuantized(context, params->activation, output,
+                                      &data->op_data.activation_min,
+                                      &data->op_data.activation_max);
+#if ESP_NN
+    TF_LITE_ENSURE_EQ(context, NumDimensions(input), 4);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(output), 4);
+    data->batches = input->dims->data[0];
+    data->depth = input->dims->data[3];
+    TF_LITE_ENSURE_EQ(context, output->dims->data[0], data->batches);
+    TF_LITE_ENSURE_EQ(context, output->dims->data[3], data->depth);
+    data->input_height = input->dims->data[1];
+    data->input_width = input->dims->data[2];
+    data->output_height = output->dims->data[1];
+    data->output_width = output->dims->data[2];
+    data->input_size = data->input_width * data->input_height * data->depth;
+    data->output_size = data->output_width * data->output_height * data->depth;
+#endif
+  }
+
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(output);
+
+  return kTfLiteOk;
 }
 
 }  // namespace
 
 TfLiteRegistration Register_AVERAGE_POOL_2D() {
-  return tflite::micro::RegisterOp(Init, PoolingPrepare, AverageEval);
+  return tflite::micro::RegisterOp(Init, Prepare, AverageEval);
 }
 
 TfLiteRegistration Register_MAX_POOL_2D() {
-  return tflite::micro::RegisterOp(Init, PoolingPrepare, MaxEval);
+  return tflite::micro::RegisterOp(Init, Prepare, MaxEval);
 }
 
+#if ESP_NN
+TfLiteRegistration Register_AVERAGE_POOL_2D_INT8() {
+  return tflite::micro::RegisterOp(Init, Prepare, AverageEvalInt8);
+}
+
+TfLiteRegistration Register_MAX_POOL_2D_INT8() {
+  return tflite::micro::RegisterOp(Init, Prepare, MaxEvalInt8);
+}
+#endif
+
 }  // namespace tflite
@@ -25,14 +25,10 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long softmax_total_time = 0;
-
 namespace tflite {
 namespace {
 // Softmax parameter data that persists in user_data
@@ -42,6 +38,9 @@ struct NodeData {
   SoftmaxParams op_data;
 #if ESP_NN
   int buffer_idx;
+  // Rows and row length of esp_nn_softmax_s8, set by Prepare.
+  int outer_size;
+  int depth;
 #endif
 };
 
@@ -50,6 +49,24 @@ static void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(NodeData));
 }
 
+#if ESP_NN
+void SoftmaxInt8(TfLiteContext* context, const TfLiteEvalTensor* input,
+                 TfLiteEvalTensor* output, const NodeData* data) {
+  const int32_t input_beta_multiplier = data->op_data.input_multiplier;
+  const int32_t input_beta_left_shift = data->op_data.input_left_shift;
+  const int diff_min = data->op_data.diff_min;
+  const int8_t *in_ptr = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t *out_ptr = tflite::micro::GetTensorData<int8_t>(output);
+  void *scratch_buf = NULL;
+  if (data->buffer_idx > -1) {
+    scratch_buf = context->GetScratchBuffer(context, data->buffer_idx);
+  }
+  esp_nn_set_softmax_scratch_buf(scratch_buf);
+  esp_nn_softmax_s8(in_ptr, data->outer_size, data->depth, input_beta_multiplier,
+                    input_beta_left_shift, diff_min, out_ptr);
+}
+#endif
+
 void SoftmaxQuantized(TfLiteContext* context, const TfLiteEvalTensor* input,
                       TfLiteEvalTensor* output, const NodeData* data) {
   if (input->type == kTfLiteInt8) {
@@ -61,25 +78,7 @@ void SoftmaxQuantized(TfLiteContext* context, const TfLiteEvalTensor* input,
           tflite::micro::GetTensorData<int16_t>(output));
     } else {
 #if ESP_NN
-      const int32_t input_beta_multiplier = data->op_data.input_multiplier;
-      const int32_t input_beta_left_shift = data->op_data.input_left_shift;
-      const int diff_min = data->op_data.diff_min;
-      const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
-      const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
-      const int trailing_dim = input_shape.DimensionsCount() - 1;
-      const int outer_size =
-          MatchingFlatSizeSkipDim(input_shape, trailing_dim, output_shape);
-      const int depth =
-          MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
-      const int8_t *in_ptr = tflite::micro::GetTensorData<int8_t>(input);
-      int8_t *out_ptr = tflite::micro::GetTensorData<int8_t>(output);
-      void *scratch_buf = NULL;
-      if (data->buffer_idx > -1) {
-        scratch_buf = context->GetScratchBuffer(context, data->buffer_idx);
-      }
-      esp_nn_set_softmax_scratch_buf(scratch_buf);
-      esp_nn_softmax_s8(in_ptr, outer_size, depth, input_beta_multiplier,
-                        input_beta_left_shift, diff_min, out_ptr);
+      SoftmaxInt8(context, input, output, data);
 #else
       tflite::reference_ops::Softmax(
           data->op_data, tflite::micro::GetTensorShape(input),
@@ -104,7 +103,6 @@ static TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   NodeData data = *static_cast<NodeData*>(node->user_data);
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {
     case kTfLiteFloat32: {
       tflite::reference_ops::Softmax(
@@ -124,10 +122,22 @@ static TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  softmax_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
+#if ESP_NN
+// Eval of Register_SOFTMAX_INT8(), int8 input and output only, which leaves
+// the float and int16 kernels out of the link.
+static TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  SoftmaxInt8(context, input, output, static_cast<NodeData*>(node->user_data));
+  return kTfLiteOk;
+}
+#endif
+
 static TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -181,7 +191,15 @@ static TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       CalculateSoftmaxParams(context, input, output, params, &data->op_data);
 
 #if ESP_NN
+  data->buffer_idx = -1;
   if (output->type == kTfLiteInt8 && input->type == kTfLiteInt8) {
+    const int trailing_dim = NumDimensions(input) - 1;
+    TF_LITE_ENSURE_EQ(context, NumDimensions(output), NumDimensions(input));
+    TF_LITE_ENSURE_EQ(context, output->dims->data[trailing_dim],
+                      input->dims->data[trailing_dim]);
+    data->depth = input->dims->data[trailing_dim];
+    data->outer_size = data->depth > 0 ? NumElements(input) / data->depth : 0;
+
     const int32_t input_width = input->dims->data[1];
     const int32_t input_height = input->dims->data[2];
     int scratch_buf_size = esp_nn_get_softmax_scratch_size(input_width,
@@ -204,4 +222,10 @@ TfLiteRegistration Register_SOFTMAX() {
   return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
+#if ESP_NN
+TfLiteRegistration Register_SOFTMAX_INT8() {
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+}
+#endif
+
 }  // namespace tflite
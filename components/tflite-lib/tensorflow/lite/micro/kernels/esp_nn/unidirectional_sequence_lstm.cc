@@ -0,0 +1,398 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/unidirectional_sequence_lstm.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/portable_tensor_utils.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/logistic.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/tanh.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/lstm_shared.h"
+#include "tensorflow/lite/micro/kernels/micro_tensor_utils.h"
+
+#if ESP_NN
+#include <esp_nn.h>
+#endif
+
+namespace tflite {
+namespace {
+
+struct NodeData {
+  // First, for the Prepare and Eval of the reference kernel.
+  UnidirectionalSequenceLstmOpData op_data;
+#if ESP_NN
+  // Set by Prepare for int8 inputs, when the gate matmuls go through esp_nn.
+  bool use_esp_nn;
+  bool use_cifg;
+  int n_cell;
+  int n_output;
+#endif
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+}
+
+#if ESP_NN
+TfLiteStatus PrepareEspNn(TfLiteContext* context, TfLiteNode* node,
+                          NodeData* data) {
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TfLiteTensor* input_to_output_weights =
+      micro_context->AllocateTempInputTensor(node,
+                                             kLstmInputToOutputWeightsTensor);
+  TfLiteTensor* recurrent_to_output_weights =
+      micro_context->AllocateTempInputTensor(
+          node, kLstmRecurrentToOutputWeightsTensor);
+  TfLiteTensor* cell_to_output_weights = micro_context->AllocateTempInputTensor(
+      node, kLstmCellToOutputWeightsTensor);
+  const int n_input = input_to_output_weights->dims->data[1];
+  const int n_cell = input_to_output_weights->dims->data[0];
+  const int n_output = recurrent_to_output_weights->dims->data[1];
+  TfLiteTensor* input_to_input_weights = micro_context->AllocateTempInputTensor(
+      node, kLstmInputToInputWeightsTensor);
+  const bool use_peephole = cell_to_output_weights != nullptr;
+  micro_context->DeallocateTempTfLiteTensor(input_to_output_weights);
+  micro_context->DeallocateTempTfLiteTensor(recurrent_to_output_weights);
+  if (cell_to_output_weights != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(cell_to_output_weights);
+  }
+  if (input_to_input_weights != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(input_to_input_weights);
+  }
+
+  data->use_cifg = input_to_input_weights == nullptr;
+  data->n_cell = n_cell;
+  data->n_output = n_output;
+  // The esp_nn calls take 16 bit sizes. The reference peephole runs over
+  // n_output values of the n_cell of a gate, which the per batch steps of
+  // EvalEspNn only reproduce when they are the same.
+  data->use_esp_nn = n_cell <= UINT16_MAX && n_input <= UINT16_MAX &&
+                     n_output <= UINT16_MAX &&
+                     (!use_peephole || n_output == n_cell);
+  return kTfLiteOk;
+}
+#endif
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_OK(context, UnidirectionalSequenceLstmPrepare(context, node));
+#if ESP_NN
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kLstmInputTensor);
+  TfLiteTensor* input_to_output_weights =
+      micro_context->AllocateTempInputTensor(node,
+                                             kLstmInputToOutputWeightsTensor);
+  const bool is_integer = input->type == kTfLiteInt8 &&
+                          input_to_output_weights->type == kTfLiteInt8;
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(input_to_output_weights);
+  data->use_esp_nn = false;
+  if (is_integer) {
+    TF_LITE_ENSURE_OK(context, PrepareEspNn(context, node, data));
+  }
+#endif
+  return kTfLiteOk;
+}
+
+#if ESP_NN
+// The input and recurrent matmuls of a gate, accumulated into `gate`. The
+// weights are read where they are, the zero points are folded into the
+// effective biases by the reference Prepare. See
+// CalculateLstmGateInteger8x8_16 in lstm_eval.cc.
+void GateMatmuls(TfLiteContext* context, TfLiteNode* node,
+                 const int8_t* input_ptr, int n_input, int input_weights,
+                 const int32_t* input_bias, int32_t input_scale_a,
+                 int32_t input_scale_b, const int8_t* output_state_ptr,
+                 int n_output, int recurrent_weights,
+                 const int32_t* recurrent_bias, int32_t recurrent_scale_a,
+                 int32_t recurrent_scale_b, int n_cell, int16_t* gate) {
+  std::memset(gate, 0, n_cell * sizeof(int16_t));
+  esp_nn_fully_connected_s8_acc_s16(
+      input_ptr, n_input,
+      tflite::micro::GetTensorData<int8_t>(
+          tflite::micro::GetEvalInput(context, node, input_weights)),
+      input_bias, gate, n_cell, input_scale_b, input_scale_a);
+  esp_nn_fully_connected_s8_acc_s16(
+      output_state_ptr, n_output,
+      tflite::micro::GetTensorData<int8_t>(
+          tflite::micro::GetEvalInput(context, node, recurrent_weights)),
+      recurrent_bias, gate, n_cell, recurrent_scale_b, recurrent_scale_a);
+}
+
+// The peephole, layer normalization and activation of a gate, after its
+// matmuls. See CalculateLstmGateInteger8x8_16 in lstm_eval.cc.
+void FinishGate(const int16_t* cell_state, const TfLiteEvalTensor* cell_weights,
+                int32_t cell_scale_a, int32_t cell_scale_b,
+                const TfLiteEvalTensor* layer_norm_coefficients,
+                const TfLiteEvalTensor* layer_norm_bias,
+                int32_t layer_norm_scale_a, int32_t layer_norm_scale_b,
+                int32_t variance_guard, int n_cell,
+                TfLiteFusedActivation activation, int16_t* gate) {
+  if (cell_weights != nullptr) {
+    tflite::tensor_utils::VectorBatchVectorCwiseProductAccumulate(
+        tflite::micro::GetTensorData<int16_t>(cell_weights), n_cell,
+        cell_state, 1, cell_scale_a, cell_scale_b, gate);
+  }
+  if (layer_norm_coefficients != nullptr) {
+    tflite::tensor_utils::ApplyLayerNorm(
+        gate, tflite::micro::GetTensorData<int16_t>(layer_norm_coefficients),
+        tflite::micro::GetTensorData<int32_t>(layer_norm_bias),
+        layer_norm_scale_a, layer_norm_scale_b, variance_guard, 1, n_cell,
+        gate);
+  }
+  if (activation == kTfLiteActSigmoid) {
+    reference_integer_ops::Logistic(0, 0, n_cell, gate, gate);
+  } else {
+    int32_t dims_data = n_cell;
+    RuntimeShape shape = RuntimeShape(1, &dims_data);
+    reference_integer_ops::Tanh(0, 0, shape, gate, shape, gate);
+  }
+}
+
+// LstmStepInteger8x8_16 of lstm_eval.cc for one batch, with the matmuls of
+// the gates and the projection in esp_nn. The gates are computed in turn in
+// the reference, but their matmuls only read the input and the previous
+// output state, so they can all go first.
+void StepEspNn(TfLiteContext* context, TfLiteNode* node, const NodeData& data,
+               const int8_t* input_ptr, int n_input, int8_t* output_state_ptr,
+               int16_t* cell_state_ptr, int8_t* output_ptr, int16_t* gates,
+               int8_t* hidden) {
+  const IntegerLstmParameter& param = data.op_data.integer_lstm_param;
+  const int n_cell = data.n_cell;
+  const int n_output = data.n_output;
+  const bool use_cifg = data.use_cifg;
+  const bool use_layer_norm = data.op_data.use_layer_norm;
+  int16_t* input_gate = gates;
+  int16_t* forget_gate = gates + n_cell;
+  int16_t* cell_gate = gates + 2 * n_cell;
+  int16_t* output_gate = gates + 3 * n_cell;
+
+  if (!use_cifg) {
+    GateMatmuls(context, node, input_ptr, n_input,
+                kLstmInputToInputWeightsTensor,
+                param.input_to_input_effective_bias,
+                param.effective_input_to_input_scale_a,
+                param.effective_input_to_input_scale_b, output_state_ptr,
+                n_output, kLstmRecurrentToInputWeightsTensor,
+                param.recurrent_to_input_effective_bias,
+                param.effective_recurrent_to_input_scale_a,
+                param.effective_recurrent_to_input_scale_b, n_cell,
+                input_gate);
+  }
+  GateMatmuls(context, node, input_ptr, n_input,
+              kLstmInputToForgetWeightsTensor,
+              param.input_to_forget_effective_bias,
+              param.effective_input_to_forget_scale_a,
+              param.effective_input_to_forget_scale_b, output_state_ptr,
+              n_output, kLstmRecurrentToForgetWeightsTensor,
+              param.recurrent_to_forget_effective_bias,
+              param.effective_recurrent_to_forget_scale_a,
+              param.effective_recurrent_to_forget_scale_b, n_cell,
+              forget_gate);
+  GateMatmuls(context, node, input_ptr, n_input, kLstmInputToCellWeightsTensor,
+              param.input_to_cell_effective_bias,
+              param.effective_input_to_cell_scale_a,
+              param.effective_input_to_cell_scale_b, output_state_ptr,
+              n_output, kLstmRecurrentToCellWeightsTensor,
+              param.recurrent_to_cell_effective_bias,
+              param.effective_recurrent_to_cell_scale_a,
+              param.effective_recurrent_to_cell_scale_b, n_cell, cell_gate);
+  GateMatmuls(context, node, input_ptr, n_input,
+              kLstmInputToOutputWeightsTensor,
+              param.input_to_output_effective_bias,
+              param.effective_input_to_output_scale_a,
+              param.effective_input_to_output_scale_b, output_state_ptr,
+              n_output, kLstmRecurrentToOutputWeightsTensor,
+              param.recurrent_to_output_effective_bias,
+              param.effective_recurrent_to_output_scale_a,
+              param.effective_recurrent_to_output_scale_b, n_cell,
+              output_gate);
+
+  auto input_tensor = [&](int index) -> const TfLiteEvalTensor* {
+    return tflite::micro::GetEvalInput(context, node, index);
+  };
+  auto layer_norm_tensor = [&](int index) -> const TfLiteEvalTensor* {
+    return use_layer_norm ? input_tensor(index) : nullptr;
+  };
+  if (!use_cifg) {
+    FinishGate(cell_state_ptr, input_tensor(kLstmCellToInputWeightsTensor),
+               param.effective_cell_to_input_scale_a,
+               param.effective_cell_to_input_scale_b,
+               layer_norm_tensor(kLstmInputLayerNormCoefficientsTensor),
+               input_tensor(kLstmInputGateBiasTensor),
+               param.layer_norm_input_scale_a, param.layer_norm_input_scale_b,
+               param.input_variance_guard, n_cell, kTfLiteActSigmoid,
+               input_gate);
+  }
+  FinishGate(cell_state_ptr, input_tensor(kLstmCellToForgetWeightsTensor),
+             param.effective_cell_to_forget_scale_a,
+             param.effective_cell_to_forget_scale_b,
+             layer_norm_tensor(kLstmForgetLayerNormCoefficientsTensor),
+             input_tensor(kLstmForgetGateBiasTensor),
+             param.layer_norm_forget_scale_a, param.layer_norm_forget_scale_b,
+             param.forget_variance_guard, n_cell, kTfLiteActSigmoid,
+             forget_gate);
+  FinishGate(cell_state_ptr, nullptr, 0, 0,
+             layer_norm_tensor(kLstmCellLayerNormCoefficientsTensor),
+             input_tensor(kLstmCellGateBiasTensor),
+             param.layer_norm_cell_scale_a, param.layer_norm_cell_scale_b,
+             param.cell_variance_guard, n_cell, kTfLiteActTanh, cell_gate);
+
+  // Update the cell state, see UpdateLstmCellInteger. The forget gate is the
+  // scratch, as there is no input gate with CIFG.
+  int16_t* scratch = forget_gate;
+  tflite::tensor_utils::CwiseMul(forget_gate, cell_state_ptr, 1, n_cell, 15,
+                                 cell_state_ptr);
+  if (use_cifg) {
+    tflite::tensor_utils::Sub1Vector(forget_gate, n_cell, scratch);
+    tflite::tensor_utils::CwiseMul(scratch, cell_gate, 1, n_cell,
+                                   30 + param.cell_scale, scratch);
+  } else {
+    tflite::tensor_utils::CwiseMul(input_gate, cell_gate, 1, n_cell,
+                                   30 + param.cell_scale, scratch);
+  }
+  tflite::tensor_utils::CwiseAdd(cell_state_ptr, scratch, 1, n_cell,
+                                 cell_state_ptr);
+  if (param.quantized_cell_clip > 0) {
+    tflite::tensor_utils::CwiseClipping(cell_state_ptr, n_cell,
+                                        param.quantized_cell_clip);
+  }
+
+  FinishGate(cell_state_ptr, input_tensor(kLstmCellToOutputWeightsTensor),
+             param.effective_cell_to_output_scale_a,
+             param.effective_cell_to_output_scale_b,
+             layer_norm_tensor(kLstmOutputLayerNormCoefficientsTensor),
+             input_tensor(kLstmOutputGateBiasTensor),
+             param.layer_norm_output_scale_a, param.layer_norm_output_scale_b,
+             param.output_variance_guard, n_cell, kTfLiteActSigmoid,
+             output_gate);
+
+  // Update the output state, see CalculateLstmOutputInteger8x8_16. The input
+  // gate is done with, and holds the tanh of the cell state.
+  int16_t* cell_tanh = input_gate;
+  int32_t tanh_input_left_shift = (15 + param.cell_scale) - 3;
+  if (tanh_input_left_shift < 0) {
+    for (int i = 0; i < n_cell; ++i) {
+      cell_state_ptr[i] = cell_state_ptr[i] >> -tanh_input_left_shift;
+    }
+    tanh_input_left_shift = 0;
+  }
+  int32_t dims_data = n_cell;
+  RuntimeShape tanh_shape = RuntimeShape(1, &dims_data);
+  reference_integer_ops::Tanh(0, tanh_input_left_shift, tanh_shape,
+                              cell_state_ptr, tanh_shape, cell_tanh);
+  tflite::tensor_utils::CwiseMul(output_gate, cell_tanh,
+                                 param.effective_hidden_scale_a,
+                                 param.effective_hidden_scale_b, 1, n_cell,
+                                 param.hidden_zp, hidden);
+
+  const TfLiteEvalTensor* projection_weights =
+      input_tensor(kLstmProjectionWeightsTensor);
+  if (projection_weights != nullptr) {
+    // The reference accumulates into a zeroed output state, clamped to int8.
+    esp_nn_fully_connected_s8(
+        hidden, 0, n_cell,
+        tflite::micro::GetTensorData<int8_t>(projection_weights), 0,
+        param.projection_effective_bias, output_state_ptr, n_output,
+        data.op_data.output_state_zero_point, param.effective_proj_scale_b,
+        param.effective_proj_scale_a, INT8_MIN, INT8_MAX);
+    if (param.quantized_proj_clip > 0) {
+      tflite::tensor_utils::CwiseClipping(output_state_ptr, n_output,
+                                          param.quantized_proj_clip);
+    }
+  } else {
+    std::memcpy(output_state_ptr, hidden, n_output * sizeof(int8_t));
+  }
+  std::memcpy(output_ptr, output_state_ptr, n_output * sizeof(int8_t));
+}
+
+// EvalInteger8x8_16Lstm of lstm_eval.cc, one step per batch and time. The
+// batches are independent of each other, so their order does not matter.
+TfLiteStatus EvalEspNn(TfLiteContext* context, TfLiteNode* node,
+                       const NodeData& data) {
+  const auto* params =
+      reinterpret_cast<TfLiteUnidirectionalSequenceLSTMParams*>(
+          node->builtin_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kLstmInputTensor);
+  TfLiteEvalTensor* output_state =
+      tflite::micro::GetMutableEvalInput(context, node, kLstmOutputStateTensor);
+  TfLiteEvalTensor* cell_state =
+      tflite::micro::GetMutableEvalInput(context, node, kLstmCellStateTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kLstmOutputTensor);
+
+  const int n_input = input->dims->data[input->dims->size - 1];
+  int max_time, n_batch;
+  if (input->dims->size == 2) {
+    max_time = 1;
+    n_batch = input->dims->data[0];
+  } else {
+    max_time = params->time_major ? input->dims->data[0] : input->dims->data[1];
+    n_batch = params->time_major ? input->dims->data[1] : input->dims->data[0];
+  }
+  const int n_cell = data.n_cell;
+  const int n_output = data.n_output;
+
+  int16_t* gates = static_cast<int16_t*>(context->GetScratchBuffer(
+      context, data.op_data.scratch_index[kIntegerGateScratch]));
+  int8_t* hidden = static_cast<int8_t*>(context->GetScratchBuffer(
+      context, data.op_data.scratch_index[kIntegerHiddenScratch]));
+  for (int t = 0; t < max_time; ++t) {
+    for (int b = 0; b < n_batch; ++b) {
+      const int time_offset =
+          params->time_major ? t * n_batch + b : b * max_time + t;
+      StepEspNn(context, node, data,
+                tflite::micro::GetTensorData<int8_t>(input) +
+                    time_offset * n_input,
+                n_input,
+                tflite::micro::GetTensorData<int8_t>(output_state) +
+                    b * n_output,
+                tflite::micro::GetTensorData<int16_t>(cell_state) + b * n_cell,
+                tflite::micro::GetTensorData<int8_t>(output) +
+                    time_offset * n_output,
+                gates, hidden);
+    }
+  }
+  return kTfLiteOk;
+}
+#endif
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+#if ESP_NN
+  const NodeData& data = *static_cast<const NodeData*>(node->user_data);
+  if (data.use_esp_nn) {
+    return EvalEspNn(context, node, data);
+  }
+#endif
+  return UnidirectionalSequenceLstmEval(context, node);
+}
+
+}  // namespace
+
+TfLiteRegistration Register_UNIDIRECTIONAL_SEQUENCE_LSTM() {
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
+}
+
+}  // namespace tflite
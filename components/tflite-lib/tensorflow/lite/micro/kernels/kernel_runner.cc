@@ -38,10 +38,12 @@ void ClearBufferApi(TfLiteContext* context_) {
 KernelRunner::KernelRunner(const TfLiteRegistration& registration,
                            TfLiteTensor* tensors, int tensors_size,
                            TfLiteIntArray* inputs, TfLiteIntArray* outputs,
-                           void* builtin_data, TfLiteIntArray* intermediates)
+                           void* builtin_data, TfLiteIntArray* intermediates,
+                           uint8_t* arena, size_t arena_size)
     : registration_(registration),
-      allocator_(SingleArenaBufferAllocator::Create(kKernelRunnerBuffer_,
-                                                    kKernelRunnerBufferSize_)),
+      allocator_(SingleArenaBufferAllocator::Create(
+          arena != nullptr ? arena : kKernelRunnerBuffer_,
+          arena != nullptr ? arena_size : kKernelRunnerBufferSize_)),
       mock_micro_graph_(allocator_),
       fake_micro_context_(tensors, allocator_, &mock_micro_graph_) {
   // Prepare TfLiteContext:
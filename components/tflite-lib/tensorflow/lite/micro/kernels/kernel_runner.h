@@ -30,13 +30,15 @@ namespace micro {
 // this class. Simply pass in the registration, list of required tensors, inputs
 // array, outputs array, and any pre-builtin data. Calling Invoke() will
 // automatically walk the kernel and outputs will be ready on the TfLiteTensor
-// output provided during construction.
+// output provided during construction. Kernels needing more than the internal
+// arena, e.g. on 64-bit hosts, can be given one of `arena_size` bytes.
 class KernelRunner {
  public:
   KernelRunner(const TfLiteRegistration& registration, TfLiteTensor* tensors,
                int tensors_size, TfLiteIntArray* inputs,
                TfLiteIntArray* outputs, void* builtin_data,
-               TfLiteIntArray* intermediates = nullptr);
+               TfLiteIntArray* intermediates = nullptr,
+               uint8_t* arena = nullptr, size_t arena_size = 0);
 
   // Calls init and prepare on the kernel (i.e. TfLiteRegistration) struct. Any
   // exceptions will be DebugLog'd and returned as a status code.
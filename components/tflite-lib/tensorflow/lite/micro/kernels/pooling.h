@@ -67,7 +67,7 @@ void MaxPoolingEvalQuantized(TfLiteContext* context, TfLiteNode* node,
                              const TfLiteEvalTensor* input,
                              TfLiteEvalTensor* output);
 
-#if defined(CMSIS_NN)
+#if defined(CMSIS_NN) || defined(ESP_NN)
 TfLiteRegistration Register_AVERAGE_POOL_2D_INT8();
 
 TfLiteRegistration Register_MAX_POOL_2D_INT8();
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/kernels/internal/reference/resize_bilinear.h"
 
+#include <cstdint>
+#include <limits>
+
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -30,6 +33,152 @@ constexpr int kInputTensor = 0;
 constexpr int kSizeTensor = 1;
 constexpr int kOutputTensor = 0;
 
+// Fixed point of the interpolation weights of
+// reference_ops::ResizeBilinearInteger: 1 << 10 is a weight of one.
+constexpr int kWeightBits = 10;
+
+// Source rows (or columns) of one output row (or column) and the weight of
+// the upper one; the lower one has (1 << kWeightBits) - weight. The weight is
+// negative left of the first input pixel with half pixel centers, where lower
+// and upper are both the first pixel.
+struct InterpolationTap {
+  int16_t lower;
+  int16_t upper;
+  int16_t weight;
+};
+
+struct OpData {
+  // One tap per output row and one per output column, for int8 data.
+  InterpolationTap* rows;
+  InterpolationTap* cols;
+  // One input row interpolated between the two source rows of an output row.
+  int row_buffer_index;
+  // All weights are multiples of a quarter, which is the case of exact 2x
+  // (and 4x) upsampling: the interpolation then runs in 16 bits.
+  bool quarter_weights;
+};
+
+// The per output pixel computations of reference_ops::ResizeBilinearInteger,
+// done once for each output row or column.
+TfLiteStatus ComputeTaps(TfLiteContext* context, int input_size,
+                         int output_size, const TfLiteResizeBilinearParams& params,
+                         InterpolationTap** taps) {
+  TF_LITE_ENSURE(context, input_size <= std::numeric_limits<int16_t>::max());
+  *taps = static_cast<InterpolationTap*>(context->AllocatePersistentBuffer(
+      context, output_size * sizeof(InterpolationTap)));
+  TF_LITE_ENSURE(context, *taps != nullptr);
+
+  int32_t scale_10 =
+      ((1 << kWeightBits) * input_size + output_size / 2) / output_size;
+  if (params.align_corners && output_size > 1) {
+    scale_10 = ((1 << kWeightBits) * (input_size - 1) + (output_size - 1) / 2) /
+               (output_size - 1);
+  }
+  for (int i = 0; i < output_size; ++i) {
+    int32_t scaled, lower, upper;
+    reference_ops::ComputeInterpolationValuesInteger(
+        i, scale_10, params.half_pixel_centers, input_size, &scaled, &lower,
+        &upper);
+    (*taps)[i].lower = static_cast<int16_t>(lower);
+    (*taps)[i].upper = static_cast<int16_t>(upper);
+    (*taps)[i].weight = static_cast<int16_t>(scaled - (lower << kWeightBits));
+  }
+  return kTfLiteOk;
+}
+
+bool QuarterWeights(const InterpolationTap* taps, int size) {
+  constexpr int kQuarterMask = (1 << (kWeightBits - 2)) - 1;
+  for (int i = 0; i < size; ++i) {
+    if ((taps[i].weight & kQuarterMask) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TfLiteStatus PrepareInt8(TfLiteContext* context, TfLiteNode* node,
+                         const TfLiteTensor* input, const TfLiteTensor* size) {
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto* params =
+      reinterpret_cast<TfLiteResizeBilinearParams*>(node->builtin_data);
+  const int32_t* output_size = GetTensorData<int32_t>(size);
+  const int output_height = output_size[0];
+  const int output_width = output_size[1];
+  const int input_height = SizeOfDimension(input, 1);
+  const int input_width = SizeOfDimension(input, 2);
+  const int depth = SizeOfDimension(input, 3);
+
+  TF_LITE_ENSURE_STATUS(ComputeTaps(context, input_height, output_height,
+                                    *params, &data->rows));
+  TF_LITE_ENSURE_STATUS(ComputeTaps(context, input_width, output_width,
+                                    *params, &data->cols));
+  data->quarter_weights = QuarterWeights(data->rows, output_height) &&
+                          QuarterWeights(data->cols, output_width);
+  const int row_element_size =
+      data->quarter_weights ? sizeof(int16_t) : sizeof(int32_t);
+  return context->RequestScratchBufferInArena(
+      context, input_width * depth * row_element_size,
+      &data->row_buffer_index);
+}
+
+// Separable form of reference_ops::ResizeBilinearInteger: each output row
+// first interpolates its two source rows into `row`, then interpolates the
+// columns of `row`. The products of the weights are the reference ones and
+// the sums are exact, so the result is bit-identical. With kBits = 2 the
+// weights are quarters, the sums fit in 16 bits and need no 64-bit rounding.
+template <typename AccT, int kBits>
+void ResizeInt8(const OpData& data, const RuntimeShape& input_shape,
+                const int8_t* input_data, const RuntimeShape& output_shape,
+                int8_t* output_data, AccT* row) {
+  constexpr int32_t kOne = 1 << kBits;
+  constexpr int kWeightShift = kWeightBits - kBits;
+  constexpr int32_t kDivisor = 1 << (2 * kBits);
+  constexpr int32_t kRound = kDivisor / 2;
+
+  const int batches = input_shape.Dims(0);
+  const int input_height = input_shape.Dims(1);
+  const int row_size = input_shape.Dims(2) * input_shape.Dims(3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int depth = output_shape.Dims(3);
+
+  for (int b = 0; b < batches; ++b) {
+    const int8_t* image = input_data + b * input_height * row_size;
+    for (int y = 0; y < output_height; ++y) {
+      const InterpolationTap& ty = data.rows[y];
+      const int8_t* lower = image + ty.lower * row_size;
+      const int8_t* upper = image + ty.upper * row_size;
+      const int32_t wy = ty.weight >> kWeightShift;
+      if (wy == 0) {
+        for (int i = 0; i < row_size; ++i) {
+          row[i] = static_cast<AccT>(lower[i] * kOne);
+        }
+      } else {
+        for (int i = 0; i < row_size; ++i) {
+          row[i] = static_cast<AccT>(lower[i] * (kOne - wy) + upper[i] * wy);
+        }
+      }
+      for (int x = 0; x < output_width; ++x) {
+        const InterpolationTap& tx = data.cols[x];
+        const AccT* left = row + tx.lower * depth;
+        const AccT* right = row + tx.upper * depth;
+        const int32_t wx = tx.weight >> kWeightShift;
+        for (int c = 0; c < depth; ++c) {
+          const int32_t sum = left[c] * (kOne - wx) + right[c] * wx;
+          *output_data++ =
+              static_cast<int8_t>((sum + (sum > 0 ? kRound : -kRound)) /
+                                  kDivisor);
+        }
+      }
+    }
+  }
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -60,6 +209,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteError;
   }
 
+  if (input->type == kTfLiteInt8) {
+    TF_LITE_ENSURE_STATUS(PrepareInt8(context, node, input, size));
+  }
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(size);
   micro_context->DeallocateTempTfLiteTensor(output);
@@ -89,16 +242,23 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                                   tflite::micro::GetTensorShape(output),
                                   tflite::micro::GetTensorData<float>(output));
   } else if (output->type == kTfLiteInt8) {
-    tflite::ResizeBilinearParams op_params;
-    op_params.align_corners = params->align_corners;
-    op_params.half_pixel_centers = params->half_pixel_centers;
-    reference_ops::ResizeBilinearInteger(
-        op_params, tflite::micro::GetTensorShape(input),
-        tflite::micro::GetTensorData<int8_t>(input),
-        tflite::micro::GetTensorShape(size),
-        tflite::micro::GetTensorData<int32_t>(size),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int8_t>(output));
+    TFLITE_DCHECK(node->user_data != nullptr);
+    const OpData& data = *(static_cast<const OpData*>(node->user_data));
+    void* row = context->GetScratchBuffer(context, data.row_buffer_index);
+    if (data.quarter_weights) {
+      ResizeInt8<int16_t, 2>(data, tflite::micro::GetTensorShape(input),
+                             tflite::micro::GetTensorData<int8_t>(input),
+                             tflite::micro::GetTensorShape(output),
+                             tflite::micro::GetTensorData<int8_t>(output),
+                             static_cast<int16_t*>(row));
+    } else {
+      ResizeInt8<int32_t, kWeightBits>(
+          data, tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int8_t>(input),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int8_t>(output),
+          static_cast<int32_t*>(row));
+    }
   } else {
     MicroPrintf("Output type is %d, requires float or int8.", output->type);
     return kTfLiteError;
@@ -110,7 +270,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_RESIZE_BILINEAR() {
-  return tflite::micro::RegisterOp(nullptr, Prepare, Eval);
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
 }  // namespace tflite
@@ -47,18 +47,20 @@ inline TfLiteRegistration Register_SOFTMAX_INT8_INT16() {
 }
 #endif
 
-#if defined(CMSIS_NN)
+#if defined(CMSIS_NN) || defined(ESP_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int8 input/output and uses the latency optimized implementations.
 TfLiteRegistration Register_SOFTMAX_INT8();
+#else
+inline TfLiteRegistration Register_SOFTMAX_INT8() { return Register_SOFTMAX(); }
+#endif
 
+#if defined(CMSIS_NN)
 // Returns a TfLiteRegistration struct for kernel variant that only supports
 // int16 input/output and uses the latency optimized implementations.
 TfLiteRegistration Register_SOFTMAX_INT16();
 
 #else
-inline TfLiteRegistration Register_SOFTMAX_INT8() { return Register_SOFTMAX(); }
-
 inline TfLiteRegistration Register_SOFTMAX_INT16() {
   return Register_SOFTMAX();
 }
@@ -40,7 +40,7 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteSVDFParams*>(node->builtin_data);
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataSvdf& data = *(static_cast<const OpDataSvdf*>(node->user_data));
+  OpDataSvdf* data = static_cast<OpDataSvdf*>(node->user_data);
 
   const TfLiteEvalTensor* input =
       tflite::micro::GetEvalInput(context, node, kSvdfInputTensor);
@@ -59,9 +59,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (weights_feature->type) {
     case kTfLiteFloat32: {
-      EvalFloatSvdfReference(
-          context, node, input, weights_feature, weights_time, bias, params,
-          data.scratch_tensor_index, activation_state, output);
+      EvalFloatSvdfReference(context, node, input, weights_feature,
+                             weights_time, bias, params, activation_state,
+                             output, data);
       return kTfLiteOk;
       break;
     }
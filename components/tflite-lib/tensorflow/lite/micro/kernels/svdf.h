@@ -34,6 +34,13 @@ struct OpDataSvdf {
   int input_zero_point;
   int output_zero_point;
   int activation_state_zero_point;
+
+  // The activation state is a ring buffer of memory_size columns per filter
+  // rather than being shifted by a column per invoke. This is the column
+  // holding the oldest activation, which the next invoke replaces with the
+  // newest one. MicroGraph::ResetVariableTensors() leaves it where it is,
+  // which is fine as the reset gives every column the same value.
+  int activation_state_head;
 };
 
 // Input tensors.
@@ -55,7 +62,7 @@ void EvalInt8SvdfReference(TfLiteContext* context, TfLiteNode* node,
                            const TfLiteSVDFParams* params,
                            TfLiteEvalTensor* activation_state_tensor,
                            TfLiteEvalTensor* output_tensor,
-                           const OpDataSvdf& data);
+                           OpDataSvdf* data);
 
 // TODO(#523): remove 16-bit code when no longer needed.
 void EvalInt16SvdfReference(TfLiteContext* context, TfLiteNode* node,
@@ -66,14 +73,14 @@ void EvalInt16SvdfReference(TfLiteContext* context, TfLiteNode* node,
                             const TfLiteSVDFParams* params,
                             TfLiteEvalTensor* activation_state_tensor,
                             TfLiteEvalTensor* output_tensor,
-                            const OpDataSvdf& data);
+                            OpDataSvdf* data);
 
 void EvalFloatSvdfReference(
     TfLiteContext* context, TfLiteNode* node, const TfLiteEvalTensor* input,
     const TfLiteEvalTensor* weights_feature,
     const TfLiteEvalTensor* weights_time, const TfLiteEvalTensor* bias,
-    const TfLiteSVDFParams* params, int scratch_tensor_index,
-    TfLiteEvalTensor* activation_state, TfLiteEvalTensor* output);
+    const TfLiteSVDFParams* params, TfLiteEvalTensor* activation_state,
+    TfLiteEvalTensor* output, OpDataSvdf* data);
 
 TfLiteStatus PrepareSvdf(TfLiteContext* context, TfLiteNode* node);
 
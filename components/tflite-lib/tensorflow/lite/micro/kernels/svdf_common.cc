@@ -38,6 +38,11 @@ namespace tflite {
  * 2.) Output dimensions - the TFLite version determines output size and runtime
  * and resizes the output tensor. Micro runtime does not support tensor
  * resizing.
+ * 3.) Activation state - instead of shifting the whole state left by one
+ * column per invoke, each filter's memory is a ring buffer whose oldest column
+ * the new activation replaces (see OpDataSvdf::activation_state_head). The time
+ * weights are applied from the oldest column to the newest, in the order of the
+ * shifted state, so the results are the same.
  */
 
 const int kSvdfInputTensor = 0;
@@ -57,7 +62,7 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
                               const TfLiteSVDFParams* params,
                               TfLiteEvalTensor* activation_state_tensor,
                               TfLiteEvalTensor* output_tensor,
-                              const OpDataSvdf& data) {
+                              OpDataSvdf* data) {
   const int n_rank = params->rank;
   const int n_batch = input_tensor->dims->data[0];
   const int n_input = input_tensor->dims->data[1];
@@ -69,24 +74,15 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
   TFLITE_DCHECK(context->GetScratchBuffer != nullptr);
 
   int32_t* scratch_tensor = static_cast<int32_t*>(
-      context->GetScratchBuffer(context, data.scratch_tensor_index));
+      context->GetScratchBuffer(context, data->scratch_tensor_index));
   int32_t* scratch_output_tensor = static_cast<int32_t*>(
-      context->GetScratchBuffer(context, data.scratch_output_tensor_index));
+      context->GetScratchBuffer(context, data->scratch_output_tensor_index));
 
-  // Shift states.
-  T* const state_ptr = tflite::micro::GetTensorData<T>(activation_state_tensor);
-
-  // Left shift the activation_state.
-  {
-    T* new_state_start = state_ptr;
-    const T* old_state_start = state_ptr + 1;
-    const T* old_state_end = state_ptr + n_batch * n_filter * n_memory;
-    while (old_state_start != old_state_end) {
-      *new_state_start++ = *old_state_start++;
-    }
-  }
-
-  // Note: no need to clear the latest activation, matmul is not accumulative.
+  // The newest activation replaces the oldest one, after which the column
+  // following it is the oldest.
+  const int newest = data->activation_state_head;
+  const int oldest = newest + 1 == n_memory ? 0 : newest + 1;
+  data->activation_state_head = oldest;
 
   // Feature matmul.
   {
@@ -96,7 +92,7 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
         tflite::micro::GetTensorData<int8_t>(weights_feature_tensor);
     const int32_t output_max = std::numeric_limits<T>::max();
     const int32_t output_min = std::numeric_limits<T>::min();
-    T* result_in_batch = state + (n_memory - 1);
+    T* result_in_batch = state + newest;
     for (int b = 0; b < n_batch; b++) {
       const int8_t* matrix_ptr = weight_feature;
       for (int r = 0; r < n_filter; r++) {
@@ -104,15 +100,15 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
         const int8_t* vector_in_batch = input + b * n_input;
         for (int c = 0; c < n_input; c++) {
           dot_prod +=
-              *matrix_ptr++ * (*vector_in_batch++ - data.input_zero_point);
+              *matrix_ptr++ * (*vector_in_batch++ - data->input_zero_point);
         }
         dot_prod = MultiplyByQuantizedMultiplier(
-            dot_prod, data.effective_scale_1_a, data.effective_scale_1_b);
+            dot_prod, data->effective_scale_1_a, data->effective_scale_1_b);
         dot_prod = std::min(std::max(output_min, dot_prod), output_max);
         // The int16 version of the op assumes a zero_point of 0.  This
         // code accounts for the potentially non-zero zero_point for the int8
         // version of the op.
-        *result_in_batch = data.activation_state_zero_point + dot_prod;
+        *result_in_batch = data->activation_state_zero_point + dot_prod;
         result_in_batch += n_memory;
       }
     }
@@ -123,7 +119,7 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
     for (int b = 0; b < n_batch; ++b) {
       int32_t* scratch_ptr_batch = scratch_tensor + b * n_filter;
 
-      // Perform batched vector dot product:
+      // Perform batched vector dot product, from the oldest activation:
       const T* vector1_ptr =
           tflite::micro::GetTensorData<T>(weights_time_tensor);
       const T* vector2_ptr =
@@ -132,11 +128,17 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
 
       for (int i = 0; i < n_filter; i++) {
         *scratch_ptr_batch = 0;
-        for (int j = 0; j < n_memory; j++) {
+        for (int j = oldest; j < n_memory; j++) {
           *scratch_ptr_batch +=
               *vector1_ptr++ *
-              (*vector2_ptr++ - data.activation_state_zero_point);
+              (vector2_ptr[j] - data->activation_state_zero_point);
         }
+        for (int j = 0; j < oldest; j++) {
+          *scratch_ptr_batch +=
+              *vector1_ptr++ *
+              (vector2_ptr[j] - data->activation_state_zero_point);
+        }
+        vector2_ptr += n_memory;
         scratch_ptr_batch++;
       }
     }
@@ -181,9 +183,9 @@ void EvalIntegerSvdfReference(TfLiteContext* context, TfLiteNode* node,
     const int32_t output_min = std::numeric_limits<int8_t>::min();
     for (int i = 0; i < n_batch * n_unit; ++i) {
       int32_t x1 = scratch_output_tensor[i];
-      int32_t x2 = MultiplyByQuantizedMultiplier(x1, data.effective_scale_2_a,
-                                                 data.effective_scale_2_b);
-      int32_t x3 = x2 + data.output_zero_point;
+      int32_t x2 = MultiplyByQuantizedMultiplier(x1, data->effective_scale_2_a,
+                                                 data->effective_scale_2_b);
+      int32_t x3 = x2 + data->output_zero_point;
       int32_t x4 = std::min(std::max(output_min, x3), output_max);
       tflite::micro::GetTensorData<int8_t>(output_tensor)[i] =
           static_cast<int8_t>(x4);
@@ -205,7 +207,7 @@ void EvalInt16SvdfReference(TfLiteContext* context, TfLiteNode* node,
                             const TfLiteSVDFParams* params,
                             TfLiteEvalTensor* activation_state_tensor,
                             TfLiteEvalTensor* output_tensor,
-                            const OpDataSvdf& data) {
+                            OpDataSvdf* data) {
   EvalIntegerSvdfReference<int16_t>(
       context, node, input_tensor, weights_feature_tensor, weights_time_tensor,
       bias_tensor, params, activation_state_tensor, output_tensor, data);
@@ -219,7 +221,7 @@ void EvalInt8SvdfReference(TfLiteContext* context, TfLiteNode* node,
                            const TfLiteSVDFParams* params,
                            TfLiteEvalTensor* activation_state_tensor,
                            TfLiteEvalTensor* output_tensor,
-                           const OpDataSvdf& data) {
+                           OpDataSvdf* data) {
   EvalIntegerSvdfReference<int8_t>(
       context, node, input_tensor, weights_feature_tensor, weights_time_tensor,
       bias_tensor, params, activation_state_tensor, output_tensor, data);
@@ -228,19 +230,23 @@ void EvalInt8SvdfReference(TfLiteContext* context, TfLiteNode* node,
 static inline void ApplyTimeWeightsBiasAndActivation(
     int batch_size, int memory_size, int num_filters, int num_units, int rank,
     const float* const weights_time_ptr, const float* const bias_ptr,
-    TfLiteFusedActivation activation, float* const state_ptr,
+    TfLiteFusedActivation activation, float* const state_ptr, int oldest,
     float* const scratch_ptr, float* const output_ptr) {
   // Compute matmul(activation_state, weights_time).
   for (int b = 0; b < batch_size; ++b) {
-    // Perform batched vector dot product:
+    // Perform batched vector dot product, from the oldest activation:
     float* scratch_ptr_batch = scratch_ptr + b * num_filters;
     const float* vector1_ptr = weights_time_ptr;
     const float* vector2_ptr = state_ptr + b * memory_size * num_filters;
     for (int i = 0; i < num_filters; ++i) {
       *scratch_ptr_batch = 0.f;
-      for (int j = 0; j < memory_size; ++j) {
-        *scratch_ptr_batch += *vector1_ptr++ * *vector2_ptr++;
+      for (int j = oldest; j < memory_size; ++j) {
+        *scratch_ptr_batch += *vector1_ptr++ * vector2_ptr[j];
+      }
+      for (int j = 0; j < oldest; ++j) {
+        *scratch_ptr_batch += *vector1_ptr++ * vector2_ptr[j];
       }
+      vector2_ptr += memory_size;
       scratch_ptr_batch++;
     }
   }
@@ -290,8 +296,8 @@ void EvalFloatSvdfReference(
     TfLiteContext* context, TfLiteNode* node, const TfLiteEvalTensor* input,
     const TfLiteEvalTensor* weights_feature,
     const TfLiteEvalTensor* weights_time, const TfLiteEvalTensor* bias,
-    const TfLiteSVDFParams* params, int scratch_tensor_index,
-    TfLiteEvalTensor* activation_state, TfLiteEvalTensor* output) {
+    const TfLiteSVDFParams* params, TfLiteEvalTensor* activation_state,
+    TfLiteEvalTensor* output, OpDataSvdf* data) {
   const int rank = params->rank;
   const int batch_size = input->dims->data[0];
   const int input_size = input->dims->data[1];
@@ -312,33 +318,26 @@ void EvalFloatSvdfReference(
   TFLITE_DCHECK(context->GetScratchBuffer != nullptr);
 
   float* scratch_ptr = static_cast<float*>(
-      context->GetScratchBuffer(context, scratch_tensor_index));
+      context->GetScratchBuffer(context, data->scratch_tensor_index));
 
   float* output_ptr = tflite::micro::GetTensorData<float>(output);
 
-  // Left shift the activation_state.
-  {
-    float* new_state_start = state_ptr;
-    const float* old_state_start = state_ptr + 1;
-    const float* old_state_end =
-        state_ptr + batch_size * num_filters * memory_size;
-    while (old_state_start != old_state_end) {
-      *new_state_start++ = *old_state_start++;
-    }
-  }
-
-  // Note: no need to clear the latest activation, matmul is not accumulative.
+  // The newest activation replaces the oldest one, after which the column
+  // following it is the oldest.
+  const int newest = data->activation_state_head;
+  const int oldest = newest + 1 == memory_size ? 0 : newest + 1;
+  data->activation_state_head = oldest;
 
   // Compute conv1d(inputs, weights_feature).
-  // The activation_state's rightmost column is used to save current cycle
-  // activation. This is achieved by starting at state_ptr[memory_size - 1] and
-  // having the stride equal to memory_size.
+  // The activation_state's newest column is used to save current cycle
+  // activation. This is achieved by starting at state_ptr[newest] and having
+  // the stride equal to memory_size.
 
   // Perform batched matrix vector multiply operation:
   {
     const float* matrix = weights_feature_ptr;
     const float* vector = input_ptr;
-    float* result = &state_ptr[memory_size - 1];
+    float* result = &state_ptr[newest];
     float* result_in_batch = result;
     for (int i = 0; i < batch_size; ++i) {
       const float* matrix_ptr = matrix;
@@ -356,7 +355,7 @@ void EvalFloatSvdfReference(
 
   ApplyTimeWeightsBiasAndActivation(
       batch_size, memory_size, num_filters, num_units, rank, weights_time_ptr,
-      bias_ptr, params->activation, state_ptr, scratch_ptr, output_ptr);
+      bias_ptr, params->activation, state_ptr, oldest, scratch_ptr, output_ptr);
 }
 
 TfLiteStatus PrepareSvdf(TfLiteContext* context, TfLiteNode* node) {
@@ -438,6 +437,9 @@ TfLiteStatus PrepareSvdf(TfLiteContext* context, TfLiteNode* node) {
 
   TFLITE_DCHECK(node->user_data != nullptr);
   OpDataSvdf* data = static_cast<OpDataSvdf*>(node->user_data);
+  // Any column can start the ring, the state being all zero points until the
+  // first invoke.
+  data->activation_state_head = 0;
 
   if (input->type == kTfLiteInt8) {
     TF_LITE_ENSURE_EQ(context, weights_feature->type, kTfLiteInt8);
@@ -0,0 +1,64 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_UNIDIRECTIONAL_SEQUENCE_LSTM_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_UNIDIRECTIONAL_SEQUENCE_LSTM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/lstm_eval.h"
+
+namespace tflite {
+
+constexpr int scratch_index_size = 12;
+
+// Scratch buffers of the integer 8x8_16 kernel: the four gates, each
+// n_batch * n_cell int16 values one after the other (input, forget, cell and
+// output), and the int8 hidden state.
+constexpr int kIntegerGateScratch = 0;
+constexpr int kIntegerHiddenScratch = 1;
+
+struct UnidirectionalSequenceLstmOpData {
+  // If the lstm is layer norm.
+  bool use_layer_norm;
+  // The scratch index.
+  int scratch_index[scratch_index_size];
+
+  int32_t row_sums_size;
+  int32_t* row_sums;
+  bool compute_row_sums = false;
+
+  int32_t input_zero_point;
+  int32_t output_state_zero_point;
+
+  IntegerLstmParameter integer_lstm_param;
+  HybridLstmScales hybrid_lstm_scales;
+};
+
+// Init, Prepare and Eval of the reference kernel. Prepare and Eval take
+// node->user_data as their UnidirectionalSequenceLstmOpData.
+void* UnidirectionalSequenceLstmInit(TfLiteContext* context, const char* buffer,
+                                     size_t length);
+
+TfLiteStatus UnidirectionalSequenceLstmPrepare(TfLiteContext* context,
+                                               TfLiteNode* node);
+
+TfLiteStatus UnidirectionalSequenceLstmEval(TfLiteContext* context,
+                                            TfLiteNode* node);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_UNIDIRECTIONAL_SEQUENCE_LSTM_H_
@@ -0,0 +1,187 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/memory_planner/cached_memory_planner.h"
+
+#include <string.h>
+
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+namespace {
+
+uint32_t FoldWord(uint32_t checksum, int value) {
+  uint32_t word = static_cast<uint32_t>(value);
+  for (int i = 0; i < 4; ++i) {
+    checksum ^= (word >> (i * 8)) & 0xff;
+    checksum *= 0x01000193;
+  }
+  return checksum;
+}
+
+}  // namespace
+
+uint32_t MemoryPlanChecksum(uint32_t checksum, int size, int first_time_used,
+                            int last_time_used, int offline_offset) {
+  checksum = FoldWord(checksum, size);
+  checksum = FoldWord(checksum, first_time_used);
+  checksum = FoldWord(checksum, last_time_used);
+  return FoldWord(checksum, offline_offset);
+}
+
+const MemoryPlanCacheHeader* GetMemoryPlanCache(const Model* model) {
+  if (model == nullptr || model->metadata() == nullptr) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < model->metadata()->size(); ++i) {
+    auto metadata = model->metadata()->Get(i);
+    if (metadata->name() == nullptr ||
+        strcmp(metadata->name()->c_str(), kMemoryPlanCacheMetadata) != 0) {
+      continue;
+    }
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers =
+        model->buffers();
+    if (buffers == nullptr || metadata->buffer() >= buffers->size()) {
+      return nullptr;
+    }
+    auto* array = (*buffers)[metadata->buffer()]->data();
+    if (array == nullptr ||
+        array->size() < sizeof(MemoryPlanCacheHeader) + sizeof(BufferPlan)) {
+      return nullptr;
+    }
+    // Buffer data is 16 byte aligned in the flatbuffer.
+    const MemoryPlanCacheHeader* cache =
+        reinterpret_cast<const MemoryPlanCacheHeader*>(array->data());
+    const BufferPlan* plan = GetBufferPlan(cache);
+    if (cache->magic != kMemoryPlanCacheMagic ||
+        cache->version != kMemoryPlanCacheVersion || plan->buffer_count < 0 ||
+        array->size() < sizeof(MemoryPlanCacheHeader) +
+                            SizeOfBufferPlan(plan->buffer_count)) {
+      MicroPrintf("Ignoring invalid memory plan cache");
+      return nullptr;
+    }
+    return cache;
+  }
+  return nullptr;
+}
+
+CachedMemoryPlanner::CachedMemoryPlanner(const Model* model)
+    : cache_(GetMemoryPlanCache(model)),
+      buffer_count_(0),
+      checksum_(kMemoryPlanChecksumSeed),
+      buffers_fit_(true),
+      mismatch_reported_(false) {}
+
+CachedMemoryPlanner::~CachedMemoryPlanner() {}
+
+TfLiteStatus CachedMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                       int scratch_buffer_size) {
+  buffer_count_ = 0;
+  checksum_ = kMemoryPlanChecksumSeed;
+  buffers_fit_ = true;
+  mismatch_reported_ = false;
+  // Recording buffers in the fallback planner is cheap, only planning is not.
+  return fallback_planner_.Init(scratch_buffer, scratch_buffer_size);
+}
+
+void CachedMemoryPlanner::CheckBuffer(int size, int first_time_used,
+                                      int last_time_used, int offline_offset) {
+  if (cache_ == nullptr) {
+    return;
+  }
+  checksum_ = MemoryPlanChecksum(checksum_, size, first_time_used,
+                                 last_time_used, offline_offset);
+  const BufferPlan* plan = GetBufferPlan(cache_);
+  if (buffer_count_ < plan->buffer_count) {
+    const int32_t offset = plan->buffer_plan_entries[buffer_count_].offset;
+    if (offset < 0 ||
+        static_cast<uint32_t>(offset) + size > cache_->arena_size ||
+        (offline_offset != kOnlinePlannedBuffer && offset != offline_offset)) {
+      buffers_fit_ = false;
+    }
+  }
+}
+
+TfLiteStatus CachedMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                            int last_time_used) {
+  TF_LITE_ENSURE_STATUS(
+      fallback_planner_.AddBuffer(size, first_time_used, last_time_used));
+  CheckBuffer(size, first_time_used, last_time_used, kOnlinePlannedBuffer);
+  ++buffer_count_;
+  return kTfLiteOk;
+}
+
+TfLiteStatus CachedMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                            int last_time_used,
+                                            int offline_offset) {
+  TF_LITE_ENSURE_STATUS(fallback_planner_.AddBuffer(
+      size, first_time_used, last_time_used, offline_offset));
+  CheckBuffer(size, first_time_used, last_time_used, offline_offset);
+  ++buffer_count_;
+  return kTfLiteOk;
+}
+
+bool CachedMemoryPlanner::UsesCachedPlan() {
+  if (cache_ == nullptr) {
+    return false;
+  }
+  if (buffer_count_ == GetBufferPlan(cache_)->buffer_count &&
+      checksum_ == cache_->checksum && buffers_fit_) {
+    return true;
+  }
+  if (!mismatch_reported_) {
+    MicroPrintf(
+        "Memory plan cache does not match the model (%d buffers, %d cached), "
+        "planning at runtime",
+        buffer_count_, GetBufferPlan(cache_)->buffer_count);
+    mismatch_reported_ = true;
+  }
+  return false;
+}
+
+size_t CachedMemoryPlanner::GetMaximumMemorySize() {
+  if (UsesCachedPlan()) {
+    return cache_->arena_size;
+  }
+  return fallback_planner_.GetMaximumMemorySize();
+}
+
+int CachedMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus CachedMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                     int* offset) {
+  if (!UsesCachedPlan()) {
+    return fallback_planner_.GetOffsetForBuffer(buffer_index, offset);
+  }
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = GetBufferPlan(cache_)->buffer_plan_entries[buffer_index].offset;
+  return kTfLiteOk;
+}
+
+void CachedMemoryPlanner::PrintMemoryPlan() {
+  if (UsesCachedPlan()) {
+    MicroPrintf("Cached memory plan: %d buffers, %d bytes", buffer_count_,
+                cache_->arena_size);
+    return;
+  }
+  fallback_planner_.PrintMemoryPlan();
+}
+
+}  // namespace tflite
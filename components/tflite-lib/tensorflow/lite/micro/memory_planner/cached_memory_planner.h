@@ -0,0 +1,113 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_CACHED_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_CACHED_MEMORY_PLANNER_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/memory_plan_struct.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Name of the model metadata entry holding a memory plan cache.
+constexpr char kMemoryPlanCacheMetadata[] = "MicroMemoryPlanCache";
+
+constexpr uint32_t kMemoryPlanCacheMagic = 0x43504d54;  // "TMPC"
+constexpr uint32_t kMemoryPlanCacheVersion = 1;
+
+// Layout of the metadata buffer, all fields in the target byte order (little
+// endian on every platform TFLM runs on). The header is directly followed by
+// a BufferPlan holding one offset per buffer, in AddBuffer() order.
+struct MemoryPlanCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  // MemoryPlanChecksum() over all the buffers the plan was computed for.
+  uint32_t checksum;
+  // GetMaximumMemorySize() of the plan.
+  uint32_t arena_size;
+};
+
+// Folds one AddBuffer() call into a running checksum (32-bit FNV-1a), starting
+// from kMemoryPlanChecksumSeed. The checksum covers everything the planner is
+// told about the model, so a plan is valid for any model and set of kernels
+// requesting exactly the same buffers.
+constexpr uint32_t kMemoryPlanChecksumSeed = 0x811c9dc5;
+uint32_t MemoryPlanChecksum(uint32_t checksum, int size, int first_time_used,
+                            int last_time_used, int offline_offset);
+
+// Returns the memory plan cache embedded in `model`, or nullptr when it has
+// none or it was written by an incompatible version.
+const MemoryPlanCacheHeader* GetMemoryPlanCache(const Model* model);
+
+inline const BufferPlan* GetBufferPlan(const MemoryPlanCacheHeader* cache) {
+  return reinterpret_cast<const BufferPlan*>(cache + 1);
+}
+
+// A memory planner that takes buffer offsets from a plan computed offline by
+// tensorflow/lite/micro/tools/memory_plan_cache, so no sorting or searching is
+// done at startup.
+//
+// The plan is checked while buffers are added: the checksum of their sizes and
+// lifetimes has to match the one recorded with the plan, and every buffer has
+// to fit the planned arena. Otherwise, e.g. when the kernels request different
+// scratch buffers than the ones the tool was built with, offsets are computed
+// by a GreedyMemoryPlanner as usual.
+class CachedMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // `model` is searched for a memory plan cache, it may not have one.
+  explicit CachedMemoryPlanner(const Model* model);
+  ~CachedMemoryPlanner() override;
+
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  size_t GetMaximumMemorySize() override;
+  int GetBufferCount() override;
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  void PrintMemoryPlan() override;
+
+  // Whether the offsets come from the cached plan, valid once all buffers
+  // have been added.
+  bool UsesCachedPlan();
+
+ private:
+  void CheckBuffer(int size, int first_time_used, int last_time_used,
+                   int offline_offset);
+
+  const MemoryPlanCacheHeader* cache_;  // not owned, may be null
+  GreedyMemoryPlanner fallback_planner_;
+
+  int buffer_count_;
+  uint32_t checksum_;
+  bool buffers_fit_;
+  bool mismatch_reported_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_CACHED_MEMORY_PLANNER_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/micro_allocator.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 
@@ -459,6 +460,7 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
   }
 
   model_is_allocating_ = true;
+  streamed_ops_ = 0;
 
   uint8_t* data_allocator_buffer =
       persistent_buffer_allocator_->AllocatePersistentBuffer(
@@ -488,6 +490,33 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
   return output;
 }
 
+TfLiteStatus MicroAllocator::SetBatchSize(int batch_size) {
+  if (model_is_allocating_) {
+    MicroPrintf("MicroAllocator: Batch size set while a model is allocating");
+    return kTfLiteError;
+  }
+  if (batch_size < 1) {
+    MicroPrintf("MicroAllocator: Invalid batch size %d", batch_size);
+    return kTfLiteError;
+  }
+  batch_size_ = batch_size;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::SetStreamedOperators(int num_ops, size_t bytes) {
+  if (!model_is_allocating_) {
+    MicroPrintf("MicroAllocator: Streamed operators set outside of allocation");
+    return kTfLiteError;
+  }
+  if (batch_size_ > 1) {
+    MicroPrintf("MicroAllocator: Row streaming needs a batch size of 1");
+    return kTfLiteError;
+  }
+  streamed_ops_ = num_ops;
+  streamed_bytes_ = bytes;
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::FinishModelAllocation(
     const Model* model, SubgraphAllocations* subgraph_allocations,
     ScratchBufferHandle** scratch_buffer_handles) {
@@ -552,7 +581,13 @@ TfLiteStatus MicroAllocator::RequestScratchBufferInArena(size_t bytes,
   *current_request = {};
   // Assign -1 as a sentinel value that will be updated when the node finishes
   // allocating:
-  current_request->bytes = bytes;
+  // Buffers first requested by a streamed node prepared again only exist
+  // while it is streamed.
+  if (streamed_ops_ > 0) {
+    current_request->streamed_bytes = bytes;
+  } else {
+    current_request->bytes = bytes;
+  }
   current_request->node_idx = kUnassignedScratchBufferRequestIndex;
   current_request->subgraph_idx = subgraph_idx;
 
@@ -564,6 +599,18 @@ TfLiteStatus MicroAllocator::RequestScratchBufferInArena(size_t bytes,
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::ResizeScratchBufferRequest(int buffer_idx,
+                                                        size_t bytes) {
+  if (!model_is_allocating_ || buffer_idx < 0 ||
+      static_cast<size_t>(buffer_idx) >= scratch_buffer_request_count_) {
+    MicroPrintf("MicroAllocator: No scratch buffer request %d to resize",
+                buffer_idx);
+    return kTfLiteError;
+  }
+  GetScratchBufferRequests()[buffer_idx].streamed_bytes = bytes;
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
   // When a node has finished preparing, all temp allocations performed by the
   // kernel should be cleaned up:
@@ -633,6 +680,10 @@ TfLiteTensor* MicroAllocator::AllocatePersistentTfLiteTensor(
   // This value is allocated from persistent arena space. It is guaranteed to be
   // around for the lifetime of the application.
   TfLiteTensor* tensor = AllocatePersistentTfLiteTensorInternal();
+  if (tensor == nullptr) {
+    MicroPrintf("Failed to allocate memory for persistent TfLiteTensor");
+    return nullptr;
+  }
 
   // Populate any fields from the flatbuffer, since this TfLiteTensor struct is
   // allocated in the persistent section of the arena, ensure that additional
@@ -697,6 +748,10 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
   TfLiteTensor* tensor = reinterpret_cast<TfLiteTensor*>(
       non_persistent_buffer_allocator_->AllocateTemp(sizeof(TfLiteTensor),
                                                      alignof(TfLiteTensor)));
+  if (tensor == nullptr) {
+    MicroPrintf("Failed to allocate memory for temporary TfLiteTensor");
+    return nullptr;
+  }
 
   // Populate any fields from the flatbuffer, since this TfLiteTensor struct is
   // allocated in the temp section of the arena, ensure that additional
@@ -761,11 +816,45 @@ TfLiteStatus MicroAllocator::AllocateTfLiteEvalTensors(
         return kTfLiteError;
       }
     }
+    if (batch_size_ > 1) {
+      TF_LITE_ENSURE_STATUS(ResizeBatchDimension(tensors, alloc_count));
+    }
     subgraph_allocations[subgraph_idx].tensors = tensors;
   }
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::ResizeBatchDimension(
+    TfLiteEvalTensor* eval_tensors, size_t tensor_count) {
+  for (size_t i = 0; i < tensor_count; ++i) {
+    TfLiteEvalTensor* tensor = &eval_tensors[i];
+    // Constant tensors (weights, biases, shapes) point into the flatbuffer and
+    // are shared by all the batches.
+    if (tensor->data.data != nullptr) {
+      continue;
+    }
+    if (tensor->dims->size == 0 || tensor->dims->data[0] != 1) {
+      MicroPrintf("Tensor %d has no leading dimension of 1 to batch", i);
+      return kTfLiteError;
+    }
+    TfLiteIntArray* dims = reinterpret_cast<TfLiteIntArray*>(
+        persistent_buffer_allocator_->AllocatePersistentBuffer(
+            TfLiteIntArrayGetSizeInBytes(tensor->dims->size),
+            alignof(TfLiteIntArray)));
+    if (dims == nullptr) {
+      MicroPrintf("Failed to allocate dims of tensor %d", i);
+      return kTfLiteError;
+    }
+    dims->size = tensor->dims->size;
+    dims->data[0] = batch_size_;
+    for (int d = 1; d < dims->size; ++d) {
+      dims->data[d] = tensor->dims->data[d];
+    }
+    tensor->dims = dims;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::AllocateVariables(const SubGraph* subgraph,
                                                TfLiteEvalTensor* eval_tensors) {
   for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
@@ -831,6 +920,17 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   const int32_t* offline_planner_offsets = nullptr;
   TF_LITE_ENSURE_STATUS(
       builder.GetOfflinePlannedOffsets(&offline_planner_offsets));
+  // An offline plan only holds for the tensor sizes and lifetimes of the
+  // model.
+  if (batch_size_ > 1 && offline_planner_offsets != nullptr) {
+    MicroPrintf("Ignoring the offline memory plan for batch size %d",
+                batch_size_);
+    offline_planner_offsets = nullptr;
+  }
+  if (streamed_ops_ > 0 && offline_planner_offsets != nullptr) {
+    MicroPrintf("Ignoring the offline memory plan for row streaming");
+    offline_planner_offsets = nullptr;
+  }
   TF_LITE_ENSURE_STATUS(
       builder.InitializeAllocationInfo(offline_planner_offsets, allocations));
 
@@ -848,6 +948,21 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   uint8_t* planner_arena = non_persistent_buffer_allocator_->AllocateTemp(
       remaining_arena_size, MicroArenaBufferAlignment());
   TF_LITE_ENSURE(tflite::GetMicroErrorReporter(), planner_arena != nullptr);
+
+  // With row streaming, plan the model as it is first to report what
+  // streaming saves. A separate planner keeps memory_planner_ to one plan.
+  size_t unstreamed_usage = 0;
+  if (streamed_ops_ > 0) {
+    GreedyMemoryPlanner unstreamed_planner;
+    unstreamed_planner.Init(planner_arena, remaining_arena_size);
+    TF_LITE_ENSURE_STATUS(CreatePlan(&unstreamed_planner, allocation_info,
+                                     allocation_info_count));
+    unstreamed_usage = unstreamed_planner.GetMaximumMemorySize();
+    PlanStreamedOperators(
+        model, allocation_info,
+        allocation_info_count - scratch_buffer_request_count_);
+  }
+
   memory_planner_->Init(planner_arena, remaining_arena_size);
   TF_LITE_ENSURE_STATUS(
       CreatePlan(memory_planner_, allocation_info, allocation_info_count));
@@ -871,6 +986,16 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   memory_planner_->PrintMemoryPlan();
 #endif
   head_usage = memory_planner_->GetMaximumMemorySize();
+  if (streamed_ops_ > 0) {
+    MicroPrintf("Row streaming %d operators: %u bytes of tensors, %u without",
+                streamed_ops_, static_cast<unsigned>(head_usage),
+                static_cast<unsigned>(unstreamed_usage));
+    if (head_usage >= unstreamed_usage) {
+      MicroPrintf(
+          "Row streaming does not lower the planned tensors, try more rows "
+          "per band or fewer operators");
+    }
+  }
 
   // The head is used to store memory plans for one model at a time during the
   // model preparation stage, and is re-purposed to store scratch buffer handles
@@ -890,6 +1015,59 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   return kTfLiteOk;
 }
 
+void MicroAllocator::PlanStreamedOperators(const Model* model,
+                                           AllocationInfo* allocation_info,
+                                           size_t scratch_offset) {
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  const auto* operators = subgraph->operators();
+
+  // The allocation scopes of the first and last streamed operator, taken from
+  // the creation of their outputs.
+  const int first_scope =
+      allocation_info[operators->Get(0)->outputs()->Get(0)].first_created;
+  const int last_scope =
+      allocation_info[operators->Get(streamed_ops_ - 1)->outputs()->Get(0)]
+          .first_created;
+  auto widen = [&](AllocationInfo* current) {
+    current->first_created = std::min(current->first_created, first_scope);
+    current->last_used = std::max(current->last_used, last_scope);
+  };
+
+  for (int i = 0; i < streamed_ops_; ++i) {
+    const auto* op = operators->Get(i);
+    for (size_t n = 0; op->inputs() != nullptr && n < op->inputs()->size();
+         ++n) {
+      if (op->inputs()->Get(n) >= 0) {
+        widen(&allocation_info[op->inputs()->Get(n)]);
+      }
+    }
+    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
+         ++n) {
+      widen(&allocation_info[op->outputs()->Get(n)]);
+    }
+    // The band windows replace the tensors between the operators.
+    if (i < streamed_ops_ - 1) {
+      AllocationInfo* current = &allocation_info[op->outputs()->Get(0)];
+      if (i == 0) {
+        current->bytes = streamed_bytes_;
+      } else {
+        current->needs_allocating = false;
+      }
+    }
+  }
+
+  internal::ScratchBufferRequest* requests = GetScratchBufferRequests();
+  for (size_t i = 0; i < scratch_buffer_request_count_; ++i) {
+    if (requests[i].subgraph_idx == 0 && requests[i].node_idx < streamed_ops_) {
+      AllocationInfo* current = &allocation_info[scratch_offset + i];
+      if (requests[i].streamed_bytes > 0) {
+        current->bytes = requests[i].streamed_bytes;
+      }
+      widen(current);
+    }
+  }
+}
+
 TfLiteStatus MicroAllocator::AllocateScratchBufferHandles(
     ScratchBufferHandle** scratch_buffer_handles, size_t handle_count) {
   TFLITE_DCHECK(scratch_buffer_handles != nullptr);
@@ -29,6 +29,8 @@ limitations under the License.
 
 namespace tflite {
 
+struct AllocationInfo;
+
 // TODO(b/199402574): rename to tflite_internal or just remove internal
 // namespace.
 namespace internal {
@@ -63,6 +65,10 @@ struct ScratchBufferRequest {
   // have `before` = node_idx and `after` = node_idx.
   int node_idx;
   int subgraph_idx;
+  // Bytes needed while the node runs in row bands, 0 if it needs `bytes`
+  // there too. Set by kernels prepared again for MicroRowStreamer, see
+  // MicroAllocator::ResizeScratchBufferRequest().
+  size_t streamed_bytes;
 };
 
 }  // namespace internal
@@ -192,6 +198,20 @@ class MicroAllocator {
   // Return value is nullptr if the allocations failed.
   SubgraphAllocations* StartModelAllocation(const Model* model);
 
+  // Sets the leading dimension of every non-constant tensor of the models
+  // allocated afterwards to `batch_size`, see MicroInterpreter::SetBatchSize().
+  // Can't be called while a model is allocating.
+  TfLiteStatus SetBatchSize(int batch_size);
+
+  // Plans the tensors between the first `num_ops` operators of subgraph 0 of
+  // the allocating model as one buffer of `bytes`, returned in the output of
+  // the first operator, and keeps everything these operators use alive while
+  // any of them runs. Called by MicroRowStreamer, which keeps its band
+  // windows in that buffer, after the operators are prepared. The memory plan
+  // reports the planned tensor bytes with and without streaming and warns
+  // when streaming does not lower them.
+  TfLiteStatus SetStreamedOperators(int num_ops, size_t bytes);
+
   // Finish allocating internal resources required for model inference.
   //
   // -Plan the memory for activation tensors and scratch buffers.
@@ -252,6 +272,12 @@ class MicroAllocator {
   TfLiteStatus RequestScratchBufferInArena(size_t bytes, int subgraph_idx,
                                            int* buffer_idx);
 
+  // Changes the size of the scratch buffer `buffer_idx` requested earlier in
+  // the allocation of the current model to `bytes` while its node is streamed.
+  // Lets a kernel prepared again, see MicroRowStreamer, keep its buffers
+  // instead of adding new ones.
+  TfLiteStatus ResizeScratchBufferRequest(int buffer_idx, size_t bytes);
+
   // Finish allocating a specific NodeAndRegistration prepare block (kernel
   // entry for a model) with a given node ID. This call ensures that any scratch
   // buffer requests and temporary allocations are handled and ready for the
@@ -327,6 +353,17 @@ class MicroAllocator {
   // the head section.
   internal::ScratchBufferRequest* GetScratchBufferRequests();
 
+  // Replaces the flatbuffer dims of the non-constant tensors in `eval_tensors`
+  // with persistent copies whose leading dimension is batch_size_.
+  TfLiteStatus ResizeBatchDimension(TfLiteEvalTensor* eval_tensors,
+                                    size_t tensor_count);
+
+  // Applies SetStreamedOperators() to the lifetimes and sizes in
+  // `allocation_info`, which starts with the tensors of subgraph 0.
+  void PlanStreamedOperators(const Model* model,
+                             AllocationInfo* allocation_info,
+                             size_t scratch_offset);
+
   // A simple memory allocator that always allocate from the arena tail or head.
   INonPersistentBufferAllocator* non_persistent_buffer_allocator_;
   IPersistentBufferAllocator* persistent_buffer_allocator_;
@@ -339,6 +376,14 @@ class MicroAllocator {
 
   bool model_is_allocating_;
 
+  // Leading dimension of the non-constant tensors, 1 runs the model as is.
+  int batch_size_ = 1;
+
+  // Operators run by row streaming and the bytes of their band windows, see
+  // SetStreamedOperators().
+  int streamed_ops_ = 0;
+  size_t streamed_bytes_ = 0;
+
   // Holds the number of ScratchBufferRequest instances stored in the head
   // section when a model is allocating.
   size_t scratch_buffer_request_count_ = 0;
@@ -39,6 +39,11 @@ TfLiteStatus MicroContext::RequestScratchBufferInArena(size_t bytes,
       bytes, graph_.GetCurrentSubgraphIndex(), buffer_idx);
 }
 
+TfLiteStatus MicroContext::ResizeScratchBufferInArena(size_t bytes,
+                                                      int buffer_idx) {
+  return allocator_.ResizeScratchBufferRequest(buffer_idx, bytes);
+}
+
 void* MicroContext::GetScratchBuffer(int buffer_idx) {
   ScratchBufferHandle* handle = scratch_buffer_handles_ + buffer_idx;
   return handle->data;
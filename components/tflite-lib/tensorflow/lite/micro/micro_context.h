@@ -50,6 +50,11 @@ class MicroContext {
   virtual TfLiteStatus RequestScratchBufferInArena(size_t bytes,
                                                    int* buffer_idx);
 
+  // Changes the size of a scratch buffer this kernel requested earlier. Only
+  // for kernels prepared again before the allocation finishes, see
+  // MicroRowStreamer.
+  TfLiteStatus ResizeScratchBufferInArena(size_t bytes, int buffer_idx);
+
   // Get the scratch buffer pointer.
   // This method is only available in Eval stage.
   // Virtual so that it can be faked for kernel tests.
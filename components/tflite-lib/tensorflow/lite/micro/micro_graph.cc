@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_row_streaming.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
@@ -152,7 +153,26 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
     return kTfLiteError;
   }
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-  for (size_t i = 0; i < operators_size; ++i) {
+  size_t first_op = 0;
+  if (subgraph_idx == 0 && row_streamer_ != nullptr) {
+    TfLiteStatus invoke_status;
+    {
+      // The streamed operators take turns band by band, so they are timed as
+      // one event rather than one per node.
+      ScopedMicroProfiler scoped_profiler(
+          "ROW_STREAMING",
+          static_cast<MicroProfilerInterface*>(context_->profiler));
+      invoke_status = row_streamer_->Invoke(context_);
+    }
+    allocator_->ResetTempAllocations();
+    if (invoke_status != kTfLiteOk) {
+      MicroPrintf("Row streaming the first %d operators failed",
+                  row_streamer_->num_ops());
+      return invoke_status;
+    }
+    first_op = row_streamer_->num_ops();
+  }
+  for (size_t i = first_op; i < operators_size; ++i) {
     TfLiteNode* node =
         &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
     const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
@@ -164,8 +184,8 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
 // only defined for builds with the error strings.
 #if !defined(TF_LITE_STRIP_ERROR_STRINGS)
     ScopedMicroProfiler scoped_profiler(
-        OpNameFromRegistration(registration),
-        reinterpret_cast<MicroProfiler*>(context_->profiler));
+        OpNameFromRegistration(registration), subgraph_idx, i, context_, node,
+        static_cast<MicroProfilerInterface*>(context_->profiler));
 #endif
 
     TFLITE_DCHECK(registration->invoke);
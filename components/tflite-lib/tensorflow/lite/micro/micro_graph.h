@@ -23,6 +23,8 @@ limitations under the License.
 
 namespace tflite {
 
+class MicroRowStreamer;
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -87,6 +89,12 @@ class MicroGraph {
   // Get the resource variables for this TFLM graph.
   MicroResourceVariables* GetResourceVariables() { return resource_variables_; }
 
+  // Hands the first operators of subgraph 0 to `row_streamer`, which runs them
+  // in bands before InvokeSubgraph() continues with the remaining operators.
+  void SetRowStreamer(MicroRowStreamer* row_streamer) {
+    row_streamer_ = row_streamer;
+  }
+
  private:
   TfLiteContext* context_;
   const Model* model_;
@@ -95,6 +103,7 @@ class MicroGraph {
   int current_subgraph_index_;
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
+  MicroRowStreamer* row_streamer_ = nullptr;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
@@ -180,6 +181,22 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroInterpreter::SetBatchSize(int batch_size) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetBatchSize() has to be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  return allocator_.SetBatchSize(batch_size);
+}
+
+TfLiteStatus MicroInterpreter::SetRowStreaming(int num_ops, int band_rows) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetRowStreaming() has to be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  return row_streamer_.Configure(num_ops, band_rows);
+}
+
 TfLiteStatus MicroInterpreter::AllocateTensors() {
   SubgraphAllocations* allocations = allocator_.StartModelAllocation(model_);
 
@@ -209,6 +226,12 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
 
   TF_LITE_ENSURE_STATUS(graph_.PrepareSubgraphs());
 
+  if (row_streamer_.num_ops() > 0) {
+    TF_LITE_ENSURE_STATUS(row_streamer_.Prepare(&context_, model_, &allocator_,
+                                                graph_.GetAllocations()));
+    graph_.SetRowStreamer(&row_streamer_);
+  }
+
   // Prepare is done, we're ready for Invoke. Memory allocation is no longer
   // allowed. Kernels can only fetch scratch buffers via GetScratchBuffer.
   context_.AllocatePersistentBuffer = nullptr;
@@ -282,7 +305,43 @@ TfLiteStatus MicroInterpreter::Invoke() {
   if (!tensors_allocated_) {
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
   }
-  return graph_.InvokeSubgraph(0);
+  TfLiteStatus status = graph_.InvokeSubgraph(0);
+
+  // Kernels read inputs through the eval tensors, the TfLiteTensor returned by
+  // input() still holds the arena address.
+  if (input_buffers_bound_) {
+    TfLiteEvalTensor* eval_tensors = graph_.GetAllocations()[0].tensors;
+    for (size_t i = 0; i < inputs_size(); ++i) {
+      eval_tensors[inputs().Get(i)].data.data = input_tensors_[i]->data.data;
+    }
+    input_buffers_bound_ = false;
+  }
+  return status;
+}
+
+TfLiteStatus MicroInterpreter::SetInputBuffer(size_t index, void* data,
+                                              size_t size) {
+  if (!tensors_allocated_) {
+    MicroPrintf("SetInputBuffer() called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  TfLiteTensor* tensor = input(index);
+  if (tensor == nullptr) {
+    return kTfLiteError;
+  }
+  if (data == nullptr || size < tensor->bytes) {
+    MicroPrintf("Input buffer of %d bytes is too small, %d bytes required",
+                static_cast<int>(size), static_cast<int>(tensor->bytes));
+    return kTfLiteError;
+  }
+  if (reinterpret_cast<uintptr_t>(data) % MicroArenaBufferAlignment() != 0) {
+    MicroPrintf("Input buffer %p is not aligned to %d bytes", data,
+                static_cast<int>(MicroArenaBufferAlignment()));
+    return kTfLiteError;
+  }
+  graph_.GetAllocations()[0].tensors[inputs().Get(index)].data.data = data;
+  input_buffers_bound_ = true;
+  return kTfLiteOk;
 }
 
 TfLiteTensor* MicroInterpreter::input(size_t index) {
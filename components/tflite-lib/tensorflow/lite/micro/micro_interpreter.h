@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_graph.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/micro_row_streaming.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -89,6 +90,26 @@ class MicroInterpreter {
   // intermediate tensors.
   TfLiteStatus AllocateTensors();
 
+  // Makes every Invoke() run the model on `batch_size` inputs at once, e.g.
+  // to re-score recorded data. The leading dimension of every non-constant
+  // tensor is taken as the batch dimension: it has to be 1 in the model and
+  // becomes `batch_size`, so the memory plan scales with it and inputs and
+  // outputs hold `batch_size` consecutive items. Must be called before
+  // AllocateTensors().
+  TfLiteStatus SetBatchSize(int batch_size);
+
+  // Runs the first `num_ops` operators, a chain of int8 CONV_2D and
+  // DEPTHWISE_CONV_2D, over bands of `band_rows` rows of the last one's output
+  // so the tensors between them never exist at full size, which shrinks the
+  // arena of models whose largest activations come first. The results are the
+  // same as without it. The windows, halo rows included, and the kernels'
+  // scratch buffers for the band shapes can outweigh what it saves, so some
+  // choices of `num_ops` and `band_rows` grow the arena instead; compare them
+  // with tools/arena_size. Needs the esp-nn kernels and a batch size of 1, see
+  // MicroRowStreamer. Must be called before AllocateTensors(), 0 operators
+  // turns it off.
+  TfLiteStatus SetRowStreaming(int num_ops, int band_rows);
+
   // In order to support partial graph runs for strided models, this can return
   // values other than kTfLiteOk and kTfLiteError.
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
@@ -108,6 +129,14 @@ class MicroInterpreter {
     return *model_->subgraphs()->Get(0)->inputs();
   }
   TfLiteTensor* input_tensor(size_t index) { return input(index); }
+
+  // Binds an externally owned buffer as the storage of input `index` for the
+  // next Invoke() only, so a producer can fill it in place instead of copying
+  // into input(index)->data. The buffer must hold input(index)->bytes, be
+  // aligned to MicroArenaBufferAlignment() and stay unchanged until Invoke()
+  // returns. Afterwards the input points back into the arena. Must be called
+  // after AllocateTensors().
+  TfLiteStatus SetInputBuffer(size_t index, void* data, size_t size);
   template <class T>
   T* typed_input_tensor(int tensor_index) {
     if (TfLiteTensor* tensor_ptr = input_tensor(tensor_index)) {
@@ -177,6 +206,7 @@ class MicroInterpreter {
   TfLiteContext context_ = {};
   MicroAllocator& allocator_;
   MicroGraph graph_;
+  MicroRowStreamer row_streamer_;
   bool tensors_allocated_;
 
   TfLiteStatus initialization_status_;
@@ -188,6 +218,9 @@ class MicroInterpreter {
   TfLiteTensor** input_tensors_;
   TfLiteTensor** output_tensors_;
 
+  // Set while SetInputBuffer() has redirected an input away from the arena.
+  bool input_buffers_bound_ = false;
+
   MicroContext micro_context_;
 };
 
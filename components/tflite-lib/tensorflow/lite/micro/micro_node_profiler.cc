@@ -0,0 +1,277 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_node_profiler.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_string.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+namespace {
+
+// Handle returned when the record table is full; EndEvent ignores it.
+constexpr uint32_t kInvalidHandle = 0xFFFFFFFF;
+
+int CopyDims(const TfLiteEvalTensor* tensor, int32_t* dims, int max_dims) {
+  if (tensor == nullptr || tensor->dims == nullptr) {
+    return 0;
+  }
+  int count = tensor->dims->size < max_dims ? tensor->dims->size : max_dims;
+  for (int i = 0; i < count; ++i) {
+    dims[i] = tensor->dims->data[i];
+  }
+  return count;
+}
+
+uint32_t FlatSize(const TfLiteEvalTensor* tensor) {
+  uint32_t size = 1;
+  for (int i = 0; i < tensor->dims->size; ++i) {
+    size *= tensor->dims->data[i];
+  }
+  return size;
+}
+
+const TfLiteEvalTensor* NodeTensor(TfLiteContext* context,
+                                   const TfLiteIntArray* indices, int i) {
+  if (indices == nullptr || i >= indices->size || indices->data[i] < 0) {
+    return nullptr;
+  }
+  return context->GetEvalTensor(context, indices->data[i]);
+}
+
+// Multiply-accumulates per invocation for the ops that are dominated by them;
+// 0 for everything else.
+uint32_t CountMacs(const char* tag, TfLiteContext* context,
+                   const TfLiteNode* node) {
+  const TfLiteEvalTensor* filter = NodeTensor(context, node->inputs, 1);
+  const TfLiteEvalTensor* output = NodeTensor(context, node->outputs, 0);
+  if (tag == nullptr || filter == nullptr || output == nullptr ||
+      filter->dims == nullptr || output->dims == nullptr) {
+    return 0;
+  }
+  const TfLiteIntArray* f = filter->dims;
+  if (strcmp(tag, "CONV_2D") == 0 && f->size == 4) {
+    // filter: [out_ch, h, w, in_ch]
+    return FlatSize(output) * f->data[1] * f->data[2] * f->data[3];
+  }
+  if (strcmp(tag, "DEPTHWISE_CONV_2D") == 0 && f->size == 4) {
+    // filter: [1, h, w, out_ch]
+    return FlatSize(output) * f->data[1] * f->data[2];
+  }
+  if (strcmp(tag, "FULLY_CONNECTED") == 0 && f->size == 2) {
+    // filter: [out_ch, in_ch]
+    return FlatSize(output) * f->data[1];
+  }
+  return 0;
+}
+
+void FormatDims(char* buf, int buf_size, const int32_t* dims, int count,
+                char separator) {
+  char* current = buf;
+  int remaining = buf_size;
+  buf[0] = '\0';
+  for (int i = 0; i < count && remaining > 1; ++i) {
+    if (i > 0) {
+      *current++ = separator;
+      *current = '\0';
+      remaining--;
+    }
+    int len = MicroSnprintf(current, remaining, "%d", dims[i]);
+    current += len;
+    remaining -= len;
+  }
+}
+
+}  // namespace
+
+uint32_t MicroNodeProfiler::BeginEvent(const char* tag) {
+  int index = FindOrAddRecord(tag, -1, -1);
+  if (index < 0) {
+    return kInvalidHandle;
+  }
+  return StartRecord(index);
+}
+
+uint32_t MicroNodeProfiler::BeginNodeEvent(const char* tag, int subgraph_idx,
+                                           int node_idx, TfLiteContext* context,
+                                           const TfLiteNode* node) {
+  int index = FindOrAddRecord(tag, subgraph_idx, node_idx);
+  if (index < 0) {
+    return kInvalidHandle;
+  }
+  NodeRecord& record = records_[index];
+  if (record.invocations == 0 && context != nullptr && node != nullptr) {
+    // Shapes are static in TFLM, so they are only looked up once per node.
+    record.input_dims_count = CopyDims(NodeTensor(context, node->inputs, 0),
+                                       record.input_dims, kMaxDims);
+    record.output_dims_count = CopyDims(NodeTensor(context, node->outputs, 0),
+                                        record.output_dims, kMaxDims);
+    record.macs = CountMacs(tag, context, node);
+  }
+  return StartRecord(index);
+}
+
+void MicroNodeProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kInvalidHandle) {
+    return;
+  }
+  TFLITE_DCHECK(event_handle < static_cast<uint32_t>(num_records_));
+  NodeRecord& record = records_[event_handle];
+  uint32_t ticks = GetCurrentTimeTicks() - record.start_ticks;
+  record.samples[record.invocations % kMaxSamples] = ticks;
+  record.total_ticks += ticks;
+  record.invocations++;
+}
+
+uint32_t MicroNodeProfiler::StartRecord(int index) {
+  next_record_hint_ = index + 1 < kMaxNodes ? index + 1 : 0;
+  records_[index].start_ticks = GetCurrentTimeTicks();
+  return index;
+}
+
+int MicroNodeProfiler::FindOrAddRecord(const char* tag, int subgraph_idx,
+                                       int node_idx) {
+  auto matches = [&](const NodeRecord& r) {
+    if (node_idx < 0) {
+      return r.node_idx < 0 && strcmp(r.tag, tag) == 0;
+    }
+    return r.node_idx == node_idx && r.subgraph_idx == subgraph_idx;
+  };
+
+  if (next_record_hint_ < num_records_ &&
+      matches(records_[next_record_hint_])) {
+    return next_record_hint_;
+  }
+  for (int i = 0; i < num_records_; ++i) {
+    if (matches(records_[i])) {
+      return i;
+    }
+  }
+  if (num_records_ == kMaxNodes) {
+    return -1;
+  }
+
+  NodeRecord& record = records_[num_records_];
+  memset(&record, 0, sizeof(record));
+  record.tag = tag;
+  record.subgraph_idx = subgraph_idx;
+  record.node_idx = node_idx;
+  return num_records_++;
+}
+
+uint32_t MicroNodeProfiler::GetPercentileTicks(const NodeRecord& record,
+                                               int percentile) const {
+  int count = record.invocations < kMaxSamples
+                  ? static_cast<int>(record.invocations)
+                  : kMaxSamples;
+  if (count == 0) {
+    return 0;
+  }
+  // Insertion sort of at most kMaxSamples values.
+  uint32_t sorted[kMaxSamples];
+  for (int i = 0; i < count; ++i) {
+    uint32_t value = record.samples[i];
+    int j = i;
+    for (; j > 0 && sorted[j - 1] > value; --j) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+  }
+  return sorted[((count - 1) * percentile + 50) / 100];
+}
+
+uint32_t MicroNodeProfiler::GetTotalTicks() const {
+  uint32_t ticks = 0;
+  for (int i = 0; i < num_records_; ++i) {
+    const NodeRecord& record = records_[i];
+    if (record.invocations > 0) {
+      ticks += record.samples[(record.invocations - 1) % kMaxSamples];
+    }
+  }
+  return ticks;
+}
+
+void MicroNodeProfiler::Log() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  char in_shape[48];
+  char out_shape[48];
+  for (int i = 0; i < num_records_; ++i) {
+    const NodeRecord& r = records_[i];
+    FormatDims(in_shape, sizeof(in_shape), r.input_dims, r.input_dims_count,
+               'x');
+    FormatDims(out_shape, sizeof(out_shape), r.output_dims,
+               r.output_dims_count, 'x');
+    MicroPrintf("[%d:%d] %s %s -> %s, %u MACs: p50 %u p99 %u ticks (%u runs)",
+                r.subgraph_idx, r.node_idx, r.tag, in_shape, out_shape, r.macs,
+                GetPercentileTicks(r, 50), GetPercentileTicks(r, 99),
+                r.invocations);
+  }
+#endif
+}
+
+void MicroNodeProfiler::LogCsv() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  char in_shape[48];
+  char out_shape[48];
+  MicroPrintf(
+      "\"Subgraph\",\"Node\",\"Op\",\"Input shape\",\"Output shape\",\"MACs\","
+      "\"Invocations\",\"Mean ticks\",\"P50 ticks\",\"P99 ticks\"");
+  for (int i = 0; i < num_records_; ++i) {
+    const NodeRecord& r = records_[i];
+    FormatDims(in_shape, sizeof(in_shape), r.input_dims, r.input_dims_count,
+               'x');
+    FormatDims(out_shape, sizeof(out_shape), r.output_dims,
+               r.output_dims_count, 'x');
+    uint32_t mean = r.invocations > 0
+                        ? static_cast<uint32_t>(r.total_ticks / r.invocations)
+                        : 0;
+    MicroPrintf("%d,%d,%s,%s,%s,%u,%u,%u,%u,%u", r.subgraph_idx, r.node_idx,
+                r.tag, in_shape, out_shape, r.macs, r.invocations, mean,
+                GetPercentileTicks(r, 50), GetPercentileTicks(r, 99));
+  }
+#endif
+}
+
+void MicroNodeProfiler::LogJson() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  char in_shape[48];
+  char out_shape[48];
+  MicroPrintf("[");
+  for (int i = 0; i < num_records_; ++i) {
+    const NodeRecord& r = records_[i];
+    FormatDims(in_shape, sizeof(in_shape), r.input_dims, r.input_dims_count,
+               ',');
+    FormatDims(out_shape, sizeof(out_shape), r.output_dims,
+               r.output_dims_count, ',');
+    uint32_t mean = r.invocations > 0
+                        ? static_cast<uint32_t>(r.total_ticks / r.invocations)
+                        : 0;
+    MicroPrintf(
+        "{\"subgraph\":%d,\"node\":%d,\"op\":\"%s\",\"input\":[%s],"
+        "\"output\":[%s],\"macs\":%u,\"invocations\":%u,\"mean_ticks\":%u,"
+        "\"p50_ticks\":%u,\"p99_ticks\":%u}%s",
+        r.subgraph_idx, r.node_idx, r.tag, in_shape, out_shape, r.macs,
+        r.invocations, mean, GetPercentileTicks(r, 50),
+        GetPercentileTicks(r, 99), i + 1 < num_records_ ? "," : "");
+  }
+  MicroPrintf("]");
+#endif
+}
+
+}  // namespace tflite
@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_NODE_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_NODE_PROFILER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+namespace tflite {
+
+// MicroNodeProfiler keeps one record per graph node rather than one per event,
+// so two nodes running the same op (e.g. every CONV_2D of a model) are reported
+// separately. Each record holds the node's input/output shapes, its MAC count
+// and the duration of the last kMaxSamples invocations, from which p50/p99 are
+// derived. The operators run by row streaming alternate band by band and
+// share a single "ROW_STREAMING" record, see MicroInterpreter::SetRowStreaming().
+//
+// Pass an instance to the MicroInterpreter constructor to enable it. When no
+// profiler is given, the interpreter does no timing at all.
+class MicroNodeProfiler : public MicroProfilerInterface {
+ public:
+  // Maximum number of distinct nodes (plus tagged non-node events) tracked.
+  static constexpr int kMaxNodes = 64;
+  // Number of most recent invocations per node used for percentiles.
+  static constexpr int kMaxSamples = 32;
+  static constexpr int kMaxDims = 4;
+
+  struct NodeRecord {
+    const char* tag;
+    int subgraph_idx;
+    int node_idx;  // -1 for events started through BeginEvent().
+    int input_dims_count;
+    int32_t input_dims[kMaxDims];
+    int output_dims_count;
+    int32_t output_dims[kMaxDims];
+    uint32_t macs;
+    uint32_t invocations;
+    uint64_t total_ticks;
+    uint32_t start_ticks;
+    uint32_t samples[kMaxSamples];
+  };
+
+  MicroNodeProfiler() = default;
+  virtual ~MicroNodeProfiler() = default;
+
+  // Events not tied to a node are aggregated per tag. The lifetime of the tag
+  // must exceed that of the profiler.
+  virtual uint32_t BeginEvent(const char* tag) override;
+
+  virtual uint32_t BeginNodeEvent(const char* tag, int subgraph_idx,
+                                  int node_idx, TfLiteContext* context,
+                                  const TfLiteNode* node) override;
+
+  virtual void EndEvent(uint32_t event_handle) override;
+
+  // Drops all records and statistics.
+  void ClearEvents() { num_records_ = 0; }
+
+  int num_records() const { return num_records_; }
+  const NodeRecord& record(int index) const { return records_[index]; }
+
+  // Returns the given percentile (0-100) of the retained samples of a record.
+  uint32_t GetPercentileTicks(const NodeRecord& record, int percentile) const;
+
+  // Returns the sum of the most recent duration of every record, i.e. the
+  // time of the last Invoke() when all records are graph nodes.
+  uint32_t GetTotalTicks() const;
+
+  // Prints one line per node in human readable form.
+  void Log() const;
+
+  // Prints one row per node in CSV (Comma Separated Value) form.
+  void LogCsv() const;
+
+  // Prints all nodes as a JSON array, one object per line.
+  void LogJson() const;
+
+ private:
+  int FindOrAddRecord(const char* tag, int subgraph_idx, int node_idx);
+  uint32_t StartRecord(int index);
+
+  NodeRecord records_[kMaxNodes];
+  int num_records_ = 0;
+  // Nodes are invoked in order, so the record after the last one used is
+  // almost always the next one needed.
+  int next_record_hint_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_NODE_PROFILER_H_
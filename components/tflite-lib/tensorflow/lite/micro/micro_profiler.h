@@ -97,7 +97,11 @@ class MicroProfiler : public MicroProfilerInterface {
 // MicroInterpreter and we want to ensure zero overhead for the release builds.
 class ScopedMicroProfiler {
  public:
-  explicit ScopedMicroProfiler(const char* tag, MicroProfiler* profiler) {}
+  explicit ScopedMicroProfiler(const char* tag,
+                               MicroProfilerInterface* profiler) {}
+  ScopedMicroProfiler(const char* tag, int subgraph_idx, int node_idx,
+                      TfLiteContext* context, const TfLiteNode* node,
+                      MicroProfilerInterface* profiler) {}
 };
 
 #else
@@ -114,13 +118,25 @@ class ScopedMicroProfiler {
 // }
 class ScopedMicroProfiler {
  public:
-  explicit ScopedMicroProfiler(const char* tag, MicroProfiler* profiler)
+  explicit ScopedMicroProfiler(const char* tag,
+                               MicroProfilerInterface* profiler)
       : profiler_(profiler) {
     if (profiler_ != nullptr) {
       event_handle_ = profiler_->BeginEvent(tag);
     }
   }
 
+  // Same as above, for the invocation of a graph node.
+  ScopedMicroProfiler(const char* tag, int subgraph_idx, int node_idx,
+                      TfLiteContext* context, const TfLiteNode* node,
+                      MicroProfilerInterface* profiler)
+      : profiler_(profiler) {
+    if (profiler_ != nullptr) {
+      event_handle_ = profiler_->BeginNodeEvent(tag, subgraph_idx, node_idx,
+                                                context, node);
+    }
+  }
+
   ~ScopedMicroProfiler() {
     if (profiler_ != nullptr) {
       profiler_->EndEvent(event_handle_);
@@ -129,7 +145,7 @@ class ScopedMicroProfiler {
 
  private:
   uint32_t event_handle_ = 0;
-  MicroProfiler* profiler_ = nullptr;
+  MicroProfilerInterface* profiler_ = nullptr;
 };
 #endif  // !defined(TF_LITE_STRIP_ERROR_STRINGS)
 
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <cstdint>
 
+#include "tensorflow/lite/c/common.h"
+
 namespace tflite {
 
 // Interface class that the TFLM framework relies on for profiling.
@@ -31,6 +33,15 @@ class MicroProfilerInterface {
 
   // Marks the end of an event associated with event_handle.
   virtual void EndEvent(uint32_t event_handle) = 0;
+
+  // Marks the start of the event for the node_idx-th operator of a subgraph.
+  // Profilers that attribute time to individual nodes can inspect the node's
+  // tensors through context. The default only records the tag.
+  virtual uint32_t BeginNodeEvent(const char* tag, int subgraph_idx,
+                                  int node_idx, TfLiteContext* context,
+                                  const TfLiteNode* node) {
+    return BeginEvent(tag);
+  }
 };
 
 }  // namespace tflite
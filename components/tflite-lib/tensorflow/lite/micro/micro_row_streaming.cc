@@ -0,0 +1,297 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_row_streaming.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+namespace {
+
+// Kernels may rely on the alignment of the rows they are given.
+constexpr size_t kRowAlignment = 16;
+
+bool IsStreamableTensor(const TfLiteEvalTensor* tensor) {
+  return tensor->type == kTfLiteInt8 && tensor->dims->size == 4 &&
+         tensor->dims->data[0] == 1 &&
+         (tensor->dims->data[2] * tensor->dims->data[3]) % kRowAlignment == 0;
+}
+
+int8_t ZeroPoint(const SubGraph* subgraph, int tensor_index) {
+  const auto* quantization = subgraph->tensors()->Get(tensor_index)
+                                 ->quantization();
+  if (quantization == nullptr || quantization->zero_point() == nullptr ||
+      quantization->zero_point()->size() == 0) {
+    return 0;
+  }
+  return static_cast<int8_t>(quantization->zero_point()->Get(0));
+}
+
+bool IsConsumedOutsideChain(const SubGraph* subgraph, int tensor_index,
+                            int consumer) {
+  for (size_t i = 0; subgraph->outputs() != nullptr &&
+                     i < subgraph->outputs()->size();
+       ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  for (size_t op = 0; op < NumSubgraphOperators(subgraph); ++op) {
+    const auto* inputs = subgraph->operators()->Get(op)->inputs();
+    for (size_t i = 0; inputs != nullptr && i < inputs->size(); ++i) {
+      if (inputs->Get(i) == tensor_index &&
+          op != static_cast<size_t>(consumer)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TfLiteStatus MicroRowStreamer::Configure(int num_ops, int band_rows) {
+  if (num_ops == 0) {
+    num_ops_ = 0;
+    return kTfLiteOk;
+  }
+  if (num_ops < 2 || band_rows < 1) {
+    MicroPrintf("Row streaming needs at least 2 operators and 1 row per band");
+    return kTfLiteError;
+  }
+  num_ops_ = num_ops;
+  band_rows_ = band_rows;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroRowStreamer::Prepare(TfLiteContext* context,
+                                       const Model* model,
+                                       MicroAllocator* allocator,
+                                       SubgraphAllocations* allocations) {
+#if ESP_NN
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  if (static_cast<size_t>(num_ops_) > NumSubgraphOperators(subgraph)) {
+    MicroPrintf("Row streaming %d operators, the model only has %d", num_ops_,
+                NumSubgraphOperators(subgraph));
+    return kTfLiteError;
+  }
+
+  layers_ = static_cast<Layer*>(
+      allocator->AllocatePersistentBuffer(sizeof(Layer) * num_ops_));
+  TF_LITE_ENSURE(context, layers_ != nullptr);
+
+  TfLiteEvalTensor* tensors = allocations[0].tensors;
+  for (int i = 0; i < num_ops_; ++i) {
+    NodeAndRegistration& op = allocations[0].node_and_registrations[i];
+    Layer* layer = &layers_[i];
+    layer->node = &op.node;
+
+    const TfLiteIntArray* inputs = op.node.inputs;
+    const TfLiteIntArray* outputs = op.node.outputs;
+    if (outputs->size != 1 ||
+        (i > 0 && inputs->data[0] != layers_[i - 1].node->outputs->data[0])) {
+      MicroPrintf("Row streaming: operator %d does not consume operator %d", i,
+                  i - 1);
+      return kTfLiteError;
+    }
+    if (i < num_ops_ - 1 &&
+        IsConsumedOutsideChain(subgraph, outputs->data[0], i + 1)) {
+      MicroPrintf("Row streaming: the output of operator %d is used elsewhere",
+                  i);
+      return kTfLiteError;
+    }
+
+    const TfLiteEvalTensor* input = &tensors[inputs->data[0]];
+    const TfLiteEvalTensor* filter = &tensors[inputs->data[1]];
+    const TfLiteEvalTensor* output = &tensors[outputs->data[0]];
+    if (!IsStreamableTensor(input) || !IsStreamableTensor(output)) {
+      MicroPrintf(
+          "Row streaming: operator %d needs int8 NHWC tensors of one batch "
+          "whose rows are a multiple of %d bytes",
+          i, static_cast<int>(kRowAlignment));
+      return kTfLiteError;
+    }
+
+    TfLitePadding padding;
+    int stride_width, dilation_height, dilation_width;
+    switch (op.registration->builtin_code) {
+      case BuiltinOperator_CONV_2D: {
+        const auto* params =
+            static_cast<const TfLiteConvParams*>(op.node.builtin_data);
+        padding = params->padding;
+        stride_width = params->stride_width;
+        layer->stride = params->stride_height;
+        dilation_width = params->dilation_width_factor;
+        dilation_height = params->dilation_height_factor;
+        layer->eval_rows = ConvEvalInt8Rows;
+        break;
+      }
+      case BuiltinOperator_DEPTHWISE_CONV_2D: {
+        const auto* params =
+            static_cast<const TfLiteDepthwiseConvParams*>(op.node.builtin_data);
+        padding = params->padding;
+        stride_width = params->stride_width;
+        layer->stride = params->stride_height;
+        dilation_width = params->dilation_width_factor;
+        dilation_height = params->dilation_height_factor;
+        layer->eval_rows = DepthwiseConvEvalInt8Rows;
+        break;
+      }
+      default:
+        MicroPrintf("Row streaming: operator %d is not a CONV_2D or "
+                    "DEPTHWISE_CONV_2D", i);
+        return kTfLiteError;
+    }
+
+    layer->filter_height = filter->dims->data[1];
+    layer->input_height = input->dims->data[1];
+    layer->output_height = output->dims->data[1];
+    layer->input_row_bytes = input->dims->data[2] * input->dims->data[3];
+    layer->output_row_bytes = output->dims->data[2] * output->dims->data[3];
+    layer->input_zero_point = ZeroPoint(subgraph, inputs->data[0]);
+
+    int out_height, out_width;
+    layer->pad_top =
+        ComputePaddingHeightWidth(layer->stride, stride_width, dilation_height,
+                                  dilation_width, input->dims->data[1],
+                                  input->dims->data[2], layer->filter_height,
+                                  filter->dims->data[2], padding, &out_height,
+                                  &out_width)
+            .height;
+  }
+  input_ = &tensors[layers_[0].node->inputs->data[0]];
+  output_ = &tensors[layers_[num_ops_ - 1].node->outputs->data[0]];
+  windows_ = &tensors[layers_[0].node->outputs->data[0]];
+
+  // Size every window for the largest band.
+  for (int i = 0; i < num_ops_; ++i) {
+    layers_[i].window_rows = 0;
+  }
+  for (int begin = 0; begin < output_->dims->data[1]; begin += band_rows_) {
+    PlanBand(begin, std::min(begin + band_rows_, output_->dims->data[1]));
+    for (int i = 0; i < num_ops_; ++i) {
+      layers_[i].window_rows = std::max(
+          layers_[i].window_rows, layers_[i].last_row - layers_[i].first_row);
+    }
+  }
+  size_t bytes = 0;
+  for (int i = 0; i < num_ops_; ++i) {
+    layers_[i].window_offset = bytes;
+    bytes += AlignSizeUp(layers_[i].window_rows * layers_[i].input_row_bytes,
+                         kRowAlignment);
+  }
+  TF_LITE_ENSURE_STATUS(allocator->SetStreamedOperators(num_ops_, bytes));
+
+  // The kernels were prepared for whole tensors, let them check that their
+  // scratch buffers also fit the bands.
+  for (int i = 0; i < num_ops_; ++i) {
+    const int output_rows =
+        i < num_ops_ - 1 ? layers_[i + 1].window_rows : band_rows_;
+    if (layers_[i].eval_rows == ConvEvalInt8Rows) {
+      TF_LITE_ENSURE_STATUS(
+          ConvPrepareInt8Rows(context, layers_[i].node, output_rows));
+    } else {
+      TF_LITE_ENSURE_STATUS(
+          DepthwiseConvPrepareInt8Rows(context, layers_[i].node, output_rows));
+    }
+    TF_LITE_ENSURE_STATUS(allocator->FinishPrepareNodeAllocations(i));
+  }
+  return kTfLiteOk;
+#else
+  MicroPrintf("Row streaming needs the esp-nn kernels");
+  return kTfLiteError;
+#endif
+}
+
+void MicroRowStreamer::PlanBand(int begin, int end) {
+  for (int i = num_ops_ - 1; i >= 0; --i) {
+    Layer* layer = &layers_[i];
+    layer->first_row = begin * layer->stride - layer->pad_top;
+    layer->last_row =
+        (end - 1) * layer->stride - layer->pad_top + layer->filter_height;
+    begin = layer->first_row;
+    end = layer->last_row;
+  }
+}
+
+TfLiteStatus MicroRowStreamer::Invoke(TfLiteContext* context) {
+  const int output_height = output_->dims->data[1];
+  int8_t* windows = windows_->data.int8;
+
+  for (int begin = 0; begin < output_height; begin += band_rows_) {
+    const int end = std::min(begin + band_rows_, output_height);
+    PlanBand(begin, end);
+
+    for (int i = 0; i < num_ops_; ++i) {
+      const Layer& layer = layers_[i];
+      const size_t row_bytes = layer.input_row_bytes;
+      // Rows of the window that lie inside the input.
+      const int in_first = std::max(layer.first_row, 0);
+      const int in_last = std::min(layer.last_row, layer.input_height);
+
+      const int8_t* input;
+      if (i == 0 && in_first == layer.first_row &&
+          in_last == layer.last_row) {
+        input = input_->data.int8 + layer.first_row * row_bytes;
+      } else {
+        int8_t* window = windows + layer.window_offset;
+        if (i == 0) {
+          std::memcpy(window + (in_first - layer.first_row) * row_bytes,
+                      input_->data.int8 + in_first * row_bytes,
+                      (in_last - in_first) * row_bytes);
+        }
+        std::memset(window, layer.input_zero_point,
+                    (in_first - layer.first_row) * row_bytes);
+        std::memset(window + (in_last - layer.first_row) * row_bytes,
+                    layer.input_zero_point,
+                    (layer.last_row - in_last) * row_bytes);
+        input = window;
+      }
+
+      // Output rows wanted by the next layer, or the band itself.
+      int out_first = begin;
+      int out_last = end;
+      int8_t* output = output_->data.int8 + begin * layer.output_row_bytes;
+      if (i < num_ops_ - 1) {
+        out_first = layers_[i + 1].first_row;
+        out_last = layers_[i + 1].last_row;
+        output = windows + layers_[i + 1].window_offset;
+      }
+      // Rows outside the output are padding for the next layer.
+      const int window_first = out_first;
+      out_first = std::max(out_first, 0);
+      out_last = std::min(out_last, layer.output_height);
+
+      const int in_row = out_first * layer.stride - layer.pad_top;
+      TF_LITE_ENSURE_STATUS(layer.eval_rows(
+          context, layer.node, input + (in_row - layer.first_row) * row_bytes,
+          (out_last - out_first - 1) * layer.stride + layer.filter_height,
+          output + (out_first - window_first) * layer.output_row_bytes,
+          out_last - out_first));
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
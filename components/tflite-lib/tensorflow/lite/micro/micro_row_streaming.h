@@ -0,0 +1,96 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_ROW_STREAMING_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_ROW_STREAMING_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Runs the first operators of subgraph 0, a chain of int8 CONV_2D and
+// DEPTHWISE_CONV_2D where each consumes the output of the one before, over
+// horizontal bands of the last one's output rows. For every band it works out
+// the rows each layer needs, halo rows included, and computes them into small
+// windows, so the activations between these layers never exist at full size.
+// Halo rows shared by two bands are computed twice.
+//
+// Rows above and below a tensor are filled with its zero point and the kernels
+// run without vertical padding, which gives the same results as the normal
+// path. The windows are planned as one buffer by the allocator, see
+// MicroAllocator::SetStreamedOperators(). Needs the esp-nn kernels.
+class MicroRowStreamer {
+ public:
+  // Streams the first `num_ops` operators in bands of `band_rows` output rows,
+  // 0 turns row streaming off.
+  TfLiteStatus Configure(int num_ops, int band_rows);
+
+  // Checks that the configured operators can be streamed and sizes their
+  // windows. Called after the operators are prepared and before the model
+  // allocation is finished.
+  TfLiteStatus Prepare(TfLiteContext* context, const Model* model,
+                       MicroAllocator* allocator,
+                       SubgraphAllocations* allocations);
+
+  // Computes the output of the last streamed operator.
+  TfLiteStatus Invoke(TfLiteContext* context);
+
+  int num_ops() const { return num_ops_; }
+
+ private:
+  typedef TfLiteStatus (*EvalRowsFunc)(TfLiteContext* context, TfLiteNode* node,
+                                       const int8_t* input, int input_rows,
+                                       int8_t* output, int output_rows);
+
+  struct Layer {
+    TfLiteNode* node;
+    EvalRowsFunc eval_rows;
+    int stride;
+    int filter_height;
+    int pad_top;
+    int input_height;
+    int output_height;
+    size_t input_row_bytes;
+    size_t output_row_bytes;
+    int8_t input_zero_point;
+    // Offset of the window holding the input rows, in the first intermediate
+    // tensor which carries all windows, and its size in rows.
+    size_t window_offset;
+    int window_rows;
+    // Input rows [first_row, last_row) needed by the current band, they may
+    // reach past the edges of the input.
+    int first_row;
+    int last_row;
+  };
+
+  // Sets first_row and last_row of every layer for output rows [begin, end)
+  // of the last layer.
+  void PlanBand(int begin, int end);
+
+  int num_ops_ = 0;
+  int band_rows_ = 0;
+  Layer* layers_ = nullptr;
+  TfLiteEvalTensor* input_ = nullptr;
+  TfLiteEvalTensor* output_ = nullptr;
+  TfLiteEvalTensor* windows_ = nullptr;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_ROW_STREAMING_H_
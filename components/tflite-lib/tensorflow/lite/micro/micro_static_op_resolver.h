@@ -0,0 +1,67 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// An op resolver whose set of builtin ops is fixed at compile time, usually
+// generated from a model by tools/op_resolver. `Ops` provides:
+//
+//   static constexpr int kNumOps;
+//   // Slot of `op` in [0, kNumOps), or -1 if it is not one of the ops.
+//   static constexpr int Index(BuiltinOperator op);
+//   // Fills the kNumOps registrations and parsers, in slot order.
+//   static void Register(TfLiteRegistration* registrations,
+//                        MicroOpResolver::BuiltinParseFunction* parsers);
+//
+// Unlike MicroMutableOpResolver, looking up an op is a switch on its builtin
+// code rather than a search of the registrations, and only the registration
+// functions Ops::Register() calls are linked. Custom ops are not supported.
+template <typename Ops>
+class MicroStaticOpResolver : public MicroOpResolver {
+ public:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+
+  MicroStaticOpResolver() { Ops::Register(registrations_, parsers_); }
+
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op) const override {
+    const int index = Ops::Index(op);
+    return index < 0 ? nullptr : &registrations_[index];
+  }
+
+  const TfLiteRegistration* FindOp(const char* op) const override {
+    return nullptr;
+  }
+
+  MicroOpResolver::BuiltinParseFunction GetOpDataParser(
+      BuiltinOperator op) const override {
+    const int index = Ops::Index(op);
+    return index < 0 ? nullptr : parsers_[index];
+  }
+
+ private:
+  TfLiteRegistration registrations_[Ops::kNumOps];
+  MicroOpResolver::BuiltinParseFunction parsers_[Ops::kNumOps];
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
@@ -0,0 +1,394 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures how much of the tensor arena a model uses, per category, and the
+// smallest arena AllocateTensors() succeeds with. The result is written as a
+// header for the application to size its arena with.
+//
+// Usage: arena_size [-r ops:rows] <model.tflite> <output.h>
+//
+// With -r, the model is allocated with the first `ops` operators row streamed
+// in bands of `rows` rows, see MicroInterpreter::SetRowStreaming(). Not every
+// setting shrinks the arena, some grow it, so compare with the size without -r.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/memory_planner/cached_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+constexpr size_t kMaxArenaSize = 16 * 1024 * 1024;
+// MicroAllocator aligns the start of the arena to 16 bytes, heap allocations
+// may only be 4 byte aligned.
+constexpr size_t kArenaAlignmentSlack = 12;
+
+// Built with ESP_NN_MULTICORE, kernels request one scratch buffer per core.
+#if defined(ESP_NN_USE_PTHREADS)
+constexpr int kMulticore = 1;
+#else
+constexpr int kMulticore = 0;
+#endif
+
+// Row streaming configuration given with -r, 0 operators when off.
+int streamed_ops = 0;
+int band_rows = 0;
+
+struct BufferRequirement {
+  int size;
+  int first_time_used;
+  int last_time_used;
+  int offline_offset;
+};
+
+// Plans with a GreedyMemoryPlanner and keeps the buffers it was given.
+class BufferRecorder : public tflite::MicroMemoryPlanner {
+ public:
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override {
+    buffers_.clear();
+    return planner_.Init(scratch_buffer, scratch_buffer_size);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override {
+    buffers_.push_back({size, first_time_used, last_time_used,
+                        tflite::kOnlinePlannedBuffer});
+    return planner_.AddBuffer(size, first_time_used, last_time_used);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override {
+    buffers_.push_back(
+        {size, first_time_used, last_time_used, offline_offset});
+    return planner_.AddBuffer(size, first_time_used, last_time_used,
+                              offline_offset);
+  }
+
+  size_t GetMaximumMemorySize() override {
+    return planner_.GetMaximumMemorySize();
+  }
+  int GetBufferCount() override { return planner_.GetBufferCount(); }
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override {
+    return planner_.GetOffsetForBuffer(buffer_index, offset);
+  }
+
+  const std::vector<BufferRequirement>& buffers() const { return buffers_; }
+
+ private:
+  tflite::GreedyMemoryPlanner planner_;
+  std::vector<BufferRequirement> buffers_;
+};
+
+struct FreeDeleter {
+  void operator()(uint8_t* p) const { free(p); }
+};
+using AlignedBuffer = std::unique_ptr<uint8_t, FreeDeleter>;
+
+AlignedBuffer AllocateAligned(size_t size) {
+  return AlignedBuffer(
+      static_cast<uint8_t*>(aligned_alloc(16, (size + 15) & ~size_t{15})));
+}
+
+bool ReadFile(const char* path, AlignedBuffer* data, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  *data = AllocateAligned(*size);
+  bool ok = *data != nullptr && fread(data->get(), 1, *size, f) == *size;
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "Can't read %s\n", path);
+  }
+  return ok;
+}
+
+tflite::AllOpsResolver& Resolver() {
+  static tflite::AllOpsResolver resolver;
+  return resolver;
+}
+
+// Whether the model fits an arena of `arena_size` bytes, allocated the way the
+// application does it: CachedMemoryPlanner living outside the arena.
+bool FitsArena(const tflite::Model* model, uint8_t* arena,
+               size_t arena_size) {
+  tflite::CachedMemoryPlanner planner(model);
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, arena_size, &planner);
+  if (allocator == nullptr) {
+    return false;
+  }
+  tflite::MicroInterpreter interpreter(model, Resolver(), allocator);
+  return interpreter.SetRowStreaming(streamed_ops, band_rows) == kTfLiteOk &&
+         interpreter.AllocateTensors() == kTfLiteOk;
+}
+
+// Smallest arena the model fits, or 0 if it doesn't fit kMaxArenaSize.
+size_t FindMinimumArenaSize(const tflite::Model* model, uint8_t* arena) {
+  // Failed attempts are reported through DebugLog(), which writes to stderr.
+  fflush(stderr);
+  const int saved_stderr = dup(STDERR_FILENO);
+  const int null_fd = open("/dev/null", O_WRONLY);
+  dup2(null_fd, STDERR_FILENO);
+
+  size_t fits = 0;
+  if (FitsArena(model, arena, kMaxArenaSize)) {
+    size_t lo = 0;
+    fits = kMaxArenaSize;
+    while (fits - lo > 1) {
+      const size_t mid = lo + (fits - lo) / 2;
+      if (FitsArena(model, arena, mid)) {
+        fits = mid;
+      } else {
+        lo = mid;
+      }
+    }
+  }
+
+  fflush(stderr);
+  dup2(saved_stderr, STDERR_FILENO);
+  close(saved_stderr);
+  close(null_fd);
+  return fits;
+}
+
+// Number of tensors the planner is given, which come before the scratch
+// buffers requested by kernels. See AllocationInfoBuilder.
+size_t CountPlannedTensors(const tflite::Model* model) {
+  size_t count = 0;
+  for (const tflite::SubGraph* subgraph : *model->subgraphs()) {
+    for (const tflite::Tensor* tensor : *subgraph->tensors()) {
+      const tflite::Buffer* buffer = model->buffers()->Get(tensor->buffer());
+      if (tensor->is_variable() ||
+          (buffer->data() != nullptr && buffer->data()->size() > 0)) {
+        continue;
+      }
+      bool empty = false;
+      if (tensor->shape() != nullptr) {
+        for (int32_t dim : *tensor->shape()) {
+          empty |= dim == 0;
+        }
+      }
+      if (!empty) {
+        ++count;
+      }
+    }
+  }
+  // The band windows of row streaming replace the tensors between the
+  // streamed operators, and are planned as the first of them.
+  if (streamed_ops > 2) {
+    count -= streamed_ops - 2;
+  }
+  return count;
+}
+
+// Arena size the greedy planner needs for `buffers`.
+size_t PlanSize(const std::vector<BufferRequirement>& buffers) {
+  std::vector<unsigned char> scratch(
+      buffers.size() * tflite::GreedyMemoryPlanner::per_buffer_size());
+  tflite::GreedyMemoryPlanner planner;
+  planner.Init(scratch.data(), scratch.size());
+  for (const BufferRequirement& b : buffers) {
+    if (b.offline_offset == tflite::kOnlinePlannedBuffer) {
+      planner.AddBuffer(b.size, b.first_time_used, b.last_time_used);
+    } else {
+      planner.AddBuffer(b.size, b.first_time_used, b.last_time_used,
+                        b.offline_offset);
+    }
+  }
+  return planner.GetMaximumMemorySize();
+}
+
+// MODEL_ARENA_SIZE_H_ from path/to/model_arena_size.h
+std::string IncludeGuard(const char* path) {
+  const char* name = strrchr(path, '/');
+  std::string guard;
+  for (const char* c = name ? name + 1 : path; *c; ++c) {
+    guard += isalnum(*c) ? toupper(*c) : '_';
+  }
+  return guard + "_";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "r:")) != -1) {
+    if (opt != 'r' ||
+        sscanf(optarg, "%d:%d", &streamed_ops, &band_rows) != 2) {
+      optind = argc;
+      break;
+    }
+  }
+  if (argc - optind != 2) {
+    fprintf(stderr, "Usage: %s [-r ops:rows] <model.tflite> <output.h>\n",
+            argv[0]);
+    return 1;
+  }
+  const char* model_path = argv[optind];
+  const char* header_path = argv[optind + 1];
+
+  AlignedBuffer model_data;
+  size_t model_size;
+  if (!ReadFile(model_path, &model_data, &model_size)) {
+    return 1;
+  }
+  flatbuffers::Verifier verifier(model_data.get(), model_size);
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a valid model\n", model_path);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.get());
+  AlignedBuffer arena = AllocateAligned(kMaxArenaSize);
+
+  const size_t minimum_size = FindMinimumArenaSize(model, arena.get());
+  if (minimum_size == 0) {
+    fprintf(stderr, "AllocateTensors() fails even with %zu bytes\n",
+            kMaxArenaSize);
+    return 1;
+  }
+
+  // Planned buffers, tensors first then kernel scratch buffers.
+  BufferRecorder recorder;
+  {
+    tflite::MicroAllocator* allocator =
+        tflite::MicroAllocator::Create(arena.get(), kMaxArenaSize, &recorder);
+    tflite::MicroInterpreter interpreter(model, Resolver(), allocator);
+    interpreter.SetRowStreaming(streamed_ops, band_rows);
+    interpreter.AllocateTensors();
+  }
+  std::vector<BufferRequirement> tensors = recorder.buffers();
+  const size_t tensor_count = CountPlannedTensors(model);
+  size_t scratch_count = 0;
+  if (tensor_count <= tensors.size()) {
+    scratch_count = tensors.size() - tensor_count;
+    tensors.resize(tensor_count);
+  }
+  const size_t non_persistent_size = recorder.GetMaximumMemorySize();
+  const size_t activations_size = PlanSize(tensors);
+
+  // Persistent allocations by type.
+  tflite::RecordingMicroInterpreter recording_interpreter(
+      model, Resolver(), arena.get(), kMaxArenaSize);
+  if (recording_interpreter.SetRowStreaming(streamed_ops, band_rows) !=
+          kTfLiteOk ||
+      recording_interpreter.AllocateTensors() != kTfLiteOk) {
+    return 1;
+  }
+  const tflite::RecordingMicroAllocator& allocator =
+      recording_interpreter.GetMicroAllocator();
+  const size_t persistent_size =
+      allocator.GetSimpleMemoryAllocator()->GetPersistentUsedBytes();
+  struct {
+    const char* name;
+    const char* description;
+    tflite::RecordedAllocationType type;
+  } categories[] = {
+      {"EvalTensors", "TfLiteEvalTensor structs",
+       tflite::RecordedAllocationType::kTfLiteEvalTensorData},
+      {"Tensors", "persistent TfLiteTensor structs",
+       tflite::RecordedAllocationType::kPersistentTfLiteTensorData},
+      {"Quantization", "quantization parameters of persistent tensors",
+       tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData},
+      {"KernelData", "buffers allocated by kernels, e.g. per channel params",
+       tflite::RecordedAllocationType::kPersistentBufferData},
+      {"Variables", "variable tensor data",
+       tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData},
+      {"Nodes", "NodeAndRegistration structs",
+       tflite::RecordedAllocationType::kNodeAndRegistrationArray},
+      {"OpData", "builtin operator options",
+       tflite::RecordedAllocationType::kOpData},
+  };
+
+  FILE* out = fopen(header_path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "Can't write %s\n", header_path);
+    return 1;
+  }
+  const char* model_name = strrchr(model_path, '/');
+  const std::string guard = IncludeGuard(header_path);
+  fprintf(out,
+          "// Generated by tensorflow/lite/micro/tools/arena_size from %s,\n"
+          "// for esp-nn %s kernels%s, with %zu-bit pointers. Do not edit.\n\n",
+          model_name ? model_name + 1 : model_path, ESP_NN_TARGET_NAME,
+          kMulticore ? " on two cores" : "", sizeof(void*) * 8);
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  std::string target = ESP_NN_TARGET_NAME;
+  for (char& c : target) {
+    c = toupper(c);
+  }
+  fprintf(out, "#define ARENA_SIZE_ESP_NN_%s 1\n", target.c_str());
+  fprintf(out, "#define ARENA_SIZE_ESP_NN_MULTICORE %d\n", kMulticore);
+  fprintf(out,
+          "// Operators row streamed in bands of rows, see "
+          "MicroInterpreter::SetRowStreaming().\n"
+          "#define ARENA_SIZE_ROW_STREAMING_OPS %d\n"
+          "#define ARENA_SIZE_ROW_STREAMING_BAND_ROWS %d\n\n",
+          streamed_ops, band_rows);
+  fprintf(out,
+          "// Smallest arena AllocateTensors() succeeds with, when the memory\n"
+          "// planner is not allocated from it, plus %zu bytes in case the\n"
+          "// arena is not 16 byte aligned.\n"
+          "constexpr int kArenaMinimumSize = %zu;\n\n",
+          kArenaAlignmentSlack, minimum_size + kArenaAlignmentSlack);
+  fprintf(out,
+          "// Activation tensors and kernel scratch buffers, which share memory\n"
+          "// as planned by the GreedyMemoryPlanner.\n"
+          "constexpr int kArenaNonPersistentSize = %zu;\n"
+          "// What the %zu kernel scratch buffers add to the plan.\n"
+          "constexpr int kArenaScratchSize = %zu;\n\n",
+          non_persistent_size, scratch_count,
+          non_persistent_size - activations_size);
+  fprintf(out,
+          "// Interpreter state, kept for the lifetime of the interpreter.\n"
+          "constexpr int kArenaPersistentSize = %zu;\n",
+          persistent_size);
+  for (const auto& category : categories) {
+    fprintf(out, "// %s\nconstexpr int kArenaPersistent%sSize = %zu;\n",
+            category.description, category.name,
+            allocator.GetRecordedAllocation(category.type).used_bytes);
+  }
+  fprintf(out, "\n#endif  // %s\n", guard.c_str());
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Can't write %s\n", header_path);
+    return 1;
+  }
+
+  printf("%s: minimum arena %zu bytes (non-persistent %zu, of which scratch "
+         "%zu, persistent %zu)\n",
+         header_path, minimum_size, non_persistent_size,
+         non_persistent_size - activations_size, persistent_size);
+  return 0;
+}
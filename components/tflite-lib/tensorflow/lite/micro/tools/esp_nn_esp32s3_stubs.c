@@ -0,0 +1,53 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Placeholders for the ESP32-S3 assembly routines of esp-nn.
+ *
+ * Host tools only prepare models, which needs the scratch sizes computed by
+ * the C part of the S3 kernels, but never run them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void esp_nn_esp32s3_stub(const char *name)
+{
+    fprintf(stderr, "%s can only run on an ESP32-S3\n", name);
+    abort();
+}
+
+#define ESP32S3_STUB(name) \
+    void name(void) { esp_nn_esp32s3_stub(#name); }
+
+ESP32S3_STUB(esp_nn_add_elementwise_s8_esp32s3)
+ESP32S3_STUB(esp_nn_aligned_s8_to_s16_with_offset_esp32s3)
+ESP32S3_STUB(esp_nn_avg_pool_s8_esp32s3)
+ESP32S3_STUB(esp_nn_conv_s16_mult4_1x1_esp32s3)
+ESP32S3_STUB(esp_nn_conv_s16_mult8_esp32s3)
+ESP32S3_STUB(esp_nn_conv_s8_mult8_1x1_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult1_3x3_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult1_3x3_no_pad_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult1_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult4_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult8_3x3_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s16_mult8_esp32s3)
+ESP32S3_STUB(esp_nn_depthwise_conv_s8_mult1_3x3_padded_esp32s3)
+ESP32S3_STUB(esp_nn_fully_connected_s8_esp32s3)
+ESP32S3_STUB(esp_nn_max_pool_s8_esp32s3)
+ESP32S3_STUB(esp_nn_mul_elementwise_s8_esp32s3)
+ESP32S3_STUB(esp_nn_multiply_by_quantized_mult_asm_esp32s3)
+ESP32S3_STUB(esp_nn_multiply_by_quantized_mult_ver1_esp32s3)
+ESP32S3_STUB(esp_nn_relu6_s8_esp32s3)
+ESP32S3_STUB(esp_nn_s8_to_s16_esp32s3)
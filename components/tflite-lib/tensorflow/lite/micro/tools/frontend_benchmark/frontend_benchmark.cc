@@ -0,0 +1,366 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Times the audio frontend of experimental/microfrontend on synthetic audio
+// and checks that it is bit-exact with the reference pipeline it optimizes:
+// kissfft's kiss_fftr() and 64 bit filterbank accumulators, one window per
+// FrontendProcessSamples() call.
+//
+// Usage: frontend_benchmark [-s seconds] [-r repeats]
+//
+// The audio is 16 kHz, a mix of tones, sweeps, noise, silence and clipping.
+// Each configuration is checked with FrontendProcessSamples() and with
+// FrontendProcessSamplesBatch() on blocks of random lengths, then timed on
+// the whole audio. Returns 1 if any feature differs from the reference.
+
+#include <time.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_util.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/kiss_fft_int16.h"
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+
+struct Config {
+  const char* name;
+  int window_ms;
+  int step_ms;
+  int num_channels;
+  bool pcan;
+};
+
+// The default configuration, the one of the micro_speech example, and one with
+// a 1024 point FFT, an odd power of two.
+const Config kConfigs[] = {
+    {"default 25/10 ms, 32 channels", 25, 10, 32, false},
+    {"micro_speech 30/20 ms, 40 channels, pcan", 30, 20, 40, true},
+    {"64/16 ms, 40 channels", 64, 16, 40, false},
+};
+
+uint32_t random_state = 1;
+
+uint32_t Random() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state >> 8;
+}
+
+std::vector<int16_t> MakeAudio(int seconds) {
+  std::vector<int16_t> audio(seconds * kSampleRate);
+  const double pi = 3.14159265358979323846;
+  for (size_t i = 0; i < audio.size(); ++i) {
+    const double t = static_cast<double>(i) / kSampleRate;
+    const int part = static_cast<int>(t * 4) % 6;
+    double value = 0;
+    switch (part) {
+      case 0:  // Tones
+        value = 9000 * sin(2 * pi * 440 * t) + 3000 * sin(2 * pi * 3100 * t);
+        break;
+      case 1:  // Sweep
+        value = 12000 * sin(2 * pi * (200 + 3000 * fmod(t, 1.0)) * t);
+        break;
+      case 2:  // Noise
+        value = static_cast<int>(Random() % 20001) - 10000;
+        break;
+      case 3:  // Near silence
+        value = static_cast<int>(Random() % 5) - 2;
+        break;
+      case 4:  // Clipping
+        value = 60000 * sin(2 * pi * 150 * t);
+        break;
+      case 5:  // Quiet noise
+        value = static_cast<int>(Random() % 601) - 300;
+        break;
+    }
+    if (value > 32767) value = 32767;
+    if (value < -32768) value = -32768;
+    audio[i] = static_cast<int16_t>(value);
+  }
+  return audio;
+}
+
+bool Populate(const Config& config, FrontendState* state) {
+  FrontendConfig frontend_config;
+  FrontendFillConfigWithDefaults(&frontend_config);
+  frontend_config.window.size_ms = config.window_ms;
+  frontend_config.window.step_size_ms = config.step_ms;
+  frontend_config.filterbank.num_channels = config.num_channels;
+  frontend_config.pcan_gain_control.enable_pcan = config.pcan;
+  return FrontendPopulateState(&frontend_config, state, kSampleRate);
+}
+
+// FrontendProcessSamples() before it was optimized: the FFT of kissfft and
+// the filterbank with 64 bit accumulators.
+class ReferenceFrontend {
+ public:
+  explicit ReferenceFrontend(FrontendState* state) : state_(state) {
+    size_t size = 0;
+    kissfft_fixed16::kiss_fftr_alloc(state->fft.fft_size, 0, nullptr, &size);
+    kiss_memory_.resize(size);
+    kiss_cfg_ = kissfft_fixed16::kiss_fftr_alloc(state->fft.fft_size, 0,
+                                                 kiss_memory_.data(), &size);
+  }
+
+  FrontendOutput ProcessSamples(const int16_t* samples, size_t num_samples,
+                                size_t* num_samples_read) {
+    FrontendOutput output = {nullptr, 0};
+    if (!WindowProcessSamples(&state_->window, samples, num_samples,
+                              num_samples_read)) {
+      return output;
+    }
+    FftState* fft = &state_->fft;
+    const int input_shift =
+        15 - MostSignificantBit32(state_->window.max_abs_output_value);
+    size_t i;
+    for (i = 0; i < fft->input_size; ++i) {
+      fft->input[i] = static_cast<int16_t>(
+          static_cast<uint16_t>(state_->window.output[i]) << input_shift);
+    }
+    for (; i < fft->fft_size; ++i) {
+      fft->input[i] = 0;
+    }
+    kissfft_fixed16::kiss_fftr(
+        kiss_cfg_, fft->input,
+        reinterpret_cast<kissfft_fixed16::kiss_fft_cpx*>(fft->output));
+
+    int32_t* energy = reinterpret_cast<int32_t*>(fft->output);
+    FilterbankConvertFftComplexToEnergy(&state_->filterbank, fft->output,
+                                        energy);
+    AccumulateChannels64(energy);
+    uint32_t* scaled_filterbank =
+        FilterbankSqrt(&state_->filterbank, input_shift);
+    NoiseReductionApply(&state_->noise_reduction, scaled_filterbank);
+    if (state_->pcan_gain_control.enable_pcan) {
+      PcanGainControlApply(&state_->pcan_gain_control, scaled_filterbank);
+    }
+    const int correction_bits =
+        MostSignificantBit32(fft->fft_size) - 1 - (kFilterbankBits / 2);
+    output.values =
+        LogScaleApply(&state_->log_scale, scaled_filterbank,
+                      state_->filterbank.num_channels, correction_bits);
+    output.size = state_->filterbank.num_channels;
+    return output;
+  }
+
+ private:
+  void AccumulateChannels64(const int32_t* energy) {
+    const FilterbankState* filterbank = &state_->filterbank;
+    uint64_t* work = filterbank->work;
+    uint64_t weight_accumulator = 0;
+    uint64_t unweight_accumulator = 0;
+    for (int i = 0; i < filterbank->num_channels + 1; ++i) {
+      const int32_t* magnitudes =
+          energy + filterbank->channel_frequency_starts[i];
+      const int16_t* weights =
+          filterbank->weights + filterbank->channel_weight_starts[i];
+      const int16_t* unweights =
+          filterbank->unweights + filterbank->channel_weight_starts[i];
+      for (int j = 0; j < filterbank->channel_widths[i]; ++j) {
+        weight_accumulator += weights[j] * static_cast<uint64_t>(magnitudes[j]);
+        unweight_accumulator +=
+            unweights[j] * static_cast<uint64_t>(magnitudes[j]);
+      }
+      *work++ = weight_accumulator;
+      weight_accumulator = unweight_accumulator;
+      unweight_accumulator = 0;
+    }
+  }
+
+  FrontendState* state_;
+  std::vector<char> kiss_memory_;
+  kissfft_fixed16::kiss_fftr_cfg kiss_cfg_;
+};
+
+double NowUs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+// Features of the whole audio, one vector after the other.
+std::vector<uint16_t> RunReference(const Config& config,
+                                   const std::vector<int16_t>& audio) {
+  FrontendState state;
+  std::vector<uint16_t> features;
+  if (!Populate(config, &state)) {
+    return features;
+  }
+  ReferenceFrontend reference(&state);
+  size_t read = 0;
+  while (read < audio.size()) {
+    size_t n;
+    FrontendOutput output =
+        reference.ProcessSamples(&audio[read], audio.size() - read, &n);
+    features.insert(features.end(), output.values, output.values + output.size);
+    read += n;
+  }
+  FrontendFreeStateContents(&state);
+  return features;
+}
+
+std::vector<uint16_t> RunSingle(const Config& config,
+                                const std::vector<int16_t>& audio) {
+  FrontendState state;
+  std::vector<uint16_t> features;
+  if (!Populate(config, &state)) {
+    return features;
+  }
+  size_t read = 0;
+  while (read < audio.size()) {
+    size_t n;
+    FrontendOutput output =
+        FrontendProcessSamples(&state, &audio[read], audio.size() - read, &n);
+    features.insert(features.end(), output.values, output.values + output.size);
+    read += n;
+  }
+  FrontendFreeStateContents(&state);
+  return features;
+}
+
+// Feeds the audio in blocks of random lengths, from less than a step to a few
+// windows, and collects at most a random number of vectors per call.
+std::vector<uint16_t> RunBatch(const Config& config,
+                               const std::vector<int16_t>& audio) {
+  FrontendState state;
+  std::vector<uint16_t> features;
+  if (!Populate(config, &state)) {
+    return features;
+  }
+  const size_t num_channels = state.filterbank.num_channels;
+  const size_t max_block = 4 * state.window.size;
+  std::vector<uint16_t> frames(max_block * num_channels);
+  size_t read = 0;
+  while (read < audio.size()) {
+    size_t block = 1 + Random() % max_block;
+    if (block > audio.size() - read) {
+      block = audio.size() - read;
+    }
+    const size_t max_frames = Random() % 4 == 0 ? Random() % 3 : max_block;
+    size_t n;
+    const size_t num_frames = FrontendProcessSamplesBatch(
+        &state, &audio[read], block, frames.data(), max_frames, &n);
+    features.insert(features.end(), frames.begin(),
+                    frames.begin() + num_frames * num_channels);
+    read += n;
+  }
+  FrontendFreeStateContents(&state);
+  return features;
+}
+
+bool Check(const char* what, const std::vector<uint16_t>& features,
+           const std::vector<uint16_t>& reference) {
+  if (features == reference) {
+    return true;
+  }
+  size_t i = 0;
+  while (i < features.size() && i < reference.size() &&
+         features[i] == reference[i]) {
+    ++i;
+  }
+  printf("  %s differs from the reference at value %zu of %zu (%zu values)\n",
+         what, i, reference.size(), features.size());
+  return false;
+}
+
+// Microseconds per feature vector of the whole audio, the best of repeats.
+template <typename Run>
+double Time(const Config& config, int repeats, size_t num_vectors, Run run) {
+  double best = 0;
+  for (int r = 0; r < repeats; ++r) {
+    FrontendState state;
+    if (!Populate(config, &state)) {
+      return 0;
+    }
+    const double start = NowUs();
+    run(&state);
+    const double us = NowUs() - start;
+    if (r == 0 || us < best) {
+      best = us;
+    }
+    FrontendFreeStateContents(&state);
+  }
+  return best / num_vectors;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int seconds = 20;
+  int repeats = 5;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      repeats = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [-s seconds] [-r repeats]\n", argv[0]);
+      return 1;
+    }
+  }
+  const std::vector<int16_t> audio = MakeAudio(seconds);
+
+  bool exact = true;
+  for (const Config& config : kConfigs) {
+    printf("%s\n", config.name);
+    const std::vector<uint16_t> reference = RunReference(config, audio);
+    if (reference.empty()) {
+      printf("  Failed to populate the frontend\n");
+      return 1;
+    }
+    exact &= Check("FrontendProcessSamples", RunSingle(config, audio),
+                   reference);
+    exact &= Check("FrontendProcessSamplesBatch", RunBatch(config, audio),
+                   reference);
+
+    const size_t num_vectors = reference.size() / config.num_channels;
+    std::vector<uint16_t> features(reference.size());
+    const double reference_us =
+        Time(config, repeats, num_vectors, [&](FrontendState* state) {
+          ReferenceFrontend frontend(state);
+          for (size_t read = 0, n; read < audio.size(); read += n) {
+            frontend.ProcessSamples(&audio[read], audio.size() - read, &n);
+          }
+        });
+    const double single_us =
+        Time(config, repeats, num_vectors, [&](FrontendState* state) {
+          for (size_t read = 0, n; read < audio.size(); read += n) {
+            FrontendProcessSamples(state, &audio[read], audio.size() - read,
+                                   &n);
+          }
+        });
+    const double batch_us =
+        Time(config, repeats, num_vectors, [&](FrontendState* state) {
+          size_t n;
+          FrontendProcessSamplesBatch(state, audio.data(), audio.size(),
+                                      features.data(), num_vectors, &n);
+        });
+    printf("  %zu vectors, us per vector: reference %.2f, "
+           "FrontendProcessSamples %.2f, FrontendProcessSamplesBatch %.2f "
+           "(%.2fx)\n",
+           num_vectors, reference_us, single_us, batch_us,
+           reference_us / batch_us);
+  }
+  printf("%s\n", exact ? "Bit-exact with the reference"
+                       : "Differs from the reference");
+  return exact ? 0 : 1;
+}
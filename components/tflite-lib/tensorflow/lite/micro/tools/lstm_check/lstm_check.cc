@@ -0,0 +1,401 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks that the int8 UNIDIRECTIONAL_SEQUENCE_LSTM of kernels/esp_nn, which
+// runs the gate matmuls through esp_nn, is bit-exact with the reference kernel
+// of unidirectional_sequence_lstm_common.cc.
+//
+// Usage: lstm_check
+//
+// Every combination of time major, CIFG, peephole, projection, layer norm and
+// clipping is run for a few invokes through both kernels, on random shapes,
+// and the outputs and cell states compared. So are the shapes for which the
+// esp-nn kernel keeps the reference path: an input over 16 bits and peephole
+// models whose output size differs from their cell count. Returns 1 if any
+// output or cell state differs.
+
+#include <cstdio>
+#include <initializer_list>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/lstm_shared.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/kernels/unidirectional_sequence_lstm.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace tflite {
+namespace {
+
+struct Config {
+  int batches;
+  int time_steps;
+  int n_input;
+  int n_cell;
+  int n_output;
+  bool time_major;
+  bool cifg;
+  bool peephole;
+  bool projection;
+  bool projection_bias;
+  bool layer_norm;
+  float cell_clip;
+  float projection_clip;
+};
+
+// Quantization of the tensors, see the integer 8x8_16 Prepare.
+constexpr float kInputScale = 0.02f;
+constexpr int kInputZeroPoint = -3;
+constexpr float kWeightsScale = 0.008f;
+constexpr float kOutputScale = 0.03f;
+constexpr int kOutputZeroPoint = 5;
+constexpr float kCellScale = 1.0f / 2048;
+
+// Tensors 0 to 23 are the LSTM inputs, numbered as in lstm_shared.h, then
+// come the output and the five intermediates.
+constexpr int kOutputTensor = 24;
+constexpr int kIntermediateTensors = 25;
+constexpr int kNumTensors = 30;
+
+// More than the internal arena of KernelRunner, which the LSTM outgrows on
+// 64-bit hosts.
+constexpr size_t kArenaSize = 32 * 1024;
+uint8_t arena[kArenaSize];
+
+uint32_t random_state = 11;
+
+uint32_t Random() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state >> 8;
+}
+
+int RandomInt(int min, int max) {
+  return min + static_cast<int>(Random() % (max - min + 1));
+}
+
+template <typename T>
+void Fill(std::vector<T>* values, int size, int min, int max) {
+  values->resize(size);
+  for (T& value : *values) {
+    value = RandomInt(min, max);
+  }
+}
+
+// Weights, states and buffers of one LSTM.
+struct LstmModel {
+  std::vector<int8_t> input;
+  // Input to gate weights, then recurrent to gate weights, of the input,
+  // forget, cell and output gates.
+  std::vector<int8_t> weights[8];
+  std::vector<int16_t> peephole_weights[3];
+  std::vector<int32_t> bias[4];
+  std::vector<int8_t> projection_weights;
+  std::vector<int32_t> projection_bias;
+  std::vector<int8_t> output_state;
+  std::vector<int16_t> cell_state;
+  std::vector<int16_t> layer_norm_weights[4];
+  std::vector<int8_t> output;
+  int16_t gate_intermediates[4];
+  int8_t hidden_intermediate;
+};
+
+LstmModel RandomModel(const Config& config) {
+  LstmModel model;
+  Fill(&model.input, config.batches * config.time_steps * config.n_input,
+       -128, 127);
+  for (int i = 0; i < 4; ++i) {
+    Fill(&model.weights[i], config.n_cell * config.n_input, -127, 127);
+    Fill(&model.weights[4 + i], config.n_cell * config.n_output, -127, 127);
+    Fill(&model.bias[i], config.n_cell, -20000, 20000);
+    Fill(&model.layer_norm_weights[i], config.n_cell, 500, 2000);
+  }
+  for (std::vector<int16_t>& weights : model.peephole_weights) {
+    Fill(&weights, config.n_cell, -3000, 3000);
+  }
+  Fill(&model.projection_weights, config.n_output * config.n_cell, -127, 127);
+  Fill(&model.projection_bias, config.n_output, -3000, 3000);
+  model.output_state.assign(config.batches * config.n_output,
+                            kOutputZeroPoint);
+  model.cell_state.assign(config.batches * config.n_cell, 0);
+  model.output.resize(config.batches * config.time_steps * config.n_output);
+  return model;
+}
+
+// Dimensions and per tensor quantization of the tensors of one run, which
+// have to outlive the KernelRunner.
+class TensorStore {
+ public:
+  TensorStore() { dims_.reserve(kNumTensors * 4); }
+
+  TfLiteIntArray* Dims(std::initializer_list<int> dims) {
+    const size_t start = dims_.size();
+    dims_.push_back(static_cast<int>(dims.size()));
+    dims_.insert(dims_.end(), dims.begin(), dims.end());
+    return testing::IntArrayFromInts(&dims_[start]);
+  }
+
+  template <typename T>
+  void Set(int index, T* data, TfLiteIntArray* dims, float scale,
+           int zero_point, bool is_variable = false) {
+    Quantization& quantization = quantization_[index];
+    quantization.scale[0] = 1;
+    quantization.scale[1] = scale;
+    quantization.zero_point[0] = 1;
+    quantization.zero_point[1] = zero_point;
+    quantization.affine.scale =
+        testing::FloatArrayFromFloats(quantization.scale);
+    quantization.affine.zero_point =
+        testing::IntArrayFromInts(quantization.zero_point);
+    quantization.affine.quantized_dimension = 0;
+    tensors_[index] = testing::CreateTensor(data, dims, is_variable);
+    tensors_[index].params = {scale, zero_point};
+    tensors_[index].quantization = {kTfLiteAffineQuantization,
+                                    &quantization.affine};
+  }
+
+  TfLiteTensor* tensors() { return tensors_; }
+
+ private:
+  struct Quantization {
+    float scale[2];
+    int zero_point[2];
+    TfLiteAffineQuantization affine;
+  };
+
+  std::vector<int> dims_;
+  TfLiteTensor tensors_[kNumTensors];
+  Quantization quantization_[kNumTensors];
+};
+
+// Runs `invokes` of the LSTM with `registration` on a copy of `model`, and
+// appends the output and cell state after each invoke to `output_values` and
+// `cell_states`. Returns false if the kernel fails.
+bool Run(const Config& config, const LstmModel& original,
+         const TfLiteRegistration& registration, int invokes,
+         std::vector<int8_t>* output_values,
+         std::vector<int16_t>* cell_states) {
+  LstmModel model = original;
+  TensorStore store;
+  const int batches = config.batches;
+  const int time_steps = config.time_steps;
+
+  store.Set(kLstmInputTensor, model.input.data(),
+            config.time_major
+                ? store.Dims({time_steps, batches, config.n_input})
+                : store.Dims({batches, time_steps, config.n_input}),
+            kInputScale, kInputZeroPoint);
+  for (int i = 0; i < 4; ++i) {
+    store.Set(kLstmInputToInputWeightsTensor + i, model.weights[i].data(),
+              store.Dims({config.n_cell, config.n_input}),
+              kWeightsScale * (1.0f + 0.3f * i), 0);
+    store.Set(kLstmRecurrentToInputWeightsTensor + i,
+              model.weights[4 + i].data(),
+              store.Dims({config.n_cell, config.n_output}),
+              kWeightsScale * (1.2f + 0.2f * i), 0);
+    // With layer norm the bias is in the scale of the layer norm input.
+    store.Set(kLstmInputGateBiasTensor + i, model.bias[i].data(),
+              store.Dims({config.n_cell}),
+              config.layer_norm ? 1.0f / 4096 / 1024
+                                : kInputScale * kWeightsScale,
+              0);
+    store.Set(kLstmInputLayerNormCoefficientsTensor + i,
+              model.layer_norm_weights[i].data(), store.Dims({config.n_cell}),
+              1.0f / 1024, 0);
+    store.Set(kIntermediateTensors + i, &model.gate_intermediates[i],
+              store.Dims({1}), (1.0f + 0.5f * i) / 4096, 0);
+  }
+  for (int i = 0; i < 3; ++i) {
+    store.Set(kLstmCellToInputWeightsTensor + i,
+              model.peephole_weights[i].data(), store.Dims({config.n_cell}),
+              0.0002f * (i + 1), 0);
+  }
+  store.Set(kLstmProjectionWeightsTensor, model.projection_weights.data(),
+            store.Dims({config.n_output, config.n_cell}), 0.01f, 0);
+  store.Set(kLstmProjectionBiasTensor, model.projection_bias.data(),
+            store.Dims({config.n_output}), 0.0001f, 0);
+  store.Set(kLstmOutputStateTensor, model.output_state.data(),
+            store.Dims({batches, config.n_output}), kOutputScale,
+            kOutputZeroPoint, /*is_variable=*/true);
+  store.Set(kLstmCellStateTensor, model.cell_state.data(),
+            store.Dims({batches, config.n_cell}), kCellScale, 0,
+            /*is_variable=*/true);
+  store.Set(kOutputTensor, model.output.data(),
+            config.time_major
+                ? store.Dims({time_steps, batches, config.n_output})
+                : store.Dims({batches, time_steps, config.n_output}),
+            kOutputScale, kOutputZeroPoint);
+  store.Set(kIntermediateTensors + 4, &model.hidden_intermediate,
+            store.Dims({1}), 1.0f / 128, -2);
+
+  int inputs[25];
+  inputs[0] = config.layer_norm ? 24 : 20;
+  for (int i = 0; i < inputs[0]; ++i) {
+    inputs[1 + i] = i;
+  }
+  int* tensor = inputs + 1;
+  if (config.cifg) {
+    tensor[kLstmInputToInputWeightsTensor] = kTfLiteOptionalTensor;
+    tensor[kLstmRecurrentToInputWeightsTensor] = kTfLiteOptionalTensor;
+    tensor[kLstmCellToInputWeightsTensor] = kTfLiteOptionalTensor;
+    tensor[kLstmInputGateBiasTensor] = kTfLiteOptionalTensor;
+    if (config.layer_norm) {
+      tensor[kLstmInputLayerNormCoefficientsTensor] = kTfLiteOptionalTensor;
+    }
+  }
+  if (!config.peephole) {
+    tensor[kLstmCellToInputWeightsTensor] = kTfLiteOptionalTensor;
+    tensor[kLstmCellToForgetWeightsTensor] = kTfLiteOptionalTensor;
+    tensor[kLstmCellToOutputWeightsTensor] = kTfLiteOptionalTensor;
+  }
+  if (!config.projection) {
+    tensor[kLstmProjectionWeightsTensor] = kTfLiteOptionalTensor;
+  }
+  if (!config.projection || !config.projection_bias) {
+    tensor[kLstmProjectionBiasTensor] = kTfLiteOptionalTensor;
+  }
+  int outputs[] = {1, kOutputTensor};
+  int intermediates[] = {5,
+                         kIntermediateTensors,
+                         kIntermediateTensors + 1,
+                         kIntermediateTensors + 2,
+                         kIntermediateTensors + 3,
+                         kIntermediateTensors + 4};
+
+  TfLiteUnidirectionalSequenceLSTMParams params = {
+      kTfLiteActTanh, config.cell_clip, config.projection_clip,
+      config.time_major, false};
+  micro::KernelRunner runner(registration, store.tensors(), kNumTensors,
+                             testing::IntArrayFromInts(inputs),
+                             testing::IntArrayFromInts(outputs), &params,
+                             testing::IntArrayFromInts(intermediates), arena,
+                             kArenaSize);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    printf("  Prepare failed\n");
+    return false;
+  }
+  for (int i = 0; i < invokes; ++i) {
+    if (runner.Invoke() != kTfLiteOk) {
+      printf("  Invoke failed\n");
+      return false;
+    }
+    output_values->insert(output_values->end(), model.output.begin(),
+                          model.output.end());
+    cell_states->insert(cell_states->end(), model.cell_state.begin(),
+                        model.cell_state.end());
+  }
+  return true;
+}
+
+// Runs both kernels on the same random model. Returns false if they differ.
+bool Check(const Config& config) {
+  const LstmModel model = RandomModel(config);
+  const TfLiteRegistration reference = micro::RegisterOp(
+      UnidirectionalSequenceLstmInit,
+      UnidirectionalSequenceLstmPrepare,
+      UnidirectionalSequenceLstmEval);
+  const TfLiteRegistration esp_nn =
+      Register_UNIDIRECTIONAL_SEQUENCE_LSTM();
+  constexpr int kInvokes = 3;
+
+  std::vector<int8_t> reference_outputs, outputs;
+  std::vector<int16_t> reference_cell_states, cell_states;
+  bool exact = Run(config, model, reference, kInvokes, &reference_outputs,
+                   &reference_cell_states) &&
+               Run(config, model, esp_nn, kInvokes, &outputs, &cell_states);
+  if (exact && outputs != reference_outputs) {
+    printf("  output differs from the reference");
+    exact = false;
+  } else if (exact && cell_states != reference_cell_states) {
+    printf("  cell state differs from the reference");
+    exact = false;
+  }
+  if (!exact) {
+    printf(" with %d batches, %d steps, %d inputs, %d cells, %d outputs%s%s%s"
+           "%s%s%s%s\n",
+           config.batches, config.time_steps, config.n_input, config.n_cell,
+           config.n_output, config.time_major ? ", time major" : "",
+           config.cifg ? ", CIFG" : "", config.peephole ? ", peephole" : "",
+           config.projection ? ", projection" : "",
+           config.projection_bias ? " with bias" : "",
+           config.layer_norm ? ", layer norm" : "",
+           config.cell_clip > 0 ? ", clipped" : "");
+  }
+  return exact;
+}
+
+// Checks every combination of the LSTM variants, `variant` having a bit per
+// option, on random shapes. Returns false if a check fails.
+bool CheckVariant(int variant, int* checked) {
+  Config config;
+  config.batches = RandomInt(1, 3);
+  config.time_steps = RandomInt(1, 6);
+  config.n_input = RandomInt(1, 10);
+  config.n_cell = RandomInt(5, 17);
+  config.time_major = variant & 1;
+  config.cifg = variant & 2;
+  config.peephole = variant & 4;
+  config.projection = variant & 8;
+  config.projection_bias = config.projection && RandomInt(0, 1);
+  config.layer_norm = variant & 16;
+  const bool clip = variant & 32;
+  config.cell_clip = clip ? 0.7f : 0.0f;
+  config.projection_clip = clip && config.projection ? 0.5f : 0.0f;
+  // Without projection the output size is the cell count. A peephole model
+  // with another output size keeps the reference path in the esp-nn kernel,
+  // so it is checked with both sizes.
+  config.n_output = config.projection ? RandomInt(3, 13) : config.n_cell;
+  bool exact = Check(config);
+  ++*checked;
+  if (config.peephole && config.n_output != config.n_cell) {
+    config.n_output = config.n_cell;
+    exact &= Check(config);
+    ++*checked;
+  }
+  return exact;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  if (argc != 1) {
+    fprintf(stderr, "Usage: %s\n", argv[0]);
+    return 1;
+  }
+
+  bool exact = true;
+  int checked = 0;
+  for (int variant = 0; variant < 64; ++variant) {
+    exact &= tflite::CheckVariant(variant, &checked);
+  }
+  // An input too long for the 16 bit sizes of esp-nn, which keeps the
+  // reference path.
+  tflite::Config long_input = {};
+  long_input.batches = 1;
+  long_input.time_steps = 2;
+  long_input.n_input = UINT16_MAX + 3;
+  long_input.n_cell = 2;
+  long_input.n_output = 2;
+  exact &= tflite::Check(long_input);
+  ++checked;
+
+  printf("%d LSTMs checked\n", checked);
+  printf("%s\n", exact ? "Bit-exact with the reference"
+                       : "Differs from the reference");
+  return exact ? 0 : 1;
+}
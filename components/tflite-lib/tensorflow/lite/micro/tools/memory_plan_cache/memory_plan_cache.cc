@@ -0,0 +1,242 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Computes the arena plan of a model on the host and stores it in the model
+// as `MicroMemoryPlanCache` metadata, so that CachedMemoryPlanner can use it
+// at startup instead of running the GreedyMemoryPlanner.
+//
+// Usage: memory_plan_cache <input.tflite> <output.tflite> [arena_size]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/memory_planner/cached_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+constexpr size_t kDefaultArenaSize = 16 * 1024 * 1024;
+
+// Plans with a GreedyMemoryPlanner, keeping track of what it was asked for and
+// of the offsets it came up with.
+class PlanRecorder : public tflite::MicroMemoryPlanner {
+ public:
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override {
+    checksum_ = tflite::kMemoryPlanChecksumSeed;
+    offsets_.clear();
+    return planner_.Init(scratch_buffer, scratch_buffer_size);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override {
+    return AddBuffer(size, first_time_used, last_time_used,
+                     tflite::kOnlinePlannedBuffer);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override {
+    checksum_ = tflite::MemoryPlanChecksum(checksum_, size, first_time_used,
+                                           last_time_used, offline_offset);
+    offsets_.push_back(-1);
+    if (offline_offset == tflite::kOnlinePlannedBuffer) {
+      return planner_.AddBuffer(size, first_time_used, last_time_used);
+    }
+    return planner_.AddBuffer(size, first_time_used, last_time_used,
+                              offline_offset);
+  }
+
+  size_t GetMaximumMemorySize() override {
+    return planner_.GetMaximumMemorySize();
+  }
+
+  int GetBufferCount() override { return planner_.GetBufferCount(); }
+
+  // Called by the allocator for every buffer when it commits the plan.
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override {
+    TF_LITE_ENSURE_STATUS(planner_.GetOffsetForBuffer(buffer_index, offset));
+    offsets_[buffer_index] = *offset;
+    return kTfLiteOk;
+  }
+
+  // Serialized MemoryPlanCacheHeader followed by the BufferPlan.
+  std::vector<uint8_t> Serialize() {
+    tflite::MemoryPlanCacheHeader header;
+    header.magic = tflite::kMemoryPlanCacheMagic;
+    header.version = tflite::kMemoryPlanCacheVersion;
+    header.checksum = checksum_;
+    header.arena_size = static_cast<uint32_t>(GetMaximumMemorySize());
+    const int32_t buffer_count = static_cast<int32_t>(offsets_.size());
+
+    std::vector<uint8_t> data(sizeof(header) +
+                              tflite::SizeOfBufferPlan(buffer_count));
+    uint8_t* next = data.data();
+    memcpy(next, &header, sizeof(header));
+    next += sizeof(header);
+    memcpy(next, &buffer_count, sizeof(buffer_count));
+    next += sizeof(buffer_count);
+    memcpy(next, offsets_.data(), offsets_.size() * sizeof(int32_t));
+    return data;
+  }
+
+  uint32_t checksum() const { return checksum_; }
+  const std::vector<int32_t>& offsets() const { return offsets_; }
+
+ private:
+  tflite::GreedyMemoryPlanner planner_;
+  uint32_t checksum_ = tflite::kMemoryPlanChecksumSeed;
+  std::vector<int32_t> offsets_;
+};
+
+struct FreeDeleter {
+  void operator()(uint8_t* p) const { free(p); }
+};
+using AlignedBuffer = std::unique_ptr<uint8_t, FreeDeleter>;
+
+AlignedBuffer AllocateAligned(size_t size) {
+  // aligned_alloc() wants a multiple of the alignment
+  return AlignedBuffer(
+      static_cast<uint8_t*>(aligned_alloc(16, (size + 15) & ~size_t{15})));
+}
+
+bool ReadFile(const char* path, AlignedBuffer* data, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  *data = AllocateAligned(*size);
+  bool ok = *data != nullptr && fread(data->get(), 1, *size, f) == *size;
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "Can't read %s\n", path);
+  }
+  return ok;
+}
+
+bool WriteFile(const char* path, const uint8_t* data, size_t size) {
+  FILE* f = fopen(path, "wb");
+  bool ok = f != nullptr && fwrite(data, 1, size, f) == size;
+  if (f != nullptr) {
+    ok = fclose(f) == 0 && ok;
+  }
+  if (!ok) {
+    fprintf(stderr, "Can't write %s\n", path);
+  }
+  return ok;
+}
+
+// Runs AllocateTensors() for `model` with `planner`.
+bool AllocateTensors(const tflite::Model* model,
+                     tflite::MicroMemoryPlanner* planner, uint8_t* arena,
+                     size_t arena_size) {
+  static tflite::AllOpsResolver resolver;
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, arena_size, planner);
+  if (allocator == nullptr) {
+    return false;
+  }
+  tflite::MicroInterpreter interpreter(model, resolver, allocator);
+  return interpreter.AllocateTensors() == kTfLiteOk;
+}
+
+// Adds `plan` as the memory plan cache of the model, replacing any previous.
+flatbuffers::DetachedBuffer EmbedPlan(const tflite::Model* model,
+                                      const std::vector<uint8_t>& plan) {
+  std::unique_ptr<tflite::ModelT> model_t(model->UnPack());
+
+  tflite::MetadataT* metadata = nullptr;
+  for (auto& entry : model_t->metadata) {
+    if (entry->name == tflite::kMemoryPlanCacheMetadata) {
+      metadata = entry.get();
+    }
+  }
+  if (metadata == nullptr) {
+    model_t->buffers.emplace_back(new tflite::BufferT);
+    model_t->metadata.emplace_back(new tflite::MetadataT);
+    metadata = model_t->metadata.back().get();
+    metadata->name = tflite::kMemoryPlanCacheMetadata;
+    metadata->buffer = model_t->buffers.size() - 1;
+  }
+  model_t->buffers[metadata->buffer]->data = plan;
+
+  // The flatbuffers copy shipped with TFLM has no implicit default allocator.
+  // The returned buffer frees itself through it, hence static.
+  static flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, model_t.get()));
+  return fbb.Release();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "Usage: %s <input.tflite> <output.tflite> [arena_size]\n",
+            argv[0]);
+    return 1;
+  }
+  const size_t arena_size =
+      argc > 3 ? strtoul(argv[3], nullptr, 0) : kDefaultArenaSize;
+
+  AlignedBuffer model_data;
+  size_t model_size;
+  if (!ReadFile(argv[1], &model_data, &model_size)) {
+    return 1;
+  }
+  flatbuffers::Verifier verifier(model_data.get(), model_size);
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a valid model\n", argv[1]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.get());
+
+  AlignedBuffer arena = AllocateAligned(arena_size);
+  PlanRecorder recorder;
+  if (!AllocateTensors(model, &recorder, arena.get(), arena_size)) {
+    fprintf(stderr, "AllocateTensors() failed, try a larger arena_size\n");
+    return 1;
+  }
+  const std::vector<uint8_t> plan = recorder.Serialize();
+  flatbuffers::DetachedBuffer output = EmbedPlan(model, plan);
+
+  // Check the device side accepts the plan and comes up with the same layout.
+  const tflite::Model* planned_model = tflite::GetModel(output.data());
+  tflite::CachedMemoryPlanner cached_planner(planned_model);
+  if (!AllocateTensors(planned_model, &cached_planner, arena.get(),
+                       arena_size) ||
+      !cached_planner.UsesCachedPlan()) {
+    fprintf(stderr, "Embedded plan is not used by CachedMemoryPlanner\n");
+    return 1;
+  }
+
+  if (!WriteFile(argv[2], output.data(), output.size())) {
+    return 1;
+  }
+  printf("%s: %zu buffers, %zu bytes of non-persistent arena, checksum %08x\n",
+         argv[2], recorder.offsets().size(), recorder.GetMaximumMemorySize(),
+         (unsigned)recorder.checksum());
+  return 0;
+}
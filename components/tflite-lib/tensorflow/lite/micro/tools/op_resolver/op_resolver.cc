@@ -0,0 +1,431 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes the op resolver of a model as a header: the builtin ops it uses, for
+// tflite::MicroStaticOpResolver. Ops whose every use has int8 activations are
+// registered with their _INT8 kernel variant, which leaves the code for the
+// other types out of the link.
+//
+// Usage: op_resolver <model.tflite | model_data.cc> <name_op_resolver.h>
+//
+// A .cc model is the C array written by convert_bytes_to_c_source(). The
+// header defines NameOps and NameOpResolver, from the name of the header.
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace {
+
+// How MicroMutableOpResolver registers each builtin op, see its Add*()
+// functions. Keep in sync with micro_mutable_op_resolver.h.
+struct OpInfo {
+  tflite::BuiltinOperator op;
+  const char* registration;
+  // Registration of the int8 only variant, nullptr if there is none.
+  const char* int8_registration;
+  const char* parser;
+  // Input 1 is the weights, which must be int8 too for the int8 variant.
+  bool has_weights;
+};
+
+#define OP(name, registration, parser) \
+  {tflite::BuiltinOperator_##name, registration, nullptr, parser, false}
+#define OP_INT8(name, registration, int8_registration, parser, has_weights) \
+  {tflite::BuiltinOperator_##name, registration, int8_registration,         \
+   parser, has_weights}
+
+const OpInfo kOps[] = {
+    OP(ABS, "tflite::ops::micro::Register_ABS()", "ParseAbs"),
+    OP(ADD, "tflite::Register_ADD()", "ParseAdd"),
+    OP(ADD_N, "tflite::Register_ADD_N()", "ParseAddN"),
+    OP(ARG_MAX, "tflite::ops::micro::Register_ARG_MAX()", "ParseArgMax"),
+    OP(ARG_MIN, "tflite::ops::micro::Register_ARG_MIN()", "ParseArgMin"),
+    OP(ASSIGN_VARIABLE, "tflite::Register_ASSIGN_VARIABLE()",
+       "ParseAssignVariable"),
+    OP_INT8(AVERAGE_POOL_2D, "tflite::Register_AVERAGE_POOL_2D()",
+            "tflite::Register_AVERAGE_POOL_2D_INT8()", "ParsePool", false),
+    OP(BATCH_TO_SPACE_ND, "tflite::Register_BATCH_TO_SPACE_ND()",
+       "ParseBatchToSpaceNd"),
+    OP(BROADCAST_ARGS, "tflite::Register_BROADCAST_ARGS()",
+       "ParseBroadcastArgs"),
+    OP(BROADCAST_TO, "tflite::Register_BROADCAST_TO()", "ParseBroadcastTo"),
+    OP(CALL_ONCE, "tflite::Register_CALL_ONCE()", "ParseCallOnce"),
+    OP(CAST, "tflite::Register_CAST()", "ParseCast"),
+    OP(CEIL, "tflite::ops::micro::Register_CEIL()", "ParseCeil"),
+    OP(CONCATENATION, "tflite::ops::micro::Register_CONCATENATION()",
+       "ParseConcatenation"),
+    OP_INT8(CONV_2D, "tflite::Register_CONV_2D()",
+            "tflite::Register_CONV_2D_INT8()", "ParseConv2D", true),
+    OP(COS, "tflite::ops::micro::Register_COS()", "ParseCos"),
+    OP(CUMSUM, "tflite::Register_CUMSUM()", "ParseCumsum"),
+    OP(DEPTH_TO_SPACE, "tflite::Register_DEPTH_TO_SPACE()",
+       "ParseDepthToSpace"),
+    OP_INT8(DEPTHWISE_CONV_2D, "tflite::Register_DEPTHWISE_CONV_2D()",
+            "tflite::Register_DEPTHWISE_CONV_2D_INT8()",
+            "ParseDepthwiseConv2D", true),
+    OP(DEQUANTIZE, "tflite::Register_DEQUANTIZE()", "ParseDequantize"),
+    OP(DIV, "tflite::Register_DIV()", "ParseDiv"),
+    OP(ELU, "tflite::Register_ELU()", "ParseElu"),
+    OP(EQUAL, "tflite::ops::micro::Register_EQUAL()", "ParseEqual"),
+    OP(EXP, "tflite::Register_EXP()", "ParseExp"),
+    OP(EXPAND_DIMS, "tflite::Register_EXPAND_DIMS()", "ParseExpandDims"),
+    OP(FILL, "tflite::Register_FILL()", "ParseFill"),
+    OP(FLOOR, "tflite::ops::micro::Register_FLOOR()", "ParseFloor"),
+    OP(FLOOR_DIV, "tflite::Register_FLOOR_DIV()", "ParseFloorDiv"),
+    OP(FLOOR_MOD, "tflite::Register_FLOOR_MOD()", "ParseFloorMod"),
+    OP_INT8(FULLY_CONNECTED, "tflite::Register_FULLY_CONNECTED()",
+            "tflite::Register_FULLY_CONNECTED_INT8()", "ParseFullyConnected",
+            true),
+    OP(GATHER, "tflite::Register_GATHER()", "ParseGather"),
+    OP(GATHER_ND, "tflite::Register_GATHER_ND()", "ParseGatherNd"),
+    OP(GREATER, "tflite::ops::micro::Register_GREATER()", "ParseGreater"),
+    OP(GREATER_EQUAL, "tflite::ops::micro::Register_GREATER_EQUAL()",
+       "ParseGreaterEqual"),
+    OP(HARD_SWISH, "tflite::Register_HARD_SWISH()", "ParseHardSwish"),
+    OP(IF, "tflite::Register_IF()", "ParseIf"),
+    OP(L2_NORMALIZATION, "tflite::ops::micro::Register_L2_NORMALIZATION()",
+       "ParseL2Normalization"),
+    OP(L2_POOL_2D, "tflite::Register_L2_POOL_2D()", "ParsePool"),
+    OP(LEAKY_RELU, "tflite::Register_LEAKY_RELU()", "ParseLeakyRelu"),
+    OP(LESS, "tflite::ops::micro::Register_LESS()", "ParseLess"),
+    OP(LESS_EQUAL, "tflite::ops::micro::Register_LESS_EQUAL()",
+       "ParseLessEqual"),
+    OP(LOG, "tflite::ops::micro::Register_LOG()", "ParseLog"),
+    OP(LOGICAL_AND, "tflite::Register_LOGICAL_AND()", "ParseLogicalAnd"),
+    OP(LOGICAL_NOT, "tflite::ops::micro::Register_LOGICAL_NOT()",
+       "ParseLogicalNot"),
+    OP(LOGICAL_OR, "tflite::Register_LOGICAL_OR()", "ParseLogicalOr"),
+    OP(LOGISTIC, "tflite::Register_LOGISTIC()", "ParseLogistic"),
+    OP_INT8(MAX_POOL_2D, "tflite::Register_MAX_POOL_2D()",
+            "tflite::Register_MAX_POOL_2D_INT8()", "ParsePool", false),
+    OP(MAXIMUM, "tflite::ops::micro::Register_MAXIMUM()", "ParseMaximum"),
+    OP(MEAN, "tflite::Register_MEAN()", "ParseReducer"),
+    OP(MINIMUM, "tflite::ops::micro::Register_MINIMUM()", "ParseMinimum"),
+    OP(MIRROR_PAD, "tflite::Register_MIRROR_PAD()", "ParseMirrorPad"),
+    OP(MUL, "tflite::Register_MUL()", "ParseMul"),
+    OP(NEG, "tflite::ops::micro::Register_NEG()", "ParseNeg"),
+    OP(NOT_EQUAL, "tflite::ops::micro::Register_NOT_EQUAL()",
+       "ParseNotEqual"),
+    OP(PACK, "tflite::ops::micro::Register_PACK()", "ParsePack"),
+    OP(PAD, "tflite::ops::micro::Register_PAD()", "ParsePad"),
+    OP(PADV2, "tflite::ops::micro::Register_PADV2()", "ParsePadV2"),
+    OP(PRELU, "tflite::Register_PRELU()", "ParsePrelu"),
+    OP(QUANTIZE, "tflite::Register_QUANTIZE()", "ParseQuantize"),
+    OP(READ_VARIABLE, "tflite::Register_READ_VARIABLE()",
+       "ParseReadVariable"),
+    OP(REDUCE_MAX, "tflite::Register_REDUCE_MAX()", "ParseReducer"),
+    OP(RELU, "tflite::Register_RELU()", "ParseRelu"),
+    OP(RELU6, "tflite::Register_RELU6()", "ParseRelu6"),
+    OP(RESHAPE, "tflite::ops::micro::Register_RESHAPE()", "ParseReshape"),
+    OP(RESIZE_BILINEAR, "tflite::Register_RESIZE_BILINEAR()",
+       "ParseResizeBilinear"),
+    OP(RESIZE_NEAREST_NEIGHBOR,
+       "tflite::ops::micro::Register_RESIZE_NEAREST_NEIGHBOR()",
+       "ParseResizeNearestNeighbor"),
+    OP(ROUND, "tflite::ops::micro::Register_ROUND()", "ParseRound"),
+    OP(RSQRT, "tflite::ops::micro::Register_RSQRT()", "ParseRsqrt"),
+    OP(SELECT_V2, "tflite::Register_SELECT_V2()", "ParseSelectV2"),
+    OP(SHAPE, "tflite::Register_SHAPE()", "ParseShape"),
+    OP(SIN, "tflite::ops::micro::Register_SIN()", "ParseSin"),
+    OP(SLICE, "tflite::Register_SLICE()", "ParseSlice"),
+    OP_INT8(SOFTMAX, "tflite::Register_SOFTMAX()",
+            "tflite::Register_SOFTMAX_INT8()", "ParseSoftmax", false),
+    OP(SPACE_TO_BATCH_ND, "tflite::Register_SPACE_TO_BATCH_ND()",
+       "ParseSpaceToBatchNd"),
+    OP(SPACE_TO_DEPTH, "tflite::Register_SPACE_TO_DEPTH()",
+       "ParseSpaceToDepth"),
+    OP(SPLIT, "tflite::ops::micro::Register_SPLIT()", "ParseSplit"),
+    OP(SPLIT_V, "tflite::ops::micro::Register_SPLIT_V()", "ParseSplitV"),
+    OP(SQRT, "tflite::ops::micro::Register_SQRT()", "ParseSqrt"),
+    OP(SQUARE, "tflite::ops::micro::Register_SQUARE()", "ParseSquare"),
+    OP(SQUARED_DIFFERENCE, "tflite::Register_SQUARED_DIFFERENCE()",
+       "ParseSquaredDifference"),
+    OP(SQUEEZE, "tflite::Register_SQUEEZE()", "ParseSqueeze"),
+    OP(STRIDED_SLICE, "tflite::ops::micro::Register_STRIDED_SLICE()",
+       "ParseStridedSlice"),
+    OP(SUB, "tflite::Register_SUB()", "ParseSub"),
+    OP(SUM, "tflite::Register_SUM()", "ParseReducer"),
+    OP(SVDF, "tflite::Register_SVDF()", "ParseSvdf"),
+    OP(TANH, "tflite::ops::micro::Register_TANH()", "ParseTanh"),
+    OP(TRANSPOSE, "tflite::Register_TRANSPOSE()", "ParseTranspose"),
+    OP(TRANSPOSE_CONV, "tflite::Register_TRANSPOSE_CONV()",
+       "ParseTransposeConv"),
+    OP(UNIDIRECTIONAL_SEQUENCE_LSTM,
+       "tflite::Register_UNIDIRECTIONAL_SEQUENCE_LSTM()",
+       "ParseUnidirectionalSequenceLSTM"),
+    OP(UNPACK, "tflite::ops::micro::Register_UNPACK()", "ParseUnpack"),
+    OP(VAR_HANDLE, "tflite::Register_VAR_HANDLE()", "ParseVarHandle"),
+    OP(WHILE, "tflite::Register_WHILE()", "ParseWhile"),
+    OP(ZEROS_LIKE, "tflite::Register_ZEROS_LIKE()", "ParseZerosLike"),
+};
+
+#undef OP
+#undef OP_INT8
+
+const OpInfo* FindOpInfo(tflite::BuiltinOperator op) {
+  for (const OpInfo& info : kOps) {
+    if (info.op == op) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+// An op of the model and whether all its uses can take the int8 variant.
+struct UsedOp {
+  const OpInfo* info;
+  bool all_int8;
+};
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  data->resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  bool ok = fread(data->data(), 1, data->size(), f) == data->size();
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "Can't read %s\n", path);
+  }
+  return ok;
+}
+
+bool EndsWith(const std::string& s, const char* suffix) {
+  const size_t len = strlen(suffix);
+  return s.size() >= len && s.compare(s.size() - len, len, suffix) == 0;
+}
+
+// The bytes of the first array initializer of C source, the 0x.. literals
+// between its braces.
+bool ParseCArray(const std::vector<uint8_t>& source,
+                 std::vector<uint8_t>* data) {
+  std::string text(source.begin(), source.end());
+  size_t pos = text.find("[] = {");
+  if (pos == std::string::npos) {
+    return false;
+  }
+  const size_t end = text.find('}', pos);
+  data->clear();
+  while ((pos = text.find("0x", pos)) < end) {
+    char* next;
+    data->push_back(strtoul(text.c_str() + pos, &next, 16));
+    pos = next - text.c_str();
+  }
+  return !data->empty();
+}
+
+bool IsInt8(const tflite::SubGraph* subgraph,
+            const flatbuffers::Vector<int32_t>* indices, size_t i) {
+  if (indices == nullptr || indices->size() <= i || indices->Get(i) < 0) {
+    return false;
+  }
+  return subgraph->tensors()->Get(indices->Get(i))->type() ==
+         tflite::TensorType_INT8;
+}
+
+// The ops of all subgraphs, in the order of the schema, or an empty list if
+// one of them is not a builtin op of MicroMutableOpResolver.
+std::vector<UsedOp> FindUsedOps(const tflite::Model* model) {
+  std::vector<UsedOp> used;
+  for (const OpInfo& info : kOps) {
+    used.push_back({&info, true});
+  }
+  std::vector<bool> seen(used.size(), false);
+  for (const tflite::SubGraph* subgraph : *model->subgraphs()) {
+    if (subgraph->operators() == nullptr) {
+      continue;
+    }
+    for (const tflite::Operator* op : *subgraph->operators()) {
+      const tflite::OperatorCode* code =
+          model->operator_codes()->Get(op->opcode_index());
+      const tflite::BuiltinOperator builtin = tflite::GetBuiltinCode(code);
+      const OpInfo* info = FindOpInfo(builtin);
+      if (info == nullptr) {
+        if (builtin == tflite::BuiltinOperator_CUSTOM) {
+          fprintf(stderr, "Custom op %s is not supported\n",
+                  code->custom_code() ? code->custom_code()->c_str() : "");
+        } else {
+          fprintf(stderr, "Op %s is not supported\n",
+                  tflite::EnumNameBuiltinOperator(builtin));
+        }
+        return {};
+      }
+      const size_t i = info - kOps;
+      seen[i] = true;
+      used[i].all_int8 = used[i].all_int8 &&
+                         IsInt8(subgraph, op->inputs(), 0) &&
+                         IsInt8(subgraph, op->outputs(), 0) &&
+                         (!info->has_weights ||
+                          IsInt8(subgraph, op->inputs(), 1));
+    }
+  }
+  std::vector<UsedOp> result;
+  for (size_t i = 0; i < used.size(); ++i) {
+    if (seen[i]) {
+      result.push_back(used[i]);
+    }
+  }
+  return result;
+}
+
+// person_detect from path/to/person_detect_op_resolver.h
+std::string BaseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  std::string base = name ? name + 1 : path;
+  if (EndsWith(base, ".h")) {
+    base.resize(base.size() - 2);
+  }
+  if (EndsWith(base, "_op_resolver")) {
+    base.resize(base.size() - strlen("_op_resolver"));
+  }
+  return base;
+}
+
+// PersonDetect from person_detect
+std::string CamelCase(const std::string& name) {
+  std::string result;
+  bool upper = true;
+  for (char c : name) {
+    if (!isalnum(c)) {
+      upper = true;
+    } else {
+      result += upper ? toupper(c) : c;
+      upper = false;
+    }
+  }
+  return result;
+}
+
+std::string IncludeGuard(const char* path) {
+  const char* name = strrchr(path, '/');
+  std::string guard;
+  for (const char* c = name ? name + 1 : path; *c; ++c) {
+    guard += isalnum(*c) ? toupper(*c) : '_';
+  }
+  return guard + "_";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <model.tflite | model_data.cc> <output.h>\n",
+            argv[0]);
+    return 1;
+  }
+  const char* model_path = argv[1];
+  const char* header_path = argv[2];
+
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(model_path, &model_data)) {
+    return 1;
+  }
+  if (EndsWith(model_path, ".cc") || EndsWith(model_path, ".c") ||
+      EndsWith(model_path, ".cpp")) {
+    std::vector<uint8_t> source;
+    source.swap(model_data);
+    if (!ParseCArray(source, &model_data)) {
+      fprintf(stderr, "No model array in %s\n", model_path);
+      return 1;
+    }
+  }
+  flatbuffers::Verifier verifier(model_data.data(), model_data.size());
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a valid model\n", model_path);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  const std::vector<UsedOp> ops = FindUsedOps(model);
+  if (ops.empty()) {
+    return 1;
+  }
+
+  FILE* out = fopen(header_path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "Can't write %s\n", header_path);
+    return 1;
+  }
+  const char* model_name = strrchr(model_path, '/');
+  const std::string name = CamelCase(BaseName(header_path));
+  const std::string guard = IncludeGuard(header_path);
+  fprintf(out,
+          "// Generated by tensorflow/lite/micro/tools/op_resolver from %s.\n"
+          "// Do not edit.\n\n",
+          model_name ? model_name + 1 : model_path);
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  fprintf(out,
+          "#include \"tensorflow/lite/micro/micro_mutable_op_resolver.h\"\n"
+          "#include \"tensorflow/lite/micro/micro_static_op_resolver.h\"\n\n");
+  fprintf(out,
+          "// The builtin ops of the model, see tflite::MicroStaticOpResolver."
+          "\n// Ops only used with int8 activations get their _INT8 kernel "
+          "variant.\n");
+  fprintf(out, "struct %sOps {\n", name.c_str());
+  fprintf(out, "  static constexpr int kNumOps = %zu;\n\n", ops.size());
+  fprintf(out,
+          "  static constexpr int Index(tflite::BuiltinOperator op) {\n"
+          "    switch (op) {\n");
+  for (size_t i = 0; i < ops.size(); ++i) {
+    fprintf(out, "      case tflite::BuiltinOperator_%s:\n        return %zu;\n",
+            tflite::EnumNameBuiltinOperator(ops[i].info->op), i);
+  }
+  fprintf(out,
+          "      default:\n"
+          "        return -1;\n"
+          "    }\n"
+          "  }\n\n");
+  fprintf(out,
+          "  static void Register(\n"
+          "      TfLiteRegistration* registrations,\n"
+          "      tflite::MicroOpResolver::BuiltinParseFunction* parsers) {\n");
+  for (size_t i = 0; i < ops.size(); ++i) {
+    const OpInfo& info = *ops[i].info;
+    const bool int8 = ops[i].all_int8 && info.int8_registration != nullptr;
+    fprintf(out,
+            "    registrations[%zu] = %s;\n"
+            "    registrations[%zu].builtin_code = "
+            "tflite::BuiltinOperator_%s;\n"
+            "    parsers[%zu] = tflite::%s;\n",
+            i, int8 ? info.int8_registration : info.registration, i,
+            tflite::EnumNameBuiltinOperator(info.op), i, info.parser);
+  }
+  fprintf(out, "  }\n};\n\n");
+  fprintf(out,
+          "using %sOpResolver = tflite::MicroStaticOpResolver<%sOps>;\n\n",
+          name.c_str(), name.c_str());
+  fprintf(out, "#endif  // %s\n", guard.c_str());
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Can't write %s\n", header_path);
+    return 1;
+  }
+
+  printf("%s: %zu ops\n", header_path, ops.size());
+  for (const UsedOp& op : ops) {
+    printf("  %s%s\n", tflite::EnumNameBuiltinOperator(op.info->op),
+           op.all_int8 && op.info->int8_registration ? " (int8)" : "");
+  }
+  return 0;
+}
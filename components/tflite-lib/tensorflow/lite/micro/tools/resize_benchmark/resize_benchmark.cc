@@ -0,0 +1,227 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Times the int8 RESIZE_BILINEAR kernel and checks that it is bit-exact with
+// reference_ops::ResizeBilinearInteger, which it optimizes.
+//
+// Usage: resize_benchmark [-r repeats]
+//
+// Random shapes (up and down scaling, batches, odd depths) are checked in the
+// three coordinate modes: default, align_corners and half_pixel_centers. Then
+// a few camera and decoder sized resizes, exact 2x upsampling among them, are
+// timed against the reference. Returns 1 if any output differs.
+
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/reference/resize_bilinear.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+struct Shape {
+  int batches;
+  int input_height;
+  int input_width;
+  int depth;
+  int output_height;
+  int output_width;
+};
+
+struct Mode {
+  const char* name;
+  bool align_corners;
+  bool half_pixel_centers;
+};
+
+const Mode kModes[] = {
+    {"default", false, false},
+    {"align_corners", true, false},
+    {"half_pixel_centers", false, true},
+};
+
+const Shape kBenchmarkShapes[] = {
+    {1, 48, 48, 8, 96, 96},   // 2x
+    {1, 24, 24, 32, 48, 48},  // 2x, decoder
+    {1, 40, 40, 3, 96, 96},
+    {1, 96, 96, 1, 64, 64},
+};
+
+uint32_t random_state = 1;
+
+uint32_t Random() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state >> 8;
+}
+
+double NowUs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+// Runs the RESIZE_BILINEAR kernel and the reference on the same input,
+// `repeats` times each. Returns false if the outputs differ or the kernel
+// fails; *kernel_us and *reference_us are the best times.
+bool Run(const Shape& shape, const Mode& mode, int repeats, double* kernel_us,
+         double* reference_us) {
+  std::vector<int8_t> input(shape.batches * shape.input_height *
+                            shape.input_width * shape.depth);
+  for (int8_t& value : input) {
+    value = static_cast<int8_t>(Random());
+  }
+  const size_t output_size = shape.batches * shape.output_height *
+                             shape.output_width * shape.depth;
+  std::vector<int8_t> output(output_size), reference(output_size);
+
+  int input_dims[] = {4, shape.batches, shape.input_height, shape.input_width,
+                      shape.depth};
+  int size_dims[] = {1, 2};
+  int output_dims[] = {4, shape.batches, shape.output_height,
+                       shape.output_width, shape.depth};
+  int32_t size_data[] = {shape.output_height, shape.output_width};
+  TfLiteTensor tensors[] = {
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims), 0.5f,
+          0),
+      tflite::testing::CreateTensor(
+          size_data, tflite::testing::IntArrayFromInts(size_dims)),
+      tflite::testing::CreateQuantizedTensor(
+          output.data(), tflite::testing::IntArrayFromInts(output_dims), 0.5f,
+          0),
+  };
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  int inputs[] = {2, 0, 1};
+  int outputs[] = {1, 2};
+  TfLiteResizeBilinearParams params = {mode.align_corners,
+                                       mode.half_pixel_centers};
+  const TfLiteRegistration registration = tflite::Register_RESIZE_BILINEAR();
+  tflite::micro::KernelRunner runner(
+      registration, tensors, 3, tflite::testing::IntArrayFromInts(inputs),
+      tflite::testing::IntArrayFromInts(outputs), &params);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    printf("  Prepare failed\n");
+    return false;
+  }
+
+  tflite::ResizeBilinearParams op_params;
+  op_params.align_corners = mode.align_corners;
+  op_params.half_pixel_centers = mode.half_pixel_centers;
+  const tflite::RuntimeShape input_shape(4, input_dims + 1);
+  const tflite::RuntimeShape size_shape(1, size_dims + 1);
+  const tflite::RuntimeShape output_shape(4, output_dims + 1);
+
+  *kernel_us = 0;
+  *reference_us = 0;
+  for (int r = 0; r < repeats; ++r) {
+    double start = NowUs();
+    if (runner.Invoke() != kTfLiteOk) {
+      printf("  Invoke failed\n");
+      return false;
+    }
+    double us = NowUs() - start;
+    if (r == 0 || us < *kernel_us) {
+      *kernel_us = us;
+    }
+    start = NowUs();
+    tflite::reference_ops::ResizeBilinearInteger(
+        op_params, input_shape, input.data(), size_shape, size_data,
+        output_shape, reference.data());
+    us = NowUs() - start;
+    if (r == 0 || us < *reference_us) {
+      *reference_us = us;
+    }
+  }
+
+  if (output != reference) {
+    size_t i = 0;
+    while (output[i] == reference[i]) {
+      ++i;
+    }
+    printf("  %s %dx%dx%dx%d -> %dx%d differs from the reference at value "
+           "%zu: %d instead of %d\n",
+           mode.name, shape.batches, shape.input_height, shape.input_width,
+           shape.depth, shape.output_height, shape.output_width, i, output[i],
+           reference[i]);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int repeats = 20;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      repeats = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [-r repeats]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  bool exact = true;
+  double kernel_us, reference_us;
+  int checked = 0;
+  for (const Mode& mode : kModes) {
+    for (int i = 0; i < 100; ++i) {
+      Shape shape;
+      shape.batches = 1 + Random() % 2;
+      shape.input_height = 1 + Random() % 12;
+      shape.input_width = 1 + Random() % 12;
+      shape.depth = 1 + Random() % 9;
+      switch (i % 4) {
+        case 0:  // Exact 2x
+          shape.output_height = 2 * shape.input_height;
+          shape.output_width = 2 * shape.input_width;
+          break;
+        case 1:  // Exact 4x
+          shape.output_height = 4 * shape.input_height;
+          shape.output_width = 4 * shape.input_width;
+          break;
+        default:
+          shape.output_height = 1 + Random() % 24;
+          shape.output_width = 1 + Random() % 24;
+          break;
+      }
+      exact &= Run(shape, mode, 1, &kernel_us, &reference_us);
+      ++checked;
+    }
+  }
+  printf("%d random shapes checked\n", checked);
+
+  for (const Shape& shape : kBenchmarkShapes) {
+    for (const Mode& mode : kModes) {
+      exact &= Run(shape, mode, repeats, &kernel_us, &reference_us);
+      printf("%dx%dx%d -> %dx%d %s: reference %.1f us, kernel %.1f us "
+             "(%.2fx)\n",
+             shape.input_height, shape.input_width, shape.depth,
+             shape.output_height, shape.output_width, mode.name, reference_us,
+             kernel_us, reference_us / kernel_us);
+    }
+  }
+  printf("%s\n", exact ? "Bit-exact with the reference"
+                       : "Differs from the reference");
+  return exact ? 0 : 1;
+}
@@ -0,0 +1,380 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks that the SVDF kernel, whose activation state is a ring buffer, gives
+// the outputs of the former implementation, which shifted the whole state left
+// by one column per invoke.
+//
+// Usage: svdf_check
+//
+// int8, int16 and float SVDF run for several times their memory size, with
+// ranks above one and batches, next to a copy of the shifting algorithm. Half
+// way through, the state is reset the way MicroGraph::ResetVariableTensors()
+// does it. Returns 1 if any output differs.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/svdf.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+struct Shape {
+  int batches;
+  int input_size;
+  int num_filters;
+  int rank;
+  int memory_size;
+};
+
+const Shape kShapes[] = {
+    {2, 7, 8, 2, 5},
+    {1, 10, 6, 1, 1},
+    {3, 4, 12, 3, 10},
+    {1, 16, 64, 1, 8},
+    {2, 9, 20, 4, 3},
+};
+
+// Quantization of the integer SVDF, see SvdfPrepare().
+constexpr float kInputScale = 0.02f;
+constexpr int kInputZeroPoint = -5;
+constexpr float kWeightsFeatureScale = 0.01f;
+constexpr float kWeightsTimeScale = 0.003f;
+constexpr float kOutputScale = 0.1f;
+constexpr int kOutputZeroPoint = 2;
+
+uint32_t random_state = 7;
+
+uint32_t Random() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state >> 8;
+}
+
+int RandomInt(int min, int max) {
+  return min + static_cast<int>(Random() % (max - min + 1));
+}
+
+float RandomFloat() { return RandomInt(-1000, 1000) / 1000.0f; }
+
+// The activation state of the former implementation: `memory_size` columns
+// per filter and batch, the whole buffer shifted left by one per invoke.
+template <typename T>
+class ShiftedState {
+ public:
+  ShiftedState(const Shape& shape, T value)
+      : memory_size_(shape.memory_size),
+        state_(shape.batches * shape.num_filters * shape.memory_size, value) {}
+
+  // Shifts the state and returns where the newest column of each filter of
+  // batch 0 goes, `memory_size` apart.
+  T* Shift() {
+    std::copy(state_.begin() + 1, state_.end(), state_.begin());
+    return state_.data() + memory_size_ - 1;
+  }
+
+  const T* data() const { return state_.data(); }
+
+  void Reset(T value) { std::fill(state_.begin(), state_.end(), value); }
+
+ private:
+  const int memory_size_;
+  std::vector<T> state_;
+};
+
+// Runs `invokes` of the int8 (T = int8_t) or int16 (T = int16_t) SVDF and
+// compares each output with the former algorithm. Returns false on a mismatch.
+template <typename T>
+bool CheckInteger(const Shape& shape, int invokes) {
+  const bool int8_state = sizeof(T) == 1;
+  const float state_scale = int8_state ? 0.05f : 0.002f;
+  // The int16 SVDF requires a zero point of 0, int8 allows any.
+  const int state_zero_point = int8_state ? 3 : 0;
+  const int units = shape.num_filters / shape.rank;
+
+  std::vector<int8_t> input(shape.batches * shape.input_size);
+  std::vector<int8_t> weights_feature(shape.num_filters * shape.input_size);
+  std::vector<T> weights_time(shape.num_filters * shape.memory_size);
+  std::vector<int32_t> bias(units);
+  std::vector<T> state(shape.batches * shape.num_filters * shape.memory_size,
+                       state_zero_point);
+  std::vector<int8_t> output(shape.batches * units);
+  for (int8_t& value : weights_feature) {
+    value = RandomInt(-127, 127);
+  }
+  for (T& value : weights_time) {
+    value = int8_state ? RandomInt(-127, 127) : RandomInt(-200, 200);
+  }
+  for (int32_t& value : bias) {
+    value = RandomInt(-5000, 5000);
+  }
+
+  int input_dims[] = {2, shape.batches, shape.input_size};
+  int weights_feature_dims[] = {2, shape.num_filters, shape.input_size};
+  int weights_time_dims[] = {2, shape.num_filters, shape.memory_size};
+  int bias_dims[] = {1, units};
+  int state_dims[] = {2, shape.batches,
+                      shape.memory_size * shape.num_filters};
+  int output_dims[] = {2, shape.batches, units};
+  TfLiteTensor tensors[] = {
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims),
+          kInputScale, kInputZeroPoint),
+      tflite::testing::CreateQuantizedTensor(
+          weights_feature.data(),
+          tflite::testing::IntArrayFromInts(weights_feature_dims),
+          kWeightsFeatureScale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          weights_time.data(),
+          tflite::testing::IntArrayFromInts(weights_time_dims),
+          kWeightsTimeScale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(bias_dims),
+          state_scale * kWeightsTimeScale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          state.data(), tflite::testing::IntArrayFromInts(state_dims),
+          state_scale, state_zero_point, /*is_variable=*/true),
+      tflite::testing::CreateQuantizedTensor(
+          output.data(), tflite::testing::IntArrayFromInts(output_dims),
+          kOutputScale, kOutputZeroPoint),
+  };
+  int inputs[] = {5, 0, 1, 2, 3, 4};
+  int outputs[] = {1, 5};
+  TfLiteSVDFParams params = {shape.rank, kTfLiteActNone, false};
+  const TfLiteRegistration registration = tflite::Register_SVDF();
+  tflite::micro::KernelRunner runner(
+      registration, tensors, 6, tflite::testing::IntArrayFromInts(inputs),
+      tflite::testing::IntArrayFromInts(outputs), &params);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    printf("  int%d Prepare failed\n", static_cast<int>(sizeof(T) * 8));
+    return false;
+  }
+
+  int32_t scale_1_a, scale_2_a;
+  int scale_1_b, scale_2_b;
+  tflite::QuantizeMultiplier(
+      static_cast<double>(kInputScale * kWeightsFeatureScale / state_scale),
+      &scale_1_a, &scale_1_b);
+  tflite::QuantizeMultiplier(
+      static_cast<double>(state_scale * kWeightsTimeScale / kOutputScale),
+      &scale_2_a, &scale_2_b);
+
+  ShiftedState<T> shifted(shape, state_zero_point);
+  for (int t = 0; t < invokes; ++t) {
+    if (t == invokes / 2) {
+      std::fill(state.begin(), state.end(), state_zero_point);
+      shifted.Reset(state_zero_point);
+    }
+    for (int8_t& value : input) {
+      value = RandomInt(-128, 127);
+    }
+    if (runner.Invoke() != kTfLiteOk) {
+      printf("  int%d Invoke failed\n", static_cast<int>(sizeof(T) * 8));
+      return false;
+    }
+
+    // Feature matmul into the newest column.
+    T* newest = shifted.Shift();
+    for (int b = 0; b < shape.batches; ++b) {
+      for (int f = 0; f < shape.num_filters; ++f) {
+        int32_t dot = 0;
+        for (int i = 0; i < shape.input_size; ++i) {
+          dot += weights_feature[f * shape.input_size + i] *
+                 (input[b * shape.input_size + i] - kInputZeroPoint);
+        }
+        dot = tflite::MultiplyByQuantizedMultiplier(dot, scale_1_a, scale_1_b);
+        dot = std::min<int32_t>(std::max<int32_t>(
+                                    std::numeric_limits<T>::min(), dot),
+                                std::numeric_limits<T>::max());
+        *newest = static_cast<T>(state_zero_point + dot);
+        newest += shape.memory_size;
+      }
+    }
+
+    // Time weights, rank reduction, bias and rescale.
+    for (int b = 0; b < shape.batches; ++b) {
+      for (int u = 0; u < units; ++u) {
+        int32_t sum = bias[u];
+        for (int r = 0; r < shape.rank; ++r) {
+          const int f = u * shape.rank + r;
+          const T* column =
+              shifted.data() + (b * shape.num_filters + f) * shape.memory_size;
+          int32_t dot = 0;
+          for (int m = 0; m < shape.memory_size; ++m) {
+            dot += weights_time[f * shape.memory_size + m] *
+                   (column[m] - state_zero_point);
+          }
+          sum += dot;
+        }
+        int32_t expected =
+            tflite::MultiplyByQuantizedMultiplier(sum, scale_2_a, scale_2_b) +
+            kOutputZeroPoint;
+        expected = std::min(127, std::max(-128, expected));
+        if (output[b * units + u] != expected) {
+          printf("  int%d %dx%d, %d filters, rank %d, memory %d: invoke %d "
+                 "output %d is %d instead of %d\n",
+                 static_cast<int>(sizeof(T) * 8), shape.batches,
+                 shape.input_size, shape.num_filters, shape.rank,
+                 shape.memory_size, t, b * units + u, output[b * units + u],
+                 static_cast<int>(expected));
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Float version of CheckInteger(), the outputs have to be bit-identical.
+bool CheckFloat(const Shape& shape, int invokes) {
+  const int units = shape.num_filters / shape.rank;
+  std::vector<float> input(shape.batches * shape.input_size);
+  std::vector<float> weights_feature(shape.num_filters * shape.input_size);
+  std::vector<float> weights_time(shape.num_filters * shape.memory_size);
+  std::vector<float> bias(units);
+  std::vector<float> state(
+      shape.batches * shape.num_filters * shape.memory_size, 0.0f);
+  std::vector<float> output(shape.batches * units);
+  for (float& value : weights_feature) {
+    value = RandomFloat();
+  }
+  for (float& value : weights_time) {
+    value = RandomFloat();
+  }
+  for (float& value : bias) {
+    value = RandomFloat();
+  }
+
+  int input_dims[] = {2, shape.batches, shape.input_size};
+  int weights_feature_dims[] = {2, shape.num_filters, shape.input_size};
+  int weights_time_dims[] = {2, shape.num_filters, shape.memory_size};
+  int bias_dims[] = {1, units};
+  int state_dims[] = {2, shape.batches,
+                      shape.memory_size * shape.num_filters};
+  int output_dims[] = {2, shape.batches, units};
+  TfLiteTensor tensors[] = {
+      tflite::testing::CreateTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims)),
+      tflite::testing::CreateTensor(
+          weights_feature.data(),
+          tflite::testing::IntArrayFromInts(weights_feature_dims)),
+      tflite::testing::CreateTensor(
+          weights_time.data(),
+          tflite::testing::IntArrayFromInts(weights_time_dims)),
+      tflite::testing::CreateTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(bias_dims)),
+      tflite::testing::CreateTensor(
+          state.data(), tflite::testing::IntArrayFromInts(state_dims),
+          /*is_variable=*/true),
+      tflite::testing::CreateTensor(
+          output.data(), tflite::testing::IntArrayFromInts(output_dims)),
+  };
+  int inputs[] = {5, 0, 1, 2, 3, 4};
+  int outputs[] = {1, 5};
+  TfLiteSVDFParams params = {shape.rank, kTfLiteActRelu, false};
+  const TfLiteRegistration registration = tflite::Register_SVDF();
+  tflite::micro::KernelRunner runner(
+      registration, tensors, 6, tflite::testing::IntArrayFromInts(inputs),
+      tflite::testing::IntArrayFromInts(outputs), &params);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    printf("  float Prepare failed\n");
+    return false;
+  }
+
+  ShiftedState<float> shifted(shape, 0.0f);
+  for (int t = 0; t < invokes; ++t) {
+    if (t == invokes / 2) {
+      std::fill(state.begin(), state.end(), 0.0f);
+      shifted.Reset(0.0f);
+    }
+    for (float& value : input) {
+      value = RandomFloat();
+    }
+    if (runner.Invoke() != kTfLiteOk) {
+      printf("  float Invoke failed\n");
+      return false;
+    }
+
+    float* newest = shifted.Shift();
+    for (int b = 0; b < shape.batches; ++b) {
+      for (int f = 0; f < shape.num_filters; ++f) {
+        float dot = 0.0f;
+        for (int i = 0; i < shape.input_size; ++i) {
+          dot += weights_feature[f * shape.input_size + i] *
+                 input[b * shape.input_size + i];
+        }
+        *newest = dot;
+        newest += shape.memory_size;
+      }
+    }
+
+    for (int b = 0; b < shape.batches; ++b) {
+      for (int u = 0; u < units; ++u) {
+        float sum = bias[u];
+        for (int r = 0; r < shape.rank; ++r) {
+          const int f = u * shape.rank + r;
+          const float* column =
+              shifted.data() + (b * shape.num_filters + f) * shape.memory_size;
+          float dot = 0.0f;
+          for (int m = 0; m < shape.memory_size; ++m) {
+            dot += weights_time[f * shape.memory_size + m] * column[m];
+          }
+          sum += dot;
+        }
+        const float expected = std::max(0.0f, sum);
+        if (std::memcmp(&output[b * units + u], &expected, sizeof(float)) !=
+            0) {
+          printf("  float %dx%d, %d filters, rank %d, memory %d: invoke %d "
+                 "output %d is %g instead of %g\n",
+                 shape.batches, shape.input_size, shape.num_filters,
+                 shape.rank, shape.memory_size, t, b * units + u,
+                 output[b * units + u], expected);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 1) {
+    fprintf(stderr, "Usage: %s\n", argv[0]);
+    return 1;
+  }
+
+  bool exact = true;
+  for (const Shape& shape : kShapes) {
+    // Enough invokes for the ring to wrap around a few times on each side of
+    // the reset.
+    const int invokes = 6 * shape.memory_size + 4;
+    exact &= CheckInteger<int8_t>(shape, invokes);
+    exact &= CheckInteger<int16_t>(shape, invokes);
+    exact &= CheckFloat(shape, invokes);
+  }
+  printf("%s\n", exact ? "Matches the shifted activation state"
+                       : "Differs from the shifted activation state");
+  return exact ? 0 : 1;
+}
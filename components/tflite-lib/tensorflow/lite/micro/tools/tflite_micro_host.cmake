@@ -0,0 +1,101 @@
+# Native build of tflite-lib and esp-nn for the host tools in this directory.
+#
+# ESP_NN_TARGET picks the esp-nn kernel set whose buffer requirements are
+# reproduced: `generic` (ESP32 and others), `esp32s3` or `ansi`
+# (CONFIG_NN_ANSI_C). With `esp32s3` the C parts of the S3 kernels are built
+# and their assembly routines are stubbed out, so models can be prepared but
+# not invoked. ESP_NN_MULTICORE matches CONFIG_NN_MULTICORE.
+#
+# Sizes of persistent allocations depend on the pointer size. They are only
+# exact when building for a 32-bit host, e.g. with -DCMAKE_C_FLAGS=-m32
+# -DCMAKE_CXX_FLAGS=-m32, and larger than on the device otherwise.
+
+set(ESP_NN_TARGET "generic" CACHE STRING "esp-nn kernel set: generic, esp32s3 or ansi")
+set_property(CACHE ESP_NN_TARGET PROPERTY STRINGS generic esp32s3 ansi)
+option(ESP_NN_MULTICORE "Convolutions split across two cores" OFF)
+
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release)
+endif()
+
+set(tflite_lib_dir "${CMAKE_CURRENT_LIST_DIR}/../../../..")
+set(esp_nn_dir "${tflite_lib_dir}/../esp-nn")
+set(tflite_dir "${tflite_lib_dir}/tensorflow/lite")
+set(tfmicro_dir "${tflite_dir}/micro")
+set(tfmicro_kernels_dir "${tfmicro_dir}/kernels")
+
+# Same sources as the IDF component, see tflite-lib/CMakeLists.txt
+file(GLOB srcs_micro
+          "${tfmicro_dir}/*.cc"
+          "${tfmicro_dir}/memory_planner/*.cc"
+          "${tfmicro_dir}/arena_allocator/*.cc")
+file(GLOB srcs_kernels
+          "${tfmicro_kernels_dir}/*.cc")
+list(REMOVE_ITEM srcs_kernels
+          "${tfmicro_kernels_dir}/add.cc"
+          "${tfmicro_kernels_dir}/conv.cc"
+          "${tfmicro_kernels_dir}/depthwise_conv.cc"
+          "${tfmicro_kernels_dir}/fully_connected.cc"
+          "${tfmicro_kernels_dir}/mul.cc"
+          "${tfmicro_kernels_dir}/pooling.cc"
+          "${tfmicro_kernels_dir}/softmax.cc"
+          "${tfmicro_kernels_dir}/transpose_conv.cc"
+          "${tfmicro_kernels_dir}/unidirectional_sequence_lstm.cc")
+file(GLOB esp_nn_kernels
+          "${tfmicro_kernels_dir}/esp_nn/*.cc")
+file(GLOB esp_nn_srcs
+          "${esp_nn_dir}/src/*/*_ansi.c"
+          "${esp_nn_dir}/src/*/*_opt.c"
+          "${esp_nn_dir}/src/*/*_parallel.c")
+
+if(ESP_NN_TARGET STREQUAL "esp32s3")
+    list(APPEND esp_nn_srcs
+          "${esp_nn_dir}/src/convolution/esp_nn_conv_esp32s3.c"
+          "${esp_nn_dir}/src/convolution/esp_nn_depthwise_conv_s8_esp32s3.c"
+          "${CMAKE_CURRENT_LIST_DIR}/esp_nn_esp32s3_stubs.c")
+    set(esp_nn_defs CONFIG_IDF_TARGET_ESP32S3=1 CONFIG_NN_OPTIMIZED=1)
+elseif(ESP_NN_TARGET STREQUAL "generic")
+    set(esp_nn_defs CONFIG_NN_OPTIMIZED=1)
+elseif(ESP_NN_TARGET STREQUAL "ansi")
+    set(esp_nn_defs CONFIG_NN_ANSI_C=1)
+else()
+    message(FATAL_ERROR "Unknown ESP_NN_TARGET ${ESP_NN_TARGET}")
+endif()
+
+add_library(tflite_micro_host STATIC
+            ${srcs_micro}
+            ${srcs_kernels}
+            ${esp_nn_kernels}
+            ${esp_nn_srcs}
+            "${tflite_dir}/kernels/kernel_util.cc"
+            "${tflite_dir}/c/common.cc"
+            "${tflite_dir}/core/api/error_reporter.cc"
+            "${tflite_dir}/core/api/flatbuffer_conversions.cc"
+            "${tflite_dir}/core/api/op_resolver.cc"
+            "${tflite_dir}/core/api/tensor_utils.cc"
+            "${tflite_dir}/kernels/internal/quantization_util.cc"
+            "${tflite_dir}/kernels/internal/portable_tensor_utils.cc"
+            "${tflite_dir}/kernels/internal/tensor_utils.cc"
+            "${tflite_dir}/kernels/internal/reference/portable_tensor_utils.cc"
+            "${tflite_dir}/schema/schema_utils.cc")
+target_include_directories(tflite_micro_host PUBLIC
+            "${tflite_lib_dir}"
+            "${tflite_lib_dir}/third_party/gemmlowp"
+            "${tflite_lib_dir}/third_party/flatbuffers/include"
+            "${tflite_lib_dir}/third_party/ruy"
+            "${tflite_lib_dir}/third_party/kissfft"
+            "${esp_nn_dir}/include"
+            "${esp_nn_dir}/src/common")
+target_compile_definitions(tflite_micro_host PUBLIC
+            TF_LITE_STATIC_MEMORY TF_LITE_DISABLE_X86_NEON ESP_NN ${esp_nn_defs}
+            ESP_NN_TARGET_NAME="${ESP_NN_TARGET}")
+target_compile_options(tflite_micro_host PRIVATE
+            $<$<COMPILE_LANGUAGE:CXX>:-std=gnu++14 -fno-rtti -fno-exceptions>
+            -Wno-unused-parameter -Wno-unused-function)
+target_link_libraries(tflite_micro_host PUBLIC m)
+
+if(ESP_NN_MULTICORE)
+    find_package(Threads REQUIRED)
+    target_compile_definitions(tflite_micro_host PUBLIC ESP_NN_USE_PTHREADS=1)
+    target_link_libraries(tflite_micro_host PUBLIC Threads::Threads)
+endif()
@@ -0,0 +1,328 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Times the int8 TRANSPOSE_CONV kernel and checks that it is bit-exact with
+// reference_integer_ops::TransposeConv, which it replaces.
+//
+// Usage: transpose_conv_benchmark [-r repeats]
+//
+// Random shapes are checked with batches, strides of 1 to 3 on each axis, SAME
+// and VALID padding, every output size the padding allows, and with and
+// without bias; a third of them take the stride 2, 2x2 and 3x3 path. The
+// per-channel scales drive outputs past both ends of the int8 range, as the
+// kernel clamps there whatever the activation. Then a few decoder sized
+// layers are timed against the reference. Returns 1 if any output differs or
+// the clamping was not exercised.
+
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/transpose_conv.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+struct Shape {
+  int batches;
+  int input_height;
+  int input_width;
+  int input_depth;
+  int output_height;
+  int output_width;
+  int output_depth;
+  int filter_height;
+  int filter_width;
+  int stride_height;
+  int stride_width;
+  TfLitePadding padding;
+  bool bias;
+};
+
+const Shape kBenchmarkShapes[] = {
+    {1, 12, 12, 32, 24, 24, 16, 3, 3, 2, 2, kTfLitePaddingSame, true},
+    {1, 12, 12, 32, 24, 24, 16, 2, 2, 2, 2, kTfLitePaddingSame, true},
+    {1, 24, 24, 16, 48, 48, 8, 4, 4, 2, 2, kTfLitePaddingSame, true},
+    {1, 20, 20, 8, 22, 22, 8, 3, 3, 1, 1, kTfLitePaddingValid, true},
+};
+
+constexpr float kInputScale = 0.05f;
+constexpr int kInputZeroPoint = -7;
+constexpr float kOutputScale = 0.4f;
+constexpr int kOutputZeroPoint = 4;
+
+uint32_t random_state = 5;
+
+uint32_t Random() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state >> 8;
+}
+
+int RandomInt(int min, int max) {
+  return min + static_cast<int>(Random() % (max - min + 1));
+}
+
+double NowUs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+// Picks an output size whose forward convolution has `input_size` outputs.
+int RandomOutputSize(int input_size, int filter_size, int stride,
+                     TfLitePadding padding) {
+  if (padding == kTfLitePaddingSame) {
+    return RandomInt((input_size - 1) * stride + 1, input_size * stride);
+  }
+  return RandomInt((input_size - 1) * stride + filter_size,
+                   input_size * stride + filter_size - 1);
+}
+
+// Runs the TRANSPOSE_CONV kernel and the reference on the same input,
+// `repeats` times each. Returns false if the outputs differ or the kernel
+// fails; *kernel_us and *reference_us are the best times. Adds the outputs
+// clamped to the int8 range to *clamped.
+bool Run(const Shape& shape, int repeats, double* kernel_us,
+         double* reference_us, int* clamped) {
+  std::vector<int8_t> input(shape.batches * shape.input_height *
+                            shape.input_width * shape.input_depth);
+  for (int8_t& value : input) {
+    value = static_cast<int8_t>(Random());
+  }
+  std::vector<int8_t> filter(shape.output_depth * shape.filter_height *
+                             shape.filter_width * shape.input_depth);
+  for (int8_t& value : filter) {
+    value = static_cast<int8_t>(RandomInt(-127, 127));
+  }
+  std::vector<int32_t> bias(shape.output_depth);
+  for (int32_t& value : bias) {
+    value = RandomInt(-20000, 20000);
+  }
+  const size_t output_size = shape.batches * shape.output_height *
+                             shape.output_width * shape.output_depth;
+  std::vector<int8_t> output(output_size), reference(output_size);
+  std::vector<int32_t> scratch(output_size);
+
+  // Per-channel filter scales, led by their count as FloatArrayFromFloats()
+  // wants it, and the matching bias scales.
+  std::vector<float> filter_scales(shape.output_depth + 1);
+  std::vector<float> bias_scales(shape.output_depth + 1);
+  std::vector<int> zero_points(shape.output_depth + 1, 0);
+  filter_scales[0] = bias_scales[0] = shape.output_depth;
+  zero_points[0] = shape.output_depth;
+  for (int i = 1; i <= shape.output_depth; ++i) {
+    filter_scales[i] = 0.002f * (1 + RandomInt(0, 100) / 10.0f);
+    bias_scales[i] = kInputScale * filter_scales[i];
+  }
+  TfLiteAffineQuantization filter_quantization = {
+      tflite::testing::FloatArrayFromFloats(filter_scales.data()),
+      tflite::testing::IntArrayFromInts(zero_points.data()), 0};
+  TfLiteAffineQuantization bias_quantization = {
+      tflite::testing::FloatArrayFromFloats(bias_scales.data()),
+      tflite::testing::IntArrayFromInts(zero_points.data()), 0};
+
+  int output_shape_dims[] = {1, 4};
+  int filter_dims[] = {4, shape.output_depth, shape.filter_height,
+                       shape.filter_width, shape.input_depth};
+  int input_dims[] = {4, shape.batches, shape.input_height, shape.input_width,
+                      shape.input_depth};
+  int bias_dims[] = {1, shape.output_depth};
+  int output_dims[] = {4, shape.batches, shape.output_height,
+                       shape.output_width, shape.output_depth};
+  int32_t output_shape_data[] = {shape.batches, shape.output_height,
+                                 shape.output_width, shape.output_depth};
+  TfLiteTensor tensors[] = {
+      tflite::testing::CreateTensor(
+          output_shape_data,
+          tflite::testing::IntArrayFromInts(output_shape_dims)),
+      tflite::testing::CreateTensor(
+          filter.data(), tflite::testing::IntArrayFromInts(filter_dims)),
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims),
+          kInputScale, kInputZeroPoint),
+      tflite::testing::CreateTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(bias_dims)),
+      tflite::testing::CreateQuantizedTensor(
+          output.data(), tflite::testing::IntArrayFromInts(output_dims),
+          kOutputScale, kOutputZeroPoint),
+  };
+  tensors[0].allocation_type = kTfLiteMmapRo;
+  tensors[1].quantization = {kTfLiteAffineQuantization, &filter_quantization};
+  tensors[1].params = {filter_scales[1], 0};
+  tensors[3].quantization = {kTfLiteAffineQuantization, &bias_quantization};
+  int inputs_with_bias[] = {4, 0, 1, 2, 3};
+  int inputs_without_bias[] = {3, 0, 1, 2};
+  int outputs[] = {1, 4};
+  TfLiteTransposeConvParams params = {shape.padding, shape.stride_width,
+                                      shape.stride_height};
+  const TfLiteRegistration registration = tflite::Register_TRANSPOSE_CONV();
+  tflite::micro::KernelRunner runner(
+      registration, tensors, 5,
+      tflite::testing::IntArrayFromInts(shape.bias ? inputs_with_bias
+                                                   : inputs_without_bias),
+      tflite::testing::IntArrayFromInts(outputs), &params);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    printf("  Prepare failed\n");
+    return false;
+  }
+
+  // The reference with the quantization Prepare works out.
+  tflite::ConvParams op_params = {};
+  int unused_height, unused_width;
+  const TfLitePaddingValues padding = tflite::ComputePaddingHeightWidth(
+      shape.stride_height, shape.stride_width, 1, 1, shape.output_height,
+      shape.output_width, shape.filter_height, shape.filter_width,
+      shape.padding, &unused_height, &unused_width);
+  op_params.padding_values.height = padding.height;
+  op_params.padding_values.width = padding.width;
+  op_params.stride_height = shape.stride_height;
+  op_params.stride_width = shape.stride_width;
+  op_params.input_offset = -kInputZeroPoint;
+  op_params.output_offset = kOutputZeroPoint;
+  std::vector<int32_t> multipliers(shape.output_depth);
+  std::vector<int32_t> shifts(shape.output_depth);
+  for (int i = 0; i < shape.output_depth; ++i) {
+    int shift;
+    tflite::QuantizeMultiplier(static_cast<double>(kInputScale) *
+                                   filter_scales[i + 1] / kOutputScale,
+                               &multipliers[i], &shift);
+    shifts[i] = shift;
+  }
+  const tflite::RuntimeShape input_shape(4, input_dims + 1);
+  const tflite::RuntimeShape filter_shape(4, filter_dims + 1);
+  const tflite::RuntimeShape bias_shape(1, bias_dims + 1);
+  const tflite::RuntimeShape output_shape(4, output_dims + 1);
+
+  *kernel_us = 0;
+  *reference_us = 0;
+  for (int r = 0; r < repeats; ++r) {
+    double start = NowUs();
+    if (runner.Invoke() != kTfLiteOk) {
+      printf("  Invoke failed\n");
+      return false;
+    }
+    double us = NowUs() - start;
+    if (r == 0 || us < *kernel_us) {
+      *kernel_us = us;
+    }
+    start = NowUs();
+    tflite::reference_integer_ops::TransposeConv(
+        op_params, multipliers.data(), shifts.data(), input_shape,
+        input.data(), filter_shape, filter.data(), bias_shape,
+        shape.bias ? bias.data() : nullptr, output_shape, reference.data(),
+        tflite::RuntimeShape(), nullptr, scratch.data());
+    us = NowUs() - start;
+    if (r == 0 || us < *reference_us) {
+      *reference_us = us;
+    }
+  }
+
+  if (output != reference) {
+    size_t i = 0;
+    while (output[i] == reference[i]) {
+      ++i;
+    }
+    printf("  %dx%dx%dx%d -> %dx%dx%d, filter %dx%d, stride %dx%d, %s%s "
+           "differs from the reference at value %zu: %d instead of %d\n",
+           shape.batches, shape.input_height, shape.input_width,
+           shape.input_depth, shape.output_height, shape.output_width,
+           shape.output_depth, shape.filter_height, shape.filter_width,
+           shape.stride_height, shape.stride_width,
+           shape.padding == kTfLitePaddingSame ? "SAME" : "VALID",
+           shape.bias ? "" : " without bias", i, output[i], reference[i]);
+    return false;
+  }
+  for (int8_t value : reference) {
+    if (value == std::numeric_limits<int8_t>::min() ||
+        value == std::numeric_limits<int8_t>::max()) {
+      ++*clamped;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int repeats = 20;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      repeats = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [-r repeats]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  bool exact = true;
+  double kernel_us, reference_us;
+  int checked = 0;
+  int clamped = 0;
+  for (int i = 0; i < 150; ++i) {
+    Shape shape;
+    shape.batches = RandomInt(1, 3);
+    shape.input_height = RandomInt(1, 8);
+    shape.input_width = RandomInt(1, 8);
+    shape.input_depth = RandomInt(1, 12);
+    shape.output_depth = RandomInt(1, 12);
+    if (i % 3 == 0) {  // The stride 2, 2x2 and 3x3 path
+      shape.filter_height = shape.filter_width = RandomInt(2, 3);
+      shape.stride_height = shape.stride_width = 2;
+    } else {
+      shape.filter_height = RandomInt(1, 5);
+      shape.filter_width = RandomInt(1, 5);
+      shape.stride_height = RandomInt(1, 3);
+      shape.stride_width = RandomInt(1, 3);
+    }
+    shape.padding = Random() % 2 ? kTfLitePaddingSame : kTfLitePaddingValid;
+    shape.output_height =
+        RandomOutputSize(shape.input_height, shape.filter_height,
+                         shape.stride_height, shape.padding);
+    shape.output_width = RandomOutputSize(
+        shape.input_width, shape.filter_width, shape.stride_width,
+        shape.padding);
+    shape.bias = i % 5 != 4;
+    exact &= Run(shape, 1, &kernel_us, &reference_us, &clamped);
+    ++checked;
+  }
+  printf("%d random shapes checked, %d outputs clamped\n", checked, clamped);
+  if (clamped == 0) {
+    printf("No output reached the ends of the int8 range\n");
+    exact = false;
+  }
+
+  for (const Shape& shape : kBenchmarkShapes) {
+    exact &= Run(shape, repeats, &kernel_us, &reference_us, &clamped);
+    printf("%dx%dx%d -> %dx%dx%d, filter %dx%d, stride %d: reference %.1f us, "
+           "kernel %.1f us (%.2fx)\n",
+           shape.input_height, shape.input_width, shape.input_depth,
+           shape.output_height, shape.output_width, shape.output_depth,
+           shape.filter_height, shape.filter_width, shape.stride_height,
+           reference_us, kernel_us, reference_us / kernel_us);
+  }
+  printf("%s\n", exact ? "Bit-exact with the reference"
+                       : "Differs from the reference");
+  return exact ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host stand-in for the esp32-camera driver header: only the frame buffer
+// type, laid out as in components/esp32-camera/driver/include/esp_camera.h.
+
+#ifndef PERSON_DETECTION_HOST_ESP_CAMERA_H_
+#define PERSON_DETECTION_HOST_ESP_CAMERA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "sensor.h"
+
+typedef struct {
+    uint8_t * buf;              /*!< Pointer to the pixel data */
+    size_t len;                 /*!< Length of the buffer in bytes */
+    size_t width;               /*!< Width of the buffer in pixels */
+    size_t height;              /*!< Height of the buffer in pixels */
+    pixformat_t format;         /*!< Format of the pixel data */
+    struct timeval timestamp;   /*!< Timestamp since boot of the first DMA buffer of the frame */
+} camera_fb_t;
+
+#endif  // PERSON_DETECTION_HOST_ESP_CAMERA_H_
@@ -0,0 +1,33 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+// Host stand-in for the ESP-IDF logging macros, printing to stderr.
+
+#ifndef PERSON_DETECTION_HOST_ESP_LOG_H_
+#define PERSON_DETECTION_HOST_ESP_LOG_H_
+
+#include <stdio.h>
+
+#define ESP_LOG_HOST(level, tag, format, ...) \
+  fprintf(stderr, level " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_HOST("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_HOST("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_HOST("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { (void) (tag); } while (0)
+#define ESP_LOGV(tag, format, ...) do { (void) (tag); } while (0)
+
+#endif  // PERSON_DETECTION_HOST_ESP_LOG_H_
@@ -0,0 +1,23 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+// Host stand-in for soc/efuse_reg.h, which to_jpg.cpp includes but does not
+// use.
+
+#ifndef PERSON_DETECTION_HOST_SOC_EFUSE_REG_H_
+#define PERSON_DETECTION_HOST_SOC_EFUSE_REG_H_
+
+#endif  // PERSON_DETECTION_HOST_SOC_EFUSE_REG_H_
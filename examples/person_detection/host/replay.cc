@@ -0,0 +1,278 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs the application's image path on a Linux host: frames are replayed by
+// the file frame source, preprocessed by PreprocessFrame() and inferred with
+// the same model and ops as on the device. Prints the scores and timings of
+// every frame and the end-to-end throughput and latency.
+//
+// Usage: replay [-s WxH] [-p gray|rgb565] [-f fps] [-n frames] [-l]
+//               [-b batch] [-r ops:rows] <path>
+//
+// <path> is a directory of frame files or a raw video file, see
+// frame_source_file_config_t. Raw frames default to 96x96 gray, like
+// static_images/sample_images. With -b, frames are inferred `batch` at a
+// time (MicroInterpreter::SetBatchSize()), which is faster for re-scoring
+// recorded footage but delays the response to the first frames of a batch.
+// With -r, the first `ops` operators run in bands of `rows` output rows
+// (MicroInterpreter::SetRowStreaming()), which needs less arena for the same
+// scores.
+
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "detection_responder.h"
+#include "frame_source.h"
+#include "image_preprocess.h"
+#include "model_settings.h"
+#include "person_detect_model_data.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#if __has_include("person_detect_op_resolver.h")
+#include "person_detect_op_resolver.h"
+#endif
+
+namespace {
+
+// Arena per batch item. Pointers are twice as large as on the device, so are
+// the persistent allocations. There is no need to size this tightly on the
+// host.
+constexpr size_t kTensorArenaSize = 512 * 1024;
+constexpr int kMaxBatchSize = 256;
+
+int64_t monotonic_us() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+int64_t timeval_us(const struct timeval& tv) {
+  return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+int64_t wall_us() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return timeval_us(now);
+}
+
+void Usage() {
+  fprintf(stderr,
+          "Usage: replay [-s WxH] [-p gray|rgb565] [-f fps] [-n frames] [-l] "
+          "[-b batch] [-r ops:rows] <path>\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  frame_source_file_config_t config = {};
+  config.format = PIXFORMAT_GRAYSCALE;
+  config.width = kNumCols;
+  config.height = kNumRows;
+  long max_frames = 0;
+  int batch_size = 1;
+  int streamed_ops = 0, band_rows = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "s:p:f:n:lb:r:")) != -1) {
+    switch (opt) {
+      case 's':
+        if (sscanf(optarg, "%zux%zu", &config.width, &config.height) != 2) {
+          Usage();
+          return 1;
+        }
+        break;
+      case 'p':
+        if (strcmp(optarg, "gray") == 0) {
+          config.format = PIXFORMAT_GRAYSCALE;
+        } else if (strcmp(optarg, "rgb565") == 0) {
+          config.format = PIXFORMAT_RGB565;
+        } else {
+          Usage();
+          return 1;
+        }
+        break;
+      case 'f':
+        config.fps = strtof(optarg, nullptr);
+        break;
+      case 'n':
+        max_frames = strtol(optarg, nullptr, 0);
+        break;
+      case 'l':
+        config.loop = true;
+        break;
+      case 'b':
+        batch_size = atoi(optarg);
+        if (batch_size < 1 || batch_size > kMaxBatchSize) {
+          fprintf(stderr, "Batch size must be 1 to %d\n", kMaxBatchSize);
+          return 1;
+        }
+        break;
+      case 'r':
+        if (sscanf(optarg, "%d:%d", &streamed_ops, &band_rows) != 2) {
+          Usage();
+          return 1;
+        }
+        break;
+      default:
+        Usage();
+        return 1;
+    }
+  }
+  if (optind + 1 != argc) {
+    Usage();
+    return 1;
+  }
+  config.path = argv[optind];
+  if (config.loop && max_frames <= 0) {
+    fprintf(stderr, "-l needs -n\n");
+    return 1;
+  }
+
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    fprintf(stderr, "Model schema version %d, expected %d\n",
+            static_cast<int>(model->version()), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+  // The same resolver as the application, see main_functions.cc.
+#if __has_include("person_detect_op_resolver.h")
+  PersonDetectOpResolver micro_op_resolver;
+#else
+  tflite::MicroMutableOpResolver<5> micro_op_resolver;
+  micro_op_resolver.AddAveragePool2D();
+  micro_op_resolver.AddConv2D();
+  micro_op_resolver.AddDepthwiseConv2D();
+  micro_op_resolver.AddReshape();
+  micro_op_resolver.AddSoftmax();
+#endif
+
+  const size_t arena_size = kTensorArenaSize * batch_size;
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[arena_size + 16]);
+  uint8_t* tensor_arena = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(arena.get()) + 15) & ~uintptr_t{15});
+
+  tflite::MicroInterpreter interpreter(model, micro_op_resolver, tensor_arena,
+                                       arena_size);
+  if (interpreter.SetBatchSize(batch_size) != kTfLiteOk ||
+      interpreter.SetRowStreaming(streamed_ops, band_rows) != kTfLiteOk ||
+      interpreter.AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "AllocateTensors() failed\n");
+    return 1;
+  }
+  printf("Batch size %d, arena %zu bytes\n", batch_size,
+         interpreter.arena_used_bytes());
+  TfLiteTensor* input = interpreter.input(0);
+  TfLiteTensor* output = interpreter.output(0);
+
+  const frame_source_t* source = &frame_source_file;
+  if (source->init(&config) != 0) {
+    return 1;
+  }
+
+  long frames = 0;
+  int64_t preprocess_total_us = 0, invoke_total_us = 0;
+  int64_t latency_total_us = 0, latency_max_us = 0;
+  const int64_t start_us = monotonic_us();
+  bool end_of_stream = false;
+  while (!end_of_stream) {
+    // Fill the batch. The last one may be partial, the items after it are
+    // inferred but not reported.
+    struct timeval captured[kMaxBatchSize];
+    int64_t preprocess_us[kMaxBatchSize];
+    int count = 0;
+    while (count < batch_size) {
+      if (max_frames > 0 && frames + count >= max_frames) {
+        end_of_stream = true;
+        break;
+      }
+      camera_fb_t* fb = source->fb_get();
+      if (fb == nullptr) {
+        end_of_stream = true;
+        break;
+      }
+      const int64_t t0 = monotonic_us();
+      TfLiteStatus status =
+          PreprocessFrame(fb, input->data.int8 + count * kMaxImageSize);
+      captured[count] = fb->timestamp;
+      source->fb_return(fb);
+      if (status != kTfLiteOk) {
+        return 1;
+      }
+      preprocess_us[count++] = monotonic_us() - t0;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    const int64_t t1 = monotonic_us();
+    if (interpreter.Invoke() != kTfLiteOk) {
+      fprintf(stderr, "Invoke failed\n");
+      return 1;
+    }
+    const int64_t invoke_us = monotonic_us() - t1;
+
+    for (int i = 0; i < count; i++) {
+      const int8_t* scores = output->data.int8 + i * kCategoryCount;
+      float person_score = (scores[kPersonIndex] - output->params.zero_point) *
+                           output->params.scale;
+      float no_person_score =
+          (scores[kNotAPersonIndex] - output->params.zero_point) *
+          output->params.scale;
+      RespondToDetection(error_reporter, person_score, no_person_score,
+                         input->data.int8 + i * kMaxImageSize,
+                         kImageCameraGray);
+
+      // Capture to response, what the device reports as detection latency
+      const int64_t latency_us = wall_us() - timeval_us(captured[i]);
+      printf("frame %ld: preprocess %lld us, invoke %lld us, latency %lld us\n",
+             frames + i, static_cast<long long>(preprocess_us[i]),
+             static_cast<long long>(invoke_us / count),
+             static_cast<long long>(latency_us));
+      preprocess_total_us += preprocess_us[i];
+      latency_total_us += latency_us;
+      if (latency_us > latency_max_us) {
+        latency_max_us = latency_us;
+      }
+    }
+    invoke_total_us += invoke_us;
+    frames += count;
+  }
+  const int64_t elapsed_us = monotonic_us() - start_us;
+
+  if (frames == 0) {
+    fprintf(stderr, "No frames replayed\n");
+    return 1;
+  }
+  printf("%ld frames in %.3f s: %.1f fps, preprocess %lld us, invoke %lld us, "
+         "latency %lld us mean, %lld us max\n",
+         frames, elapsed_us / 1e6, frames * 1e6 / elapsed_us,
+         static_cast<long long>(preprocess_total_us / frames),
+         static_cast<long long>(invoke_total_us / frames),
+         static_cast<long long>(latency_total_us / frames),
+         static_cast<long long>(latency_max_us));
+  return 0;
+}
@@ -0,0 +1,215 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks that the interpreter options which must not change the results give
+// the same scores, bit for bit, as a plain interpreter. Every frame of <path>
+// is preprocessed like in replay.cc and inferred once per configuration:
+//
+// Usage: score_check [-b batch]... [-r ops:rows]... <path>
+//
+// Each -b adds a configuration that infers `batch` frames at a time
+// (MicroInterpreter::SetBatchSize()), the last batch is partial unless `batch`
+// divides the number of frames. Each -r adds one that streams the first `ops`
+// operators in bands of `rows` rows (MicroInterpreter::SetRowStreaming()).
+// Prints the arena of each configuration and exits with 1 on the first output
+// that differs from the one of the plain interpreter.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "frame_source.h"
+#include "image_preprocess.h"
+#include "model_settings.h"
+#include "person_detect_model_data.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#if __has_include("person_detect_op_resolver.h")
+#include "person_detect_op_resolver.h"
+#endif
+
+namespace {
+
+// Arena per batch item, see replay.cc
+constexpr size_t kTensorArenaSize = 512 * 1024;
+constexpr int kMaxBatchSize = 256;
+constexpr int kMaxConfigs = 16;
+
+struct Config {
+  int batch_size;
+  int streamed_ops;
+  int band_rows;
+};
+
+void Usage() {
+  fprintf(stderr,
+          "Usage: score_check [-b batch]... [-r ops:rows]... <path>\n");
+}
+
+// Infers `frames` (kMaxImageSize bytes each) with `config` and stores the
+// kCategoryCount outputs of each in `scores`.
+bool Infer(const tflite::Model* model, const tflite::MicroOpResolver& resolver,
+           const Config& config, const std::vector<int8_t>& frames,
+           std::vector<int8_t>* scores) {
+  const size_t arena_size = kTensorArenaSize * config.batch_size;
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[arena_size + 16]);
+  uint8_t* tensor_arena = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(arena.get()) + 15) & ~uintptr_t{15});
+
+  tflite::MicroInterpreter interpreter(model, resolver, tensor_arena,
+                                       arena_size);
+  if (interpreter.SetBatchSize(config.batch_size) != kTfLiteOk ||
+      interpreter.SetRowStreaming(config.streamed_ops, config.band_rows) !=
+          kTfLiteOk ||
+      interpreter.AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "AllocateTensors() failed\n");
+    return false;
+  }
+  printf("batch %d, rows %d:%d: arena %zu bytes\n", config.batch_size,
+         config.streamed_ops, config.band_rows,
+         interpreter.arena_used_bytes());
+  TfLiteTensor* input = interpreter.input(0);
+  TfLiteTensor* output = interpreter.output(0);
+
+  // The last batch may be partial, the items after it keep the previous
+  // frames and are not reported.
+  const size_t frame_count = frames.size() / kMaxImageSize;
+  scores->resize(frame_count * kCategoryCount);
+  for (size_t first = 0; first < frame_count; first += config.batch_size) {
+    size_t count = frame_count - first;
+    if (count > static_cast<size_t>(config.batch_size)) {
+      count = config.batch_size;
+    }
+    memcpy(input->data.int8, frames.data() + first * kMaxImageSize,
+           count * kMaxImageSize);
+    if (interpreter.Invoke() != kTfLiteOk) {
+      fprintf(stderr, "Invoke failed\n");
+      return false;
+    }
+    memcpy(scores->data() + first * kCategoryCount, output->data.int8,
+           count * kCategoryCount);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config configs[kMaxConfigs];
+  int config_count = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "b:r:")) != -1) {
+    if (config_count == kMaxConfigs) {
+      fprintf(stderr, "At most %d configurations\n", kMaxConfigs);
+      return 1;
+    }
+    Config& config = configs[config_count++];
+    config = {1, 0, 0};
+    switch (opt) {
+      case 'b':
+        config.batch_size = atoi(optarg);
+        if (config.batch_size < 1 || config.batch_size > kMaxBatchSize) {
+          fprintf(stderr, "Batch size must be 1 to %d\n", kMaxBatchSize);
+          return 1;
+        }
+        break;
+      case 'r':
+        if (sscanf(optarg, "%d:%d", &config.streamed_ops,
+                   &config.band_rows) != 2) {
+          Usage();
+          return 1;
+        }
+        break;
+      default:
+        Usage();
+        return 1;
+    }
+  }
+  if (optind + 1 != argc || config_count == 0) {
+    Usage();
+    return 1;
+  }
+
+  frame_source_file_config_t source_config = {};
+  source_config.path = argv[optind];
+  source_config.format = PIXFORMAT_GRAYSCALE;
+  source_config.width = kNumCols;
+  source_config.height = kNumRows;
+  const frame_source_t* source = &frame_source_file;
+  if (source->init(&source_config) != 0) {
+    return 1;
+  }
+  std::vector<int8_t> frames;
+  while (camera_fb_t* fb = source->fb_get()) {
+    frames.resize(frames.size() + kMaxImageSize);
+    TfLiteStatus status =
+        PreprocessFrame(fb, frames.data() + frames.size() - kMaxImageSize);
+    source->fb_return(fb);
+    if (status != kTfLiteOk) {
+      return 1;
+    }
+  }
+  const size_t frame_count = frames.size() / kMaxImageSize;
+  if (frame_count == 0) {
+    fprintf(stderr, "No frames read\n");
+    return 1;
+  }
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    fprintf(stderr, "Model schema version %d, expected %d\n",
+            static_cast<int>(model->version()), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+  // The same resolver as the application, see main_functions.cc.
+#if __has_include("person_detect_op_resolver.h")
+  PersonDetectOpResolver micro_op_resolver;
+#else
+  tflite::MicroMutableOpResolver<5> micro_op_resolver;
+  micro_op_resolver.AddAveragePool2D();
+  micro_op_resolver.AddConv2D();
+  micro_op_resolver.AddDepthwiseConv2D();
+  micro_op_resolver.AddReshape();
+  micro_op_resolver.AddSoftmax();
+#endif
+
+  std::vector<int8_t> expected;
+  if (!Infer(model, micro_op_resolver, Config{1, 0, 0}, frames, &expected)) {
+    return 1;
+  }
+  for (int c = 0; c < config_count; c++) {
+    std::vector<int8_t> scores;
+    if (!Infer(model, micro_op_resolver, configs[c], frames, &scores)) {
+      return 1;
+    }
+    for (size_t i = 0; i < scores.size(); i++) {
+      if (scores[i] != expected[i]) {
+        fprintf(stderr, "Frame %zu output %zu is %d instead of %d\n",
+                i / kCategoryCount, i % kCategoryCount, scores[i],
+                expected[i]);
+        return 1;
+      }
+    }
+  }
+  printf("%zu frames, %d configurations: same scores\n", frame_count,
+         config_count);
+  return 0;
+}
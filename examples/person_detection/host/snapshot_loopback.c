@@ -0,0 +1,262 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Sends snapshots to a listener on 127.0.0.1 and checks what arrives: the
+ * framing, the sequence numbers and the decoded JPEG against the frame. The
+ * sender and the receiver are polled in turns from one thread. */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_jpg_decode.h"
+#include "snapshot_sender.h"
+
+#define WIDTH 96
+#define HEIGHT 96
+#define MAX_SNAPSHOT (64 * 1024)
+
+static int failures;
+
+#define CHECK(cond, ...) do {                             \
+    if (!(cond)) {                                        \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);       \
+      printf(__VA_ARGS__);                                \
+      printf("\n");                                       \
+      failures++;                                         \
+    }                                                     \
+  } while (0)
+
+static uint8_t frame[WIDTH * HEIGHT];
+
+static struct {
+  int listener;
+  int conn;
+  uint8_t buf[MAX_SNAPSHOT];
+  size_t len;
+} rx = { .listener = -1, .conn = -1 };
+
+typedef struct {
+  uint32_t sequence;
+  uint16_t width;
+  uint16_t height;
+  uint8_t score;
+  uint8_t jpeg[MAX_SNAPSHOT];
+  size_t jpeg_len;
+} snapshot_t;
+
+static uint16_t get_u16(const uint8_t *p)
+{
+  return (uint16_t) (p[0] << 8 | p[1]);
+}
+
+static void receiver_poll(void)
+{
+  if (rx.conn < 0) {
+    rx.conn = accept(rx.listener, NULL, NULL);
+    if (rx.conn < 0) {
+      return;
+    }
+    fcntl(rx.conn, F_SETFL, O_NONBLOCK);
+    rx.len = 0;
+  }
+  ssize_t n = recv(rx.conn, rx.buf + rx.len, sizeof(rx.buf) - rx.len, 0);
+  if (n > 0) {
+    rx.len += n;
+  } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+    close(rx.conn);
+    rx.conn = -1;
+  }
+}
+
+/* Takes one whole snapshot off the received bytes, false if there is none yet */
+static bool parse_snapshot(snapshot_t *s)
+{
+  if (rx.len < SNAPSHOT_HEADER_SIZE) {
+    return false;
+  }
+  CHECK(memcmp(rx.buf, SNAPSHOT_MAGIC, 4) == 0, "bad magic");
+  size_t pos = SNAPSHOT_HEADER_SIZE;
+  s->jpeg_len = 0;
+  while (true) {
+    if (pos + 2 > rx.len) {
+      return false;
+    }
+    uint16_t chunk = get_u16(rx.buf + pos);
+    if (pos + 2 + chunk > rx.len) {
+      return false;
+    }
+    memcpy(s->jpeg + s->jpeg_len, rx.buf + pos + 2, chunk);
+    s->jpeg_len += chunk;
+    pos += 2 + chunk;
+    if (chunk == 0) {
+      break;
+    }
+  }
+  s->sequence = (uint32_t) get_u16(rx.buf + 4) << 16 | get_u16(rx.buf + 6);
+  s->width = get_u16(rx.buf + 8);
+  s->height = get_u16(rx.buf + 10);
+  s->score = rx.buf[12];
+  memmove(rx.buf, rx.buf + pos, rx.len - pos);
+  rx.len -= pos;
+  return true;
+}
+
+/* Polls both ends until a snapshot arrives or the sender gives up on it */
+static bool exchange(snapshot_t *s)
+{
+  for (int idle = 0; idle < 200;) {
+    bool busy = snapshot_sender_poll();
+    receiver_poll();
+    if (parse_snapshot(s)) {
+      return true;
+    }
+    if (!busy) {
+      idle++;
+      struct timespec pause = { 0, 5 * 1000 * 1000 };
+      nanosleep(&pause, NULL);
+    }
+  }
+  return false;
+}
+
+static const snapshot_t *decoded;
+static uint8_t gray[WIDTH * HEIGHT];
+
+static size_t jpeg_read(void *arg, size_t index, uint8_t *buf, size_t len)
+{
+  (void) arg;
+  if (buf) {
+    memcpy(buf, decoded->jpeg + index, len);
+  }
+  return len;
+}
+
+static bool jpeg_write(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data)
+{
+  (void) arg;
+  if (data) {
+    for (uint16_t r = 0; r < h; r++) {
+      memcpy(gray + (y + r) * WIDTH + x, data + r * w, w);
+    }
+  }
+  return true;
+}
+
+static void check_image(const snapshot_t *s)
+{
+  decoded = s;
+  CHECK(esp_jpg_decode_gray(s->jpeg_len, JPG_SCALE_NONE, jpeg_read, jpeg_write, NULL) == ESP_OK,
+        "snapshot %u does not decode", (unsigned) s->sequence);
+  long error = 0;
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    error += abs(gray[i] - frame[i]);
+  }
+  CHECK(error / (WIDTH * HEIGHT) < 4, "snapshot %u differs by %ld on average",
+        (unsigned) s->sequence, error / (WIDTH * HEIGHT));
+}
+
+static bool submit(uint8_t score)
+{
+  uint8_t *buf = snapshot_sender_acquire();
+  if (buf == NULL) {
+    return false;
+  }
+  memcpy(buf, frame, sizeof(frame));
+  snapshot_sender_commit(WIDTH, HEIGHT, score);
+  return true;
+}
+
+static snapshot_t snapshot;
+
+static void test_snapshots(void)
+{
+  uint32_t sent, dropped;
+  for (int i = 0; i < 5; i++) {
+    CHECK(submit(60 + i), "snapshot %d not accepted", i);
+    CHECK(!submit(0), "accepted a snapshot while one is pending");
+    CHECK(exchange(&snapshot), "snapshot %d did not arrive", i);
+    CHECK(snapshot.sequence == (uint32_t) i, "sequence %u, want %d", (unsigned) snapshot.sequence, i);
+    CHECK(snapshot.width == WIDTH && snapshot.height == HEIGHT, "size %ux%u", snapshot.width, snapshot.height);
+    CHECK(snapshot.score == 60 + i, "score %u", snapshot.score);
+    check_image(&snapshot);
+  }
+  while (snapshot_sender_poll()) {
+  }
+  snapshot_sender_stats(&sent, &dropped);
+  CHECK(sent == 5 && dropped == 5, "sent %u dropped %u", (unsigned) sent, (unsigned) dropped);
+}
+
+/* After the receiver hangs up, snapshots are lost until the sender notices
+ * and connects again */
+static void test_reconnect(void)
+{
+  close(rx.conn);
+  rx.conn = -1;
+  for (int attempt = 0; attempt < 5; attempt++) {
+    while (!submit(99)) {
+      snapshot_sender_poll();
+    }
+    if (exchange(&snapshot)) {
+      CHECK(snapshot.score == 99, "score %u", snapshot.score);
+      check_image(&snapshot);
+      return;
+    }
+  }
+  CHECK(false, "no snapshot after the receiver reconnected");
+}
+
+int main(int argc, char *argv[])
+{
+  srand(argc > 1 ? atoi(argv[1]) : 1);
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      frame[y * WIDTH + x] = (uint8_t) (x * 2 + y + (rand() & 7));
+    }
+  }
+
+  rx.listener = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  if (rx.listener < 0 || bind(rx.listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(rx.listener, 1) != 0 ||
+      getsockname(rx.listener, (struct sockaddr *) &addr, &addr_len) != 0) {
+    printf("Couldn't listen on 127.0.0.1: errno %d\n", errno);
+    return 1;
+  }
+  fcntl(rx.listener, F_SETFL, O_NONBLOCK);
+
+  snapshot_sender_config_t config = { "127.0.0.1", ntohs(addr.sin_port), WIDTH, HEIGHT, 80 };
+  if (!snapshot_sender_init(&config)) {
+    printf("snapshot_sender_init failed\n");
+    return 1;
+  }
+
+  test_snapshots();
+  test_reconnect();
+
+  printf("%s\n", failures ? "Snapshot loopback tests failed" : "Snapshot loopback tests passed");
+  return failures != 0;
+}
@@ -0,0 +1,293 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Sends telemetry to a listener on 127.0.0.1 and checks what arrives: the
+ * decoded records, their coalescing and the accounting of the records that
+ * a full ring drops. The sender and the receiver are polled in turns from one
+ * thread. */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tcp_client.h"
+#include "telemetry.h"
+
+#define FLUSH_INTERVAL_MS 100
+
+static int failures;
+
+#define CHECK(cond, ...) do {                             \
+    if (!(cond)) {                                        \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);       \
+      printf(__VA_ARGS__);                                \
+      printf("\n");                                       \
+      failures++;                                         \
+    }                                                     \
+  } while (0)
+
+static struct {
+  int listener;
+  int conn;
+  bool started;       /* The magic of this connection was checked */
+  uint8_t buf[64 * 1024];
+  size_t len;
+  int reads;          /* recv() calls that returned data */
+} rx = { .listener = -1, .conn = -1 };
+
+static void receiver_poll(void)
+{
+  if (rx.conn < 0) {
+    rx.conn = accept(rx.listener, NULL, NULL);
+    if (rx.conn < 0) {
+      return;
+    }
+    fcntl(rx.conn, F_SETFL, O_NONBLOCK);
+    rx.len = 0;
+    rx.started = false;
+  }
+  ssize_t n = recv(rx.conn, rx.buf + rx.len, sizeof(rx.buf) - rx.len, 0);
+  if (n > 0) {
+    rx.len += n;
+    rx.reads++;
+  } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+    close(rx.conn);
+    rx.conn = -1;
+  }
+}
+
+/* Takes one record off the received bytes, false if there is none yet */
+static bool parse_record(telemetry_record_t *record)
+{
+  size_t pos = 0;
+  if (!rx.started) {
+    if (rx.len < TELEMETRY_MAGIC_SIZE) {
+      return false;
+    }
+    CHECK(memcmp(rx.buf, TELEMETRY_MAGIC, TELEMETRY_MAGIC_SIZE) == 0, "bad magic");
+    rx.started = true;
+    pos = TELEMETRY_MAGIC_SIZE;
+  }
+  bool found = false;
+  if (rx.len - pos >= 2) {
+    size_t msg_len = rx.buf[pos] << 8 | rx.buf[pos + 1];
+    if (rx.len - pos - 2 >= msg_len) {
+      CHECK(telemetry_decode(rx.buf + pos + 2, msg_len, record), "record does not decode");
+      pos += 2 + msg_len;
+      found = true;
+    }
+  }
+  memmove(rx.buf, rx.buf + pos, rx.len - pos);
+  rx.len -= pos;
+  return found;
+}
+
+static void pause_ms(int ms)
+{
+  struct timespec pause = { ms / 1000, (ms % 1000) * 1000 * 1000 };
+  nanosleep(&pause, NULL);
+}
+
+/* Polls both ends until a record arrives, for up to two seconds */
+static bool next_record(telemetry_record_t *record)
+{
+  for (int idle = 0; idle < 400;) {
+    bool busy = telemetry_poll();
+    receiver_poll();
+    if (parse_record(record)) {
+      return true;
+    }
+    if (!busy) {
+      idle++;
+      pause_ms(5);
+    }
+  }
+  return false;
+}
+
+static void make_record(telemetry_record_t *r, int i)
+{
+  memset(r, 0, sizeof(*r));
+  r->person_score = i;
+  r->no_person_score = 100 - i;
+  r->flags = i % 3 == 0 ? TELEMETRY_FLAG_REUSED : 0;
+  r->num_ops = i % 3 == 0 ? 0 : 31;
+  r->invoke_us = 100000 + i;
+  r->arena_used = 81 * 1024 + i;
+  r->frames_skipped = i / 3;
+  r->frames_dropped = i / 5;
+  for (int op = 0; op < r->num_ops; op++) {
+    /* From 1 to 5 bytes of LEB128 */
+    r->op_us[op] = (uint32_t) op * 0x9e3779b1u >> (op % 32) ^ i;
+  }
+}
+
+static void check_record(const telemetry_record_t *got, const telemetry_record_t *want)
+{
+  CHECK(got->sequence == want->sequence, "sequence %u, want %u",
+        (unsigned) got->sequence, (unsigned) want->sequence);
+  CHECK(got->timestamp_ms == want->timestamp_ms, "timestamp of #%u", (unsigned) want->sequence);
+  CHECK(got->person_score == want->person_score && got->no_person_score == want->no_person_score,
+        "scores of #%u", (unsigned) want->sequence);
+  CHECK(got->flags == want->flags, "flags of #%u", (unsigned) want->sequence);
+  CHECK(got->invoke_us == want->invoke_us && got->arena_used == want->arena_used &&
+        got->frames_skipped == want->frames_skipped &&
+        got->frames_dropped == want->frames_dropped &&
+        got->records_lost == want->records_lost,
+        "counters of #%u", (unsigned) want->sequence);
+  CHECK(got->num_ops == want->num_ops &&
+        memcmp(got->op_us, want->op_us, got->num_ops * sizeof(got->op_us[0])) == 0,
+        "op durations of #%u", (unsigned) want->sequence);
+}
+
+static telemetry_record_t pushed[256];
+static telemetry_record_t received;
+
+static void test_records(void)
+{
+  uint32_t sent, lost;
+  for (int i = 0; i < 20; i++) {
+    make_record(&pushed[i], i);
+    CHECK(telemetry_push(&pushed[i]), "record %d not accepted", i);
+  }
+  for (int i = 0; i < 20; i++) {
+    if (!next_record(&received)) {
+      CHECK(false, "record %d did not arrive", i);
+      return;
+    }
+    check_record(&received, &pushed[i]);
+  }
+  telemetry_stats(&sent, &lost);
+  CHECK(sent == 20 && lost == 0, "sent %u lost %u", (unsigned) sent, (unsigned) lost);
+}
+
+/* A few records wait for the flush interval and go out together */
+static void test_coalescing(void)
+{
+  int64_t start_us = tcp_client_now_us();
+  int reads = rx.reads;
+  for (int i = 0; i < 3; i++) {
+    make_record(&pushed[i], i + 1);
+    telemetry_push(&pushed[i]);
+  }
+  for (int i = 0; i < 5; i++) {
+    telemetry_poll();
+    receiver_poll();
+  }
+  bool early = tcp_client_now_us() - start_us < FLUSH_INTERVAL_MS * 1000;
+  CHECK(!early || rx.reads == reads, "records sent before the flush interval");
+  for (int i = 0; i < 3; i++) {
+    CHECK(next_record(&received), "record %d did not arrive", i);
+    check_record(&received, &pushed[i]);
+  }
+  CHECK(rx.reads == reads + 1, "3 records took %d reads", rx.reads - reads);
+}
+
+/* Records pushed while the ring is full are lost, which the sequence numbers
+ * and records_lost show */
+static void test_full_ring(void)
+{
+  uint32_t sent, lost;
+  telemetry_record_t record;
+  int accepted = 0;
+  while (accepted < 256) {
+    make_record(&pushed[accepted], accepted);
+    if (!telemetry_push(&pushed[accepted])) {
+      break;
+    }
+    accepted++;
+  }
+  CHECK(accepted > 20 && accepted < 256, "%d records fit the ring", accepted);
+  /* Lost along with the one that found the ring full */
+  const int rejected = 5;
+  for (int j = 0; j < rejected; j++) {
+    make_record(&record, j);
+    CHECK(!telemetry_push(&record), "full ring accepted a record");
+  }
+  for (int j = 0; j < accepted; j++) {
+    if (!next_record(&received)) {
+      CHECK(false, "record %d did not arrive", j);
+      return;
+    }
+    check_record(&received, &pushed[j]);
+  }
+  telemetry_stats(&sent, &lost);
+  CHECK(lost == (uint32_t) rejected + 1, "lost %u, want %d", (unsigned) lost, rejected + 1);
+
+  make_record(&record, 7);
+  CHECK(telemetry_push(&record), "record not accepted after the ring drained");
+  CHECK(next_record(&received), "record after the drops did not arrive");
+  CHECK(received.sequence == pushed[accepted - 1].sequence + rejected + 2,
+        "sequence %u after %d lost records", (unsigned) received.sequence, rejected + 1);
+  CHECK(received.records_lost == lost, "records_lost %u, want %u",
+        (unsigned) received.records_lost, (unsigned) lost);
+}
+
+/* After the receiver hangs up, records flow again on a new connection, which
+ * starts with the magic again */
+static void test_reconnect(void)
+{
+  close(rx.conn);
+  rx.conn = -1;
+  for (int attempt = 0; attempt < 20; attempt++) {
+    telemetry_record_t record;
+    make_record(&record, attempt);
+    telemetry_push(&record);
+    if (next_record(&received)) {
+      CHECK(rx.started, "no magic on the new connection");
+      CHECK(received.person_score == record.person_score, "wrong record after reconnecting");
+      return;
+    }
+  }
+  CHECK(false, "no record after the receiver reconnected");
+}
+
+int main(void)
+{
+  rx.listener = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  if (rx.listener < 0 || bind(rx.listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(rx.listener, 1) != 0 ||
+      getsockname(rx.listener, (struct sockaddr *) &addr, &addr_len) != 0) {
+    printf("Couldn't listen on 127.0.0.1: errno %d\n", errno);
+    return 1;
+  }
+  fcntl(rx.listener, F_SETFL, O_NONBLOCK);
+
+  telemetry_config_t config = { "127.0.0.1", ntohs(addr.sin_port), FLUSH_INTERVAL_MS };
+  if (!telemetry_init(&config)) {
+    printf("telemetry_init failed\n");
+    return 1;
+  }
+
+  test_records();
+  test_coalescing();
+  test_full_ring();
+  test_reconnect();
+
+  printf("%s\n", failures ? "Telemetry loopback tests failed" : "Telemetry loopback tests passed");
+  return failures != 0;
+}
@@ -0,0 +1,127 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Receives the telemetry stream of one device at a time and prints a line per
+ * record, and the records lost in between:
+ *
+ *   ./telemetry_receiver [port]
+ *
+ * The port defaults to 3333, the one of TELEMETRY_PORT in esp_main.h. */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+static void print_record(const telemetry_record_t *r)
+{
+  printf("#%u t=%ums person=%u%% no_person=%u%%%s invoke=%uus arena=%u "
+         "skipped=%u dropped=%u lost=%u ops=[",
+         (unsigned) r->sequence, (unsigned) r->timestamp_ms, r->person_score, r->no_person_score,
+         (r->flags & TELEMETRY_FLAG_REUSED) ? " (reused)" : "", (unsigned) r->invoke_us,
+         (unsigned) r->arena_used, (unsigned) r->frames_skipped, (unsigned) r->frames_dropped,
+         (unsigned) r->records_lost);
+  for (int i = 0; i < r->num_ops; i++) {
+    printf(i ? " %u" : "%u", (unsigned) r->op_us[i]);
+  }
+  printf("]\n");
+}
+
+/* Prints the records of one connection until it closes */
+static void receive(int conn)
+{
+  static uint8_t buf[64 * 1024];
+  size_t len = 0;
+  bool started = false;
+  static bool have_next;
+  static uint32_t next_sequence;
+
+  while (true) {
+    ssize_t n = recv(conn, buf + len, sizeof(buf) - len, 0);
+    if (n <= 0) {
+      return;
+    }
+    len += n;
+    size_t pos = 0;
+    if (!started) {
+      if (len < TELEMETRY_MAGIC_SIZE) {
+        continue;
+      }
+      if (memcmp(buf, TELEMETRY_MAGIC, TELEMETRY_MAGIC_SIZE) != 0) {
+        printf("Not a telemetry stream\n");
+        return;
+      }
+      started = true;
+      pos = TELEMETRY_MAGIC_SIZE;
+    }
+    while (len - pos >= 2) {
+      size_t msg_len = buf[pos] << 8 | buf[pos + 1];
+      if (len - pos - 2 < msg_len) {
+        break;
+      }
+      telemetry_record_t record;
+      if (telemetry_decode(buf + pos + 2, msg_len, &record)) {
+        /* A sequence going backwards is a device that restarted */
+        if (have_next && record.sequence > next_sequence) {
+          printf("lost %u records\n", (unsigned) (record.sequence - next_sequence));
+        }
+        have_next = true;
+        next_sequence = record.sequence + 1;
+        print_record(&record);
+      }
+      pos += 2 + msg_len;
+    }
+    memmove(buf, buf + pos, len - pos);
+    len -= pos;
+    fflush(stdout);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int port = argc > 1 ? atoi(argv[1]) : 3333;
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (listener < 0 || bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(listener, 1) != 0) {
+    printf("Couldn't listen on port %d: errno %d\n", port, errno);
+    return 1;
+  }
+  while (true) {
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    int conn = accept(listener, (struct sockaddr *) &from, &from_len);
+    if (conn < 0) {
+      continue;
+    }
+    char name[INET_ADDRSTRLEN];
+    printf("Connection from %s\n", inet_ntop(AF_INET, &from.sin_addr, name, sizeof(name)));
+    receive(conn);
+    close(conn);
+    printf("Connection closed\n");
+  }
+}
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "app_camera_esp.h"
+#include "frame_source.h"
 
 static const char *TAG = "app_camera";
 
@@ -59,6 +60,15 @@ int app_camera_init() {
   config.fb_count = 1;
   config.grab_mode      = CAMERA_GRAB_WHEN_EMPTY;
   config.fb_location = CAMERA_FB_IN_PSRAM;
+#if CONFIG_CAMERA_DECIMATION_ENABLED && !DISPLAY_SUPPORT
+  /* The DMA filter box-averages the QVGA luma 2x2, so only a 160x120 Y8 frame
+   * is stored and it fits in internal RAM */
+  config.pixel_format = PIXFORMAT_GRAYSCALE;
+  config.fb_location = CAMERA_FB_IN_DRAM;
+  config.decimate_x = 2;
+  config.decimate_y = 2;
+  config.decimate_mode = CAMERA_DECIMATE_BOX;
+#endif
 
   // camera init
   esp_err_t err = esp_camera_init(&config);
@@ -76,3 +86,15 @@ int app_camera_init() {
   }
   return 0;
 }
+
+static int camera_source_init(const void *config) {
+  (void) config;
+  return app_camera_init();
+}
+
+const frame_source_t frame_source_camera = {
+  .name = "camera",
+  .init = camera_source_init,
+  .fb_get = esp_camera_fb_get,
+  .fb_return = esp_camera_fb_return,
+};
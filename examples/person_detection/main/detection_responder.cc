@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "detection_responder.h"
 #include "esp_main.h"
+#if defined(DETECTION_SNAPSHOTS)
+#include "model_settings.h"
+#include "snapshot_sender.h"
+#endif
 #if DISPLAY_SUPPORT
 #include "image_provider.h"
 #include "esp_lcd.h"
@@ -22,8 +26,32 @@ static QueueHandle_t xQueueLCDFrame = NULL;
 #endif
 
 void RespondToDetection(tflite::ErrorReporter* error_reporter,
-                        float person_score, float no_person_score) {
+                        float person_score, float no_person_score,
+                        const int8_t* image, ImageEncoding encoding) {
   int person_score_int = (person_score) * 100 + 0.5;
+#if defined(DETECTION_SNAPSHOTS)
+  if (image != nullptr && person_score_int >= SNAPSHOT_MIN_SCORE) {
+    // Never waits: while the last snapshot is still being sent this one is
+    // dropped
+    uint8_t* snapshot = snapshot_sender_acquire();
+    if (snapshot != nullptr) {
+      if (encoding == kImageSignedGray) {
+        for (int i = 0; i < kNumCols * kNumRows; i++) {
+          snapshot[i] = (uint8_t) image[i] ^ 0x80;
+        }
+      } else {
+        // Camera gray is 0..125, see image_preprocess.cc
+        for (int i = 0; i < kNumCols * kNumRows; i++) {
+          snapshot[i] = image[i] > 0 ? image[i] * 2 : 0;
+        }
+      }
+      snapshot_sender_commit(kNumCols, kNumRows, person_score_int);
+    }
+  }
+#else
+  (void) image;
+  (void) encoding;
+#endif
 #if DISPLAY_SUPPORT
   if (xQueueLCDFrame == NULL) {
     xQueueLCDFrame = xQueueCreate(2, sizeof(struct lcd_frame));
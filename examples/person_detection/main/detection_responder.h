@@ -28,7 +28,18 @@ limitations under the License.
 // does not contain a person. Typically if person_score > no person score, the
 // image is considered to contain a person.  This threshold may be adjusted for
 // particular applications.
+// `image` is the model input the scores were inferred from, or nullptr when
+// they were not inferred from a new frame. `encoding` says how its pixels map
+// to gray levels.
+enum ImageEncoding {
+  // Gray in 0..125, as image_preprocess.cc produces it from camera frames.
+  kImageCameraGray,
+  // Gray in -128..127, 8-bit images with the top bit flipped (CLI images).
+  kImageSignedGray,
+};
+
 void RespondToDetection(tflite::ErrorReporter* error_reporter,
-                        float person_score, float no_person_score);
+                        float person_score, float no_person_score,
+                        const int8_t* image, ImageEncoding encoding);
 
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_DETECTION_RESPONDER_H_
@@ -18,9 +18,59 @@
 // Enable this to get cpu stats
 #define COLLECT_CPU_STATS 1
 
+// Enable this to run the first ROW_STREAMING_OPS layers of the model in bands
+// of ROW_STREAMING_BAND_ROWS output rows, so their large activations never
+// exist at full size and the model fits a smaller arena, at the cost of
+// recomputing the rows bands share. Other settings can grow the arena instead,
+// check them with tools/arena_size -r
+//#define ROW_STREAMING_OPS 4
+#define ROW_STREAMING_BAND_ROWS 4
+
 #if !defined(CLI_ONLY_INFERENCE)
 // Enable this for display
 //#define DISPLAY_SUPPORT 1
+
+// Enable this to capture and preprocess the next frame in a separate task
+// while the current one is being inferred
+#define PIPELINED_INFERENCE 1
+
+// With PIPELINED_INFERENCE, replace a frame that was not inferred yet with the
+// newest one instead of stalling capture until it is consumed
+#define PIPELINE_DROP_OLDEST 1
+
+// Enable this to reuse the last scores instead of running inference while the
+// camera image does not change
+#define MOTION_GATED_INFERENCE 1
+
+// Enable this to replay frames from files instead of capturing them, e.g. to
+// compare preprocessing or model changes on a fixed sequence. A directory is
+// replayed file by file (raw RGB565/Y8 frames of FRAME_REPLAY_WIDTH x
+// FRAME_REPLAY_HEIGHT, or *.jpg), a single file as raw video.
+//#define FRAME_REPLAY_SOURCE 1
+#define FRAME_REPLAY_PATH "/sdcard/frames"
+#define FRAME_REPLAY_FORMAT PIXFORMAT_GRAYSCALE
+#define FRAME_REPLAY_WIDTH 96
+#define FRAME_REPLAY_HEIGHT 96
+#define FRAME_REPLAY_FPS 10
+
+// Enable this to send the model input as a JPEG to SNAPSHOT_HOST:SNAPSHOT_PORT
+// whenever the person score reaches SNAPSHOT_MIN_SCORE percent. A lower
+// priority task compresses and sends it a few rows at a time, snapshots that
+// come while one is being sent are dropped. See snapshot_sender.h.
+//#define DETECTION_SNAPSHOTS 1
+#define SNAPSHOT_HOST "192.168.1.165"
+#define SNAPSHOT_PORT 3334
+#define SNAPSHOT_MIN_SCORE 60
+#define SNAPSHOT_QUALITY 80
+
+// Enable this to stream a binary record per frame (scores, per-op timings,
+// arena usage, skipped and dropped frames) to TELEMETRY_HOST:TELEMETRY_PORT,
+// sent in batches by a lower priority task at most TELEMETRY_FLUSH_MS after
+// the frame. See telemetry.h and host/telemetry_receiver.c.
+#define DETECTION_TELEMETRY 1
+#define TELEMETRY_HOST "192.168.1.165"
+#define TELEMETRY_PORT 3333
+#define TELEMETRY_FLUSH_MS 500
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,74 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "frame_slot.h"
+
+#include <esp_heap_caps.h>
+
+bool FrameSlot::Init(size_t frame_size, size_t alignment, bool drop_oldest) {
+  drop_oldest_ = drop_oldest;
+  for (int i = 0; i < 3; i++) {
+    if (buffers_[i] == NULL) {
+      /* The first layer reads the frame in place, keep it in internal RAM */
+      buffers_[i] = (int8_t *) heap_caps_aligned_alloc(alignment, frame_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (buffers_[i] == NULL) {
+      buffers_[i] = (int8_t *) heap_caps_aligned_alloc(alignment, frame_size, MALLOC_CAP_8BIT);
+    }
+    if (buffers_[i] == NULL) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FrameSlot::Publish() {
+  if (!drop_oldest_) {
+    producer_task_.store(xTaskGetCurrentTaskHandle());
+    /* A notification given between the check and the take is not lost */
+    while (state_.load() & kFresh) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+
+  uint32_t old_state = state_.exchange(back_ | kFresh);
+  back_ = old_state & kIndexMask;
+  if (old_state & kFresh) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  TaskHandle_t consumer = consumer_task_.load();
+  if (consumer != NULL) {
+    xTaskNotifyGive(consumer);
+  }
+}
+
+int8_t* FrameSlot::Acquire() {
+  consumer_task_.store(xTaskGetCurrentTaskHandle());
+  while (!(state_.load() & kFresh)) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+
+  uint32_t old_state = state_.exchange(front_);
+  front_ = old_state & kIndexMask;
+
+  if (!drop_oldest_) {
+    TaskHandle_t producer = producer_task_.load();
+    if (producer != NULL) {
+      xTaskNotifyGive(producer);
+    }
+  }
+  return buffers_[front_];
+}
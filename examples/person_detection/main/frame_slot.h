@@ -0,0 +1,72 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Single-producer/single-consumer handoff of preprocessed frames between the
+// capture task and the inference task.
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SLOT_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SLOT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Triple buffer: the producer owns one buffer, the consumer owns another and
+// the third holds the most recently published frame. Ownership moves with a
+// single atomic exchange, so neither side ever takes a lock or copies a frame.
+//
+// With `drop_oldest` set, publishing while the previous frame has not been
+// consumed yet replaces it, so the consumer always gets the newest frame. When
+// cleared, the producer instead waits until the consumer has taken it.
+class FrameSlot {
+ public:
+  // Allocates the three frame buffers with `alignment`, so the consumer can
+  // hand them to the interpreter as input storage. Returns false when out of
+  // memory.
+  bool Init(size_t frame_size, size_t alignment, bool drop_oldest);
+
+  // Buffer the producer should fill next. Valid until Publish().
+  int8_t* producer_buffer() { return buffers_[back_]; }
+
+  // Hands the producer buffer over to the consumer.
+  void Publish();
+
+  // Waits for a published frame and returns it. The buffer stays valid until
+  // the next call.
+  int8_t* Acquire();
+
+  // Number of frames that were replaced before the consumer got to them.
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  // `state_` holds the index of the published buffer plus kFresh when it has
+  // not been consumed yet.
+  static constexpr uint32_t kIndexMask = 0x3;
+  static constexpr uint32_t kFresh = 0x4;
+
+  int8_t* buffers_[3] = {nullptr, nullptr, nullptr};
+  uint32_t back_ = 0;
+  uint32_t front_ = 1;
+  std::atomic<uint32_t> state_{2};
+  bool drop_oldest_ = true;
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<TaskHandle_t> producer_task_{nullptr};
+  std::atomic<TaskHandle_t> consumer_task_{nullptr};
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SLOT_H_
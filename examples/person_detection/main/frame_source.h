@@ -0,0 +1,68 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SOURCE_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SOURCE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_camera.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Where the image provider gets its frames from. Both backends hand out
+ * camera_fb_t, so the preprocessing and everything after it run unchanged
+ * whether the frames come from the sensor or are replayed from files.
+ */
+typedef struct {
+  const char *name;
+  /* Returns 0 on success, `config` is backend specific */
+  int (*init)(const void *config);
+  /* Blocks until the next frame is due, NULL on error or end of stream */
+  camera_fb_t *(*fb_get)(void);
+  /* Gives the frame back, at most one frame is outstanding */
+  void (*fb_return)(camera_fb_t *fb);
+} frame_source_t;
+
+/* esp_camera driver, `config` is ignored */
+extern const frame_source_t frame_source_camera;
+
+typedef struct {
+  /**
+   * A directory is replayed file by file in name order: .jpg and .jpeg files
+   * as JPEG frames, files of the raw frame size as one raw frame of `format`,
+   * anything else is skipped. A regular file is replayed as raw video, i.e.
+   * back to back raw frames.
+   */
+  const char *path;
+  pixformat_t format;   /* PIXFORMAT_RGB565 (big endian) or PIXFORMAT_GRAYSCALE */
+  size_t width;         /* Raw frame size */
+  size_t height;
+  float fps;            /* Frame rate to pace fb_get() to, 0 = as fast as possible */
+  bool loop;            /* Start over at the end instead of returning NULL */
+} frame_source_file_config_t;
+
+/* Frame files, `config` is a frame_source_file_config_t */
+extern const frame_source_t frame_source_file;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_FRAME_SOURCE_H_
@@ -0,0 +1,317 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Replays frames from files, on the device (e.g. from an SD card) or on a
+ * Linux host. Only POSIX file and clock calls are used. */
+
+#include "frame_source.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+static const char *TAG = "frame_source_file";
+
+static struct {
+  frame_source_file_config_t config;
+  size_t frame_size;      /* Bytes of one raw frame */
+  char **files;           /* Directory entries in name order */
+  size_t num_files;
+  size_t next_file;
+  FILE *video;            /* Raw video file, when not replaying a directory */
+  camera_fb_t fb;
+  size_t capacity;        /* Allocated bytes of fb.buf */
+  bool outstanding;
+  int64_t due_us;         /* When the next frame is due, 0 before the first */
+} source;
+
+static int64_t monotonic_us(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/* Keeps frames config.fps apart. A consumer that falls behind restarts the
+ * schedule instead of getting a burst of frames to catch up, as a camera
+ * would drop them. */
+static void wait_until_due(void)
+{
+  if (source.config.fps <= 0) {
+    return;
+  }
+  const int64_t period_us = (int64_t) (1000000 / source.config.fps);
+  int64_t now_us = monotonic_us();
+  if (source.due_us == 0 || now_us - source.due_us > period_us) {
+    source.due_us = now_us;
+  } else if (source.due_us > now_us) {
+    usleep((useconds_t) (source.due_us - now_us));
+  }
+  source.due_us += period_us;
+}
+
+static bool reserve(size_t size)
+{
+  if (size <= source.capacity) {
+    return true;
+  }
+  uint8_t *buf = (uint8_t *) realloc(source.fb.buf, size);
+  if (buf == NULL) {
+    ESP_LOGE(TAG, "Couldn't allocate %u bytes for a frame", (unsigned) size);
+    return false;
+  }
+  source.fb.buf = buf;
+  source.capacity = size;
+  return true;
+}
+
+/* Frame size from the SOF0..SOF2 header, the ones the JPEG decoder handles */
+static bool jpeg_size(const uint8_t *buf, size_t len, size_t *width, size_t *height)
+{
+  if (len < 4 || buf[0] != 0xFF || buf[1] != 0xD8) {
+    return false;
+  }
+  size_t i = 2;
+  while (i + 4 <= len && buf[i] == 0xFF) {
+    uint8_t marker = buf[i + 1];
+    if (marker == 0xFF) {
+      i++;
+      continue;
+    }
+    if (marker >= 0xC0 && marker <= 0xC2) {
+      if (i + 9 > len) {
+        return false;
+      }
+      *height = (buf[i + 5] << 8) | buf[i + 6];
+      *width = (buf[i + 7] << 8) | buf[i + 8];
+      return true;
+    }
+    i += 2 + ((buf[i + 2] << 8) | buf[i + 3]);
+  }
+  return false;
+}
+
+static bool is_jpeg_name(const char *name)
+{
+  const char *ext = strrchr(name, '.');
+  return ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0);
+}
+
+static bool load_file(const char *name)
+{
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", source.config.path, name);
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    ESP_LOGE(TAG, "Couldn't open %s", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  bool ok = len > 0 && reserve((size_t) len) &&
+            fread(source.fb.buf, 1, (size_t) len, f) == (size_t) len;
+  fclose(f);
+  if (!ok) {
+    ESP_LOGE(TAG, "Couldn't read %s", path);
+    return false;
+  }
+
+  source.fb.len = (size_t) len;
+  if (is_jpeg_name(name)) {
+    source.fb.format = PIXFORMAT_JPEG;
+    if (!jpeg_size(source.fb.buf, source.fb.len, &source.fb.width, &source.fb.height)) {
+      ESP_LOGE(TAG, "%s: no baseline or progressive JPEG header", path);
+      return false;
+    }
+    return true;
+  }
+  if (source.fb.len != source.frame_size) {
+    ESP_LOGE(TAG, "%s: %u bytes, a %ux%u frame has %u", path, (unsigned) source.fb.len,
+             (unsigned) source.config.width, (unsigned) source.config.height,
+             (unsigned) source.frame_size);
+    return false;
+  }
+  source.fb.format = source.config.format;
+  source.fb.width = source.config.width;
+  source.fb.height = source.config.height;
+  return true;
+}
+
+static bool read_video_frame(void)
+{
+  if (!reserve(source.frame_size)) {
+    return false;
+  }
+  size_t n = fread(source.fb.buf, 1, source.frame_size, source.video);
+  if (n != source.frame_size && source.config.loop && n == 0) {
+    rewind(source.video);
+    n = fread(source.fb.buf, 1, source.frame_size, source.video);
+  }
+  if (n != source.frame_size) {
+    return false;
+  }
+  source.fb.len = source.frame_size;
+  source.fb.format = source.config.format;
+  source.fb.width = source.config.width;
+  source.fb.height = source.config.height;
+  return true;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+  return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static bool list_directory(const char *path)
+{
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    return false;
+  }
+  size_t capacity = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char file[256];
+    struct stat st;
+    snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+    if (stat(file, &st) != 0 || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    if (!is_jpeg_name(entry->d_name) && (size_t) st.st_size != source.frame_size) {
+      ESP_LOGW(TAG, "Skipping %s, neither a JPEG nor a raw frame", entry->d_name);
+      continue;
+    }
+    if (source.num_files == capacity) {
+      capacity = capacity ? 2 * capacity : 16;
+      char **files = (char **) realloc(source.files, capacity * sizeof(char *));
+      if (files == NULL) {
+        break;
+      }
+      source.files = files;
+    }
+    source.files[source.num_files] = strdup(entry->d_name);
+    if (source.files[source.num_files] == NULL) {
+      break;
+    }
+    source.num_files++;
+  }
+  closedir(dir);
+  qsort(source.files, source.num_files, sizeof(char *), compare_names);
+  return true;
+}
+
+static void release(void)
+{
+  for (size_t i = 0; i < source.num_files; i++) {
+    free(source.files[i]);
+  }
+  free(source.files);
+  if (source.video) {
+    fclose(source.video);
+  }
+  free(source.fb.buf);
+  memset(&source, 0, sizeof(source));
+}
+
+static int file_init(const void *config)
+{
+  release();
+  source.config = *(const frame_source_file_config_t *) config;
+
+  size_t bytes_per_pixel = 0;
+  if (source.config.format == PIXFORMAT_RGB565) {
+    bytes_per_pixel = 2;
+  } else if (source.config.format == PIXFORMAT_GRAYSCALE) {
+    bytes_per_pixel = 1;
+  }
+  source.frame_size = source.config.width * source.config.height * bytes_per_pixel;
+
+  struct stat st;
+  if (source.config.path == NULL || stat(source.config.path, &st) != 0) {
+    ESP_LOGE(TAG, "Couldn't find %s", source.config.path ? source.config.path : "(null)");
+    return -1;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    if (!list_directory(source.config.path) || source.num_files == 0) {
+      ESP_LOGE(TAG, "No frames in %s", source.config.path);
+      return -1;
+    }
+    ESP_LOGI(TAG, "Replaying %u files from %s", (unsigned) source.num_files, source.config.path);
+    return 0;
+  }
+
+  if (source.frame_size == 0) {
+    ESP_LOGE(TAG, "Raw video needs a size and a RGB565 or GRAYSCALE format");
+    return -1;
+  }
+  source.video = fopen(source.config.path, "rb");
+  if (source.video == NULL) {
+    ESP_LOGE(TAG, "Couldn't open %s", source.config.path);
+    return -1;
+  }
+  ESP_LOGI(TAG, "Replaying %u frames from %s", (unsigned) (st.st_size / source.frame_size),
+           source.config.path);
+  return 0;
+}
+
+static camera_fb_t *file_fb_get(void)
+{
+  if (source.outstanding) {
+    ESP_LOGE(TAG, "Previous frame was not returned");
+    return NULL;
+  }
+  bool ok;
+  if (source.video) {
+    ok = read_video_frame();
+  } else {
+    if (source.next_file == source.num_files && source.config.loop) {
+      source.next_file = 0;
+    }
+    ok = source.next_file < source.num_files && load_file(source.files[source.next_file++]);
+  }
+  if (!ok) {
+    return NULL;
+  }
+  wait_until_due();
+  gettimeofday(&source.fb.timestamp, NULL);
+  source.outstanding = true;
+  return &source.fb;
+}
+
+static void file_fb_return(camera_fb_t *fb)
+{
+  (void) fb;
+  source.outstanding = false;
+}
+
+const frame_source_t frame_source_file = {
+  .name = "file",
+  .init = file_init,
+  .fb_get = file_fb_get,
+  .fb_return = file_fb_return,
+};
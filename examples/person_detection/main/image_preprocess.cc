@@ -0,0 +1,265 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "image_preprocess.h"
+
+#include <cstring>
+
+#include "esp_jpg_decode.h"
+#include "model_settings.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+/* Source window of every output column/row and the fixed-point reciprocal of
+ * every window area. Rebuilt only when the camera frame geometry changes. */
+#define RECIP_SHIFT 24
+#define MAX_BOX_AREA 64
+
+typedef struct {
+    size_t width;
+    size_t height;
+    uint16_t col_start[kNumCols + 1];
+    uint16_t row_start[kNumRows + 1];
+    uint32_t recip[MAX_BOX_AREA + 1];
+} downscale_plan_t;
+
+static downscale_plan_t downscale_plan;
+static uint32_t box_acc[kNumCols];
+
+/* Split [0, src) into `dst` nearly equal windows, so non-integer ratios
+ * (e.g. 320 -> 96) still cover the whole frame. */
+static void split_range(size_t src, int dst, uint16_t* start) {
+    for (int i = 0; i <= dst; i++) {
+        start[i] = (uint16_t) ((src * i) / dst);
+    }
+}
+
+static bool build_downscale_plan(size_t width, size_t height) {
+    if (downscale_plan.width == width && downscale_plan.height == height) {
+        return true;
+    }
+    if (width < kNumCols || height < kNumRows) {
+        return false;
+    }
+    /* ceil(width / 96) * ceil(height / 96) bounds every window area */
+    size_t max_area = ((width + kNumCols - 1) / kNumCols) *
+                      ((height + kNumRows - 1) / kNumRows);
+    if (max_area > MAX_BOX_AREA) {
+        return false;
+    }
+    split_range(width, kNumCols, downscale_plan.col_start);
+    split_range(height, kNumRows, downscale_plan.row_start);
+
+    /* ceil(2^24 / area) makes (sum * recip) >> 24 equal sum / area for every
+     * sum < 2^24 / area, which the 0..125 gray and 0..255 Y8 ranges satisfy. */
+    downscale_plan.recip[0] = 0;
+    for (uint32_t area = 1; area <= MAX_BOX_AREA; area++) {
+        downscale_plan.recip[area] = ((1u << RECIP_SHIFT) + area - 1) / area;
+    }
+    downscale_plan.width = width;
+    downscale_plan.height = height;
+    return true;
+}
+
+/* Single streaming pass: every RGB565 source pixel is read once, converted to
+ * gray and added to the box of its output column. When the last source row of
+ * an output row has been consumed, the 96 box sums are normalised and written
+ * straight into the model input. Y8 frames from the decimating camera driver
+ * are averaged the same way and scaled down to the 0..125 RGB565 gray range. */
+static TfLiteStatus grayscale_downscale(const camera_fb_t* pic, int8_t* ret_buffer) {
+    if (!build_downscale_plan(pic->width, pic->height)) {
+        MicroPrintf("Unsupported frame size %dx%d", (int) pic->width, (int) pic->height);
+        return kTfLiteError;
+    }
+    const downscale_plan_t* plan = &downscale_plan;
+    const bool y8 = pic->format == PIXFORMAT_GRAYSCALE;
+    const size_t stride = pic->width * (y8 ? 1 : 2);
+
+    for (int row = 0; row < kNumRows; row++) {
+        const uint32_t row_start = plan->row_start[row];
+        const uint32_t row_end = plan->row_start[row + 1];
+        memset(box_acc, 0, sizeof(box_acc));
+
+        for (uint32_t r = row_start; r < row_end; r++) {
+            const uint8_t* src = pic->buf + r * stride;
+            if (y8) {
+                for (int col = 0; col < kNumCols; col++) {
+                    const uint8_t* end = pic->buf + r * stride + plan->col_start[col + 1];
+                    uint32_t sum = 0;
+                    for (; src < end; src++) {
+                        sum += *src;
+                    }
+                    box_acc[col] += sum;
+                }
+                continue;
+            }
+            for (int col = 0; col < kNumCols; col++) {
+                const uint8_t* end = pic->buf + r * stride + plan->col_start[col + 1] * 2;
+                uint32_t sum = 0;
+                for (; src < end; src += 2) {
+                    uint16_t pixel = (src[0] << 8) | src[1];
+                    sum += (pixel >> 11) + ((pixel >> 5) & 0x3F) + (pixel & 0x1F);
+                }
+                box_acc[col] += sum;
+            }
+        }
+
+        const uint32_t box_height = row_end - row_start;
+        int8_t* dst = ret_buffer + row * kNumCols;
+        for (int col = 0; col < kNumCols; col++) {
+            uint32_t area = box_height * (plan->col_start[col + 1] - plan->col_start[col]);
+            uint32_t mean = (box_acc[col] * plan->recip[area]) >> RECIP_SHIFT;
+            /* 251 / 512 ~= 125 / 255 */
+            dst[col] = (int8_t) (y8 ? (mean * 251) >> 9 : mean);
+        }
+    }
+    return kTfLiteOk;
+}
+
+/* Box filter fed by the JPEG decoder. The luma of each MCU arrives as one
+ * block and the blocks of an MCU row arrive left to right, so every decoded
+ * pixel is added straight to the box of its output row and column. Only the
+ * output rows an MCU row spans (at most 16) are live at a time; they are
+ * written into the model input as soon as the MCU row holding their last
+ * source row is done. Everything is fixed size, a frame decodes without
+ * allocating. */
+#define JPEG_MAX_SIZE (kNumCols * 4)
+#define JPEG_ACC_ROWS 16
+
+typedef struct {
+    const camera_fb_t* jpeg;
+    int8_t* out;
+    size_t width;
+    size_t height;
+    uint8_t col_index[JPEG_MAX_SIZE];
+    uint8_t row_index[JPEG_MAX_SIZE];
+    /* 64 * 255 fits, build_downscale_plan() bounds the box area */
+    uint16_t acc[JPEG_ACC_ROWS][kNumCols];
+    int next_row;
+    bool failed;
+} jpeg_box_t;
+
+static jpeg_box_t jpeg_box;
+
+static size_t jpeg_read(void* arg, size_t index, uint8_t* buf, size_t len) {
+    const camera_fb_t* fb = ((jpeg_box_t*) arg)->jpeg;
+    /* a NULL buf asks to skip len bytes */
+    if (buf) {
+        memcpy(buf, fb->buf + index, len);
+    }
+    return len;
+}
+
+static bool jpeg_start(jpeg_box_t* box, uint16_t width, uint16_t height) {
+    if (width > JPEG_MAX_SIZE || height > JPEG_MAX_SIZE ||
+        !build_downscale_plan(width, height)) {
+        MicroPrintf("Unsupported decoded JPEG size %dx%d", width, height);
+        return false;
+    }
+    if (box->width != width || box->height != height) {
+        for (int col = 0; col < kNumCols; col++) {
+            memset(&box->col_index[downscale_plan.col_start[col]], col,
+                   downscale_plan.col_start[col + 1] - downscale_plan.col_start[col]);
+        }
+        for (int row = 0; row < kNumRows; row++) {
+            memset(&box->row_index[downscale_plan.row_start[row]], row,
+                   downscale_plan.row_start[row + 1] - downscale_plan.row_start[row]);
+        }
+        box->width = width;
+        box->height = height;
+    }
+    memset(box->acc, 0, sizeof(box->acc));
+    box->next_row = 0;
+    return true;
+}
+
+/* Writes the output rows whose last source row is above `y` */
+static void jpeg_flush_rows(jpeg_box_t* box, uint32_t y) {
+    const downscale_plan_t* plan = &downscale_plan;
+    for (; box->next_row < kNumRows && plan->row_start[box->next_row + 1] <= y; box->next_row++) {
+        const int row = box->next_row;
+        const uint32_t box_height = plan->row_start[row + 1] - plan->row_start[row];
+        uint16_t* acc = box->acc[row % JPEG_ACC_ROWS];
+        int8_t* dst = box->out + row * kNumCols;
+        for (int col = 0; col < kNumCols; col++) {
+            uint32_t area = box_height * (plan->col_start[col + 1] - plan->col_start[col]);
+            uint32_t mean = (acc[col] * plan->recip[area]) >> RECIP_SHIFT;
+            /* 251 / 512 ~= 125 / 255, the RGB565 gray range */
+            dst[col] = (int8_t) ((mean * 251) >> 9);
+        }
+        memset(acc, 0, sizeof(box->acc[0]));
+    }
+}
+
+static bool jpeg_write(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    jpeg_box_t* box = (jpeg_box_t*) arg;
+    if (!data) {
+        if (x == 0 && y == 0) {
+            /* start of frame, w x h is the scaled output size */
+            box->failed = !jpeg_start(box, w, h);
+        } else if (!box->failed) {
+            /* end of frame */
+            box->failed = box->next_row != kNumRows;
+        }
+        return !box->failed;
+    }
+    if (x + w > box->width || y + h > box->height) {
+        box->failed = true;
+        return false;
+    }
+    for (uint16_t r = 0; r < h; r++, data += w) {
+        uint16_t* acc = box->acc[box->row_index[y + r] % JPEG_ACC_ROWS];
+        const uint8_t* col_index = &box->col_index[x];
+        for (uint16_t c = 0; c < w; c++) {
+            acc[col_index[c]] += data[c];
+        }
+    }
+    if (x + w == box->width) {
+        jpeg_flush_rows(box, y + h);
+    }
+    return true;
+}
+
+/* Decodes at the smallest size that is still at least kNumCols x kNumRows:
+ * the decoder's 1/2, 1/4 and 1/8 scaling skips most of the IDCT work, and the
+ * box filter averages whatever is left. Only the luma is decoded. */
+static TfLiteStatus jpeg_downscale(const camera_fb_t* pic, int8_t* ret_buffer) {
+    int scale = JPG_SCALE_NONE;
+    while (scale < JPG_SCALE_MAX &&
+           (pic->width >> (scale + 1)) >= kNumCols &&
+           (pic->height >> (scale + 1)) >= kNumRows) {
+        scale++;
+    }
+    jpeg_box.jpeg = pic;
+    jpeg_box.out = ret_buffer;
+    esp_err_t err = esp_jpg_decode_gray(pic->len, (jpg_scale_t) scale, jpeg_read, jpeg_write, &jpeg_box);
+    if (err != ESP_OK || jpeg_box.failed) {
+        MicroPrintf("JPEG decode failed");
+        return kTfLiteError;
+    }
+    return kTfLiteOk;
+}
+
+TfLiteStatus PreprocessFrame(const camera_fb_t* fb, int8_t* image_data) {
+    switch (fb->format) {
+    case PIXFORMAT_RGB565:
+    case PIXFORMAT_GRAYSCALE:
+        return grayscale_downscale(fb, image_data);
+    case PIXFORMAT_JPEG:
+        return jpeg_downscale(fb, image_data);
+    default:
+        MicroPrintf("Unsupported pixel format %d", (int) fb->format);
+        return kTfLiteError;
+    }
+}
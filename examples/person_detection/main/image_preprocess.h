@@ -0,0 +1,34 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Conversion of a camera frame into the model input. It only touches memory,
+// so it is shared by the camera image provider and the host replay tool.
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_IMAGE_PREPROCESS_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_IMAGE_PREPROCESS_H_
+
+#include <cstdint>
+
+#include "esp_camera.h"
+#include "tensorflow/lite/c/common.h"
+
+// Converts `fb` to gray and box-averages it down to kNumCols x kNumRows into
+// `image_data`. RGB565 and Y8 frames are read in place. Only the luma of JPEG
+// frames is decoded, at the smallest scale that still covers the model input,
+// and averaged block by block as it is decoded, without a frame buffer.
+// Frames whose averaging box would exceed 8x8 source pixels are rejected.
+TfLiteStatus PreprocessFrame(const camera_fb_t* fb, int8_t* image_data);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_IMAGE_PREPROCESS_H_
@@ -26,7 +26,9 @@ limitations under the License.
 
 #include "app_camera_esp.h"
 #include "esp_camera.h"
+#include "frame_source.h"
 #include "model_settings.h"
+#include "image_preprocess.h"
 #include "image_provider.h"
 #include "esp_main.h"
 
@@ -42,7 +44,9 @@ static const char* TAG = "app_camera";
 
 static uint16_t *display_buf; // buffer to hold data to be sent to display
 
-#if SAVE_IMAGE
+static const frame_source_t *frame_source;
+
+#if SAVE_IMAGE || FRAME_REPLAY_SOURCE
 static void init_sdcard() {
   esp_err_t ret = ESP_FAIL;
 
@@ -85,7 +89,7 @@ static void init_sdcard() {
 
 // Get the camera module ready
 TfLiteStatus InitCamera(tflite::ErrorReporter* error_reporter) {
-#if SAVE_IMAGE
+#if SAVE_IMAGE || FRAME_REPLAY_SOURCE
   init_sdcard();
 #endif
 #if CLI_ONLY_INFERENCE
@@ -103,7 +107,20 @@ TfLiteStatus InitCamera(tflite::ErrorReporter* error_reporter) {
   }
 #endif
 
-  int ret = app_camera_init();
+#if FRAME_REPLAY_SOURCE
+  static frame_source_file_config_t replay_config;
+  replay_config.path = FRAME_REPLAY_PATH;
+  replay_config.format = FRAME_REPLAY_FORMAT;
+  replay_config.width = FRAME_REPLAY_WIDTH;
+  replay_config.height = FRAME_REPLAY_HEIGHT;
+  replay_config.fps = FRAME_REPLAY_FPS;
+  replay_config.loop = true;
+  frame_source = &frame_source_file;
+  int ret = frame_source->init(&replay_config);
+#else
+  frame_source = &frame_source_camera;
+  int ret = frame_source->init(NULL);
+#endif
   if (ret != 0) {
     TF_LITE_REPORT_ERROR(error_reporter, "Camera init failed\n");
     return kTfLiteError;
@@ -112,70 +129,6 @@ TfLiteStatus InitCamera(tflite::ErrorReporter* error_reporter) {
   return kTfLiteOk;
 }
 
-/* Stores downscaled image */
-typedef struct  {
-    uint8_t* grayscale;
-    //uint8_t* downscaled;
-    size_t len;
-    size_t width;
-    size_t height;
-} processed_img_t;
-
-/* Convert to gray scale from original image*/
-void grayscale(camera_fb_t* pic, processed_img_t* downscaled_pic) {
-    //downscaled_pic->grayscale = heap_caps_malloc(pic->len / 2, MALLOC_CAP_SPIRAM);
-    printf("Grayscaling\n");
-    int index = 0;
-    for(int i = 0; i < pic->len / 2; i++) {
-        uint16_t pixel = (pic->buf[index]);
-        pixel = (pixel << 8) + pic->buf[index+1];
-        index +=2;
-
-        uint8_t red =   (pixel & 0b1111100000000000) >> 11;
-        uint8_t green = (pixel & 0b0000011111100000) >> 5;
-        uint8_t blue =  (pixel & 0b0000000000011111);
-
-        uint8_t gray = red + green + blue;
-
-        downscaled_pic->grayscale[i] = (gray);
-    }
-    downscaled_pic->width = pic->width;
-    downscaled_pic->height = pic->height;
-    downscaled_pic->len = pic->width * pic->height;
-}
-
-/* Downscale after gray scale image */
-void downscale_post_grayscale(processed_img_t* downscaled_img, int8_t* ret_buffer) {
-    /* allocate space for 96 x 96 byte image*/
-    printf("Downscale \n");
-    uint8_t row_pix = downscaled_img->height / 96;  // 480 -> 5
-    uint8_t col_pix = downscaled_img->width / 96;
-
-    size_t width = downscaled_img->width;
-    size_t height = downscaled_img->height;
-
-    uint32_t pixel_window_size = row_pix * col_pix;
-
-    for(int row = 0; row < 96; row ++) {
-        uint32_t downscaled_row_index = 96 * row;
-        for(int col = 0; col < 96; col++) {
-            uint32_t row_start = row * row_pix;
-            uint32_t row_end = (row * row_pix) + row_pix;
-            uint32_t col_start = col * col_pix;
-            uint32_t col_end = (col * col_pix) + col_pix;
-            uint64_t sum = 0;
-
-            for(int r = row_start; r < row_end; r ++) {
-                uint32_t row_index = r * width;
-                for(int c = col_start; c < col_end; c++) {
-                    sum += downscaled_img->grayscale[row_index + c];
-                }
-            }
-            ret_buffer[downscaled_row_index + col] = sum / pixel_window_size;
-        }
-    }
-}
-
 #if SAVE_IMAGE
 uint64_t counterbmp2 =0;
 void save_PGM_file_downscaled (int8_t* downscaled_img) {
@@ -209,19 +162,14 @@ void save_PGM_file_downscaled (int8_t* downscaled_img) {
 }
 #endif
 
-void process_image(camera_fb_t* fb, int8_t* return_img) {
-  processed_img_t processed_img;
-  processed_img.grayscale = (uint8_t*) malloc(fb->width * fb->height);
-  /* Grayscale image */
-  grayscale(fb, &processed_img);
-  /* Downscale image */
-  downscale_post_grayscale(&processed_img, return_img);
-  /* Free grayscale buffer */
-  free(processed_img.grayscale);
-  
+TfLiteStatus process_image(camera_fb_t* fb, int8_t* return_img) {
+  /* Grayscale and downscale image in one pass */
+  TfLiteStatus ret = PreprocessFrame(fb, return_img);
+
 #if SAVE_IMAGE
   save_PGM_file_downscaled(return_img);
 #endif
+  return ret;
 }
 
 void *image_provider_get_display_buf()
@@ -232,7 +180,7 @@ void *image_provider_get_display_buf()
 // Get an image from the camera module
 TfLiteStatus GetImage(tflite::ErrorReporter* error_reporter, int image_width,
                       int image_height, int channels, int8_t* image_data) {
-  camera_fb_t* fb = esp_camera_fb_get();
+  camera_fb_t* fb = frame_source->fb_get();
   if (!fb) {
     ESP_LOGE(TAG, "Camera capture failed");
     return kTfLiteError;
@@ -272,7 +220,11 @@ TfLiteStatus GetImage(tflite::ErrorReporter* error_reporter, int image_width,
   TF_LITE_REPORT_ERROR(error_reporter, "Image Captured\n");
 
   /* Pre process image into grayscale */
-  process_image(fb, image_data);
+  TfLiteStatus status = process_image(fb, image_data);
+  if (status != kTfLiteOk) {
+    frame_source->fb_return(fb);
+    return status;
+  }
   TF_LITE_REPORT_ERROR(error_reporter, "Processing Completed\n");
 
   // We have initialised camera to grayscale
@@ -282,7 +234,7 @@ TfLiteStatus GetImage(tflite::ErrorReporter* error_reporter, int image_width,
   // }
 #endif
 
-  esp_camera_fb_return(fb);
+  frame_source->fb_return(fb);
   /* here the esp camera can give you grayscale image directly */
   return kTfLiteOk;
 }
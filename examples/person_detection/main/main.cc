@@ -18,7 +18,6 @@ limitations under the License.
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "networking.c"
 #include "nvs_flash.h"
 #include "esp_netif.h"
 #include "protocol_examples_common.h"
@@ -28,6 +27,13 @@ limitations under the License.
 #if CLI_ONLY_INFERENCE
 #include "esp_cli.h"
 #endif
+#if defined(DETECTION_SNAPSHOTS)
+#include "model_settings.h"
+#include "snapshot_sender.h"
+#endif
+#if defined(DETECTION_TELEMETRY)
+#include "telemetry.h"
+#endif
 
 void tf_main(void) {
   setup();
@@ -42,13 +48,46 @@ void tf_main(void) {
 #endif
 }
 
+#if defined(DETECTION_SNAPSHOTS)
+// Runs below tf_main, which preempts it whenever a frame is ready. Waits a
+// tick after every step so the idle task and the watchdog get to run.
+static void snapshot_task(void*) {
+  while (true) {
+    vTaskDelay(snapshot_sender_poll() ? 1 : pdMS_TO_TICKS(20));
+  }
+}
+#endif
+
+#if defined(DETECTION_TELEMETRY)
+// Runs below tf_main like snapshot_task. Records wait in the ring for up to
+// TELEMETRY_FLUSH_MS anyway, so polling every 20 ms is plenty.
+static void telemetry_task(void*) {
+  while (true) {
+    vTaskDelay(telemetry_poll() ? 1 : pdMS_TO_TICKS(20));
+  }
+}
+#endif
+
 extern "C" void app_main() {
   ESP_ERROR_CHECK(nvs_flash_init());
   ESP_ERROR_CHECK(esp_netif_init());
   ESP_ERROR_CHECK(esp_event_loop_create_default());
   ESP_ERROR_CHECK(example_connect());
 
-  xTaskCreate(network_client, "tcp_client", 4096, NULL, 5, NULL);
+#if defined(DETECTION_TELEMETRY)
+  telemetry_config_t telemetry_config = {TELEMETRY_HOST, TELEMETRY_PORT,
+                                         TELEMETRY_FLUSH_MS};
+  if (telemetry_init(&telemetry_config)) {
+    xTaskCreate(telemetry_task, "telemetry", 3072, NULL, 4, NULL);
+  }
+#endif
+#if defined(DETECTION_SNAPSHOTS)
+  snapshot_sender_config_t snapshot_config = {
+      SNAPSHOT_HOST, SNAPSHOT_PORT, kNumCols, kNumRows, SNAPSHOT_QUALITY};
+  if (snapshot_sender_init(&snapshot_config)) {
+    xTaskCreate(snapshot_task, "snapshot", 4096, NULL, 4, NULL);
+  }
+#endif
   xTaskCreate((TaskFunction_t)&tf_main, "tf_main", 4 * 1024, NULL, 8, NULL);
   vTaskDelete(NULL);
 }
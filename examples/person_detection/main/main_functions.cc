@@ -16,17 +16,29 @@ limitations under the License.
 #include "main_functions.h"
 
 #include "detection_responder.h"
+#include "frame_slot.h"
 #include "image_provider.h"
 #include "model_settings.h"
+#include "motion_gate.h"
 #include "person_detect_model_data.h"
+#include "telemetry.h"
+#include "tensorflow/lite/micro/memory_planner/cached_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_node_profiler.h"
 #include "tensorflow/lite/schema/schema_generated.h"
+#if __has_include("person_detect_op_resolver.h")
+#include "person_detect_op_resolver.h"
+#endif
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <cstring>
+
 #include <esp_heap_caps.h>
 #include <esp_timer.h>
 #include <esp_log.h>
@@ -46,14 +58,139 @@ TfLiteTensor* input = nullptr;
 // signed 8-bit integers is to subtract 128 from the unsigned value to get a
 // signed value.
 
+// An area of memory to use for input, output, and intermediate arrays. It is
+// sized exactly when person_detect_arena_size.h has been generated for the
+// model and the esp-nn kernels of this build by
+// tensorflow/lite/micro/tools/arena_size, and by a rough estimate otherwise.
+// With ROW_STREAMING_OPS, the header has to be generated with
+// -r ROW_STREAMING_OPS:ROW_STREAMING_BAND_ROWS.
+#if __has_include("person_detect_arena_size.h")
+#include "person_detect_arena_size.h"
+#if defined(CONFIG_NN_ANSI_C)
+#if !defined(ARENA_SIZE_ESP_NN_ANSI)
+#error "person_detect_arena_size.h was not generated for ESP_NN_TARGET=ansi"
+#endif
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+#if !defined(ARENA_SIZE_ESP_NN_ESP32S3)
+#error "person_detect_arena_size.h was not generated for ESP_NN_TARGET=esp32s3"
+#endif
+#elif !defined(ARENA_SIZE_ESP_NN_GENERIC)
+#error "person_detect_arena_size.h was not generated for ESP_NN_TARGET=generic"
+#endif
+#if defined(CONFIG_NN_MULTICORE) != ARENA_SIZE_ESP_NN_MULTICORE
+#error "person_detect_arena_size.h does not match CONFIG_NN_MULTICORE"
+#endif
+#if (ARENA_SIZE_ROW_STREAMING_OPS + 0) != (ROW_STREAMING_OPS + 0) || \
+    (defined(ROW_STREAMING_OPS) && \
+     ARENA_SIZE_ROW_STREAMING_BAND_ROWS != ROW_STREAMING_BAND_ROWS)
+#error "person_detect_arena_size.h does not match ROW_STREAMING_OPS"
+#endif
+constexpr int kTensorArenaSize = kArenaMinimumSize;
+#else
 #ifdef CONFIG_IDF_TARGET_ESP32S3
 constexpr int scratchBufSize = 39 * 1024;
 #else
 constexpr int scratchBufSize = 0;
 #endif
-// An area of memory to use for input, output, and intermediate arrays.
 constexpr int kTensorArenaSize = 81 * 1024 + scratchBufSize;
+#endif
 static uint8_t *tensor_arena;//[kTensorArenaSize]; // Maybe we should move this to external
+
+#if defined(PIPELINED_INFERENCE)
+#ifdef PIPELINE_DROP_OLDEST
+constexpr bool kPipelineDropOldest = true;
+#else
+constexpr bool kPipelineDropOldest = false;
+#endif
+// Capture is pinned next to the Wi-Fi stack so the unpinned inference task
+// normally gets the other core to itself.
+constexpr BaseType_t kCaptureCore = 0;
+FrameSlot frame_slot;
+
+// Producer side of the pipeline: grabs and preprocesses frame N+1 while
+// loop() runs inference on frame N.
+void capture_task(void *arg) {
+  while (true) {
+    if (kTfLiteOk != GetImage(error_reporter, kNumCols, kNumRows, kNumChannels,
+                              frame_slot.producer_buffer())) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Image capture failed.");
+      vTaskDelay(1);
+      continue;
+    }
+    frame_slot.Publish();
+  }
+}
+#endif
+
+#if defined(MOTION_GATED_INFERENCE)
+// An 8x8 block differing by more than ~4 grey levels per pixel, out of the
+// 0..125 the preprocessing produces, counts as motion. Inference still runs at
+// least every kMaxSkippedFrames + 1 frames.
+constexpr uint32_t kMotionBlockThreshold =
+    4 * MotionGate::kBlockSize * MotionGate::kBlockSize;
+constexpr uint32_t kMaxSkippedFrames = 30;
+MotionGate motion_gate;
+// Scores of the last inferred frame, reported again for skipped ones.
+float last_person_score = 0.0f;
+float last_no_person_score = 0.0f;
+#endif
+
+#if defined(COLLECT_CPU_STATS)
+// Per-node timings are printed every kStatsInterval inferences.
+constexpr int kStatsInterval = 32;
+tflite::MicroNodeProfiler profiler;
+int stats_count = 0;
+
+void print_cpu_stats() {
+  printf("Total time = %u us\n", (unsigned) profiler.GetTotalTicks());
+  if (++stats_count == kStatsInterval) {
+    profiler.Log();
+#if defined(PIPELINED_INFERENCE)
+    printf("Dropped frames = %u\n", (unsigned) frame_slot.dropped());
+#endif
+#if defined(MOTION_GATED_INFERENCE)
+    printf("Skipped frames = %u of %u\n", (unsigned) motion_gate.skipped(),
+           (unsigned) motion_gate.frames());
+#endif
+    stats_count = 0;
+  }
+}
+#endif
+
+#if defined(DETECTION_TELEMETRY)
+// Queues the record of a frame for the telemetry task, see telemetry.h. Only
+// encodes into a ring, a record that finds it full is dropped.
+void push_telemetry(float person_score, float no_person_score, bool reused,
+                    uint32_t invoke_us) {
+  static telemetry_record_t record;
+  record.person_score = static_cast<uint8_t>(person_score * 100 + 0.5f);
+  record.no_person_score = static_cast<uint8_t>(no_person_score * 100 + 0.5f);
+  record.flags = reused ? TELEMETRY_FLAG_REUSED : 0;
+  record.invoke_us = reused ? 0 : invoke_us;
+  record.arena_used = interpreter->arena_used_bytes();
+  record.num_ops = 0;
+#if defined(COLLECT_CPU_STATS)
+  for (int i = 0; !reused && i < profiler.num_records() &&
+                  record.num_ops < TELEMETRY_MAX_OPS; i++) {
+    const tflite::MicroNodeProfiler::NodeRecord& node = profiler.record(i);
+    if (node.invocations > 0) {
+      record.op_us[record.num_ops++] =
+          node.samples[(node.invocations - 1) %
+                       tflite::MicroNodeProfiler::kMaxSamples];
+    }
+  }
+#endif
+#if defined(MOTION_GATED_INFERENCE)
+  record.frames_skipped = motion_gate.skipped();
+#endif
+#if defined(PIPELINED_INFERENCE)
+  record.frames_dropped = frame_slot.dropped();
+#endif
+  telemetry_push(&record);
+}
+#elif !defined(CLI_ONLY_INFERENCE)
+void push_telemetry(float, float, bool, uint32_t) {}
+#endif
 }  // namespace
 
 // The name of this function is important for Arduino compatibility.
@@ -90,6 +227,14 @@ void setup() {
   // needed by this graph.
   //
   // tflite::AllOpsResolver resolver;
+  // person_detect_op_resolver.h is generated from the model by
+  // tensorflow/lite/micro/tools/op_resolver. Its resolver finds ops with a
+  // switch on their code, and links only the int8 kernels the model uses.
+  // Regenerate it when the model changes.
+#if __has_include("person_detect_op_resolver.h")
+  // NOLINTNEXTLINE(runtime-global-variables)
+  static PersonDetectOpResolver micro_op_resolver;
+#else
   // NOLINTNEXTLINE(runtime-global-variables)
   static tflite::MicroMutableOpResolver<5> micro_op_resolver;
   micro_op_resolver.AddAveragePool2D();
@@ -97,13 +242,40 @@ void setup() {
   micro_op_resolver.AddDepthwiseConv2D();
   micro_op_resolver.AddReshape();
   micro_op_resolver.AddSoftmax();
+#endif
+
+  // Per-node profiling is only wired in when CPU stats are requested, so the
+  // interpreter does no timing at all otherwise.
+#if defined(COLLECT_CPU_STATS)
+  tflite::MicroProfilerInterface* interpreter_profiler = &profiler;
+#else
+  tflite::MicroProfilerInterface* interpreter_profiler = nullptr;
+#endif
+
+  // Buffer offsets come from the plan embedded in the model by
+  // tensorflow/lite/micro/tools/memory_plan_cache when there is a matching
+  // one, which saves planning at every boot. Otherwise this plans like the
+  // default GreedyMemoryPlanner.
+  // NOLINTNEXTLINE(runtime-global-variables)
+  static tflite::CachedMemoryPlanner memory_planner(model);
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      tensor_arena, kTensorArenaSize, &memory_planner);
 
   // Build an interpreter to run the model with.
   // NOLINTNEXTLINE(runtime-global-variables)
   static tflite::MicroInterpreter static_interpreter(
-      model, micro_op_resolver, tensor_arena, kTensorArenaSize, error_reporter);
+      model, micro_op_resolver, allocator, error_reporter, nullptr,
+      interpreter_profiler);
   interpreter = &static_interpreter;
 
+#if defined(ROW_STREAMING_OPS)
+  if (kTfLiteOk != interpreter->SetRowStreaming(ROW_STREAMING_OPS,
+                                                ROW_STREAMING_BAND_ROWS)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "SetRowStreaming() failed");
+    return;
+  }
+#endif
+
   // Allocate memory from the tensor_arena for the model's tensors.
   TfLiteStatus allocate_status = interpreter->AllocateTensors();
   if (allocate_status != kTfLiteOk) {
@@ -121,22 +293,67 @@ void setup() {
     TF_LITE_REPORT_ERROR(error_reporter, "InitCamera failed\n");
     return;
   }
+
+#if defined(MOTION_GATED_INFERENCE)
+  if (!motion_gate.Init(kNumCols, kNumRows, kMotionBlockThreshold,
+                        kMaxSkippedFrames)) {
+    printf("Couldn't allocate motion reference of %d bytes\n", kMaxImageSize);
+    return;
+  }
+#endif
+
+#if defined(PIPELINED_INFERENCE)
+  if (!frame_slot.Init(kMaxImageSize, tflite::MicroArenaBufferAlignment(),
+                       kPipelineDropOldest)) {
+    printf("Couldn't allocate frame buffers of %d bytes\n", kMaxImageSize);
+    return;
+  }
+  xTaskCreatePinnedToCore(capture_task, "capture", 4 * 1024, NULL,
+                          uxTaskPriorityGet(NULL), NULL,
+                          portNUM_PROCESSORS > 1 ? kCaptureCore : tskNO_AFFINITY);
+#endif
 #endif
 }
 
 #ifndef CLI_ONLY_INFERENCE
 // The name of this function is important for Arduino compatibility.
 void loop() {
+#if defined(PIPELINED_INFERENCE)
+  // Take the newest frame the capture task has prepared. The interpreter reads
+  // it in place, it stays ours until the next Acquire().
+  int8_t* frame = frame_slot.Acquire();
+  if (kTfLiteOk != interpreter->SetInputBuffer(0, frame, kMaxImageSize)) {
+    memcpy(input->data.int8, frame, kMaxImageSize);
+  }
+#else
   // Get image from provider.
+  int8_t* frame = input->data.int8;
   if (kTfLiteOk != GetImage(error_reporter, kNumCols, kNumRows, kNumChannels,
-                            input->data.int8)) {
+                            frame)) {
     TF_LITE_REPORT_ERROR(error_reporter, "Image capture failed.");
   }
+#endif
+
+#if defined(MOTION_GATED_INFERENCE)
+  // Nothing moved since the last inference, its result still holds.
+  if (!motion_gate.ShouldInvoke(frame)) {
+    RespondToDetection(error_reporter, last_person_score, last_no_person_score,
+                       nullptr, kImageCameraGray);
+    push_telemetry(last_person_score, last_no_person_score, true, 0);
+    vTaskDelay(1); // to avoid watchdog trigger
+    return;
+  }
+#endif
 
   // Run the model on this input and make sure it succeeds.
+  int64_t invoke_start_us = esp_timer_get_time();
   if (kTfLiteOk != interpreter->Invoke()) {
     TF_LITE_REPORT_ERROR(error_reporter, "Invoke failed.");
   }
+  uint32_t invoke_us = esp_timer_get_time() - invoke_start_us;
+#if defined(COLLECT_CPU_STATS)
+  print_cpu_stats();
+#endif
 
   TfLiteTensor* output = interpreter->output(0);
 
@@ -148,60 +365,34 @@ void loop() {
       (person_score - output->params.zero_point) * output->params.scale;
   float no_person_score_f =
       (no_person_score - output->params.zero_point) * output->params.scale;
+#if defined(MOTION_GATED_INFERENCE)
+  last_person_score = person_score_f;
+  last_no_person_score = no_person_score_f;
+#endif
 
-  // Respond to detection
-  RespondToDetection(error_reporter, person_score_f, no_person_score_f);
+  // Respond to detection. The scores are those of `frame`: input->data is
+  // back at the arena after Invoke() when the model read the frame in place.
+  RespondToDetection(error_reporter, person_score_f, no_person_score_f, frame,
+                     kImageCameraGray);
+  push_telemetry(person_score_f, no_person_score_f, false, invoke_us);
   //printf("person_score_f: %f no_person_score_f: %f\n", person_score_f, no_person_score_f);
   vTaskDelay(1); // to avoid watchdog trigger
 }
 #endif
 
-#if defined(COLLECT_CPU_STATS)
-  long long total_time = 0;
-  long long start_time = 0;
-  extern long long softmax_total_time;
-  extern long long dc_total_time;
-  extern long long conv_total_time;
-  extern long long fc_total_time;
-  extern long long pooling_total_time;
-  extern long long add_total_time;
-  extern long long mul_total_time;
-#endif
-
 void run_inference(void *ptr) {
   /* Convert from uint8 picture data to int8 */
   for (int i = 0; i < kNumCols * kNumRows; i++) {
     input->data.int8[i] = ((uint8_t *) ptr)[i] ^ 0x80;
   }
 
-#if defined(COLLECT_CPU_STATS)
-  long long start_time = esp_timer_get_time();
-#endif
   // Run the model on this input and make sure it succeeds.
   if (kTfLiteOk != interpreter->Invoke()) {
     error_reporter->Report("Invoke failed.");
   }
 
 #if defined(COLLECT_CPU_STATS)
-  long long total_time = (esp_timer_get_time() - start_time);
-  printf("Total time = %lld\n", total_time / 1000);
-  //printf("Softmax time = %lld\n", softmax_total_time / 1000);
-  printf("FC time = %lld\n", fc_total_time / 1000);
-  printf("DC time = %lld\n", dc_total_time / 1000);
-  printf("conv time = %lld\n", conv_total_time / 1000);
-  printf("Pooling time = %lld\n", pooling_total_time / 1000);
-  printf("add time = %lld\n", add_total_time / 1000);
-  printf("mul time = %lld\n", mul_total_time / 1000);
-
-  /* Reset times */
-  total_time = 0;
-  //softmax_total_time = 0;
-  dc_total_time = 0;
-  conv_total_time = 0;
-  fc_total_time = 0;
-  pooling_total_time = 0;
-  add_total_time = 0;
-  mul_total_time = 0;
+  print_cpu_stats();
 #endif
 
   TfLiteTensor* output = interpreter->output(0);
@@ -214,5 +405,6 @@ void run_inference(void *ptr) {
       (person_score - output->params.zero_point) * output->params.scale;
   float no_person_score_f =
       (no_person_score - output->params.zero_point) * output->params.scale;
-  RespondToDetection(error_reporter, person_score_f, no_person_score_f);
+  RespondToDetection(error_reporter, person_score_f, no_person_score_f,
+                     input->data.int8, kImageSignedGray);
 }
@@ -0,0 +1,67 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "motion_gate.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_heap_caps.h>
+
+bool MotionGate::Init(int width, int height, uint32_t block_threshold,
+                      uint32_t max_skipped) {
+  width_ = width;
+  height_ = height;
+  block_threshold_ = block_threshold;
+  max_skipped_ = max_skipped;
+  has_reference_ = false;
+  if (reference_ == NULL) {
+    /* Read once per frame, keep it in internal RAM */
+    reference_ = (int8_t *) heap_caps_malloc(width * height, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  return reference_ != NULL;
+}
+
+bool MotionGate::Changed(const int8_t* frame) const {
+  for (int by = 0; by < height_; by += kBlockSize) {
+    for (int bx = 0; bx < width_; bx += kBlockSize) {
+      uint32_t sad = 0;
+      for (int y = by; y < by + kBlockSize; y++) {
+        const int8_t* cur = frame + y * width_ + bx;
+        const int8_t* ref = reference_ + y * width_ + bx;
+        for (int x = 0; x < kBlockSize; x++) {
+          sad += abs(cur[x] - ref[x]);
+        }
+      }
+      if (sad > block_threshold_) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool MotionGate::ShouldInvoke(const int8_t* frame) {
+  frames_++;
+  if (has_reference_ && stale_ < max_skipped_ && !Changed(frame)) {
+    stale_++;
+    skipped_++;
+    return false;
+  }
+  memcpy(reference_, frame, width_ * height_);
+  has_reference_ = true;
+  stale_ = 0;
+  return true;
+}
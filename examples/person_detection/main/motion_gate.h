@@ -0,0 +1,64 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Change detection between consecutive camera frames, used to skip inference
+// while the scene is static.
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MOTION_GATE_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MOTION_GATE_H_
+
+#include <cstdint>
+
+// Compares each frame against the last one that was inferred, in square blocks
+// of kBlockSize pixels. The frame counts as changed as soon as the sum of
+// absolute differences of one block exceeds `block_threshold`, so a small
+// object moving is caught while sensor noise spread over the image is not.
+//
+// At most `max_skipped` frames in a row are skipped, which bounds how stale
+// the reported scores can get, e.g. after a slow lighting change.
+class MotionGate {
+ public:
+  static constexpr int kBlockSize = 8;
+
+  // Allocates the reference frame. `width` and `height` must be multiples of
+  // kBlockSize. Returns false when out of memory.
+  bool Init(int width, int height, uint32_t block_threshold,
+            uint32_t max_skipped);
+
+  // Returns true when `frame` has to be inferred, in which case it becomes
+  // the new reference. Returns false, and counts a skipped frame, otherwise.
+  bool ShouldInvoke(const int8_t* frame);
+
+  // Frames ShouldInvoke() was called with, and how many of them were skipped.
+  uint32_t frames() const { return frames_; }
+  uint32_t skipped() const { return skipped_; }
+
+ private:
+  bool Changed(const int8_t* frame) const;
+
+  int8_t* reference_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  uint32_t block_threshold_ = 0;
+  uint32_t max_skipped_ = 0;
+  // Skipped frames since the last inference; the reference is only valid
+  // once a frame was inferred.
+  uint32_t stale_ = 0;
+  bool has_reference_ = false;
+  uint32_t frames_ = 0;
+  uint32_t skipped_ = 0;
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MOTION_GATE_H_
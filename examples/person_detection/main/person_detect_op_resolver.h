@@ -0,0 +1,55 @@
+// Generated by tensorflow/lite/micro/tools/op_resolver from person_detect_model_data.cc.
+// Do not edit.
+
+#ifndef PERSON_DETECT_OP_RESOLVER_H_
+#define PERSON_DETECT_OP_RESOLVER_H_
+
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+
+// The builtin ops of the model, see tflite::MicroStaticOpResolver.
+// Ops only used with int8 activations get their _INT8 kernel variant.
+struct PersonDetectOps {
+  static constexpr int kNumOps = 5;
+
+  static constexpr int Index(tflite::BuiltinOperator op) {
+    switch (op) {
+      case tflite::BuiltinOperator_AVERAGE_POOL_2D:
+        return 0;
+      case tflite::BuiltinOperator_CONV_2D:
+        return 1;
+      case tflite::BuiltinOperator_DEPTHWISE_CONV_2D:
+        return 2;
+      case tflite::BuiltinOperator_RESHAPE:
+        return 3;
+      case tflite::BuiltinOperator_SOFTMAX:
+        return 4;
+      default:
+        return -1;
+    }
+  }
+
+  static void Register(
+      TfLiteRegistration* registrations,
+      tflite::MicroOpResolver::BuiltinParseFunction* parsers) {
+    registrations[0] = tflite::Register_AVERAGE_POOL_2D_INT8();
+    registrations[0].builtin_code = tflite::BuiltinOperator_AVERAGE_POOL_2D;
+    parsers[0] = tflite::ParsePool;
+    registrations[1] = tflite::Register_CONV_2D_INT8();
+    registrations[1].builtin_code = tflite::BuiltinOperator_CONV_2D;
+    parsers[1] = tflite::ParseConv2D;
+    registrations[2] = tflite::Register_DEPTHWISE_CONV_2D_INT8();
+    registrations[2].builtin_code = tflite::BuiltinOperator_DEPTHWISE_CONV_2D;
+    parsers[2] = tflite::ParseDepthwiseConv2D;
+    registrations[3] = tflite::ops::micro::Register_RESHAPE();
+    registrations[3].builtin_code = tflite::BuiltinOperator_RESHAPE;
+    parsers[3] = tflite::ParseReshape;
+    registrations[4] = tflite::Register_SOFTMAX_INT8();
+    registrations[4].builtin_code = tflite::BuiltinOperator_SOFTMAX;
+    parsers[4] = tflite::ParseSoftmax;
+  }
+};
+
+using PersonDetectOpResolver = tflite::MicroStaticOpResolver<PersonDetectOps>;
+
+#endif  // PERSON_DETECT_OP_RESOLVER_H_
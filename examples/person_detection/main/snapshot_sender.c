@@ -0,0 +1,256 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Sends detection snapshots over TCP, on the device (lwIP) or on a Linux
+ * host. Only POSIX socket and clock calls are used. */
+
+#include "snapshot_sender.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "esp_log.h"
+#include "img_converters.h"
+#include "tcp_client.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* Holds the headers of a JPEG and a few of its MCU rows, and more than one
+ * chunk, the encoder writes at most 512 bytes at a time */
+#define QUEUE_SIZE 4096
+/* How long a full queue may hold the sender task before the snapshot fails */
+#define SEND_TIMEOUT_MS 1000
+
+static const char *TAG = "snapshot_sender";
+
+enum {
+  SLOT_FREE,      /* The detection loop may acquire the frame buffer */
+  SLOT_FILLING,   /* Acquired, being filled */
+  SLOT_READY,     /* Committed, waiting for a connection */
+  SLOT_SENDING,   /* Being compressed and sent */
+};
+
+static struct {
+  snapshot_sender_config_t config;
+  tcp_client_t client;
+  uint8_t *frame;
+  atomic_int slot;
+  uint16_t width;
+  uint16_t height;
+  uint8_t score;
+  uint32_t sequence;
+  jpg_encoder_t *encoder;
+  bool failed;            /* The snapshot being sent is lost */
+  uint8_t *queue;
+  size_t queue_start;     /* Unsent bytes are [queue_start, queue_end) */
+  size_t queue_end;
+  uint32_t sent;
+  atomic_uint dropped;
+} sender = { .client = { .sock = -1 } };
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+  put_u16(p, v >> 16);
+  put_u16(p + 2, v);
+}
+
+static void disconnect(void)
+{
+  tcp_client_disconnect(&sender.client);
+  sender.queue_start = sender.queue_end = 0;
+}
+
+/* Sends what the socket takes without waiting. Returns false on error. */
+static bool send_queued(void)
+{
+  while (sender.queue_start < sender.queue_end) {
+    ssize_t n = send(sender.client.sock, sender.queue + sender.queue_start,
+                     sender.queue_end - sender.queue_start, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+      return false;
+    }
+    sender.queue_start += n;
+  }
+  if (sender.queue_start == sender.queue_end) {
+    sender.queue_start = sender.queue_end = 0;
+  }
+  return true;
+}
+
+/* Makes room for `len` more bytes, waiting for the socket if it must */
+static bool reserve_queue(size_t len)
+{
+  while (true) {
+    if (!send_queued()) {
+      return false;
+    }
+    if (QUEUE_SIZE - (sender.queue_end - sender.queue_start) >= len) {
+      break;
+    }
+    if (!tcp_client_wait_writable(&sender.client, SEND_TIMEOUT_MS)) {
+      ESP_LOGE(TAG, "Timed out sending a snapshot");
+      return false;
+    }
+  }
+  if (QUEUE_SIZE - sender.queue_end < len) {
+    memmove(sender.queue, sender.queue + sender.queue_start, sender.queue_end - sender.queue_start);
+    sender.queue_end -= sender.queue_start;
+    sender.queue_start = 0;
+  }
+  return true;
+}
+
+/* jpg_out_cb: queues one chunk of JPEG, a NULL `data` ends the image */
+static size_t queue_chunk(void *arg, size_t index, const void *data, size_t len)
+{
+  (void) arg;
+  (void) index;
+  if (sender.failed || !reserve_queue(2 + len)) {
+    sender.failed = true;
+    return 0;
+  }
+  put_u16(sender.queue + sender.queue_end, (uint16_t) len);
+  if (len) {
+    memcpy(sender.queue + sender.queue_end + 2, data, len);
+  }
+  sender.queue_end += 2 + len;
+  return len;
+}
+
+static bool start_snapshot(void)
+{
+  uint8_t *header = sender.queue + sender.queue_end;
+  memcpy(header, SNAPSHOT_MAGIC, 4);
+  put_u32(header + 4, sender.sequence++);
+  put_u16(header + 8, sender.width);
+  put_u16(header + 10, sender.height);
+  header[12] = sender.score;
+  memset(header + 13, 0, SNAPSHOT_HEADER_SIZE - 13);
+  sender.queue_end += SNAPSHOT_HEADER_SIZE;
+
+  sender.failed = false;
+  return jpg_encoder_start(sender.encoder, sender.frame, sender.width, sender.height,
+                           PIXFORMAT_GRAYSCALE, sender.config.quality, queue_chunk, NULL) &&
+         !sender.failed;
+}
+
+static void finish_snapshot(bool sent)
+{
+  if (sent) {
+    sender.sent++;
+  } else {
+    atomic_fetch_add(&sender.dropped, 1);
+    disconnect();
+  }
+  atomic_store(&sender.slot, SLOT_FREE);
+}
+
+bool snapshot_sender_init(const snapshot_sender_config_t *config)
+{
+  sender.config = *config;
+  if (!tcp_client_init(&sender.client, config->host, config->port)) {
+    return false;
+  }
+  sender.frame = (uint8_t *) malloc((size_t) config->max_width * config->max_height);
+  sender.queue = (uint8_t *) malloc(QUEUE_SIZE);
+  sender.encoder = jpg_encoder_create(config->max_width, false);
+  if (sender.frame == NULL || sender.queue == NULL || sender.encoder == NULL) {
+    ESP_LOGE(TAG, "Couldn't allocate the snapshot buffers");
+    return false;
+  }
+  atomic_store(&sender.slot, SLOT_FREE);
+  return true;
+}
+
+uint8_t *snapshot_sender_acquire(void)
+{
+  int expected = SLOT_FREE;
+  if (!atomic_compare_exchange_strong(&sender.slot, &expected, SLOT_FILLING)) {
+    atomic_fetch_add(&sender.dropped, 1);
+    return NULL;
+  }
+  return sender.frame;
+}
+
+void snapshot_sender_commit(uint16_t width, uint16_t height, uint8_t score)
+{
+  if (width > sender.config.max_width || height > sender.config.max_height) {
+    atomic_fetch_add(&sender.dropped, 1);
+    atomic_store(&sender.slot, SLOT_FREE);
+    return;
+  }
+  sender.width = width;
+  sender.height = height;
+  sender.score = score;
+  atomic_store(&sender.slot, SLOT_READY);
+}
+
+bool snapshot_sender_poll(void)
+{
+  switch (atomic_load(&sender.slot)) {
+  case SLOT_READY:
+    if (!tcp_client_connect_step(&sender.client)) {
+      /* Still connecting, or no receiver: drop it, there will be newer ones */
+      if (sender.client.sock < 0) {
+        finish_snapshot(false);
+      }
+      return sender.client.sock >= 0;
+    }
+    atomic_store(&sender.slot, SLOT_SENDING);
+    if (!start_snapshot()) {
+      finish_snapshot(false);
+      return false;
+    }
+    return true;
+  case SLOT_SENDING:
+    if (!jpg_encoder_done(sender.encoder) &&
+        (!jpg_encoder_run(sender.encoder, 1) || sender.failed)) {
+      finish_snapshot(false);
+      return false;
+    }
+    if (!send_queued()) {
+      finish_snapshot(false);
+      return false;
+    }
+    if (jpg_encoder_done(sender.encoder) && sender.queue_end == 0) {
+      finish_snapshot(true);
+      return false;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+void snapshot_sender_stats(uint32_t *sent, uint32_t *dropped)
+{
+  *sent = sender.sent;
+  *dropped = atomic_load(&sender.dropped);
+}
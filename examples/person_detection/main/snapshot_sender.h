@@ -0,0 +1,87 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SNAPSHOT_SENDER_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SNAPSHOT_SENDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Ships grayscale evidence frames of detections to a TCP receiver as JPEG.
+ *
+ * The detection loop only fills a frame buffer: snapshot_sender_acquire()
+ * never waits, a snapshot that finds the sender busy is dropped. Another task
+ * calls snapshot_sender_poll(), which connects with a non-blocking socket,
+ * compresses one MCU row per call straight into a send queue and drains the
+ * queue as the socket takes it. Everything is allocated by
+ * snapshot_sender_init(). Only POSIX socket calls are used, so the host build
+ * runs the same code against a local listener.
+ *
+ * Every snapshot on the wire is a header followed by the JPEG in chunks, all
+ * integers big endian:
+ *
+ *   "SNAP" | uint32 sequence | uint16 width | uint16 height | uint8 score |
+ *   3 zero bytes
+ *   { uint16 length | length bytes of JPEG } ... | uint16 0
+ *
+ * The score is the person score in percent. A connection that breaks in the
+ * middle of a snapshot loses it, the next one starts on a new connection.
+ */
+
+#define SNAPSHOT_MAGIC "SNAP"
+#define SNAPSHOT_HEADER_SIZE 16
+
+typedef struct {
+  const char *host;     /* IPv4 address of the receiver */
+  uint16_t port;
+  uint16_t max_width;   /* Largest snapshot, the buffers are sized for it */
+  uint16_t max_height;
+  uint8_t quality;      /* JPEG quality, 1..100 */
+} snapshot_sender_config_t;
+
+/* Allocates the frame buffer, the encoder and the send queue */
+bool snapshot_sender_init(const snapshot_sender_config_t *config);
+
+/**
+ * Returns the frame buffer to fill with 8-bit gray pixels, max_width *
+ * max_height bytes, or NULL if the previous snapshot is still being sent.
+ * Must be followed by snapshot_sender_commit().
+ */
+uint8_t *snapshot_sender_acquire(void);
+
+/* Queues the acquired frame buffer, holding a width x height image */
+void snapshot_sender_commit(uint16_t width, uint16_t height, uint8_t score);
+
+/**
+ * Does one step of sending: connects, compresses one MCU row or sends what
+ * the socket takes. Returns true while there is more to do, the caller should
+ * yield and call again soon. Only waits, for a bounded time, when the send
+ * queue is full.
+ */
+bool snapshot_sender_poll(void);
+
+/* Snapshots sent completely and snapshots dropped, since init */
+void snapshot_sender_stats(uint32_t *sent, uint32_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SNAPSHOT_SENDER_H_
@@ -0,0 +1,128 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tcp_client.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+#define CONNECT_TIMEOUT_US 3000000
+#define RETRY_DELAY_US 1000000
+
+static const char *TAG = "tcp_client";
+
+int64_t tcp_client_now_us(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+bool tcp_client_init(tcp_client_t *client, const char *host, uint16_t port)
+{
+  memset(client, 0, sizeof(*client));
+  client->host = host;
+  client->port = port;
+  client->sock = -1;
+  client->addr.sin_family = AF_INET;
+  client->addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &client->addr.sin_addr) != 1) {
+    ESP_LOGE(TAG, "Invalid receiver address %s", host);
+    return false;
+  }
+  return true;
+}
+
+void tcp_client_disconnect(tcp_client_t *client)
+{
+  if (client->sock >= 0) {
+    close(client->sock);
+    client->sock = -1;
+  }
+  client->connecting = false;
+  client->connect_us = tcp_client_now_us() + RETRY_DELAY_US;
+}
+
+bool tcp_client_connect_step(tcp_client_t *client)
+{
+  if (client->sock >= 0 && !client->connecting) {
+    return true;
+  }
+  int64_t now_us = tcp_client_now_us();
+  if (!client->connecting) {
+    if (now_us < client->connect_us) {
+      return false;
+    }
+    client->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (client->sock < 0) {
+      ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+      tcp_client_disconnect(client);
+      return false;
+    }
+    fcntl(client->sock, F_SETFL, fcntl(client->sock, F_GETFL, 0) | O_NONBLOCK);
+    /* The senders coalesce their writes themselves */
+    int one = 1;
+    setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(client->sock, (struct sockaddr *) &client->addr, sizeof(client->addr)) != 0 &&
+        errno != EINPROGRESS) {
+      ESP_LOGE(TAG, "Socket unable to connect: errno %d", errno);
+      tcp_client_disconnect(client);
+      return false;
+    }
+    client->connecting = true;
+    client->connect_us = now_us;
+  }
+
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(client->sock, &writable);
+  struct timeval no_wait = { 0, 0 };
+  if (select(client->sock + 1, NULL, &writable, NULL, &no_wait) <= 0) {
+    if (now_us - client->connect_us > CONNECT_TIMEOUT_US) {
+      ESP_LOGE(TAG, "Timed out connecting to %s:%d", client->host, client->port);
+      tcp_client_disconnect(client);
+    }
+    return false;
+  }
+  int err = 0;
+  socklen_t len = sizeof(err);
+  getsockopt(client->sock, SOL_SOCKET, SO_ERROR, &err, &len);
+  if (err != 0) {
+    ESP_LOGE(TAG, "Socket unable to connect to %s:%d: errno %d", client->host, client->port, err);
+    tcp_client_disconnect(client);
+    return false;
+  }
+  ESP_LOGI(TAG, "Connected to %s:%d", client->host, client->port);
+  client->connecting = false;
+  return true;
+}
+
+bool tcp_client_wait_writable(tcp_client_t *client, int timeout_ms)
+{
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(client->sock, &writable);
+  struct timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+  return select(client->sock + 1, NULL, &writable, NULL, &timeout) > 0;
+}
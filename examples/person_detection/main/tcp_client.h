@@ -0,0 +1,64 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TCP_CLIENT_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TCP_CLIENT_H_
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A non-blocking TCP connection to a fixed receiver, for the senders that
+ * run from a polling task (snapshots, telemetry). Connecting is done in steps
+ * that never wait, a failed or broken connection is retried after a delay.
+ * Only POSIX socket and clock calls are used, so it also builds on a host.
+ */
+typedef struct {
+  struct sockaddr_in addr;
+  const char *host;
+  uint16_t port;
+  int sock;               /* -1 while disconnected */
+  bool connecting;
+  int64_t connect_us;     /* When connecting started or may be retried */
+} tcp_client_t;
+
+/* Sets the receiver, false if `host` is not an IPv4 address */
+bool tcp_client_init(tcp_client_t *client, const char *host, uint16_t port);
+
+/**
+ * Starts connecting, or checks on the connection in progress. Returns true
+ * once connected, the socket is then non-blocking.
+ */
+bool tcp_client_connect_step(tcp_client_t *client);
+
+/* Closes the socket, connecting again is only tried after the retry delay */
+void tcp_client_disconnect(tcp_client_t *client);
+
+/* Waits up to `timeout_ms` for the socket to take more data */
+bool tcp_client_wait_writable(tcp_client_t *client, int timeout_ms);
+
+/* Microseconds of a monotonic clock */
+int64_t tcp_client_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TCP_CLIENT_H_
@@ -0,0 +1,271 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/* Sends telemetry records over TCP, on the device (lwIP) or on a Linux host.
+ * Only POSIX socket and clock calls are used. */
+
+#include "telemetry.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "esp_log.h"
+#include "tcp_client.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* A power of two, holds a few seconds of records at full frame rate */
+#define RING_SIZE 4096
+/* Pending bytes sent without waiting for more, about one TCP segment */
+#define FLUSH_BYTES 1400
+/* Bytes of a record message before the op durations, type included */
+#define RECORD_FIXED_SIZE 33
+
+static const char *TAG = "telemetry";
+
+static struct {
+  telemetry_config_t config;
+  tcp_client_t client;
+  uint8_t ring[RING_SIZE];
+  /* Free running byte counts, the unsent messages are [tail, head) */
+  atomic_uint head;           /* Only written by telemetry_push() */
+  atomic_uint tail;           /* Only written by telemetry_poll() */
+  uint32_t message_end;       /* End of the message at tail, tail if none */
+  size_t magic_sent;          /* Bytes of TELEMETRY_MAGIC on this connection */
+  int64_t pending_us;         /* When the ring stopped being empty */
+  uint32_t sequence;
+  uint32_t sent;
+  atomic_uint lost;
+} telemetry = { .client = { .sock = -1 } };
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+  return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+  return put_u16(put_u16(p, v >> 16), v);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+  return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+/* Writes the whole message, its length included, and returns its size */
+static size_t encode(const telemetry_record_t *record, uint8_t *msg)
+{
+  int num_ops = record->num_ops < TELEMETRY_MAX_OPS ? record->num_ops : TELEMETRY_MAX_OPS;
+  uint8_t *p = msg + 2;
+  *p++ = TELEMETRY_MSG_RECORD;
+  p = put_u32(p, record->sequence);
+  p = put_u32(p, record->timestamp_ms);
+  *p++ = record->person_score;
+  *p++ = record->no_person_score;
+  *p++ = record->flags;
+  *p++ = num_ops;
+  p = put_u32(p, record->invoke_us);
+  p = put_u32(p, record->arena_used);
+  p = put_u32(p, record->frames_skipped);
+  p = put_u32(p, record->frames_dropped);
+  p = put_u32(p, record->records_lost);
+  for (int i = 0; i < num_ops; i++) {
+    uint32_t v = record->op_us[i];
+    while (v >= 0x80) {
+      *p++ = (v & 0x7f) | 0x80;
+      v >>= 7;
+    }
+    *p++ = v;
+  }
+  put_u16(msg, p - msg - 2);
+  return p - msg;
+}
+
+bool telemetry_decode(const uint8_t *data, size_t len, telemetry_record_t *record)
+{
+  if (len < RECORD_FIXED_SIZE || data[0] != TELEMETRY_MSG_RECORD) {
+    return false;
+  }
+  record->sequence = get_u32(data + 1);
+  record->timestamp_ms = get_u32(data + 5);
+  record->person_score = data[9];
+  record->no_person_score = data[10];
+  record->flags = data[11];
+  record->num_ops = data[12];
+  record->invoke_us = get_u32(data + 13);
+  record->arena_used = get_u32(data + 17);
+  record->frames_skipped = get_u32(data + 21);
+  record->frames_dropped = get_u32(data + 25);
+  record->records_lost = get_u32(data + 29);
+  if (record->num_ops > TELEMETRY_MAX_OPS) {
+    return false;
+  }
+  size_t pos = RECORD_FIXED_SIZE;
+  for (int i = 0; i < record->num_ops; i++) {
+    uint32_t v = 0;
+    for (int shift = 0;; shift += 7) {
+      if (pos == len || shift > 28) {
+        return false;
+      }
+      uint8_t b = data[pos++];
+      v |= (uint32_t) (b & 0x7f) << shift;
+      if (!(b & 0x80)) {
+        break;
+      }
+    }
+    record->op_us[i] = v;
+  }
+  return true;
+}
+
+bool telemetry_init(const telemetry_config_t *config)
+{
+  telemetry.config = *config;
+  return tcp_client_init(&telemetry.client, config->host, config->port);
+}
+
+bool telemetry_push(telemetry_record_t *record)
+{
+  record->sequence = telemetry.sequence++;
+  record->timestamp_ms = (uint32_t) (tcp_client_now_us() / 1000);
+  record->records_lost = atomic_load_explicit(&telemetry.lost, memory_order_relaxed);
+
+  uint8_t msg[TELEMETRY_MAX_MESSAGE];
+  size_t len = encode(record, msg);
+  uint32_t head = atomic_load_explicit(&telemetry.head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&telemetry.tail, memory_order_acquire);
+  if (RING_SIZE - (head - tail) < len) {
+    atomic_fetch_add_explicit(&telemetry.lost, 1, memory_order_relaxed);
+    return false;
+  }
+  size_t start = head & (RING_SIZE - 1);
+  size_t first = len < RING_SIZE - start ? len : RING_SIZE - start;
+  memcpy(telemetry.ring + start, msg, first);
+  memcpy(telemetry.ring, msg + first, len - first);
+  atomic_store_explicit(&telemetry.head, head + len, memory_order_release);
+  return true;
+}
+
+/* Hands sent bytes back to telemetry_push(), counting complete messages */
+static void release(uint32_t tail, uint32_t new_tail)
+{
+  while (tail != new_tail) {
+    if (tail == telemetry.message_end) {
+      /* The length of the next message is not released yet */
+      const uint8_t *ring = telemetry.ring;
+      telemetry.message_end = tail + 2 + (ring[tail & (RING_SIZE - 1)] << 8 |
+                                          ring[(tail + 1) & (RING_SIZE - 1)]);
+    }
+    uint32_t step = new_tail - tail;
+    if (step > telemetry.message_end - tail) {
+      step = telemetry.message_end - tail;
+    }
+    tail += step;
+    if (tail == telemetry.message_end) {
+      telemetry.sent++;
+    }
+  }
+  atomic_store_explicit(&telemetry.tail, tail, memory_order_release);
+}
+
+/* Drops the connection and the rest of a message it broke off */
+static void fail(void)
+{
+  uint32_t tail = atomic_load_explicit(&telemetry.tail, memory_order_relaxed);
+  if (tail != telemetry.message_end) {
+    atomic_store_explicit(&telemetry.tail, telemetry.message_end, memory_order_release);
+    atomic_fetch_add_explicit(&telemetry.lost, 1, memory_order_relaxed);
+  }
+  telemetry.magic_sent = 0;
+  tcp_client_disconnect(&telemetry.client);
+}
+
+/* Sends what the socket takes, false if it is full or broke */
+static bool send_some(const uint8_t *data, size_t len, size_t *sent)
+{
+  ssize_t n = send(telemetry.client.sock, data, len, MSG_NOSIGNAL);
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+      fail();
+    }
+    *sent = 0;
+    return false;
+  }
+  *sent = n;
+  return (size_t) n == len;
+}
+
+bool telemetry_poll(void)
+{
+  uint32_t head = atomic_load_explicit(&telemetry.head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&telemetry.tail, memory_order_relaxed);
+  if (head == tail) {
+    telemetry.pending_us = 0;
+    return false;
+  }
+  int64_t now_us = tcp_client_now_us();
+  if (telemetry.pending_us == 0) {
+    telemetry.pending_us = now_us;
+  }
+  if (head - tail < FLUSH_BYTES &&
+      now_us - telemetry.pending_us < (int64_t) telemetry.config.flush_interval_ms * 1000) {
+    return false;
+  }
+  if (!tcp_client_connect_step(&telemetry.client)) {
+    return false;
+  }
+
+  size_t n;
+  while (telemetry.magic_sent < TELEMETRY_MAGIC_SIZE) {
+    if (!send_some((const uint8_t *) TELEMETRY_MAGIC + telemetry.magic_sent,
+                   TELEMETRY_MAGIC_SIZE - telemetry.magic_sent, &n)) {
+      telemetry.magic_sent += n;
+      return false;
+    }
+    telemetry.magic_sent += n;
+  }
+
+  /* At most two calls, when the pending bytes wrap around the ring */
+  while (tail != head) {
+    size_t start = tail & (RING_SIZE - 1);
+    size_t len = head - tail < RING_SIZE - start ? head - tail : RING_SIZE - start;
+    bool all = send_some(telemetry.ring + start, len, &n);
+    if (telemetry.client.sock < 0) {
+      return false;
+    }
+    release(tail, tail + n);
+    tail += n;
+    if (!all) {
+      return false;
+    }
+  }
+  telemetry.pending_us = 0;
+  head = atomic_load_explicit(&telemetry.head, memory_order_acquire);
+  return head - tail >= FLUSH_BYTES;
+}
+
+void telemetry_stats(uint32_t *sent, uint32_t *lost)
+{
+  *sent = telemetry.sent;
+  *lost = atomic_load_explicit(&telemetry.lost, memory_order_relaxed);
+}
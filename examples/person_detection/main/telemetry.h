@@ -0,0 +1,123 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TELEMETRY_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Streams one binary record per frame to a TCP receiver.
+ *
+ * telemetry_push() is called by the inference task. It encodes the record
+ * straight into a single-producer single-consumer byte ring and never waits:
+ * a record that does not fit is dropped and counted. Another task calls
+ * telemetry_poll(), which connects with a non-blocking socket and sends the
+ * ring in large send() calls, only once about a TCP segment of records is
+ * pending or the oldest pending record is flush_interval_ms old. A slow or
+ * absent receiver fills the ring, which turns into dropped records rather
+ * than delays in the inference task.
+ *
+ * Every connection starts with the 4 bytes "TLM1", followed by messages of a
+ * uint16 length and that many bytes, all integers big endian. The first byte
+ * of a message is its type, a receiver skips types it does not know. A
+ * TELEMETRY_MSG_RECORD holds:
+ *
+ *   uint8 type | uint32 sequence | uint32 timestamp_ms |
+ *   uint8 person score | uint8 no person score | uint8 flags | uint8 ops |
+ *   uint32 invoke_us | uint32 arena_used | uint32 frames_skipped |
+ *   uint32 frames_dropped | uint32 records_lost |
+ *   ops x op duration in us, unsigned LEB128
+ *
+ * Scores are in percent. Every record pushed gets the next sequence number,
+ * dropped ones too, so gaps in the sequence show lost records, including the
+ * ones still in the socket when a connection broke. The counters are totals
+ * since boot, so they survive lost records.
+ */
+
+#define TELEMETRY_MAGIC "TLM1"
+#define TELEMETRY_MAGIC_SIZE 4
+#define TELEMETRY_MSG_RECORD 1
+/* Largest number of per-op durations in a record */
+#define TELEMETRY_MAX_OPS 64
+/* Largest encoded message, length included */
+#define TELEMETRY_MAX_MESSAGE (2 + 33 + TELEMETRY_MAX_OPS * 5)
+
+/* The scores were not inferred but reused, as the frame did not change */
+#define TELEMETRY_FLAG_REUSED 0x01
+
+typedef struct {
+  uint32_t sequence;        /* Set by telemetry_push() */
+  uint32_t timestamp_ms;    /* Set by telemetry_push() */
+  uint8_t person_score;
+  uint8_t no_person_score;
+  uint8_t flags;
+  uint8_t num_ops;
+  uint32_t invoke_us;
+  uint32_t arena_used;      /* Bytes of the tensor arena in use */
+  uint32_t frames_skipped;  /* Frames whose inference was skipped */
+  uint32_t frames_dropped;  /* Frames never seen by the inference task */
+  uint32_t records_lost;    /* Set by telemetry_push() */
+  /* One per profiler record, the row-streamed ops share one */
+  uint32_t op_us[TELEMETRY_MAX_OPS];
+} telemetry_record_t;
+
+typedef struct {
+  const char *host;           /* IPv4 address of the receiver */
+  uint16_t port;
+  uint16_t flush_interval_ms; /* Longest a record waits to be coalesced */
+} telemetry_config_t;
+
+bool telemetry_init(const telemetry_config_t *config);
+
+/**
+ * Queues a record, setting its sequence, timestamp and records_lost. Returns
+ * false, counting the record as lost, if the ring is full. Must only be
+ * called from one task.
+ */
+bool telemetry_push(telemetry_record_t *record);
+
+/**
+ * Does one step of sending: connects or sends what the socket takes of the
+ * pending records. Never waits. Returns true while there is more to send
+ * right away, the caller should yield and call again soon.
+ */
+bool telemetry_poll(void);
+
+/**
+ * Records sent completely and records lost, since init. Records that were
+ * still in the socket when a connection broke are only seen as lost by the
+ * receiver, from the sequence numbers.
+ */
+void telemetry_stats(uint32_t *sent, uint32_t *lost);
+
+/**
+ * Decodes the message `data` of `len` bytes, the part after its length.
+ * Returns false if it is not a TELEMETRY_MSG_RECORD or is malformed. Bytes
+ * after the op durations are ignored, for fields added later.
+ */
+bool telemetry_decode(const uint8_t *data, size_t len, telemetry_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_TELEMETRY_H_